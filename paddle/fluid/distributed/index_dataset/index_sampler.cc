@@ -13,8 +13,14 @@
 // limitations under the License.
 
 #include "paddle/fluid/distributed/index_dataset/index_sampler.h"
+#include <algorithm>
+#include <exception>
+#include <thread>
 #include "paddle/fluid/framework/data_feed.h"
 
+DECLARE_int32(layerwise_sample_thread_num);
+DECLARE_int32(layerwise_sample_min_batch);
+
 namespace paddle {
 namespace distributed {
 
@@ -27,49 +33,127 @@ std::vector<std::vector<uint64_t>> LayerWiseSampler::sample(
       input_num * layer_counts_sum_,
       std::vector<uint64_t>(user_feature_num + 2));
 
-  auto max_layer = tree_->Height();
-  size_t idx = 0;
-  for (size_t i = 0; i < input_num; i++) {
-    auto travel_codes =
-        tree_->GetTravelCodes(target_ids[i], start_sample_layer_);
-    auto travel_path = tree_->GetNodes(travel_codes);
-    for (size_t j = 0; j < travel_path.size(); j++) {
+  // The targets are split into shards of a fixed size, each of them with
+  // its own engine seeded by the shard index, so the samples of a seed do
+  // not depend on the number of threads.
+  constexpr size_t kShardSize = 64;
+  size_t shard_num = (input_num + kShardSize - 1) / kShardSize;
+  std::random_device rd;
+  std::vector<uint64_t> shard_seeds(shard_num);
+  for (size_t s = 0; s < shard_num; s++) {
+    shard_seeds[s] = seed_ == 0 ? rd() : seed_ + s;
+  }
+  auto sample_shards = [&](size_t shard_begin, size_t shard_end) {
+    for (size_t s = shard_begin; s < shard_end; s++) {
+      std::mt19937_64 engine(shard_seeds[s]);
+      sample_range(user_inputs, target_ids, with_hierarchy, s * kShardSize,
+                   std::min(input_num, (s + 1) * kShardSize), &engine,
+                   &outputs);
+    }
+  };
+
+  size_t thread_num = FLAGS_layerwise_sample_thread_num > 0
+                          ? FLAGS_layerwise_sample_thread_num
+                          : std::thread::hardware_concurrency();
+  size_t min_batch = std::max(FLAGS_layerwise_sample_min_batch, 1);
+  thread_num = std::max<size_t>(1, std::min(thread_num, input_num / min_batch));
+  if (thread_num == 1) {
+    sample_shards(0, shard_num);
+    return outputs;
+  }
+
+  std::vector<std::thread> threads;
+  std::vector<std::exception_ptr> errors(thread_num);
+  threads.reserve(thread_num);
+  size_t chunk = (shard_num + thread_num - 1) / thread_num;
+  for (size_t t = 0; t < thread_num; t++) {
+    size_t begin = t * chunk;
+    size_t end = std::min(shard_num, begin + chunk);
+    if (begin >= end) break;
+    threads.emplace_back([&, t, begin, end]() {
+      try {
+        sample_shards(begin, end);
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  for (auto& err : errors) {
+    if (err) std::rethrow_exception(err);
+  }
+  return outputs;
+}
+
+void LayerWiseSampler::sample_range(
+    const std::vector<std::vector<uint64_t>>& user_inputs,
+    const std::vector<uint64_t>& target_ids, bool with_hierarchy,
+    size_t begin, size_t end, std::mt19937_64* engine,
+    std::vector<std::vector<uint64_t>>* outputs) {
+  auto user_feature_num = user_inputs[0].size();
+  auto& out = *outputs;
+
+  std::vector<std::uniform_int_distribution<size_t>> dists;
+  dists.reserve(layer_ids_.size());
+  for (auto* ids : layer_ids_) {
+    dists.emplace_back(0, ids->size() - 1);
+  }
+
+  // leaf codes of user features, resolved once per target
+  std::vector<uint64_t> user_codes(user_feature_num);
+  std::vector<uint8_t> user_valid(user_feature_num);
+
+  size_t idx = begin * layer_counts_sum_;
+  for (size_t i = begin; i < end; i++) {
+    uint64_t target_code = 0;
+    PADDLE_ENFORCE_EQ(tree_->GetLeafCode(target_ids[i], &target_code), true,
+                      paddle::platform::errors::InvalidArgument(
+                          "id = %d doesn't exist in Tree.", target_ids[i]));
+    if (with_hierarchy) {
+      for (size_t k = 0; k < user_feature_num; k++) {
+        user_valid[k] = tree_->GetLeafCode(user_inputs[i][k], &user_codes[k]);
+      }
+    }
+
+    for (size_t j = 0; j < layer_ids_.size(); j++) {
       // user
-      if (j > 0 && with_hierarchy) {
-        auto ancestor_codes =
-            tree_->GetAncestorCodes(user_inputs[i], max_layer - j - 1);
-        auto hierarchical_user = tree_->GetNodes(ancestor_codes);
-        for (int idx_offset = 0; idx_offset <= layer_counts_[j]; idx_offset++) {
+      for (int idx_offset = 0; idx_offset <= layer_counts_[j]; idx_offset++) {
+        auto& row = out[idx + idx_offset];
+        if (j > 0 && with_hierarchy) {
           for (size_t k = 0; k < user_feature_num; k++) {
-            outputs[idx + idx_offset][k] = hierarchical_user[k].id();
+            row[k] = user_valid[k] ? tree_->GetIdByCode(tree_->GetAncestorCode(
+                                         user_codes[k], j))
+                                   : 0;
           }
-        }
-      } else {
-        for (int idx_offset = 0; idx_offset <= layer_counts_[j]; idx_offset++) {
+        } else {
           for (size_t k = 0; k < user_feature_num; k++) {
-            outputs[idx + idx_offset][k] = user_inputs[i][k];
+            row[k] = user_inputs[i][k];
           }
         }
       }
 
       // sampler ++
-      outputs[idx][user_feature_num] = travel_path[j].id();
-      outputs[idx][user_feature_num + 1] = 1.0;
+      auto positive_id =
+          tree_->GetIdByCode(tree_->GetAncestorCode(target_code, j));
+      out[idx][user_feature_num] = positive_id;
+      out[idx][user_feature_num + 1] = 1;
       idx += 1;
+      const auto& layer_ids = *layer_ids_[j];
       for (int idx_offset = 0; idx_offset < layer_counts_[j]; idx_offset++) {
-        int sample_res = 0;
+        uint64_t sample_id = 0;
         do {
-          sample_res = sampler_vec_[j]->Sample();
-        } while (layer_ids_[j][sample_res].id() == travel_path[j].id());
-        outputs[idx + idx_offset][user_feature_num] =
-            layer_ids_[j][sample_res].id();
-        outputs[idx + idx_offset][user_feature_num + 1] = 0;
+          sample_id = layer_ids[dists[j](*engine)];
+        } while (sample_id == positive_id);
+        out[idx + idx_offset][user_feature_num] = sample_id;
+        out[idx + idx_offset][user_feature_num + 1] = 0;
       }
       idx += layer_counts_[j];
     }
   }
-  return outputs;
 }
+
 void LayerWiseSampler::sample_from_dataset(
     const uint16_t sample_slot,
     std::vector<paddle::framework::Record>* src_datas,
@@ -107,11 +191,11 @@ void LayerWiseSampler::sample_from_dataset(
           int sample_res = 0;
           do {
             sample_res = sampler_vec_[j]->Sample();
-          } while (layer_ids_[j][sample_res].id() == travel_path[j].id());
+          } while ((*layer_ids_[j])[sample_res] == travel_path[j].id());
           paddle::framework::Record instance(data);
           instance.uint64_feasigns_[sample_feasign_idx].sign().uint64_feasign_ =
-              layer_ids_[j][sample_res].id();
-          VLOG(1) << "layer id :" << layer_ids_[j][sample_res].id();
+              (*layer_ids_[j])[sample_res];
+          VLOG(1) << "layer id :" << (*layer_ids_[j])[sample_res];
           // sample_feasign_idx + 1 == label's id
           instance.uint64_feasigns_[sample_feasign_idx + 1]
               .sign()
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #pragma once
+#include <random>
 #include <vector>
 #include "paddle/fluid/distributed/index_dataset/index_wrapper.h"
 #include "paddle/fluid/framework/data_feed.h"
@@ -100,11 +101,10 @@ class LayerWiseSampler : public IndexSampler {
     auto layer_index = max_layer - 1;
     size_t idx = 0;
     while (layer_index >= start_sample_layer_) {
-      auto layer_codes = tree_->GetLayerCodes(layer_index);
-      layer_ids_.push_back(tree_->GetNodes(layer_codes));
+      layer_ids_.push_back(&tree_->GetLayerIds(layer_index));
       auto sampler_temp =
           std::make_shared<paddle::operators::math::UniformSampler>(
-              layer_ids_[idx].size() - 1, seed_);
+              layer_ids_[idx]->size() - 1, seed_);
       sampler_vec_.push_back(sampler_temp);
       layer_index--;
       idx++;
@@ -120,13 +120,22 @@ class LayerWiseSampler : public IndexSampler {
       std::vector<paddle::framework::Record>* sample_results) override;
 
  private:
+  // Samples targets in [begin, end) into rows starting at
+  // begin * layer_counts_sum_, drawing negatives from `engine`.
+  void sample_range(const std::vector<std::vector<uint64_t>>& user_inputs,
+                    const std::vector<uint64_t>& target_ids,
+                    bool with_hierarchy, size_t begin, size_t end,
+                    std::mt19937_64* engine,
+                    std::vector<std::vector<uint64_t>>* outputs);
+
   std::vector<int> layer_counts_;
   int64_t layer_counts_sum_{0};
   std::shared_ptr<TreeIndex> tree_{nullptr};
   int seed_{0};
   int start_sample_layer_{1};
   std::vector<std::shared_ptr<paddle::operators::math::Sampler>> sampler_vec_;
-  std::vector<std::vector<IndexNode>> layer_ids_;
+  // Points into the flat per-layer id arrays owned by tree_.
+  std::vector<const std::vector<uint64_t>*> layer_ids_;
 };
 
 }  // end namespace distributed
@@ -9,6 +9,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <thread>
@@ -85,9 +86,33 @@ int TreeIndex::Load(const std::string filename) {
   }
   total_nodes_num_ = data_.size();
   max_code_ += 1;
+  BuildFlatIndex();
   return 0;
 }
 
+void TreeIndex::BuildFlatIndex() {
+  flat_ids_.assign(max_code_, fake_node_.id());
+  flat_valid_.assign(max_code_, 0);
+  for (auto& item : data_) {
+    flat_ids_[item.first] = item.second.id();
+    flat_valid_[item.first] = 1;
+  }
+
+  branch_shift_ = 0;
+  auto branch = static_cast<uint64_t>(meta_.branch());
+  if (branch > 1 && (branch & (branch - 1)) == 0) {
+    while ((1ULL << branch_shift_) < branch) branch_shift_++;
+  }
+
+  layer_ids_.clear();
+  layer_ids_.resize(meta_.height());
+  for (int level = 0; level < meta_.height(); level++) {
+    for (auto code : GetLayerCodes(level)) {
+      layer_ids_[level].push_back(flat_ids_[code]);
+    }
+  }
+}
+
 std::vector<IndexNode> TreeIndex::GetNodes(const std::vector<uint64_t>& codes) {
   std::vector<IndexNode> nodes;
   nodes.reserve(codes.size());
@@ -106,6 +131,10 @@ std::vector<uint64_t> TreeIndex::GetLayerCodes(int level) {
   uint64_t level_offset = level_num - 1;
 
   std::vector<uint64_t> res;
+  if (level_offset >= max_code_) {
+    return res;
+  }
+  level_num = std::min(level_num, max_code_ - level_offset);
   res.reserve(level_num);
   for (uint64_t i = 0; i < level_num; i++) {
     auto code = level_offset + i;
@@ -121,19 +150,13 @@ std::vector<uint64_t> TreeIndex::GetAncestorCodes(
   std::vector<uint64_t> res;
   res.reserve(ids.size());
 
-  int cur_level;
+  int steps = (level >= 0) ? std::max(meta_.height() - 1 - level, 0) : 0;
+  uint64_t code = 0;
   for (size_t i = 0; i < ids.size(); i++) {
-    if (id_codes_map_.find(ids[i]) == id_codes_map_.end()) {
+    if (!GetLeafCode(ids[i], &code)) {
       res.push_back(max_code_);
     } else {
-      auto code = id_codes_map_.at(ids[i]);
-      cur_level = meta_.height() - 1;
-
-      while (level >= 0 && cur_level > level) {
-        code = (code - 1) / meta_.branch();
-        cur_level--;
-      }
-      res.push_back(code);
+      res.push_back(GetAncestorCode(code, steps));
     }
   }
   return res;
@@ -154,7 +177,7 @@ std::vector<uint64_t> TreeIndex::GetChildrenCodes(uint64_t ancestor,
     for (; p_idx < p_size; p_idx++) {
       for (int i = 0; i < meta_.branch(); i++) {
         auto code = parent[p_idx] * meta_.branch() + i + 1;
-        if (data_.find(code) != data_.end()) parent.push_back(code);
+        if (CheckIsValid(code)) parent.push_back(code);
       }
     }
     if ((code_min <= parent[p_idx]) && (parent[p_idx] < code_max)) {
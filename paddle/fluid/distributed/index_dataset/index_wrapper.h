@@ -40,12 +40,45 @@ class TreeIndex : public Index {
   uint64_t EmbSize() { return max_id_ + 1; }
   int Load(const std::string path);
 
-  inline bool CheckIsValid(int code) {
-    if (data_.find(code) != data_.end()) {
-      return true;
-    } else {
+  inline bool CheckIsValid(uint64_t code) const {
+    return code < flat_valid_.size() && flat_valid_[code];
+  }
+
+  // Flat implicit-tree accessors. Codes are used directly as array indices,
+  // so these lookups never touch the hash maps above.
+  inline uint64_t GetIdByCode(uint64_t code) const {
+    return CheckIsValid(code) ? flat_ids_[code] : fake_node_.id();
+  }
+
+  inline bool GetLeafCode(uint64_t id, uint64_t* code) const {
+    auto iter = id_codes_map_.find(id);
+    if (iter == id_codes_map_.end()) {
       return false;
     }
+    *code = iter->second;
+    return true;
+  }
+
+  // Returns the ancestor of `code` which is `steps` layers above it.
+  inline uint64_t GetAncestorCode(uint64_t code, int steps) const {
+    if (branch_shift_ == 1) {
+      return ((code + 1) >> steps) - 1;
+    }
+    if (branch_shift_ > 1) {
+      for (; steps > 0; --steps) code = (code - 1) >> branch_shift_;
+      return code;
+    }
+    for (; steps > 0; --steps) code = (code - 1) / meta_.branch();
+    return code;
+  }
+
+  // Ids of all valid nodes in layer `level`, ordered by code.
+  const std::vector<uint64_t>& GetLayerIds(int level) const {
+    PADDLE_ENFORCE_LT(level, static_cast<int>(layer_ids_.size()),
+                      paddle::platform::errors::InvalidArgument(
+                          "level = [%d] should be less than tree height [%d].",
+                          level, layer_ids_.size()));
+    return layer_ids_[level];
   }
 
   std::vector<IndexNode> GetNodes(const std::vector<uint64_t>& codes);
@@ -63,6 +96,15 @@ class TreeIndex : public Index {
   uint64_t max_id_;
   uint64_t max_code_;
   IndexNode fake_node_;
+
+ private:
+  void BuildFlatIndex();
+
+  std::vector<uint64_t> flat_ids_;
+  std::vector<uint8_t> flat_valid_;
+  std::vector<std::vector<uint64_t>> layer_ids_;
+  // log2(branch) if branch is a power of two, otherwise 0.
+  int branch_shift_{0};
 };
 
 using TreePtr = std::shared_ptr<TreeIndex>;
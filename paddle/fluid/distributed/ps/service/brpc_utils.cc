@@ -17,9 +17,22 @@ limitations under the License. */
 #include <arpa/inet.h>
 #include <netdb.h>
 
+#include <cstring>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+
 #include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/platform/enforce.h"
 
+DEFINE_bool(pserver_zero_copy_tensor, false,
+            "append cpu tensor memory to brpc IOBuf as user data on send, "
+            "and wrap a received tensor held by one IOBuf block as tensor "
+            "memory, instead of copying. Tensors read from a socket span "
+            "many blocks and are still copied on receive");
+DEFINE_int64(pserver_zero_copy_min_bytes, 64 * 1024,
+             "tensors smaller than this are still copied when "
+             "pserver_zero_copy_tensor is on");
+
 namespace paddle {
 namespace framework {
 class Variable;
@@ -52,6 +65,136 @@ framework::proto::VarType::Type VarMessageToVarType(
   }
 }
 
+// Keeps the Allocation of a tensor appended to IOBuf as user data alive
+// until brpc releases the block.
+class IOBufTensorHolders {
+ public:
+  static void Hold(void* data, std::shared_ptr<pten::Allocation> holder) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    holders_.emplace(data, std::move(holder));
+  }
+
+  static void Release(void* data) {
+    std::shared_ptr<pten::Allocation> holder;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto iter = holders_.find(data);
+      if (iter == holders_.end()) return;
+      holder = std::move(iter->second);
+      holders_.erase(iter);
+    }
+    // holder is released out of the lock
+  }
+
+ private:
+  static std::mutex mutex_;
+  static std::unordered_multimap<void*, std::shared_ptr<pten::Allocation>>
+      holders_;
+};
+
+std::mutex IOBufTensorHolders::mutex_;
+std::unordered_multimap<void*, std::shared_ptr<pten::Allocation>>
+    IOBufTensorHolders::holders_;
+
+// Tensor memory backed by a received IOBuf block.
+class IOBufAllocation : public pten::Allocation {
+ public:
+  explicit IOBufAllocation(butil::IOBuf&& buf)
+      : pten::Allocation(const_cast<char*>(buf.backing_block(0).data()),
+                         buf.size(), platform::CPUPlace()),
+        buf_(std::move(buf)) {}
+
+ private:
+  butil::IOBuf buf_;
+};
+
+static bool UseZeroCopy(size_t data_len) {
+  return FLAGS_pserver_zero_copy_tensor &&
+         data_len >= static_cast<size_t>(FLAGS_pserver_zero_copy_min_bytes);
+}
+
+static void AppendCPUTensorToIOBuf(const framework::Tensor& tensor,
+                                   butil::IOBuf* iobuf) {
+  uint64_t data_len = tensor.numel() * framework::DataTypeSize(tensor.dtype());
+  iobuf->append(reinterpret_cast<const char*>(&data_len), 8);
+  if (data_len == 0) return;
+  void* data = const_cast<void*>(tensor.data());
+  if (UseZeroCopy(data_len)) {
+    IOBufTensorHolders::Hold(data, tensor.Holder());
+    if (iobuf->append_user_data(data, data_len,
+                                IOBufTensorHolders::Release) == 0) {
+      return;
+    }
+    IOBufTensorHolders::Release(data);
+  }
+  iobuf->append(reinterpret_cast<const char*>(data), data_len);
+}
+
+// Cuts the data of `tensor` from the front of `iobuf`. The dims and dtype of
+// `tensor` must already be set.
+//
+// A tensor needs contiguous memory, so only a payload held by one block, e.g.
+// a user data block passed in process, is wrapped without copy. A payload
+// read from a socket is split into the blocks of the reads, 8KB by default,
+// and is copied block by block into the tensor.
+static void CutCPUTensorFromIOBuf(butil::IOBuf* iobuf,
+                                  framework::Tensor* tensor,
+                                  pten::DataType dtype) {
+  uint64_t data_len = 0;
+  iobuf->cutn(&data_len, 8);
+  butil::IOBuf piece;
+  iobuf->cutn(&piece, data_len);
+  size_t num_blocks = piece.backing_block_num();
+  if (UseZeroCopy(data_len) && num_blocks == 1) {
+    auto addr = reinterpret_cast<uintptr_t>(piece.backing_block(0).data());
+    if (addr % framework::DataTypeSize(dtype) == 0) {
+      tensor->set_offset(0);
+      tensor->ResetHolderWithType(
+          std::make_shared<IOBufAllocation>(std::move(piece)), dtype);
+      return;
+    }
+  }
+  char* tensor_data =
+      static_cast<char*>(tensor->mutable_data(platform::CPUPlace(), dtype));
+  for (size_t i = 0; i < num_blocks; ++i) {
+    butil::StringPiece block = piece.backing_block(i);
+    memcpy(tensor_data, block.data(), block.size());
+    tensor_data += block.size();
+  }
+}
+
+static void InitLodTensorFromMsg(const VarMsg& msg,
+                                 framework::LoDTensor* tensor) {
+  std::vector<int> vec_dim;
+  for (auto& x : msg.dims()) {
+    vec_dim.push_back(x);
+  }
+  tensor->Resize(framework::make_ddim(vec_dim));
+
+  framework::LoD lod;
+  for (int i = 0; i < msg.lod_level(); ++i) {
+    framework::Vector<size_t> v;
+    for (int j = 0; j < msg.lod(i).lod_data_size(); ++j) {
+      v.push_back(msg.lod(i).lod_data(j));
+    }
+    lod.push_back(v);
+  }
+  tensor->set_lod(lod);
+}
+
+static void InitSelectedRowsFromMsg(const VarMsg& msg,
+                                    pten::SelectedRows* slr) {
+  slr->set_height(msg.slr_height());
+  std::vector<int64_t> tmp_rows(msg.dims()[0]);
+  memcpy(tmp_rows.data(), msg.data().data(), msg.dims()[0] * sizeof(int64_t));
+  slr->set_rows(tmp_rows);
+  std::vector<int> vec_dim;
+  for (auto& x : msg.dims()) {
+    vec_dim.push_back(x);
+  }
+  slr->mutable_value()->Resize(framework::make_ddim(vec_dim));
+}
+
 void SerializeToMultiVarMsgAndIOBuf(
     const std::string& message_name,
     const std::vector<std::string>& send_var_name_val,
@@ -108,9 +251,7 @@ void SerializeLodTensor(framework::Variable* var,
   }
   // IO Buffer
   if (platform::is_cpu_place(tensor->place())) {
-    auto data_len = tensor->numel() * framework::DataTypeSize(tensor->dtype());
-    iobuf->append(reinterpret_cast<const char*>(&data_len), 8);
-    iobuf->append(reinterpret_cast<const char*>(tensor->data()), data_len);
+    AppendCPUTensorToIOBuf(*tensor, iobuf);
   } else {
 #ifdef PADDLE_WITH_CUDA
     char* temp_ptr =
@@ -153,9 +294,7 @@ void SerializeSelectedRows(framework::Variable* var,
   }
   // IO Buffer
   if (platform::is_cpu_place(tensor->place())) {
-    auto data_len = tensor->numel() * framework::DataTypeSize(tensor->dtype());
-    iobuf->append(reinterpret_cast<const char*>(&data_len), 8);
-    iobuf->append(reinterpret_cast<const char*>(tensor->data()), data_len);
+    AppendCPUTensorToIOBuf(*tensor, iobuf);
   } else {
 #ifdef PADDLE_WITH_CUDA
     char* temp_ptr =
@@ -176,17 +315,40 @@ void SerializeSelectedRows(framework::Variable* var,
   }
 }
 
+// Zero-copy counterpart of DeserializeLodTensor/DeserializeSelectedRows for
+// cpu places, cutting the tensor data from the front of `iobuf`.
+static void DeserializeCPUVar(framework::Variable* var, const VarMsg& msg,
+                              butil::IOBuf* iobuf) {
+  auto dtype =
+      framework::TransToPtenDataType(VarMessageToVarType(msg.data_type()));
+  if (msg.type() == ::paddle::distributed::LOD_TENSOR) {
+    auto* tensor = var->GetMutable<framework::LoDTensor>();
+    InitLodTensorFromMsg(msg, tensor);
+    CutCPUTensorFromIOBuf(iobuf, tensor, dtype);
+  } else if (msg.type() == ::paddle::distributed::SELECTED_ROWS) {
+    auto* slr = var->GetMutable<pten::SelectedRows>();
+    InitSelectedRowsFromMsg(msg, slr);
+    CutCPUTensorFromIOBuf(iobuf, slr->mutable_value(), dtype);
+  }
+}
+
 void DeserializeFromMultiVarMsgAndIOBuf(const MultiVarMsg& multi_msg,
                                         const butil::IOBuf* iobuf,
                                         const platform::DeviceContext& ctx,
                                         framework::Scope* scope) {
+  bool zero_copy =
+      FLAGS_pserver_zero_copy_tensor && platform::is_cpu_place(ctx.GetPlace());
+  butil::IOBuf remain;
+  if (zero_copy) remain = *iobuf;
   butil::IOBufBytesIterator io_buffer_itr(*iobuf);
   // size_t shard_buffer_remain = res_io_buffer.size();
   for (int recv_var_index = 0; recv_var_index < multi_msg.send_var_names_size();
        ++recv_var_index) {
     const auto& msg = multi_msg.var_messages(recv_var_index);
     auto* var = scope->Var(msg.varname());
-    if (msg.type() == ::paddle::distributed::LOD_TENSOR) {
+    if (zero_copy) {
+      DeserializeCPUVar(var, msg, &remain);
+    } else if (msg.type() == ::paddle::distributed::LOD_TENSOR) {
       DeserializeLodTensor(var, msg, io_buffer_itr, ctx);
     } else if (msg.type() == ::paddle::distributed::SELECTED_ROWS) {
       DeserializeSelectedRows(var, msg, io_buffer_itr, ctx);
@@ -198,6 +360,10 @@ void DeserializeFromMultiVarMsgAndIOBuf(const MultiVarMsg& multi_msg,
                                         const butil::IOBuf* iobuf,
                                         const platform::DeviceContext& ctx,
                                         const framework::Scope* scope) {
+  bool zero_copy =
+      FLAGS_pserver_zero_copy_tensor && platform::is_cpu_place(ctx.GetPlace());
+  butil::IOBuf remain;
+  if (zero_copy) remain = *iobuf;
   butil::IOBufBytesIterator io_buffer_itr(*iobuf);
   // size_t shard_buffer_remain = res_io_buffer.size();
   for (int recv_var_index = 0; recv_var_index < multi_msg.send_var_names_size();
@@ -207,7 +373,9 @@ void DeserializeFromMultiVarMsgAndIOBuf(const MultiVarMsg& multi_msg,
     PADDLE_ENFORCE_NE(var, nullptr,
                       platform::errors::InvalidArgument(
                           "Not find variable %s in scope.", msg.varname()));
-    if (msg.type() == ::paddle::distributed::LOD_TENSOR) {
+    if (zero_copy) {
+      DeserializeCPUVar(var, msg, &remain);
+    } else if (msg.type() == ::paddle::distributed::LOD_TENSOR) {
       DeserializeLodTensor(var, msg, io_buffer_itr, ctx);
     } else if (msg.type() == ::paddle::distributed::SELECTED_ROWS) {
       DeserializeSelectedRows(var, msg, io_buffer_itr, ctx);
@@ -220,21 +388,7 @@ void DeserializeLodTensor(framework::Variable* var, const VarMsg& msg,
                           const platform::DeviceContext& ctx) {
   const auto place = ctx.GetPlace();
   framework::LoDTensor* tensor = var->GetMutable<framework::LoDTensor>();
-  std::vector<int> vec_dim;
-  for (auto& x : msg.dims()) {
-    vec_dim.push_back(x);
-  }
-  tensor->Resize(framework::make_ddim(vec_dim));
-
-  framework::LoD lod;
-  for (int i = 0; i < msg.lod_level(); ++i) {
-    framework::Vector<size_t> v;
-    for (int j = 0; j < msg.lod(i).lod_data_size(); ++j) {
-      v.push_back(msg.lod(i).lod_data(j));
-    }
-    lod.push_back(v);
-  }
-  tensor->set_lod(lod);
+  InitLodTensorFromMsg(msg, tensor);
 
   void* tensor_data = tensor->mutable_data(
       place,
@@ -270,15 +424,7 @@ void DeserializeSelectedRows(
   const auto place = ctx.GetPlace();
   auto* slr = var->GetMutable<pten::SelectedRows>();
   framework::Tensor* tensor = slr->mutable_value();
-  slr->set_height(msg.slr_height());
-  std::vector<int64_t> tmp_rows(msg.dims()[0]);
-  memcpy(tmp_rows.data(), msg.data().data(), msg.dims()[0] * sizeof(int64_t));
-  slr->set_rows(tmp_rows);
-  std::vector<int> vec_dim;
-  for (auto& x : msg.dims()) {
-    vec_dim.push_back(x);
-  }
-  tensor->Resize(framework::make_ddim(vec_dim));
+  InitSelectedRowsFromMsg(msg, slr);
   void* tensor_data = tensor->mutable_data(
       place,
       framework::TransToPtenDataType(VarMessageToVarType(msg.data_type())));
@@ -494,6 +494,17 @@ void AsyncCommunicator::SendByCommunicator() {
       auto &table_id = ctx.table_id;
       size_t var_nums = varnames.size();
       auto &check_queue = send_varname_to_queue_[varnames[0]];
+      // Send() only merges SelectedRows into the buffer, the grads of any
+      // other type still go through the queue and are drained below
+      // without waiting for more pushes.
+      int max_wait_times = send_wait_times_;
+      if (send_varname_to_merge_buffer_.count(varnames[0]) > 0) {
+        if (SendMergedSparse(ctx) && independent_recv_) {
+          grad_num_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (check_queue->Size() == 0) return;
+        max_wait_times = 0;
+      }
       std::vector<std::vector<std::shared_ptr<Variable>>> vars;
       vars.resize(var_nums);
       int merged_var_num = 0;
@@ -501,7 +512,7 @@ void AsyncCommunicator::SendByCommunicator() {
       while (merged_var_num < max_merge_var_num_) {
         if (check_queue->Size() == 0) {
           VLOG(4) << "wait_times -> " << wait_times;
-          if (wait_times >= send_wait_times_) {
+          if (wait_times >= max_wait_times) {
             break;
           }
           std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -556,6 +567,25 @@ void AsyncCommunicator::SendByCommunicator() {
   return;
 }
 
+bool AsyncCommunicator::SendMergedSparse(const CommContext &ctx) {
+  auto &var_name = ctx.origin_varnames[0];
+  auto &merge_buffer = send_varname_to_merge_buffer_.at(var_name);
+  int wait_times = 0;
+  while (merge_buffer->PendingPushes() < max_merge_var_num_ &&
+         wait_times < send_wait_times_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    wait_times++;
+  }
+  if (merge_buffer->PendingPushes() == 0) return false;
+
+  auto *slr = send_scope_->Var(var_name)->GetMutable<pten::SelectedRows>();
+  auto merged_num = merge_buffer->SwapAndExport(slr);
+  VLOG(3) << "merge " << merged_num << " pushes of " << var_name << " into "
+          << slr->rows().size() << " rows";
+  RpcSendSparse(var_name, ctx.table_id, *send_scope_);
+  return true;
+}
+
 void AsyncCommunicator::PushDensePostProcessing() {
   if (independent_recv_) {
     grad_num_.fetch_add(1, std::memory_order_relaxed);
@@ -616,11 +646,21 @@ void AsyncCommunicator::PullSparseToTensorSync(
       pull_result_ptr.push_back(output_data + output_len);
     }
   }
-  auto status =
-      _worker_ptr->pull_sparse(pull_result_ptr.data(), table_id,
-                               fea_keys.data(), fea_keys.size(), is_training);
-  status.wait();
-  auto ret = status.get();
+  int32_t ret = 0;
+  // The misses of the cache are pulled for training, which creates the rows
+  // on the pservers, so the lookups of eval and infer bypass it.
+  auto *hot_cache =
+      is_training ? GetSparseHotCache(table_id, fea_dim) : nullptr;
+  if (hot_cache) {
+    ret = hot_cache->Pull(fea_keys.data(), pull_result_ptr.data(),
+                          fea_keys.size());
+  } else {
+    auto status =
+        _worker_ptr->pull_sparse(pull_result_ptr.data(), table_id,
+                                 fea_keys.data(), fea_keys.size(), is_training);
+    status.wait();
+    ret = status.get();
+  }
   if (ret != 0) {
     LOG(ERROR) << "fleet pull sparse failed, status[" << ret << "]";
     sleep(sleep_seconds_before_fail_exit_);
@@ -748,11 +788,61 @@ void AsyncCommunicator::PushSparseFromTensorAsync(
       this->Check(table_id), true,
       platform::errors::InvalidArgument(
           "can not find table: %s, please check your config", table_id));
+  auto *hot_cache = GetSparseHotCache(table_id, fea_dim);
+  if (hot_cache) {
+    hot_cache->Push(push_keys.data(), (const float **)push_g_vec.data(),
+                    push_keys.size());
+    return;
+  }
   auto status = _worker_ptr->push_sparse(table_id, push_keys.data(),
                                          (const float **)push_g_vec.data(),
                                          push_keys.size());
 }
 
+SparseHotCache *AsyncCommunicator::GetSparseHotCache(const uint64_t table_id,
+                                                     int fea_dim) {
+  if (sparse_hot_cache_rows_ == 0) return nullptr;
+  std::lock_guard<std::mutex> guard(sparse_hot_cache_mutex_);
+  auto &cache = sparse_hot_caches_[table_id];
+  if (cache) return cache.get();
+
+  // Only the training lookups go through the cache, see
+  // PullSparseToTensorSync.
+  auto pull = [this, table_id](const uint64_t *keys, float **values,
+                               size_t num) {
+    auto status = _worker_ptr->pull_sparse(values, table_id, keys, num,
+                                           /*is_training=*/true);
+    status.wait();
+    return status.get();
+  };
+  auto push = [this, table_id](const uint64_t *keys, const float **values,
+                               size_t num) {
+    _worker_ptr->push_sparse(table_id, keys, values, num);
+    return 0;
+  };
+  // push values are slot, show, click and grad, see CtrCommonPushValue
+  cache.reset(new SparseHotCache(sparse_hot_cache_rows_, fea_dim, fea_dim + 3,
+                                 sparse_hot_cache_refresh_steps_,
+                                 sparse_hot_cache_push_steps_, pull, push));
+  VLOG(1) << "create sparse hot cache for table " << table_id << " with "
+          << sparse_hot_cache_rows_ << " rows";
+  return cache.get();
+}
+
+void AsyncCommunicator::BumpSparseHotCacheVersion(const uint64_t table_id) {
+  std::lock_guard<std::mutex> guard(sparse_hot_cache_mutex_);
+  auto iter = sparse_hot_caches_.find(table_id);
+  if (iter != sparse_hot_caches_.end()) iter->second->BumpVersion();
+}
+
+SparseHotCacheStats AsyncCommunicator::GetSparseHotCacheStats(
+    const uint64_t table_id) {
+  std::lock_guard<std::mutex> guard(sparse_hot_cache_mutex_);
+  auto iter = sparse_hot_caches_.find(table_id);
+  if (iter == sparse_hot_caches_.end()) return SparseHotCacheStats();
+  return iter->second->Stats();
+}
+
 void HalfAsyncCommunicator::MainThread() {
   VLOG(3) << "HalfAsyncCommunicator MainThread start and wait";
 
@@ -787,6 +877,10 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
           std::make_shared<BlockingQueue<std::shared_ptr<Variable>>>(
               send_queue_size_);
     }
+    if (merge_sparse_on_enqueue_ && ctx.is_sparse && !ctx.is_tensor_table) {
+      send_varname_to_merge_buffer_[varnames[0]] =
+          std::make_shared<SparseMergeBuffer>(sparse_merge_max_rows_);
+    }
   }
   send_threadpool_.reset(new ::ThreadPool(thread_pool_size_));
 }
@@ -823,6 +917,20 @@ void AsyncCommunicator::Stop() {
   if (!communicator_) {
     VLOG(0) << "Communicator is not inited, do nothing";
   } else {
+    {
+      // push the gradients of hot rows still merged on the trainer
+      std::lock_guard<std::mutex> guard(sparse_hot_cache_mutex_);
+      for (auto &iter : sparse_hot_caches_) {
+        auto stats = iter.second->Stats();
+        VLOG(0) << "sparse hot cache of table " << iter.first
+                << ": hit rate " << stats.HitRate() << ", staleness "
+                << stats.staleness << " steps, saved "
+                << stats.pull_bytes_saved << " pull bytes and "
+                << stats.push_bytes_saved << " push bytes";
+        iter.second->FlushPush();
+      }
+      sparse_hot_caches_.clear();
+    }
     _worker_ptr->finalize_worker();
     VLOG(1) << "client finalize_worker done";
     if (recv_thread_) {
@@ -873,6 +981,12 @@ void AsyncCommunicator::Send(const std::vector<std::string> &var_names,
   waiting_ = false;
   for (size_t i = 0; i < var_names.size(); i++) {
     auto *var = scope.FindVar(var_names[i]);
+    auto merge_iter = send_varname_to_merge_buffer_.find(var_names[i]);
+    if (merge_iter != send_varname_to_merge_buffer_.end() &&
+        var->IsType<pten::SelectedRows>()) {
+      merge_iter->second->Add(var->Get<pten::SelectedRows>());
+      continue;
+    }
     auto tmp_grad_var = std::make_shared<Variable>();
     framework::CopyVariable(*var, tmp_grad_var.get());
     send_varname_to_queue_[var_names[i]]->Push(tmp_grad_var);
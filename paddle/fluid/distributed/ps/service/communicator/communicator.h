@@ -30,6 +30,8 @@ limitations under the License. */
 
 #include "gflags/gflags.h"
 #include "paddle/fluid/distributed/ps/service/communicator/communicator_common.h"
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_hot_cache.h"
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_merge_buffer.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/variable.h"
@@ -419,6 +421,29 @@ class AsyncCommunicator : public Communicator {
     send_queue_size_ = std::stoi(envs.at("communicator_send_queue_size"));
     need_global_step_ =
         static_cast<bool>(std::stoi(envs.at("need_global_step")));
+    // optional, merge sparse grads into SparseMergeBuffer when they are sent
+    if (envs.find("communicator_merge_sparse_on_enqueue") != envs.end()) {
+      merge_sparse_on_enqueue_ = static_cast<bool>(
+          std::stoi(envs.at("communicator_merge_sparse_on_enqueue")));
+    }
+    if (envs.find("communicator_sparse_merge_max_rows") != envs.end()) {
+      sparse_merge_max_rows_ =
+          std::stoul(envs.at("communicator_sparse_merge_max_rows"));
+    }
+    // optional, replicate the hottest rows of every sparse table locally
+    if (envs.find("communicator_sparse_hot_cache_rows") != envs.end()) {
+      sparse_hot_cache_rows_ =
+          std::stoul(envs.at("communicator_sparse_hot_cache_rows"));
+    }
+    if (envs.find("communicator_sparse_hot_cache_refresh_steps") !=
+        envs.end()) {
+      sparse_hot_cache_refresh_steps_ =
+          std::stoi(envs.at("communicator_sparse_hot_cache_refresh_steps"));
+    }
+    if (envs.find("communicator_sparse_hot_cache_push_steps") != envs.end()) {
+      sparse_hot_cache_push_steps_ =
+          std::stoi(envs.at("communicator_sparse_hot_cache_push_steps"));
+    }
   }
 
   void Start() override;
@@ -440,6 +465,10 @@ class AsyncCommunicator : public Communicator {
 
   virtual void SendByCommunicator();
 
+  // Swaps the merge buffer of a sparse var and sends the merged rows.
+  // Returns false if nothing was pushed within send_wait_times_.
+  bool SendMergedSparse(const CommContext &ctx);
+
   virtual void RecvByCommunicator();
 
   virtual void RecvNoBarrier();
@@ -466,10 +495,23 @@ class AsyncCommunicator : public Communicator {
       const framework::LoDTensor *shows, const framework::LoDTensor *clicks,
       std::vector<framework::LoDTensor *> *outputs);
 
+  // Returns the hot row cache of a sparse table, or nullptr when the cache is
+  // disabled by communicator_sparse_hot_cache_rows.
+  SparseHotCache *GetSparseHotCache(const uint64_t table_id, int fea_dim);
+
+  // Makes the hot row cache of a sparse table pull its replicas again on the
+  // next step, e.g. after the table is reloaded on the pservers.
+  void BumpSparseHotCacheVersion(const uint64_t table_id);
+
+  SparseHotCacheStats GetSparseHotCacheStats(const uint64_t table_id);
+
  protected:
   std::unordered_map<std::string,
                      std::shared_ptr<BlockingQueue<std::shared_ptr<Variable>>>>
       send_varname_to_queue_;
+  // sparse grad name -> merge buffer, only when merge_sparse_on_enqueue_
+  std::unordered_map<std::string, std::shared_ptr<SparseMergeBuffer>>
+      send_varname_to_merge_buffer_;
   std::unique_ptr<::ThreadPool> send_threadpool_{nullptr};
 
   int min_send_grad_num_before_recv_;
@@ -479,6 +521,14 @@ class AsyncCommunicator : public Communicator {
   int send_queue_size_;
   bool need_global_step_ = false;
   bool independent_recv_ = true;
+  bool merge_sparse_on_enqueue_ = false;
+  size_t sparse_merge_max_rows_ = 0;
+  size_t sparse_hot_cache_rows_ = 0;
+  int64_t sparse_hot_cache_refresh_steps_ = 100;
+  int64_t sparse_hot_cache_push_steps_ = 10;
+  std::mutex sparse_hot_cache_mutex_;
+  std::unordered_map<uint64_t, std::unique_ptr<SparseHotCache>>
+      sparse_hot_caches_;
   int parallel_task_nums_ = 0;
   int32_t sleep_seconds_before_fail_exit_;
 
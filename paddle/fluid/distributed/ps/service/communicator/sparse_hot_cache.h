@@ -0,0 +1,360 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/pten/core/utils/rw_lock.h"
+
+namespace paddle {
+namespace distributed {
+
+struct SparseHotCacheStats {
+  int64_t lookups = 0;
+  int64_t hits = 0;
+  // steps since the replicas were last pulled from the pservers
+  int64_t staleness = 0;
+  int64_t pull_bytes_saved = 0;
+  int64_t push_bytes_saved = 0;
+
+  double HitRate() const {
+    return lookups == 0 ? 0 : static_cast<double>(hits) / lookups;
+  }
+};
+
+// SparseHotCache keeps trainer side replicas of the most frequently looked
+// up rows of one sparse table. Lookups of cached ids are served locally and
+// gradients of cached ids are merged and pushed in bulk, so the hot ids,
+// which make up most of the traffic of CTR models, hit the pservers once per
+// interval instead of once per batch.
+//
+// Every Pull counts as one step. The hot set is rebuilt from the decayed id
+// frequencies and the replicas are pulled again every `refresh_steps` steps,
+// or on the next step after BumpVersion, so a replica is never more than
+// `refresh_steps` steps behind the pserver. Merged gradients are pushed every
+// `push_steps` steps and before every refresh.
+//
+// The frequencies are counted in kFreqShards shards picked by the id, so
+// concurrent Pulls rarely wait on the same lock. A shard keeps at most
+// kFreqRowsPerHotRow * capacity / kFreqShards ids and is decayed when a new
+// id does not fit, so the table stays bounded however many ids are seen.
+class SparseHotCache {
+ public:
+  // Pulls the rows of `keys` into `values`, returns 0 on success.
+  using PullFunc = std::function<int32_t(const uint64_t *keys, float **values,
+                                         size_t num)>;
+  // Pushes one gradient per key, returns 0 on success.
+  using PushFunc = std::function<int32_t(const uint64_t *keys,
+                                         const float **values, size_t num)>;
+
+  // `pull_dim` is the width of a pulled row, `push_dim` the width of a pushed
+  // gradient, laid out as CtrCommonPushValue: slot, show, click, grad...
+  SparseHotCache(size_t capacity, int pull_dim, int push_dim,
+                 int64_t refresh_steps, int64_t push_steps, PullFunc pull,
+                 PushFunc push)
+      : capacity_(capacity),
+        pull_dim_(pull_dim),
+        push_dim_(push_dim),
+        refresh_steps_(std::max<int64_t>(refresh_steps, 1)),
+        push_steps_(std::max<int64_t>(push_steps, 1)),
+        pull_(std::move(pull)),
+        push_(std::move(push)),
+        freq_shard_capacity_(
+            std::max(capacity * kFreqRowsPerHotRow / kFreqShards,
+                     static_cast<size_t>(kMinFreqRowsPerShard))) {
+    PADDLE_ENFORCE_GT(capacity_, 0,
+                      platform::errors::InvalidArgument(
+                          "The capacity of SparseHotCache must be greater "
+                          "than 0."));
+  }
+
+  ~SparseHotCache() { FlushPush(); }
+
+  // Fills `values[i]` with the row of `keys[i]`, from the replicas when the
+  // id is hot and from the pservers otherwise.
+  int32_t Pull(const uint64_t *keys, float **values, size_t num) {
+    int32_t ret = Step();
+    std::vector<uint64_t> miss_keys;
+    std::vector<float *> miss_values;
+    int64_t hits = 0;
+    {
+      pten::AutoRDLock guard(&replica_lock_);
+      for (size_t i = 0; i < num; ++i) {
+        auto iter = hot_index_.find(keys[i]);
+        if (iter == hot_index_.end()) {
+          miss_keys.push_back(keys[i]);
+          miss_values.push_back(values[i]);
+          continue;
+        }
+        std::memcpy(values[i], replicas_.data() + iter->second * pull_dim_,
+                    sizeof(float) * pull_dim_);
+        ++hits;
+      }
+    }
+    CountLookups(keys, num);
+    lookups_ += num;
+    hits_ += hits;
+    if (!miss_keys.empty()) {
+      int32_t miss_ret =
+          pull_(miss_keys.data(), miss_values.data(), miss_keys.size());
+      if (miss_ret != 0) ret = miss_ret;
+    }
+    return ret;
+  }
+
+  // Merges the gradients of hot ids into the pending buffer and pushes the
+  // others right away.
+  int32_t Push(const uint64_t *keys, const float **values, size_t num) {
+    std::vector<uint64_t> cold_keys;
+    std::vector<const float *> cold_values;
+    {
+      pten::AutoRDLock guard(&replica_lock_);
+      std::lock_guard<std::mutex> push_guard(push_mutex_);
+      for (size_t i = 0; i < num; ++i) {
+        if (hot_index_.find(keys[i]) == hot_index_.end()) {
+          cold_keys.push_back(keys[i]);
+          cold_values.push_back(values[i]);
+          continue;
+        }
+        auto iter = pending_index_.find(keys[i]);
+        if (iter == pending_index_.end()) {
+          pending_index_.emplace(keys[i], pending_keys_.size());
+          pending_keys_.push_back(keys[i]);
+          pending_grads_.insert(pending_grads_.end(), values[i],
+                                values[i] + push_dim_);
+          continue;
+        }
+        // keep the slot, accumulate show, click and grad
+        float *dst = pending_grads_.data() + iter->second * push_dim_;
+        for (int j = 1; j < push_dim_; ++j) dst[j] += values[i][j];
+        push_bytes_saved_ += sizeof(float) * push_dim_;
+      }
+    }
+    if (cold_keys.empty()) return 0;
+    return push_(cold_keys.data(), cold_values.data(), cold_keys.size());
+  }
+
+  // Forces the replicas to be pulled again on the next step, e.g. when the
+  // table is reloaded or shrunk on the pservers.
+  void BumpVersion() { ++version_; }
+
+  // Pushes the merged gradients of hot ids now.
+  int32_t FlushPush() {
+    std::vector<uint64_t> keys;
+    std::vector<float> grads;
+    TakePending(&keys, &grads);
+    return PushMerged(keys, grads);
+  }
+
+  SparseHotCacheStats Stats() const {
+    SparseHotCacheStats stats;
+    stats.lookups = lookups_.load();
+    stats.hits = hits_.load();
+    stats.staleness = step_.load() - refresh_step_.load();
+    stats.pull_bytes_saved = stats.hits * pull_dim_ * sizeof(float);
+    stats.push_bytes_saved = push_bytes_saved_.load();
+    return stats;
+  }
+
+  size_t HotRows() const {
+    pten::AutoRDLock guard(&replica_lock_);
+    return hot_index_.size();
+  }
+
+  // The number of ids whose lookup frequencies are being counted.
+  size_t FreqRows() const {
+    size_t rows = 0;
+    for (auto &shard : freq_shards_) {
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      rows += shard.freq.size();
+    }
+    return rows;
+  }
+
+ private:
+  static constexpr size_t kFreqShards = 16;
+  static constexpr size_t kFreqRowsPerHotRow = 8;
+  static constexpr size_t kMinFreqRowsPerShard = 64;
+
+  using FreqMap = std::unordered_map<uint64_t, int64_t>;
+  using Candidates = std::vector<std::pair<int64_t, uint64_t>>;
+
+  struct FreqShard {
+    mutable std::mutex mutex;
+    FreqMap freq;
+  };
+
+  static size_t FreqShardOf(uint64_t key) {
+    // fibonacci hashing, the low bits of feasigns are often skewed
+    return (key * 0x9E3779B97F4A7C15ULL) >> 60;
+  }
+
+  // Halves the frequencies and drops the ids that reach 0, so the hot set
+  // follows the recent distribution. The frequencies before the decay are
+  // appended to `candidates` unless it is null.
+  static void Decay(FreqMap *freq, Candidates *candidates) {
+    for (auto iter = freq->begin(); iter != freq->end();) {
+      if (candidates) candidates->emplace_back(iter->second, iter->first);
+      iter->second >>= 1;
+      if (iter->second == 0) {
+        iter = freq->erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+
+  void CountLookups(const uint64_t *keys, size_t num) {
+    std::vector<uint64_t> shard_keys[kFreqShards];
+    for (size_t i = 0; i < num; ++i) {
+      shard_keys[FreqShardOf(keys[i])].push_back(keys[i]);
+    }
+    for (size_t s = 0; s < kFreqShards; ++s) {
+      if (shard_keys[s].empty()) continue;
+      auto &shard = freq_shards_[s];
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      for (auto key : shard_keys[s]) {
+        auto iter = shard.freq.find(key);
+        if (iter != shard.freq.end()) {
+          ++iter->second;
+          continue;
+        }
+        while (shard.freq.size() >= freq_shard_capacity_) {
+          Decay(&shard.freq, nullptr);
+        }
+        shard.freq.emplace(key, 1);
+      }
+    }
+  }
+
+  void TakePending(std::vector<uint64_t> *keys, std::vector<float> *grads) {
+    std::lock_guard<std::mutex> guard(push_mutex_);
+    keys->swap(pending_keys_);
+    grads->swap(pending_grads_);
+    pending_index_.clear();
+  }
+
+  int32_t PushMerged(const std::vector<uint64_t> &keys,
+                     const std::vector<float> &grads) {
+    if (keys.empty()) return 0;
+    std::vector<const float *> values(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      values[i] = grads.data() + i * push_dim_;
+    }
+    return push_(keys.data(), values.data(), keys.size());
+  }
+
+  int32_t Step() {
+    int64_t step = ++step_;
+    bool refresh = step - refresh_step_.load() >= refresh_steps_ ||
+                   version_.load() != refresh_version_.load();
+    bool push = step % push_steps_ == 0;
+    if (!refresh && !push) return 0;
+    // only one trainer thread refreshes, the others keep using the replicas
+    std::unique_lock<std::mutex> guard(refresh_mutex_, std::try_to_lock);
+    if (!guard.owns_lock()) return 0;
+    int32_t ret = FlushPush();
+    if (refresh) {
+      int32_t refresh_ret = Refresh();
+      if (refresh_ret != 0) ret = refresh_ret;
+      refresh_step_ = step;
+    }
+    return ret;
+  }
+
+  int32_t Refresh() {
+    int64_t version = version_.load();
+    Candidates candidates;
+    for (auto &shard : freq_shards_) {
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      Decay(&shard.freq, &candidates);
+    }
+    if (candidates.size() > capacity_) {
+      std::nth_element(candidates.begin(), candidates.begin() + capacity_,
+                       candidates.end(),
+                       std::greater<Candidates::value_type>());
+      candidates.resize(capacity_);
+    }
+
+    std::vector<uint64_t> keys(candidates.size());
+    std::vector<float> replicas(candidates.size() * pull_dim_);
+    std::vector<float *> values(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      keys[i] = candidates[i].second;
+      values[i] = replicas.data() + i * pull_dim_;
+    }
+    if (!keys.empty()) {
+      int32_t ret = pull_(keys.data(), values.data(), keys.size());
+      if (ret != 0) return ret;
+    }
+
+    std::unordered_map<uint64_t, size_t> hot_index;
+    hot_index.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) hot_index.emplace(keys[i], i);
+    std::vector<uint64_t> pending_keys;
+    std::vector<float> pending_grads;
+    {
+      pten::AutoWRLock guard(&replica_lock_);
+      // gradients merged while pulling may belong to ids that leave the hot
+      // set, take them out together with the old replicas
+      TakePending(&pending_keys, &pending_grads);
+      hot_index_.swap(hot_index);
+      replicas_.swap(replicas);
+    }
+    refresh_version_ = version;
+    return PushMerged(pending_keys, pending_grads);
+  }
+
+  const size_t capacity_;
+  const int pull_dim_;
+  const int push_dim_;
+  const int64_t refresh_steps_;
+  const int64_t push_steps_;
+  PullFunc pull_;
+  PushFunc push_;
+  const size_t freq_shard_capacity_;
+
+  mutable pten::RWLock replica_lock_;
+  std::unordered_map<uint64_t, size_t> hot_index_;
+  std::vector<float> replicas_;
+
+  FreqShard freq_shards_[kFreqShards];
+
+  std::mutex push_mutex_;
+  std::unordered_map<uint64_t, size_t> pending_index_;
+  std::vector<uint64_t> pending_keys_;
+  std::vector<float> pending_grads_;
+
+  std::mutex refresh_mutex_;
+  std::atomic<int64_t> step_{0};
+  std::atomic<int64_t> refresh_step_{0};
+  std::atomic<int64_t> version_{0};
+  std::atomic<int64_t> refresh_version_{0};
+
+  std::atomic<int64_t> lookups_{0};
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> push_bytes_saved_{0};
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,172 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/place.h"
+#include "paddle/pten/core/selected_rows.h"
+#include "paddle/pten/core/utils/rw_lock.h"
+
+namespace paddle {
+namespace distributed {
+
+// SparseMergeBuffer accumulates the SelectedRows gradients of one sparse
+// variable at enqueue time. Rows are merged by id into one of two buffers,
+// so its memory is bounded by the number of distinct ids instead of by the
+// number of pending pushes. The send thread swaps the buffers and exports the
+// merged rows while trainers keep writing into the other one.
+class SparseMergeBuffer {
+ public:
+  // The row width is taken from the first pushed SelectedRows. `max_rows` of 0
+  // means the buffer is unbounded.
+  explicit SparseMergeBuffer(size_t max_rows, size_t shard_num = 16)
+      : max_rows_(max_rows), shard_num_(shard_num) {
+    PADDLE_ENFORCE_GT(shard_num_, 0,
+                      platform::errors::InvalidArgument(
+                          "The shard num of SparseMergeBuffer must be greater "
+                          "than 0."));
+    buffers_[0].reset(new Buffer(shard_num_));
+    buffers_[1].reset(new Buffer(shard_num_));
+  }
+
+  // Merges `slr` into the active buffer. Blocks while the active buffer
+  // already holds max_rows distinct ids, until the send thread swaps it out.
+  void Add(const pten::SelectedRows &slr) {
+    auto &rows = slr.rows();
+    if (rows.size() == 0) return;
+    int64_t width = slr.value().dims()[1];
+    int64_t expected = 0;
+    row_width_.compare_exchange_strong(expected, width);
+    PADDLE_ENFORCE_EQ(width, row_width_.load(),
+                      platform::errors::InvalidArgument(
+                          "The row width of pushed SelectedRows is %d, but "
+                          "the merge buffer expects %d.",
+                          width, row_width_.load()));
+    WaitForCapacity();
+
+    const float *values = slr.value().data<float>();
+    pten::AutoRDLock swap_guard(&swap_lock_);
+    auto &buffer = *buffers_[active_];
+    for (size_t i = 0; i < rows.size(); ++i) {
+      auto &shard = buffer.shards[static_cast<uint64_t>(rows[i]) % shard_num_];
+      const float *src = values + i * width;
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      auto iter = shard.index.find(rows[i]);
+      if (iter == shard.index.end()) {
+        shard.index.emplace(rows[i], shard.ids.size());
+        shard.ids.push_back(rows[i]);
+        shard.values.insert(shard.values.end(), src, src + width);
+        buffer.rows.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        float *dst = shard.values.data() + iter->second * width;
+        for (int64_t j = 0; j < width; ++j) {
+          dst[j] += src[j];
+        }
+      }
+    }
+    buffer.pushes.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Swaps the active and standby buffers and writes the merged rows of the
+  // swapped out buffer into `out`. Returns the number of merged pushes.
+  int64_t SwapAndExport(pten::SelectedRows *out) {
+    int standby = 0;
+    {
+      pten::AutoWRLock swap_guard(&swap_lock_);
+      standby = active_;
+      active_ = 1 - active_;
+    }
+    {
+      std::lock_guard<std::mutex> guard(capacity_mutex_);
+    }
+    capacity_cond_.notify_all();
+
+    auto &buffer = *buffers_[standby];
+    int64_t pushes = buffer.pushes.exchange(0);
+    size_t row_num = buffer.rows.exchange(0);
+
+    auto *out_rows = out->mutable_rows();
+    out_rows->clear();
+    if (row_num == 0) return pushes;
+    out_rows->reserve(row_num);
+    float *out_data = out->mutable_value()->mutable_data<float>(
+        {static_cast<int64_t>(row_num), row_width_.load()},
+        platform::CPUPlace());
+    for (auto &shard : buffer.shards) {
+      std::memcpy(out_data, shard.values.data(),
+                  shard.values.size() * sizeof(float));
+      out_data += shard.values.size();
+      for (auto id : shard.ids) {
+        out_rows->push_back(id);
+      }
+      // keep the capacity so the next round does not reallocate
+      shard.index.clear();
+      shard.ids.clear();
+      shard.values.clear();
+    }
+    return pushes;
+  }
+
+  int64_t PendingPushes() const {
+    return buffers_[active_]->pushes.load(std::memory_order_relaxed);
+  }
+
+  size_t PendingRows() const {
+    return buffers_[active_]->rows.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<int64_t, size_t> index;
+    std::vector<int64_t> ids;
+    std::vector<float> values;
+  };
+
+  struct Buffer {
+    explicit Buffer(size_t shard_num) : shards(shard_num) {}
+    std::vector<Shard> shards;
+    std::atomic<size_t> rows{0};
+    std::atomic<int64_t> pushes{0};
+  };
+
+  void WaitForCapacity() {
+    if (max_rows_ == 0 || PendingRows() < max_rows_) return;
+    std::unique_lock<std::mutex> lock(capacity_mutex_);
+    capacity_cond_.wait(lock, [this] { return PendingRows() < max_rows_; });
+  }
+
+  std::atomic<int64_t> row_width_{0};
+  const size_t max_rows_;
+  const size_t shard_num_;
+  std::unique_ptr<Buffer> buffers_[2];
+  std::atomic<int> active_{0};
+
+  mutable pten::RWLock swap_lock_;
+  std::mutex capacity_mutex_;
+  std::condition_variable capacity_cond_;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -145,6 +145,53 @@ std::future<int32_t> GraphBrpcClient::get_node_feat(
   return fut;
 }
 
+std::future<int32_t> GraphBrpcClient::sample_subgraph(
+    uint32_t table_id, const std::vector<uint64_t> &node_ids,
+    const std::vector<int> &fanouts,
+    const std::vector<std::string> &feature_names, GraphSampledSubgraph &res,
+    int server_index) {
+  if (server_index == -1) {
+    server_index = node_ids.empty() ? 0 : get_server_index_by_id(node_ids[0]);
+  }
+  DownpourBrpcClosure *closure = new DownpourBrpcClosure(1, [&](void *done) {
+    int ret = 0;
+    auto *closure = (DownpourBrpcClosure *)done;
+    if (closure->check_response(0, PS_GRAPH_SAMPLE_SUBGRAPH) != 0) {
+      ret = -1;
+    } else {
+      auto &res_io_buffer = closure->cntl(0)->response_attachment();
+      butil::IOBufBytesIterator io_buffer_itr(res_io_buffer);
+      size_t bytes_size = io_buffer_itr.bytes_left();
+      std::unique_ptr<char[]> buffer_wrapper(new char[bytes_size]);
+      char *buffer = buffer_wrapper.get();
+      io_buffer_itr.copy_and_forward((void *)(buffer), bytes_size);
+      ret = res.recover_from_buffer(buffer, bytes_size);
+    }
+    closure->set_promise_value(ret);
+  });
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+
+  closure->request(0)->set_cmd_id(PS_GRAPH_SAMPLE_SUBGRAPH);
+  closure->request(0)->set_table_id(table_id);
+  closure->request(0)->set_client_id(_client_id);
+  closure->request(0)->add_params((char *)node_ids.data(),
+                                  sizeof(uint64_t) * node_ids.size());
+  closure->request(0)->add_params((char *)fanouts.data(),
+                                  sizeof(int) * fanouts.size());
+  std::string joint_feature_name =
+      paddle::string::join_strings(feature_names, '\t');
+  closure->request(0)->add_params(joint_feature_name.c_str(),
+                                  joint_feature_name.size());
+
+  GraphPsService_Stub rpc_stub = getServiceStub(get_cmd_channel(server_index));
+  closure->cntl(0)->set_log_id(butil::gettimeofday_ms());
+  rpc_stub.service(closure->cntl(0), closure->request(0), closure->response(0),
+                   closure);
+  return fut;
+}
+
 std::future<int32_t> GraphBrpcClient::clear_nodes(uint32_t table_id) {
   DownpourBrpcClosure *closure = new DownpourBrpcClosure(
       server_size, [&, server_size = this->server_size ](void *done) {
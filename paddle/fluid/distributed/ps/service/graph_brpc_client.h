@@ -81,6 +81,16 @@ class GraphBrpcClient : public BrpcPsClient {
       const std::vector<std::string>& feature_names,
       std::vector<std::vector<std::string>>& res);
 
+  // sample the k-hop subgraph around node_ids in one call, fanouts[k]
+  // neighbors are sampled for each node reached by the k-th hop. The request
+  // is served by server_index, or by the server of node_ids[0] if it is -1,
+  // which samples the nodes of the other servers from its peers.
+  virtual std::future<int32_t> sample_subgraph(
+      uint32_t table_id, const std::vector<uint64_t>& node_ids,
+      const std::vector<int>& fanouts,
+      const std::vector<std::string>& feature_names,
+      GraphSampledSubgraph& res, int server_index = -1);
+
   virtual std::future<int32_t> set_node_feat(
       const uint32_t& table_id, const std::vector<uint64_t>& node_ids,
       const std::vector<std::string>& feature_names,
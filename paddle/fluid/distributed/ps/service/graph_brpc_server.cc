@@ -206,6 +206,8 @@ int32_t GraphBrpcService::initialize() {
       &GraphBrpcService::use_neighbors_sample_cache;
   _service_handler_map[PS_GRAPH_LOAD_GRAPH_SPLIT_CONFIG] =
       &GraphBrpcService::load_graph_split_config;
+  _service_handler_map[PS_GRAPH_SAMPLE_SUBGRAPH] =
+      &GraphBrpcService::graph_sample_subgraph;
   // shard初始化,server启动后才可从env获取到server_list的shard信息
   initialize_shard_info();
 
@@ -675,5 +677,270 @@ int32_t GraphBrpcService::load_graph_split_config(
   return 0;
 }
 
+int32_t GraphBrpcService::sample_neighbors_from_all_servers(
+    Table *table, uint32_t table_id, const std::vector<uint64_t> &node_ids,
+    int sample_size, std::vector<std::vector<uint64_t>> &res) {
+  size_t rank = get_rank();
+  res.assign(node_ids.size(), std::vector<uint64_t>());
+  std::vector<std::vector<uint64_t>> node_id_buckets(server_size);
+  std::vector<std::vector<size_t>> query_idx_buckets(server_size);
+  for (size_t query_idx = 0; query_idx < node_ids.size(); ++query_idx) {
+    int server_index =
+        ((GraphTable *)table)->get_server_index_by_id(node_ids[query_idx]);
+    node_id_buckets[server_index].push_back(node_ids[query_idx]);
+    query_idx_buckets[server_index].push_back(query_idx);
+  }
+  std::vector<size_t> request2server;
+  for (size_t server_index = 0; server_index < server_size; ++server_index) {
+    if (server_index != rank && !node_id_buckets[server_index].empty()) {
+      request2server.push_back(server_index);
+    }
+  }
+
+  auto parse_neighbors = [&](size_t server_index, const char *buffer,
+                             const int *actual_sizes) {
+    auto &query_idx_bucket = query_idx_buckets[server_index];
+    for (size_t node_idx = 0; node_idx < query_idx_bucket.size();
+         ++node_idx) {
+      auto &neighbors = res[query_idx_bucket[node_idx]];
+      size_t neighbor_num = actual_sizes[node_idx] / GraphNode::id_size;
+      neighbors.resize(neighbor_num);
+      memcpy(neighbors.data(), buffer, actual_sizes[node_idx]);
+      buffer += actual_sizes[node_idx];
+    }
+  };
+
+  size_t request_call_num = request2server.size();
+  std::future<int> fut;
+  if (request_call_num > 0) {
+    DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+        request_call_num, [&, request_call_num](void *done) {
+          int ret = 0;
+          auto *closure = (DownpourBrpcClosure *)done;
+          for (size_t request_idx = 0; request_idx < request_call_num;
+               ++request_idx) {
+            if (closure->check_response(request_idx,
+                                        PS_GRAPH_SAMPLE_NEIGHBORS) != 0) {
+              ret = -1;
+              continue;
+            }
+            auto &res_io_buffer =
+                closure->cntl(request_idx)->response_attachment();
+            butil::IOBufBytesIterator io_buffer_itr(res_io_buffer);
+            size_t bytes_size = io_buffer_itr.bytes_left();
+            std::unique_ptr<char[]> buffer_wrapper(new char[bytes_size]);
+            char *buffer = buffer_wrapper.get();
+            io_buffer_itr.copy_and_forward((void *)(buffer), bytes_size);
+            size_t node_num = *(size_t *)buffer;
+            int *actual_sizes = (int *)(buffer + sizeof(size_t));
+            parse_neighbors(request2server[request_idx],
+                            buffer + sizeof(size_t) + sizeof(int) * node_num,
+                            actual_sizes);
+          }
+          closure->set_promise_value(ret);
+        });
+    auto promise = std::make_shared<std::promise<int32_t>>();
+    closure->add_promise(promise);
+    fut = promise->get_future();
+    bool need_weight = false;
+    for (size_t request_idx = 0; request_idx < request_call_num;
+         ++request_idx) {
+      size_t server_index = request2server[request_idx];
+      closure->request(request_idx)->set_cmd_id(PS_GRAPH_SAMPLE_NEIGHBORS);
+      closure->request(request_idx)->set_table_id(table_id);
+      closure->request(request_idx)->set_client_id(rank);
+      closure->request(request_idx)
+          ->add_params((char *)node_id_buckets[server_index].data(),
+                       sizeof(uint64_t) * node_id_buckets[server_index].size());
+      closure->request(request_idx)
+          ->add_params((char *)&sample_size, sizeof(int));
+      closure->request(request_idx)
+          ->add_params((char *)&need_weight, sizeof(bool));
+      PsService_Stub rpc_stub(
+          ((GraphBrpcServer *)get_server())->get_cmd_channel(server_index));
+      closure->cntl(request_idx)->set_log_id(butil::gettimeofday_ms());
+      rpc_stub.service(closure->cntl(request_idx),
+                       closure->request(request_idx),
+                       closure->response(request_idx), closure);
+    }
+  }
+
+  // sample the local nodes while waiting for the peers
+  if (!node_id_buckets[rank].empty()) {
+    size_t node_num = node_id_buckets[rank].size();
+    std::vector<std::shared_ptr<char>> buffers(node_num);
+    std::vector<int> actual_sizes(node_num, 0);
+    ((GraphTable *)table)
+        ->random_sample_neighbors(node_id_buckets[rank].data(), sample_size,
+                                  buffers, actual_sizes, false);
+    auto &query_idx_bucket = query_idx_buckets[rank];
+    for (size_t node_idx = 0; node_idx < node_num; ++node_idx) {
+      auto &neighbors = res[query_idx_bucket[node_idx]];
+      neighbors.resize(actual_sizes[node_idx] / GraphNode::id_size);
+      memcpy(neighbors.data(), buffers[node_idx].get(),
+             actual_sizes[node_idx]);
+    }
+  }
+  return request_call_num > 0 ? fut.get() : 0;
+}
+
+int32_t GraphBrpcService::get_node_feat_from_all_servers(
+    Table *table, uint32_t table_id, const std::vector<uint64_t> &node_ids,
+    const std::vector<std::string> &feature_names,
+    std::vector<std::vector<std::string>> &res) {
+  size_t rank = get_rank();
+  res.assign(feature_names.size(), std::vector<std::string>(node_ids.size()));
+  std::vector<std::vector<uint64_t>> node_id_buckets(server_size);
+  std::vector<std::vector<size_t>> query_idx_buckets(server_size);
+  for (size_t query_idx = 0; query_idx < node_ids.size(); ++query_idx) {
+    int server_index =
+        ((GraphTable *)table)->get_server_index_by_id(node_ids[query_idx]);
+    node_id_buckets[server_index].push_back(node_ids[query_idx]);
+    query_idx_buckets[server_index].push_back(query_idx);
+  }
+  std::vector<size_t> request2server;
+  for (size_t server_index = 0; server_index < server_size; ++server_index) {
+    if (server_index != rank && !node_id_buckets[server_index].empty()) {
+      request2server.push_back(server_index);
+    }
+  }
+
+  size_t request_call_num = request2server.size();
+  std::future<int> fut;
+  if (request_call_num > 0) {
+    DownpourBrpcClosure *closure = new DownpourBrpcClosure(
+        request_call_num, [&, request_call_num](void *done) {
+          int ret = 0;
+          auto *closure = (DownpourBrpcClosure *)done;
+          for (size_t request_idx = 0; request_idx < request_call_num;
+               ++request_idx) {
+            if (closure->check_response(request_idx,
+                                        PS_GRAPH_GET_NODE_FEAT) != 0) {
+              ret = -1;
+              continue;
+            }
+            auto &res_io_buffer =
+                closure->cntl(request_idx)->response_attachment();
+            butil::IOBufBytesIterator io_buffer_itr(res_io_buffer);
+            auto &query_idx_bucket =
+                query_idx_buckets[request2server[request_idx]];
+            for (size_t feat_idx = 0; feat_idx < feature_names.size();
+                 ++feat_idx) {
+              for (size_t node_idx = 0; node_idx < query_idx_bucket.size();
+                   ++node_idx) {
+                size_t feat_len;
+                io_buffer_itr.copy_and_forward(&feat_len, sizeof(size_t));
+                auto &feat = res[feat_idx][query_idx_bucket[node_idx]];
+                feat.resize(feat_len);
+                io_buffer_itr.copy_and_forward(&feat[0], feat_len);
+              }
+            }
+          }
+          closure->set_promise_value(ret);
+        });
+    auto promise = std::make_shared<std::promise<int32_t>>();
+    closure->add_promise(promise);
+    fut = promise->get_future();
+    std::string joint_feature_name =
+        paddle::string::join_strings(feature_names, '\t');
+    for (size_t request_idx = 0; request_idx < request_call_num;
+         ++request_idx) {
+      size_t server_index = request2server[request_idx];
+      closure->request(request_idx)->set_cmd_id(PS_GRAPH_GET_NODE_FEAT);
+      closure->request(request_idx)->set_table_id(table_id);
+      closure->request(request_idx)->set_client_id(rank);
+      closure->request(request_idx)
+          ->add_params((char *)node_id_buckets[server_index].data(),
+                       sizeof(uint64_t) * node_id_buckets[server_index].size());
+      closure->request(request_idx)
+          ->add_params(joint_feature_name.c_str(), joint_feature_name.size());
+      PsService_Stub rpc_stub(
+          ((GraphBrpcServer *)get_server())->get_cmd_channel(server_index));
+      closure->cntl(request_idx)->set_log_id(butil::gettimeofday_ms());
+      rpc_stub.service(closure->cntl(request_idx),
+                       closure->request(request_idx),
+                       closure->response(request_idx), closure);
+    }
+  }
+
+  if (!node_id_buckets[rank].empty()) {
+    size_t node_num = node_id_buckets[rank].size();
+    std::vector<std::vector<std::string>> feature(
+        feature_names.size(), std::vector<std::string>(node_num));
+    ((GraphTable *)table)
+        ->get_node_feat(node_id_buckets[rank], feature_names, feature);
+    auto &query_idx_bucket = query_idx_buckets[rank];
+    for (size_t feat_idx = 0; feat_idx < feature_names.size(); ++feat_idx) {
+      for (size_t node_idx = 0; node_idx < node_num; ++node_idx) {
+        res[feat_idx][query_idx_bucket[node_idx]] =
+            std::move(feature[feat_idx][node_idx]);
+      }
+    }
+  }
+  return request_call_num > 0 ? fut.get() : 0;
+}
+
+int32_t GraphBrpcService::graph_sample_subgraph(
+    Table *table, const PsRequestMessage &request, PsResponseMessage &response,
+    brpc::Controller *cntl) {
+  CHECK_TABLE_EXIST(table, request, response)
+  if (request.params_size() < 2) {
+    set_response_code(
+        response, -1,
+        "graph_sample_subgraph request requires at least 2 arguments");
+    return 0;
+  }
+  size_t node_num = request.params(0).size() / sizeof(uint64_t);
+  uint64_t *node_data = (uint64_t *)(request.params(0).c_str());
+  size_t hop_num = request.params(1).size() / sizeof(int);
+  int *fanouts = (int *)(request.params(1).c_str());
+  std::vector<std::string> feature_names;
+  if (request.params_size() > 2 && !request.params(2).empty()) {
+    feature_names =
+        paddle::string::split_string<std::string>(request.params(2), "\t");
+  }
+
+  GraphSampledSubgraph subgraph;
+  subgraph.init(std::vector<uint64_t>(node_data, node_data + node_num));
+  std::vector<std::vector<uint64_t>> neighbors;
+  for (size_t hop = 0; hop < hop_num; ++hop) {
+    if (sample_neighbors_from_all_servers(table, request.table_id(),
+                                          subgraph.get_frontier(),
+                                          fanouts[hop], neighbors) != 0) {
+      set_response_code(response, -1,
+                        "graph_sample_subgraph failed to sample neighbors");
+      return -1;
+    }
+    subgraph.add_hop(neighbors);
+  }
+
+  if (!feature_names.empty()) {
+    std::vector<std::vector<std::string>> feature;
+    if (get_node_feat_from_all_servers(table, request.table_id(),
+                                       subgraph.node_ids, feature_names,
+                                       feature) != 0) {
+      set_response_code(response, -1,
+                        "graph_sample_subgraph failed to get node features");
+      return -1;
+    }
+    subgraph.features.resize(feature_names.size());
+    for (size_t feat_idx = 0; feat_idx < feature_names.size(); ++feat_idx) {
+      auto &feat = subgraph.features[feat_idx];
+      feat.name = feature_names[feat_idx];
+      feat.dtype = ((GraphTable *)table)->get_feat_dtype(feat.name);
+      feat.offsets.assign(1, 0);
+      for (auto &value : feature[feat_idx]) {
+        feat.data.append(value);
+        feat.offsets.push_back(feat.data.size());
+      }
+    }
+  }
+
+  std::string buffer;
+  subgraph.to_buffer(&buffer);
+  cntl->response_attachment().append(buffer.data(), buffer.size());
+  return 0;
+}
+
 }  // namespace distributed
 }  // namespace paddle
@@ -130,6 +130,21 @@ class GraphBrpcService : public PsBaseService {
                                   PsResponseMessage &response,
                                   brpc::Controller *cntl);
 
+  int32_t graph_sample_subgraph(Table *table, const PsRequestMessage &request,
+                                PsResponseMessage &response,
+                                brpc::Controller *cntl);
+
+  // sample the neighbors of the nodes kept by any server, the remote nodes
+  // are sent to their servers in one request for each server
+  int32_t sample_neighbors_from_all_servers(
+      Table *table, uint32_t table_id, const std::vector<uint64_t> &node_ids,
+      int sample_size, std::vector<std::vector<uint64_t>> &res);
+
+  int32_t get_node_feat_from_all_servers(
+      Table *table, uint32_t table_id, const std::vector<uint64_t> &node_ids,
+      const std::vector<std::string> &feature_names,
+      std::vector<std::vector<std::string>> &res);
+
  private:
   bool _is_initialize_shard_info;
   std::mutex _initialize_shard_mutex;
@@ -14,13 +14,23 @@
 
 #include "paddle/fluid/distributed/ps/table/common_dense_table.h"
 
+#include <algorithm>
+#include <cstdint>
+
 #include "paddle/fluid/platform/enforce.h"
 
+DECLARE_bool(pserver_merge_dense_push);
+
 namespace paddle {
 namespace distributed {
 
 int FLAGS_pslib_table_save_max_retry_dense = 3;
 
+// the floats of a cache line, the merge shards are aligned to it
+static constexpr int kFloatsPerCacheLine = 64 / sizeof(float);
+
+CommonDenseTable::~CommonDenseTable() { stop_merge_shards(); }
+
 void CommonDenseTable::create_initializer(const std::string& attr,
                                           const std::string& name) {
   auto slices = string::split_string<std::string>(attr, "&");
@@ -51,6 +61,15 @@ int32_t CommonDenseTable::initialize() {
 
   initialize_value();
   initialize_optimizer();
+
+  // applying the sum of the merged gradients once equals applying them one
+  // by one only when the update is linear in the gradient
+  auto& name = _config.common().name();
+  merge_push_ = !sync && FLAGS_pserver_merge_dense_push && param_dim_ > 0 &&
+                optimizer_ != nullptr && (name == "sgd" || name == "sum");
+  if (merge_push_) {
+    start_merge_shards();
+  }
   return 0;
 }
 
@@ -129,6 +148,10 @@ int32_t CommonDenseTable::set_global_lr(float* lr) {
 }
 
 int32_t CommonDenseTable::pull_dense(float* pull_values, size_t num) {
+  if (merge_push_) {
+    pull_snapshot(pull_values);
+    return 0;
+  }
   std::copy(values_[param_idx_].begin(), values_[param_idx_].end(),
             pull_values);
   return 0;
@@ -139,6 +162,16 @@ int32_t CommonDenseTable::push_dense_param(const float* values, size_t num) {
       num, param_dim_,
       paddle::platform::errors::InvalidArgument(
           "update desne param numel expected %d, but got %d", param_dim_, num));
+  if (merge_push_) {
+    flush();
+    for (auto& shard : merge_shards_) {
+      std::lock_guard<std::mutex> guard(shard->mutex);
+      std::copy(values + shard->begin, values + shard->end,
+                values_[param_idx_].begin() + shard->begin);
+      publish_snapshot(shard.get());
+    }
+    return 0;
+  }
   std::copy_n(values, param_dim_, values_[param_idx_].begin());
   return 0;
 }
@@ -158,6 +191,8 @@ int32_t CommonDenseTable::push_dense(const float* values, size_t num) {
           return 0;
         });
     task.wait();
+  } else if (merge_push_) {
+    _merge_push_dense(values, num);
   } else {
     _push_dense(values, num);
   }
@@ -190,6 +225,171 @@ int32_t CommonDenseTable::_push_dense(const float* values, size_t num) {
   return 0;
 }
 
+void CommonDenseTable::AlignedBuffer::resize(size_t size) {
+  buffer_.assign(size + kFloatsPerCacheLine, 0);
+  auto addr = reinterpret_cast<uintptr_t>(buffer_.data());
+  auto offset = (kFloatsPerCacheLine * sizeof(float) -
+                 addr % (kFloatsPerCacheLine * sizeof(float))) %
+                (kFloatsPerCacheLine * sizeof(float));
+  data_ = buffer_.data() + offset / sizeof(float);
+}
+
+void CommonDenseTable::start_merge_shards() {
+  for (auto& buffer : merged_grads_) {
+    buffer.resize(param_dim_);
+  }
+  for (auto& buffer : snapshots_) {
+    buffer.resize(param_dim_);
+  }
+  // split the param by cache lines, so that the shards never share one
+  int line_num = (param_dim_ + kFloatsPerCacheLine - 1) / kFloatsPerCacheLine;
+  int shard_num = std::min(task_pool_size_, line_num);
+  std::vector<int> buckets = bucket(line_num, shard_num);
+  stop_merge_ = false;
+  for (int shard_id = 0; shard_id < shard_num; ++shard_id) {
+    auto* shard = new MergeShard();
+    shard->begin = buckets[shard_id] * kFloatsPerCacheLine;
+    shard->end =
+        std::min(buckets[shard_id + 1] * kFloatsPerCacheLine, param_dim_);
+    merge_shards_.emplace_back(shard);
+  }
+  publish_all_snapshots();
+  for (auto& shard : merge_shards_) {
+    auto* shard_ptr = shard.get();
+    shard->thread = std::thread([this, shard_ptr] {
+      merge_shard_loop(shard_ptr);
+    });
+  }
+  VLOG(1) << "table " << _config.common().table_name() << " merges the pushes "
+          << "into " << shard_num << " shards";
+}
+
+void CommonDenseTable::stop_merge_shards() {
+  stop_merge_ = true;
+  for (auto& shard : merge_shards_) {
+    std::lock_guard<std::mutex> guard(shard->mutex);
+    shard->cv.notify_all();
+  }
+  for (auto& shard : merge_shards_) {
+    if (shard->thread.joinable()) {
+      shard->thread.join();
+    }
+  }
+  merge_shards_.clear();
+}
+
+int32_t CommonDenseTable::_merge_push_dense(const float* values, size_t num) {
+  PADDLE_ENFORCE_GE(
+      num, param_dim_,
+      paddle::platform::errors::InvalidArgument(
+          "update desne numel expected %d, but got %d", param_dim_, num));
+  auto blas = GetBlas<float>();
+  for (auto& shard : merge_shards_) {
+    {
+      std::lock_guard<std::mutex> guard(shard->mutex);
+      float* grads = merged_grads_[shard->active].data();
+      blas.VADD(shard->end - shard->begin, values + shard->begin,
+                grads + shard->begin, grads + shard->begin);
+      ++shard->pending;
+      shard->push_num.fetch_add(1, std::memory_order_relaxed);
+    }
+    shard->cv.notify_one();
+  }
+  return 0;
+}
+
+void CommonDenseTable::merge_shard_loop(MergeShard* shard) {
+  int size = shard->end - shard->begin;
+  while (true) {
+    int applying;
+    int64_t merged_num;
+    {
+      std::unique_lock<std::mutex> lock(shard->mutex);
+      shard->cv.wait(lock, [&] { return shard->pending > 0 || stop_merge_; });
+      if (shard->pending == 0) {
+        return;
+      }
+      applying = shard->active;
+      shard->active = 1 - applying;
+      merged_num = shard->pending;
+      shard->pending = 0;
+    }
+
+    float* grads = merged_grads_[applying].data();
+    optimizer_->update(grads, param_dim_, shard->begin, shard->end);
+    std::fill(grads + shard->begin, grads + shard->end, 0);
+
+    {
+      // the param is published under the lock, so that push_dense_param and
+      // flush see a consistent shard
+      std::lock_guard<std::mutex> guard(shard->mutex);
+      publish_snapshot(shard);
+      shard->applied_num.fetch_add(merged_num, std::memory_order_relaxed);
+      shard->update_num.fetch_add(1, std::memory_order_relaxed);
+    }
+    shard->applied_cv.notify_all();
+    VLOG(3) << "merge shard [" << shard->begin << ", " << shard->end
+            << ") applies " << merged_num << " pushes of " << size
+            << " floats";
+  }
+}
+
+void CommonDenseTable::publish_snapshot(MergeShard* shard) {
+  // the readers copy snapshots_[version % 2], so write the other one and
+  // switch to it
+  int64_t version = shard->version.load(std::memory_order_relaxed);
+  const float* param = values_[param_idx_].data();
+  std::copy(param + shard->begin, param + shard->end,
+            snapshots_[(version + 1) % 2].data() + shard->begin);
+  shard->version.store(version + 1, std::memory_order_release);
+}
+
+void CommonDenseTable::publish_all_snapshots() {
+  for (auto& shard : merge_shards_) {
+    std::lock_guard<std::mutex> guard(shard->mutex);
+    publish_snapshot(shard.get());
+  }
+}
+
+void CommonDenseTable::pull_snapshot(float* pull_values) {
+  for (auto& shard : merge_shards_) {
+    while (true) {
+      int64_t version = shard->version.load(std::memory_order_acquire);
+      const float* snapshot = snapshots_[version % 2].data();
+      std::copy(snapshot + shard->begin, snapshot + shard->end,
+                pull_values + shard->begin);
+      // the buffer is rewritten only after the version moves on
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (shard->version.load(std::memory_order_relaxed) == version) {
+        break;
+      }
+    }
+  }
+}
+
+int32_t CommonDenseTable::flush() {
+  for (auto& shard : merge_shards_) {
+    std::unique_lock<std::mutex> lock(shard->mutex);
+    shard->applied_cv.wait(lock, [&] {
+      return shard->applied_num.load(std::memory_order_relaxed) ==
+             shard->push_num.load(std::memory_order_relaxed);
+    });
+  }
+  return 0;
+}
+
+DenseMergePushStats CommonDenseTable::merge_push_stats() const {
+  DenseMergePushStats stats;
+  for (auto& shard : merge_shards_) {
+    int64_t push_num = shard->push_num.load(std::memory_order_relaxed);
+    int64_t applied_num = shard->applied_num.load(std::memory_order_relaxed);
+    stats.push_num = std::max(stats.push_num, push_num);
+    stats.update_num += shard->update_num.load(std::memory_order_relaxed);
+    stats.staleness = std::max(stats.staleness, push_num - applied_num);
+  }
+  return stats;
+}
+
 int32_t CommonDenseTable::load(const std::string& path,
                                const std::string& param) {
   if (param_dim_ <= 0) {
@@ -294,11 +494,16 @@ int32_t CommonDenseTable::load(const std::string& path,
                  << channel_config.path;
     }
   } while (is_read_failed);
+  if (merge_push_) {
+    publish_all_snapshots();
+  }
   return 0;
 }
 
 int32_t CommonDenseTable::save(const std::string& path,
                                const std::string& param) {
+  // apply the pushes merged before saving
+  flush();
   int save_param = atoi(param.c_str());
   uint32_t feasign_size;
   VLOG(0) << "CommonDenseTable::save path " << path;
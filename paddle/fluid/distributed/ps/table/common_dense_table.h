@@ -17,7 +17,13 @@
 #include <ThreadPool.h>
 #include <assert.h>
 #include <pthread.h>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "Eigen/Dense"
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
@@ -30,10 +36,20 @@ namespace distributed {
 
 class DenseOptimizer;
 
+struct DenseMergePushStats {
+  // the pushes merged into the shards
+  int64_t push_num{0};
+  // the optimizer updates applied by all the shards, each of them applies the
+  // sum of the pushes merged since the last update of the shard
+  int64_t update_num{0};
+  // the pushes not applied yet of the most stale shard
+  int64_t staleness{0};
+};
+
 class CommonDenseTable : public DenseTable {
  public:
   CommonDenseTable() {}
-  virtual ~CommonDenseTable() {}
+  virtual ~CommonDenseTable();
   int32_t initialize() override;
   int32_t initialize_shard() override { return 0; }
   virtual void create_initializer(const std::string& attr,
@@ -49,14 +65,59 @@ class CommonDenseTable : public DenseTable {
   int32_t load(const std::string& path, const std::string& param) override;
   int32_t save(const std::string& path, const std::string& param) override;
 
-  int32_t flush() override { return 0; }
+  int32_t flush() override;
   int32_t shrink(const std::string& param) override { return 0; }
   void clear() override { return; }
 
+  bool is_merge_push() const { return merge_push_; }
+  DenseMergePushStats merge_push_stats() const;
+
  protected:
   int32_t _push_dense(const float* values, size_t num);
+  // merge the gradient into the shards without waiting for the optimizer,
+  // used by the async table when FLAGS_pserver_merge_dense_push is set
+  int32_t _merge_push_dense(const float* values, size_t num);
 
  private:
+  // a float array starting at a cache line
+  class AlignedBuffer {
+   public:
+    void resize(size_t size);
+    float* data() { return data_; }
+    const float* data() const { return data_; }
+
+   private:
+    std::vector<float> buffer_;
+    float* data_{nullptr};
+  };
+
+  // MergeShard owns [begin, end) of the param, and its thread applies the
+  // optimizer to the gradients merged into the range.
+  struct MergeShard {
+    int begin{0};
+    int end{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    // notified when the shard applies the pushes, waited by flush
+    std::condition_variable applied_cv;
+    // the accumulator receiving the pushes, the other one is being applied
+    int active{0};
+    int64_t pending{0};
+    std::atomic<int64_t> push_num{0};
+    std::atomic<int64_t> applied_num{0};
+    std::atomic<int64_t> update_num{0};
+    // the param of the range is published to snapshots_[version % 2]
+    std::atomic<int64_t> version{0};
+    std::thread thread;
+  };
+
+  void start_merge_shards();
+  void stop_merge_shards();
+  void merge_shard_loop(MergeShard* shard);
+  void publish_snapshot(MergeShard* shard);
+  void publish_all_snapshots();
+  void pull_snapshot(float* pull_values);
+
   const int task_pool_size_ = 10;
   bool sync = true;
   std::vector<std::shared_ptr<::ThreadPool>> _shards_task_pool;
@@ -70,6 +131,12 @@ class CommonDenseTable : public DenseTable {
   int total_dim_ = 0;
   int fixed_len_params_dim_ = 0;    // used for save/load
   std::vector<int> param_col_ids_;  // used for save/load
+
+  bool merge_push_ = false;
+  std::atomic<bool> stop_merge_{false};
+  std::vector<std::unique_ptr<MergeShard>> merge_shards_;
+  AlignedBuffer merged_grads_[2];
+  AlignedBuffer snapshots_[2];
 };
 
 }  // namespace distributed
@@ -771,6 +771,154 @@ int32_t GraphTable::pull_graph_list(int start, int total_size,
   return 0;
 }
 
+void GraphSampledSubgraph::init(const std::vector<uint64_t> &seeds) {
+  node_ids.clear();
+  node_index.clear();
+  col.clear();
+  features.clear();
+  row_ptr.assign(1, 0);
+  hop_offsets.assign(1, 0);
+  for (auto id : seeds) {
+    add_node(id);
+  }
+  hop_offsets.push_back(node_ids.size());
+}
+
+int64_t GraphSampledSubgraph::add_node(uint64_t id) {
+  auto iter = node_index.find(id);
+  if (iter != node_index.end()) {
+    return iter->second;
+  }
+  int64_t index = node_ids.size();
+  node_index[id] = index;
+  node_ids.push_back(id);
+  row_ptr.push_back(col.size());
+  return index;
+}
+
+std::vector<uint64_t> GraphSampledSubgraph::get_frontier() const {
+  return std::vector<uint64_t>(node_ids.begin() + hop_offsets[hop_num() - 1],
+                               node_ids.end());
+}
+
+void GraphSampledSubgraph::add_hop(
+    const std::vector<std::vector<uint64_t>> &neighbors) {
+  int64_t start = hop_offsets[hop_num() - 1];
+  int64_t end = node_ids.size();
+  // the rows of the frontier are empty, rebuild them one by one, and the rows
+  // of the nodes reached by this hop are appended after them
+  row_ptr.resize(start + 1);
+  std::vector<uint64_t> new_nodes;
+  int64_t new_node_num = 0;
+  for (int64_t i = start; i < end; ++i) {
+    for (auto id : neighbors[i - start]) {
+      auto iter = node_index.find(id);
+      if (iter != node_index.end()) {
+        col.push_back(iter->second);
+      } else {
+        int64_t index = end + new_node_num++;
+        node_index[id] = index;
+        new_nodes.push_back(id);
+        col.push_back(index);
+      }
+    }
+    row_ptr.push_back(col.size());
+  }
+  for (auto id : new_nodes) {
+    node_ids.push_back(id);
+    row_ptr.push_back(col.size());
+  }
+  hop_offsets.push_back(node_ids.size());
+}
+
+namespace {
+
+template <typename T>
+void append_vector(const std::vector<T> &vec, std::string *buffer) {
+  size_t size = vec.size();
+  buffer->append(reinterpret_cast<const char *>(&size), sizeof(size_t));
+  buffer->append(reinterpret_cast<const char *>(vec.data()),
+                 sizeof(T) * size);
+}
+
+void append_string(const std::string &str, std::string *buffer) {
+  size_t size = str.size();
+  buffer->append(reinterpret_cast<const char *>(&size), sizeof(size_t));
+  buffer->append(str);
+}
+
+// read a size prefixed value from [*buffer, end), return false if the buffer
+// is truncated
+bool read_size(const char **buffer, const char *end, size_t elem_size,
+               size_t *size) {
+  if (end - *buffer < static_cast<ptrdiff_t>(sizeof(size_t))) return false;
+  memcpy(size, *buffer, sizeof(size_t));
+  *buffer += sizeof(size_t);
+  return static_cast<size_t>(end - *buffer) / elem_size >= *size;
+}
+
+template <typename T>
+bool read_vector(const char **buffer, const char *end, std::vector<T> *vec) {
+  size_t size;
+  if (!read_size(buffer, end, sizeof(T), &size)) return false;
+  vec->resize(size);
+  memcpy(vec->data(), *buffer, sizeof(T) * size);
+  *buffer += sizeof(T) * size;
+  return true;
+}
+
+bool read_string(const char **buffer, const char *end, std::string *str) {
+  size_t size;
+  if (!read_size(buffer, end, 1, &size)) return false;
+  str->assign(*buffer, size);
+  *buffer += size;
+  return true;
+}
+
+}  // namespace
+
+void GraphSampledSubgraph::to_buffer(std::string *buffer) const {
+  append_vector(node_ids, buffer);
+  append_vector(hop_offsets, buffer);
+  append_vector(row_ptr, buffer);
+  append_vector(col, buffer);
+  size_t feat_num = features.size();
+  buffer->append(reinterpret_cast<const char *>(&feat_num), sizeof(size_t));
+  for (auto &feat : features) {
+    append_string(feat.name, buffer);
+    append_string(feat.dtype, buffer);
+    append_vector(feat.offsets, buffer);
+    append_string(feat.data, buffer);
+  }
+}
+
+int32_t GraphSampledSubgraph::recover_from_buffer(const char *buffer,
+                                                  size_t size) {
+  const char *end = buffer + size;
+  node_index.clear();
+  size_t feat_num = 0;
+  if (!read_vector(&buffer, end, &node_ids) ||
+      !read_vector(&buffer, end, &hop_offsets) ||
+      !read_vector(&buffer, end, &row_ptr) ||
+      !read_vector(&buffer, end, &col) ||
+      !read_size(&buffer, end, 1, &feat_num)) {
+    return -1;
+  }
+  features.resize(feat_num);
+  for (auto &feat : features) {
+    if (!read_string(&buffer, end, &feat.name) ||
+        !read_string(&buffer, end, &feat.dtype) ||
+        !read_vector(&buffer, end, &feat.offsets) ||
+        !read_string(&buffer, end, &feat.data)) {
+      return -1;
+    }
+  }
+  for (size_t i = 0; i < node_ids.size(); ++i) {
+    node_index[node_ids[i]] = i;
+  }
+  return 0;
+}
+
 int32_t GraphTable::get_server_index_by_id(uint64_t id) {
   return id % shard_num / shard_num_per_server;
 }
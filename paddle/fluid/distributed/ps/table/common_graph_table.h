@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <functional>
 #include <iostream>
@@ -352,6 +353,59 @@ class ScaledLRU {
   friend class RandomSampleLRU<K, V>;
 };
 
+/*
+ * GraphSampledSubgraph is the k-hop subgraph sampled around a batch of seed
+ * nodes. Each node is kept once in node_ids, the nodes first reached by the
+ * k-th hop are node_ids[hop_offsets[k], hop_offsets[k + 1]) and the seeds are
+ * the hop 0. The sampled edges are kept in CSR, the neighbors of node_ids[i]
+ * are node_ids[col[j]] for j in [row_ptr[i], row_ptr[i + 1]). The nodes of the
+ * last hop are not expanded, so their rows are empty.
+ */
+struct GraphSampledSubgraph {
+  struct Feature {
+    std::string name;
+    // dtype of the feature in the table config, e.g. float32 or int64
+    std::string dtype;
+    // the bytes of node_ids[i] are data[offsets[i], offsets[i + 1]), a node
+    // without the feature has no bytes. When all the nodes have the same
+    // length, data is a dense [node_num, dim] tensor of dtype.
+    std::vector<int64_t> offsets;
+    std::string data;
+
+    template <typename T>
+    std::vector<T> get_values(size_t node_idx) const {
+      size_t num = (offsets[node_idx + 1] - offsets[node_idx]) / sizeof(T);
+      std::vector<T> res(num);
+      memcpy(res.data(), data.data() + offsets[node_idx], num * sizeof(T));
+      return res;
+    }
+  };
+
+  std::vector<uint64_t> node_ids;
+  std::vector<int64_t> hop_offsets;
+  std::vector<int64_t> row_ptr;
+  std::vector<int64_t> col;
+  std::vector<Feature> features;
+
+  size_t node_num() const { return node_ids.size(); }
+  size_t hop_num() const { return hop_offsets.size() - 1; }
+
+  // start a new subgraph with the deduplicated seeds
+  void init(const std::vector<uint64_t> &seeds);
+  // the nodes of the last hop, which are expanded by the next add_hop
+  std::vector<uint64_t> get_frontier() const;
+  // add the sampled neighbors of get_frontier() as the next hop
+  void add_hop(const std::vector<std::vector<uint64_t>> &neighbors);
+
+  void to_buffer(std::string *buffer) const;
+  int32_t recover_from_buffer(const char *buffer, size_t size);
+
+ private:
+  int64_t add_node(uint64_t id);
+
+  std::unordered_map<uint64_t, int64_t> node_index;
+};
+
 class GraphTable : public SparseTable {
  public:
   GraphTable() { use_cache = false; }
@@ -422,6 +476,13 @@ class GraphTable : public SparseTable {
 
   size_t get_server_num() { return server_num; }
 
+  // return the dtype of the feature in the table config, or an empty string
+  // if the feature is not configured
+  std::string get_feat_dtype(const std::string &feature_name) {
+    auto iter = feat_id_map.find(feature_name);
+    return iter == feat_id_map.end() ? std::string() : feat_dtype[iter->second];
+  }
+
   virtual int32_t make_neighbor_sample_cache(size_t size_limit, size_t ttl) {
     {
       std::unique_lock<std::mutex> lock(mutex_);
@@ -0,0 +1,127 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <thread>  // NOLINT
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/ps/service/brpc_utils.h"
+#include "paddle/pten/kernels/funcs/math_function.h"
+
+DEFINE_int32(repeat, 3, "The times of sending every tensor.");
+DEFINE_int64(max_mb, 256, "The tensors are sent from 1MB up to max_mb.");
+
+DECLARE_bool(pserver_zero_copy_tensor);
+
+namespace paddle {
+namespace distributed {
+
+static void LoopbackSockets(int* send_fd, int* recv_fd) {
+  int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  PADDLE_ENFORCE_GE(listen_fd, 0, platform::errors::Unavailable(
+                                      "Failed to create the socket."));
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  socklen_t len = sizeof(addr);
+  PADDLE_ENFORCE_EQ(
+      bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), len) == 0 &&
+          listen(listen_fd, 1) == 0 &&
+          getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr),
+                      &len) == 0,
+      true, platform::errors::Unavailable("Failed to listen on loopback."));
+  *send_fd = socket(AF_INET, SOCK_STREAM, 0);
+  PADDLE_ENFORCE_EQ(
+      connect(*send_fd, reinterpret_cast<sockaddr*>(&addr), len), 0,
+      platform::errors::Unavailable("Failed to connect to loopback."));
+  *recv_fd = accept(listen_fd, nullptr, nullptr);
+  PADDLE_ENFORCE_GE(*recv_fd, 0, platform::errors::Unavailable(
+                                     "Failed to accept on loopback."));
+  close(listen_fd);
+}
+
+// Sends a tensor of mb MB repeat times and returns the seconds it took.
+static double SendOverLoopback(int64_t mb, int send_fd, int recv_fd) {
+  platform::CPUPlace place;
+  auto& ctx = *platform::DeviceContextPool::Instance().Get(place);
+  framework::Scope scope;
+  auto* tensor = scope.Var("x")->GetMutable<framework::LoDTensor>();
+  tensor->Resize(framework::make_ddim({mb * 1024 * 1024 / 4}));
+  tensor->mutable_data<float>(place);
+  pten::funcs::set_constant(ctx, tensor, 1.5);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    MultiVariableMessage multi_msg;
+    butil::IOBuf io_buf;
+    SerializeToMultiVarMsgAndIOBuf("bench", {"x"}, {}, ctx, &scope,
+                                   &multi_msg, &io_buf);
+    size_t total = io_buf.size();
+    std::thread sender([&io_buf, send_fd]() {
+      while (!io_buf.empty() &&
+             io_buf.cut_into_file_descriptor(send_fd) > 0) {
+      }
+    });
+    butil::IOPortal received;
+    while (received.size() < total &&
+           received.append_from_file_descriptor(recv_fd, 1 << 20) > 0) {
+    }
+    sender.join();
+    PADDLE_ENFORCE_EQ(received.size(), total,
+                      platform::errors::Unavailable(
+                          "Only received %d of %d bytes over loopback.",
+                          received.size(), total));
+    framework::Scope scope_recv;
+    DeserializeFromMultiVarMsgAndIOBuf(multi_msg, &received, ctx,
+                                       &scope_recv);
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+}  // namespace distributed
+}  // namespace paddle
+
+// Measures the serialize, send and deserialize throughput of the copying
+// and the zero-copy tensor paths over a loopback tcp socket,
+// run command: ./brpc_utils_benchmark [options...]
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  int send_fd = -1;
+  int recv_fd = -1;
+  paddle::distributed::LoopbackSockets(&send_fd, &recv_fd);
+  for (int64_t mb = 1; mb <= FLAGS_max_mb; mb *= 4) {
+    for (bool zero_copy : {false, true}) {
+      FLAGS_pserver_zero_copy_tensor = zero_copy;
+      double seconds =
+          paddle::distributed::SendOverLoopback(mb, send_fd, recv_fd);
+      LOG(INFO) << mb << "MB tensor over loopback, zero_copy=" << zero_copy
+                << ": " << mb * FLAGS_repeat / seconds << " MB/s";
+    }
+  }
+  close(send_fd);
+  close(recv_fd);
+  return 0;
+}
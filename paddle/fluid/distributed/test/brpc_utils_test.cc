@@ -12,7 +12,14 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "gtest/gtest.h"
 
@@ -31,6 +38,8 @@ namespace operators = paddle::operators;
 namespace memory = paddle::memory;
 namespace distributed = paddle::distributed;
 
+DECLARE_bool(pserver_zero_copy_tensor);
+
 void CreateVarsOnScope(framework::Scope* scope, platform::Place* place,
                        const platform::DeviceContext& ctx) {
   // var 1
@@ -129,6 +138,105 @@ TEST(MultiVarMsgCPU, Run) {
   RunMultiVarMsg(place);
 }
 
+TEST(MultiVarMsgCPU, ZeroCopy) {
+  platform::CPUPlace place;
+  FLAGS_pserver_zero_copy_tensor = true;
+  RunMultiVarMsg(place);
+  FLAGS_pserver_zero_copy_tensor = false;
+}
+
+// Connects a pair of tcp sockets over the loopback interface.
+static void LoopbackSockets(int* send_fd, int* recv_fd) {
+  int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(listen_fd, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), len), 0);
+  ASSERT_EQ(listen(listen_fd, 1), 0);
+  ASSERT_EQ(getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len),
+            0);
+  *send_fd = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(connect(*send_fd, reinterpret_cast<sockaddr*>(&addr), len), 0);
+  *recv_fd = accept(listen_fd, nullptr, nullptr);
+  ASSERT_GE(*recv_fd, 0);
+  close(listen_fd);
+}
+
+// Joins the thread when the scope is left, also on a failed ASSERT.
+class ThreadJoiner {
+ public:
+  explicit ThreadJoiner(std::thread* thread) : thread_(thread) {}
+  ~ThreadJoiner() {
+    if (thread_->joinable()) thread_->join();
+  }
+
+ private:
+  std::thread* thread_;
+};
+
+// Sends the serialized tensors through a loopback socket and reads them as
+// brpc does, so the received IOBuf is split into the blocks of the reads.
+TEST(MultiVarMsgCPU, ZeroCopyLoopback) {
+  platform::CPUPlace place;
+  platform::DeviceContextPool& pool = platform::DeviceContextPool::Instance();
+  auto& ctx = *pool.Get(place);
+  int send_fd = -1;
+  int recv_fd = -1;
+  ASSERT_NO_FATAL_FAILURE(LoopbackSockets(&send_fd, &recv_fd));
+  for (int64_t mb = 1; mb <= 16; mb *= 4) {
+    framework::Scope scope;
+    auto* tensor = scope.Var("x")->GetMutable<framework::LoDTensor>();
+    tensor->Resize(framework::make_ddim({mb * 1024 * 1024 / 4}));
+    tensor->mutable_data<float>(place);
+    pten::funcs::set_constant(ctx, tensor, 1.5);
+
+    for (bool zero_copy : {false, true}) {
+      FLAGS_pserver_zero_copy_tensor = zero_copy;
+      ::paddle::distributed::MultiVariableMessage multi_msg;
+      butil::IOBuf io_buf;
+      distributed::SerializeToMultiVarMsgAndIOBuf(
+          "loopback", {"x"}, {}, ctx, &scope, &multi_msg, &io_buf);
+      size_t total = io_buf.size();
+      butil::IOPortal received;
+      {
+        // a failed write closes the socket, so the reads below end too
+        std::thread sender([&io_buf, send_fd]() {
+          while (!io_buf.empty()) {
+            if (io_buf.cut_into_file_descriptor(send_fd) <= 0) {
+              ADD_FAILURE() << "write to the loopback socket failed";
+              shutdown(send_fd, SHUT_WR);
+              return;
+            }
+          }
+        });
+        ThreadJoiner joiner(&sender);
+        while (received.size() < total) {
+          if (received.append_from_file_descriptor(recv_fd, 1 << 20) <= 0) {
+            break;
+          }
+        }
+      }
+      ASSERT_EQ(received.size(), total);
+      EXPECT_GT(received.backing_block_num(), static_cast<size_t>(1));
+
+      framework::Scope scope_recv;
+      distributed::DeserializeFromMultiVarMsgAndIOBuf(multi_msg, &received,
+                                                      ctx, &scope_recv);
+      auto& recv = scope_recv.FindVar("x")->Get<framework::LoDTensor>();
+      ASSERT_EQ(recv.numel(), tensor->numel());
+      EXPECT_FLOAT_EQ(recv.data<float>()[0], 1.5);
+      EXPECT_FLOAT_EQ(recv.data<float>()[recv.numel() - 1], 1.5);
+    }
+  }
+  FLAGS_pserver_zero_copy_tensor = false;
+  close(send_fd);
+  close(recv_fd);
+}
+
 // #ifdef PADDLE_WITH_CUDA
 // TEST(MultiVarMsgGPU, Run) {
 //   platform::CUDAPlace place;
@@ -0,0 +1,120 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/ps/table/common_dense_table.h"
+
+DECLARE_bool(pserver_merge_dense_push);
+
+DEFINE_int32(fea_dim, 100000, "The dim of the dense parameter.");
+DEFINE_int32(trainers, 16, "The trainers pushing concurrently.");
+DEFINE_int32(push_num, 50, "The pushes of every trainer.");
+
+namespace paddle {
+namespace distributed {
+
+static Table *CreateSGDTable(int fea_dim) {
+  TableParameter table_config;
+  table_config.set_table_class("CommonDenseTable");
+  FsClientParameter fs_config;
+  Table *table = new CommonDenseTable();
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CommMergeAccessor");
+  CommonAccessorParameter *common_config = table_config.mutable_common();
+  common_config->set_name("sgd");
+  common_config->set_table_name("sgd_merge_benchmark_table");
+  common_config->set_sync(false);
+  common_config->add_params("Param");
+  common_config->add_dims(fea_dim);
+  common_config->add_initializers("fill_constant&1.0");
+  common_config->add_params("LearningRate");
+  common_config->add_dims(1);
+  common_config->add_initializers("fill_constant&0.0001");
+  PADDLE_ENFORCE_EQ(table->initialize(table_config, fs_config), 0,
+                    platform::errors::Fatal("Failed to initialize the table."));
+  return table;
+}
+
+// push and pull by the trainers concurrently, return the pushes per second
+// and the max number of the pushes not applied yet
+static double PushConcurrently(Table *table, int64_t *max_staleness) {
+  std::vector<float> grads(FLAGS_fea_dim, 1.0);
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_trainers; i++) {
+    threads.emplace_back([table, &grads] {
+      std::vector<float> pull_values(FLAGS_fea_dim);
+      for (int k = 0; k < FLAGS_push_num; ++k) {
+        table->push_dense(grads.data(), grads.size());
+        table->pull_dense(pull_values.data(), FLAGS_fea_dim);
+      }
+    });
+  }
+  *max_staleness = 0;
+  auto *dense_table = dynamic_cast<CommonDenseTable *>(table);
+  int64_t total = static_cast<int64_t>(FLAGS_trainers) * FLAGS_push_num;
+  while (dense_table->is_merge_push() &&
+         dense_table->merge_push_stats().push_num < total) {
+    *max_staleness = std::max(*max_staleness,
+                              dense_table->merge_push_stats().staleness);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  table->flush();
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  return total / cost.count();
+}
+
+static void BenchMergePush() {
+  int64_t staleness;
+  FLAGS_pserver_merge_dense_push = false;
+  Table *table = CreateSGDTable(FLAGS_fea_dim);
+  double legacy_speed = PushConcurrently(table, &staleness);
+  delete table;
+
+  FLAGS_pserver_merge_dense_push = true;
+  table = CreateSGDTable(FLAGS_fea_dim);
+  double merge_speed = PushConcurrently(table, &staleness);
+  auto stats = dynamic_cast<CommonDenseTable *>(table)->merge_push_stats();
+  delete table;
+
+  LOG(INFO) << "dense push of " << FLAGS_trainers << " trainers, "
+            << "blocking table: " << legacy_speed << " pushes/s, "
+            << "merging table: " << merge_speed << " pushes/s, "
+            << stats.update_num << " shard updates, max staleness "
+            << staleness << " pushes";
+}
+
+}  // namespace distributed
+}  // namespace paddle
+
+// Compares the async dense table applying every push with the one merging
+// the pushes into its shards,
+// run command: ./dense_table_benchmark [options...]
+int main(int argc, char *argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::distributed::BenchMergePush();
+  return 0;
+}
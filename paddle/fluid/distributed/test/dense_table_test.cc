@@ -13,11 +13,16 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include <ThreadPool.h>
+#include <algorithm>
+#include <string>
+#include <thread>  // NOLINT
 #include <vector>
 #include "gtest/gtest.h"
 #include "paddle/fluid/distributed/ps.pb.h"
 #include "paddle/fluid/distributed/ps/table/common_dense_table.h"
 
+DECLARE_bool(pserver_merge_dense_push);
+
 namespace paddle {
 namespace distributed {
 
@@ -63,8 +68,12 @@ TEST(CommonDenseTable, Adam) {
   common_config->add_params("LearningRate");
   common_config->add_dims(1);
   common_config->add_initializers("fill_constant&5e-6");
+  // adam_d2sum is not linear in the gradient, its pushes are never merged
+  FLAGS_pserver_merge_dense_push = true;
   auto ret = table->initialize(table_config, fs_config);
+  FLAGS_pserver_merge_dense_push = false;
   ASSERT_EQ(ret, 0);
+  ASSERT_FALSE(dynamic_cast<CommonDenseTable *>(table)->is_merge_push());
 
   // pull parameters for create and check
   std::vector<float> init_values;
@@ -189,5 +198,96 @@ TEST(CommonDenseTable, SGD) {
   }
 }
 
+static Table *CreateLinearTable(const std::string &optimizer, int fea_dim,
+                                float lr) {
+  TableParameter table_config;
+  table_config.set_table_class("CommonDenseTable");
+  FsClientParameter fs_config;
+  Table *table = new CommonDenseTable();
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CommMergeAccessor");
+  CommonAccessorParameter *common_config = table_config.mutable_common();
+  common_config->set_name(optimizer);
+  common_config->set_table_name(optimizer + "_merge_test_table");
+  common_config->set_sync(false);
+  common_config->add_params("Param");
+  common_config->add_dims(fea_dim);
+  common_config->add_initializers("fill_constant&1.0");
+  if (optimizer == "sgd") {
+    common_config->add_params("LearningRate");
+    common_config->add_dims(1);
+    common_config->add_initializers("fill_constant&" + std::to_string(lr));
+  }
+  EXPECT_EQ(table->initialize(table_config, fs_config), 0);
+  return table;
+}
+
+// push the gradients of the trainers concurrently, the k-th push of the
+// trainer i is grads[i * push_num + k], and wait until they are applied
+static void PushConcurrently(Table *table, int trainers, int push_num,
+                             const std::vector<std::vector<float>> &grads) {
+  std::vector<std::thread> threads;
+  for (int i = 0; i < trainers; i++) {
+    threads.emplace_back([=, &grads] {
+      std::vector<float> pull_values(grads[0].size());
+      for (int k = 0; k < push_num; ++k) {
+        auto &grad = grads[i * push_num + k];
+        table->push_dense(grad.data(), grad.size());
+        table->pull_dense(pull_values.data(), pull_values.size());
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  table->flush();
+}
+
+// The merged pushes give the same parameters as the pushes applied one by
+// one, for every optimizer whose pushes are merged. The gradients are
+// multiples of 0.5 and the learning rate is 0.5, so that the sums are exact
+// in any order.
+TEST(CommonDenseTable, MergePush) {
+  int fea_dim = 1000;
+  int trainers = 8;
+  int push_num = 20;
+  float lr = 0.5;
+
+  std::vector<std::vector<float>> grads(trainers * push_num);
+  for (size_t i = 0; i < grads.size(); ++i) {
+    grads[i].resize(fea_dim);
+    for (int j = 0; j < fea_dim; ++j) {
+      grads[i][j] = static_cast<int>((i * 7 + j) % 9) * 0.5 - 2.0;
+    }
+  }
+
+  for (std::string optimizer : {"sgd", "sum"}) {
+    FLAGS_pserver_merge_dense_push = false;
+    Table *table = CreateLinearTable(optimizer, fea_dim, lr);
+    ASSERT_FALSE(dynamic_cast<CommonDenseTable *>(table)->is_merge_push());
+    PushConcurrently(table, trainers, push_num, grads);
+    std::vector<float> expected(fea_dim);
+    table->pull_dense(expected.data(), fea_dim);
+    delete table;
+
+    FLAGS_pserver_merge_dense_push = true;
+    table = CreateLinearTable(optimizer, fea_dim, lr);
+    FLAGS_pserver_merge_dense_push = false;
+    auto *dense_table = dynamic_cast<CommonDenseTable *>(table);
+    ASSERT_TRUE(dense_table->is_merge_push());
+    PushConcurrently(table, trainers, push_num, grads);
+    auto stats = dense_table->merge_push_stats();
+    ASSERT_EQ(stats.push_num, trainers * push_num);
+    ASSERT_EQ(stats.staleness, 0);
+    std::vector<float> merged(fea_dim);
+    table->pull_dense(merged.data(), fea_dim);
+    delete table;
+
+    for (int j = 0; j < fea_dim; j++) {
+      ASSERT_FLOAT_EQ(expected[j], merged[j]) << optimizer << " at " << j;
+    }
+  }
+}
+
 }  // namespace distributed
 }  // namespace paddle
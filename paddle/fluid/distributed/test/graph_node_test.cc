@@ -223,6 +223,100 @@ void testBatchSampleNeighboor(
   }
 }
 
+void testSampleSubgraph(
+    std::shared_ptr<paddle::distributed::GraphBrpcClient>& worker_ptr_) {
+  paddle::distributed::GraphSampledSubgraph subgraph;
+  auto pull_status =
+      worker_ptr_->sample_subgraph(0, {37, 96, 37}, {4, 2}, {}, subgraph);
+  pull_status.wait();
+  ASSERT_EQ(0, pull_status.get());
+  ASSERT_EQ(2, subgraph.hop_num());
+  // the duplicated seed is kept once, and the items have no out edges
+  ASSERT_EQ(8, subgraph.node_num());
+  ASSERT_EQ(std::vector<int64_t>({0, 2, 8, 8}), subgraph.hop_offsets);
+  ASSERT_EQ(37, subgraph.node_ids[0]);
+  ASSERT_EQ(96, subgraph.node_ids[1]);
+  ASSERT_EQ(9, subgraph.row_ptr.size());
+  ASSERT_EQ(6, subgraph.col.size());
+  std::vector<std::unordered_set<uint64_t>> expected = {{112, 45, 145},
+                                                        {111, 48, 247}};
+  for (size_t i = 0; i < 2; ++i) {
+    ASSERT_EQ(3, subgraph.row_ptr[i + 1] - subgraph.row_ptr[i]);
+    for (auto j = subgraph.row_ptr[i]; j < subgraph.row_ptr[i + 1]; ++j) {
+      auto id = subgraph.node_ids[subgraph.col[j]];
+      ASSERT_TRUE(expected[i].find(id) != expected[i].end());
+    }
+  }
+
+  // the seeds on both servers, served by one of them
+  pull_status = worker_ptr_->sample_subgraph(0, {59, 97, 37}, {2}, {},
+                                             subgraph, 1);
+  pull_status.wait();
+  ASSERT_EQ(0, pull_status.get());
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(2, subgraph.row_ptr[i + 1] - subgraph.row_ptr[i]);
+  }
+
+  // the seeds of both servers, sampled by hops
+  std::vector<uint64_t> seeds = {37, 96, 59, 97};
+  pull_status = worker_ptr_->sample_subgraph(0, seeds, {4, 2}, {}, subgraph);
+  pull_status.wait();
+  ASSERT_EQ(0, pull_status.get());
+  ASSERT_EQ(11, subgraph.node_num());
+  ASSERT_TRUE(subgraph.features.empty());
+}
+
+// the features of the nodes are returned with the subgraph, the items get
+// "a" = id / 2 in float32 and "b" = [id, id + 1] in int32, the users have no
+// feature in the table
+void testSampleSubgraphFeatures(
+    std::shared_ptr<paddle::distributed::GraphBrpcClient>& worker_ptr_) {
+  std::vector<uint64_t> items = {45, 145, 112, 48, 247, 111};
+  std::vector<std::vector<std::string>> features(2);
+  for (auto id : items) {
+    float a = id / 2.0f;
+    int32_t b[2] = {static_cast<int32_t>(id), static_cast<int32_t>(id + 1)};
+    features[0].emplace_back(reinterpret_cast<const char*>(&a), sizeof(a));
+    features[1].emplace_back(reinterpret_cast<const char*>(b), sizeof(b));
+  }
+  auto status = worker_ptr_->set_node_feat(0, items, {"a", "b"}, features);
+  status.wait();
+  ASSERT_EQ(0, status.get());
+
+  paddle::distributed::GraphSampledSubgraph subgraph;
+  status = worker_ptr_->sample_subgraph(0, {37, 96}, {4}, {"a", "b", "c"},
+                                        subgraph);
+  status.wait();
+  ASSERT_EQ(0, status.get());
+  ASSERT_EQ(8, subgraph.node_num());
+  ASSERT_EQ(3, subgraph.features.size());
+  auto& float_feat = subgraph.features[0];
+  auto& int_feat = subgraph.features[1];
+  ASSERT_EQ("a", float_feat.name);
+  ASSERT_EQ("float32", float_feat.dtype);
+  ASSERT_EQ("b", int_feat.name);
+  ASSERT_EQ("int32", int_feat.dtype);
+  for (auto& feat : subgraph.features) {
+    ASSERT_EQ(subgraph.node_num() + 1, feat.offsets.size());
+  }
+  // the feature not in the table config has no bytes for any node
+  ASSERT_TRUE(subgraph.features[2].data.empty());
+  for (size_t i = 0; i < subgraph.node_num(); ++i) {
+    auto id = subgraph.node_ids[i];
+    auto a = float_feat.get_values<float>(i);
+    auto b = int_feat.get_values<int32_t>(i);
+    if (i < 2) {
+      ASSERT_TRUE(a.empty());
+      ASSERT_TRUE(b.empty());
+      continue;
+    }
+    ASSERT_EQ(std::vector<float>({id / 2.0f}), a);
+    ASSERT_EQ(std::vector<int32_t>({static_cast<int32_t>(id),
+                                    static_cast<int32_t>(id + 1)}),
+              b);
+  }
+}
+
 void testCache();
 void testGraphToBuffer();
 
@@ -277,6 +371,14 @@ void GetDownpourSparseTableProto(
   ::paddle::distributed::TableAccessorParameter* accessor_proto =
       sparse_table_proto->mutable_accessor();
   accessor_proto->set_accessor_class("CommMergeAccessor");
+  ::paddle::distributed::CommonAccessorParameter* common_proto =
+      sparse_table_proto->mutable_common();
+  common_proto->add_attributes("a");
+  common_proto->add_params("float32");
+  common_proto->add_dims(1);
+  common_proto->add_attributes("b");
+  common_proto->add_params("int32");
+  common_proto->add_dims(2);
 }
 
 ::paddle::distributed::PSParameter GetServerProto() {
@@ -433,6 +535,7 @@ void RunBrpcPushSparse() {
   sleep(5);
   testSingleSampleNeighboor(worker_ptr_);
   testBatchSampleNeighboor(worker_ptr_);
+  testSampleSubgraph(worker_ptr_);
   pull_status = worker_ptr_->batch_sample_neighbors(
       0, std::vector<uint64_t>(1, 10240001024), 4, _vs, vs, true);
   pull_status.wait();
@@ -620,6 +723,8 @@ void RunBrpcPushSparse() {
 
   std::remove(edge_file_name);
   std::remove(node_file_name);
+  // adds the items to the table, so it is run before testAddNode clears it
+  testSampleSubgraphFeatures(worker_ptr_);
   testAddNode(worker_ptr_);
   LOG(INFO) << "Run stop_server";
   worker_ptr_->stop_server();
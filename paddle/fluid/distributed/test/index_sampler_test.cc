@@ -0,0 +1,163 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/index_dataset/index_sampler.h"
+#include "paddle/fluid/distributed/index_dataset/index_wrapper.h"
+
+DECLARE_int32(layerwise_sample_thread_num);
+
+namespace paddle {
+namespace distributed {
+
+static void WriteKV(FILE* fp, const std::string& key,
+                    const std::string& value) {
+  KVItem item;
+  item.set_key(key);
+  item.set_value(value);
+  std::string content;
+  item.SerializeToString(&content);
+  int num = content.size();
+  fwrite(&num, sizeof(num), 1, fp);
+  fwrite(content.data(), 1, num, fp);
+}
+
+// Writes a complete binary tree whose leaf ids start from `leaf_id_base`.
+static void GenerateTree(const std::string& path, int height,
+                         uint64_t leaf_id_base) {
+  FILE* fp = fopen(path.c_str(), "wb");
+  ASSERT_NE(fp, nullptr);
+  TreeMeta meta;
+  meta.set_height(height);
+  meta.set_branch(2);
+  WriteKV(fp, ".tree_meta", meta.SerializeAsString());
+
+  uint64_t leaf_start = (1ULL << (height - 1)) - 1;
+  uint64_t code_num = (1ULL << height) - 1;
+  for (uint64_t code = 0; code < code_num; ++code) {
+    IndexNode node;
+    bool is_leaf = code >= leaf_start;
+    node.set_id(is_leaf ? leaf_id_base + code - leaf_start : code + 1);
+    node.set_is_leaf(is_leaf);
+    node.set_probability(1.0);
+    WriteKV(fp, std::to_string(code), node.SerializeAsString());
+  }
+  fclose(fp);
+}
+
+TEST(TreeIndex, FlatLookup) {
+  const int height = 6;
+  const uint64_t leaf_id_base = 1000;
+  std::string path = "./flat_lookup_tree.pb";
+  GenerateTree(path, height, leaf_id_base);
+
+  auto wrapper = IndexWrapper::GetInstance();
+  wrapper->insert_tree_index("flat_lookup", path);
+  auto tree = wrapper->get_tree_index("flat_lookup");
+  remove(path.c_str());
+
+  ASSERT_EQ(tree->TotalNodeNums(), (1ULL << height) - 1);
+  for (int level = 0; level < height; ++level) {
+    auto codes = tree->GetLayerCodes(level);
+    auto nodes = tree->GetNodes(codes);
+    auto& ids = tree->GetLayerIds(level);
+    ASSERT_EQ(ids.size(), nodes.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+      ASSERT_EQ(ids[i], nodes[i].id());
+    }
+  }
+
+  std::vector<uint64_t> leaf_ids;
+  for (uint64_t i = 0; i < (1ULL << (height - 1)); ++i) {
+    leaf_ids.push_back(leaf_id_base + i);
+  }
+  for (int level = 0; level < height; ++level) {
+    auto ancestors = tree->GetAncestorCodes(leaf_ids, level);
+    for (size_t i = 0; i < leaf_ids.size(); ++i) {
+      auto travel = tree->GetTravelCodes(leaf_ids[i], level);
+      ASSERT_EQ(ancestors[i], travel.back());
+    }
+  }
+  // unknown ids map to the invalid code
+  auto invalid = tree->GetAncestorCodes({1}, 2);
+  ASSERT_FALSE(tree->CheckIsValid(invalid[0]));
+  ASSERT_EQ(tree->GetIdByCode(invalid[0]), 0UL);
+}
+
+TEST(LayerWiseSampler, ParallelSample) {
+  const int height = 16;
+  const uint64_t leaf_id_base = 1ULL << 20;
+  std::string path = "./layerwise_sampler_tree.pb";
+  GenerateTree(path, height, leaf_id_base);
+  IndexWrapper::GetInstance()->insert_tree_index("layerwise", path);
+  remove(path.c_str());
+
+  auto sampler = IndexSampler::Init<LayerWiseSampler>("layerwise");
+  std::vector<uint16_t> layer_sample_counts(height - 1, 5);
+  sampler->init_layerwise_conf(layer_sample_counts, 1, 1);
+  auto tree = IndexWrapper::GetInstance()->get_tree_index("layerwise");
+
+  const size_t batch = 1 << 15;
+  const size_t user_feature_num = 4;
+  std::vector<uint64_t> targets(batch);
+  std::vector<std::vector<uint64_t>> users(
+      batch, std::vector<uint64_t>(user_feature_num));
+  uint64_t leaf_num = 1ULL << (height - 1);
+  for (size_t i = 0; i < batch; ++i) {
+    targets[i] = leaf_id_base + (i * 7919) % leaf_num;
+    for (size_t k = 0; k < user_feature_num; ++k) {
+      users[i][k] = leaf_id_base + (i * 31 + k) % leaf_num;
+    }
+  }
+
+  // the same seed gives the same samples for any number of threads
+  FLAGS_layerwise_sample_thread_num = 1;
+  auto expected = sampler->sample(users, targets, true);
+  for (int thread_num : {3, 8}) {
+    FLAGS_layerwise_sample_thread_num = thread_num;
+    auto outputs = sampler->sample(users, targets, true);
+    ASSERT_EQ(outputs, expected);
+
+    size_t rows_per_target = outputs.size() / batch;
+    ASSERT_EQ(rows_per_target, static_cast<size_t>(6 * (height - 1)));
+    for (size_t i = 0; i < batch; i += 997) {
+      auto travel = tree->GetNodes(tree->GetTravelCodes(targets[i], 1));
+      size_t row = i * rows_per_target;
+      for (size_t j = 0; j < travel.size(); ++j) {
+        auto user_codes =
+            tree->GetAncestorCodes(users[i], height - 1 - static_cast<int>(j));
+        auto user_nodes = tree->GetNodes(user_codes);
+        for (size_t r = 0; r < 6; ++r, ++row) {
+          for (size_t k = 0; k < user_feature_num; ++k) {
+            ASSERT_EQ(outputs[row][k], user_nodes[k].id());
+          }
+          if (r == 0) {
+            ASSERT_EQ(outputs[row][user_feature_num], travel[j].id());
+            ASSERT_EQ(outputs[row][user_feature_num + 1], 1UL);
+          } else {
+            ASSERT_NE(outputs[row][user_feature_num], travel[j].id());
+            ASSERT_EQ(outputs[row][user_feature_num + 1], 0UL);
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
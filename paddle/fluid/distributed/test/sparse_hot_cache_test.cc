@@ -0,0 +1,216 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <mutex>  // NOLINT
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_hot_cache.h"
+
+namespace paddle {
+namespace distributed {
+
+static const int kDim = 4;
+static const int kPushDim = kDim + 3;
+static const float kLearningRate = 0.1;
+
+// In-process stand-in of a pserver sparse table with plain sgd.
+class LocalSparseTable {
+ public:
+  int32_t Pull(const uint64_t* keys, float** values, size_t num) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    ++pull_calls;
+    pulled_keys += num;
+    for (size_t i = 0; i < num; ++i) {
+      auto& row = Row(keys[i]);
+      std::copy(row.begin(), row.end(), values[i]);
+    }
+    return 0;
+  }
+
+  int32_t Push(const uint64_t* keys, const float** values, size_t num) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    pushed_keys += num;
+    for (size_t i = 0; i < num; ++i) {
+      auto& row = Row(keys[i]);
+      for (int j = 0; j < kDim; ++j) {
+        row[j] -= kLearningRate * values[i][3 + j];
+      }
+    }
+    return 0;
+  }
+
+  std::vector<float>& Row(uint64_t key) {
+    auto iter = rows_.find(key);
+    if (iter == rows_.end()) {
+      iter = rows_.emplace(key, std::vector<float>(kDim, key * 0.01f)).first;
+    }
+    return iter->second;
+  }
+
+  int64_t pull_calls = 0;
+  int64_t pulled_keys = 0;
+  int64_t pushed_keys = 0;
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<uint64_t, std::vector<float>> rows_;
+};
+
+static std::unique_ptr<SparseHotCache> MakeCache(LocalSparseTable* table,
+                                                 size_t capacity,
+                                                 int64_t refresh_steps,
+                                                 int64_t push_steps) {
+  return std::unique_ptr<SparseHotCache>(new SparseHotCache(
+      capacity, kDim, kPushDim, refresh_steps, push_steps,
+      [table](const uint64_t* keys, float** values, size_t num) {
+        return table->Pull(keys, values, num);
+      },
+      [table](const uint64_t* keys, const float** values, size_t num) {
+        return table->Push(keys, values, num);
+      }));
+}
+
+static void PullBatch(SparseHotCache* cache, const std::vector<uint64_t>& keys,
+                      std::vector<float>* out) {
+  out->resize(keys.size() * kDim);
+  std::vector<float*> values(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) values[i] = out->data() + i * kDim;
+  ASSERT_EQ(cache->Pull(keys.data(), values.data(), keys.size()), 0);
+}
+
+static void PushBatch(SparseHotCache* cache, const std::vector<uint64_t>& keys,
+                      float grad) {
+  std::vector<float> grads(keys.size() * kPushDim, grad);
+  std::vector<const float*> values(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    grads[i * kPushDim] = 2;  // slot
+    values[i] = grads.data() + i * kPushDim;
+  }
+  ASSERT_EQ(cache->Push(keys.data(), values.data(), keys.size()), 0);
+}
+
+TEST(SparseHotCache, MergeAndRefresh) {
+  LocalSparseTable table;
+  auto cache = MakeCache(&table, 2, 4, 1000);
+  std::vector<float> out;
+  // ids 1 and 2 are hot, 100 + step are cold
+  for (uint64_t step = 0; step < 3; ++step) {
+    PullBatch(cache.get(), {1, 1, 2, 2, 1, 100 + step}, &out);
+  }
+  // the 4th step refreshes, 1 and 2 become replicas
+  PullBatch(cache.get(), {1, 2, 200}, &out);
+  ASSERT_EQ(cache->HotRows(), 2UL);
+  auto stats = cache->Stats();
+  ASSERT_EQ(stats.hits, 2);
+  ASSERT_FLOAT_EQ(out[0], 0.01f);
+  ASSERT_FLOAT_EQ(out[kDim], 0.02f);
+
+  // hot grads are merged, cold grads go through right away
+  int64_t pushed = table.pushed_keys;
+  PushBatch(cache.get(), {1, 1, 2, 200}, 1.0);
+  PushBatch(cache.get(), {1, 2}, 1.0);
+  ASSERT_EQ(table.pushed_keys, pushed + 1);
+  ASSERT_EQ(cache->FlushPush(), 0);
+  ASSERT_EQ(table.pushed_keys, pushed + 3);
+  ASSERT_EQ(cache->Stats().push_bytes_saved,
+            static_cast<int64_t>(3 * kPushDim * sizeof(float)));
+  // 3 grads of 1.0 merged for id 1
+  ASSERT_FLOAT_EQ(table.Row(1)[0], 0.01f - kLearningRate * 3);
+
+  // replicas are stale until the next refresh or version bump
+  PullBatch(cache.get(), {1}, &out);
+  ASSERT_FLOAT_EQ(out[0], 0.01f);
+  cache->BumpVersion();
+  PullBatch(cache.get(), {1}, &out);
+  ASSERT_FLOAT_EQ(out[0], 0.01f - kLearningRate * 3);
+  ASSERT_EQ(cache->Stats().staleness, 0);
+}
+
+TEST(SparseHotCache, BoundedFrequencies) {
+  LocalSparseTable table;
+  auto cache = MakeCache(&table, 4, 10, 1000);
+  std::vector<float> out;
+  uint64_t cold_id = 1000;
+  for (int step = 0; step < 200; ++step) {
+    std::vector<uint64_t> keys;
+    for (int i = 0; i < 8; ++i) keys.insert(keys.end(), {1, 2, 3, 4});
+    // every id after the hot ones is seen only once
+    for (int i = 0; i < 100; ++i) keys.push_back(cold_id++);
+    PullBatch(cache.get(), keys, &out);
+  }
+  // 16 shards of at most 64 ids, far below the 20000 ids seen
+  ASSERT_LE(cache->FreqRows(), 16UL * 64);
+  ASSERT_EQ(cache->HotRows(), 4UL);
+  int64_t hits = cache->Stats().hits;
+  PullBatch(cache.get(), {1, 2, 3, 4}, &out);
+  ASSERT_EQ(cache->Stats().hits, hits + 4);
+}
+
+TEST(SparseHotCache, SkewedTraffic) {
+  const int steps = 200;
+  const int batch = 1024;
+  const int64_t refresh_steps = 20;
+  LocalSparseTable table;
+  LocalSparseTable baseline;
+  auto cache = MakeCache(&table, 1000, refresh_steps, 5);
+
+  std::mt19937_64 engine(0);
+  // roughly zipf, a few hundred ids take most of the lookups
+  std::exponential_distribution<double> dist(1.0 / 200);
+  std::vector<float> out;
+  std::vector<float> expect(batch * kDim);
+  int64_t max_staleness = 0;
+  for (int step = 0; step < steps; ++step) {
+    std::vector<uint64_t> keys(batch);
+    for (auto& key : keys) key = static_cast<uint64_t>(dist(engine)) + 1;
+    PullBatch(cache.get(), keys, &out);
+    PushBatch(cache.get(), keys, 0.001);
+
+    std::vector<float*> values(batch);
+    for (int i = 0; i < batch; ++i) values[i] = expect.data() + i * kDim;
+    baseline.Pull(keys.data(), values.data(), batch);
+    std::vector<float> grads(batch * kPushDim, 0.001);
+    std::vector<const float*> grad_ptrs(batch);
+    for (int i = 0; i < batch; ++i) grad_ptrs[i] = grads.data() + i * kPushDim;
+    baseline.Push(keys.data(), grad_ptrs.data(), batch);
+
+    // a replica never lags behind the table by more than the pending steps
+    auto stats = cache->Stats();
+    max_staleness = std::max(max_staleness, stats.staleness);
+    for (int i = 0; i < batch * kDim; ++i) {
+      ASSERT_NEAR(out[i], expect[i],
+                  kLearningRate * 0.001 * batch * refresh_steps);
+    }
+  }
+  cache->FlushPush();
+
+  auto stats = cache->Stats();
+  ASSERT_GT(stats.HitRate(), 0.5);
+  ASSERT_LT(max_staleness, refresh_steps);
+  ASSERT_LT(table.pulled_keys, baseline.pulled_keys);
+  ASSERT_LT(table.pushed_keys, baseline.pushed_keys);
+  LOG(INFO) << "hit rate " << stats.HitRate() << ", max staleness "
+            << max_staleness << " steps, pulled keys " << table.pulled_keys
+            << " vs " << baseline.pulled_keys << ", pushed keys "
+            << table.pushed_keys << " vs " << baseline.pushed_keys
+            << ", saved " << stats.pull_bytes_saved << " pull bytes and "
+            << stats.push_bytes_saved << " push bytes";
+}
+
+}  // namespace distributed
+}  // namespace paddle
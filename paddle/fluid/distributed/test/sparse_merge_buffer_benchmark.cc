@@ -0,0 +1,152 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_merge_buffer.h"
+#include "paddle/fluid/operators/math/selected_rows_functor.h"
+
+DEFINE_int32(trainer_num, 8, "The number of the pushing threads.");
+DEFINE_int32(push_per_trainer, 200, "The pushes of every thread.");
+DEFINE_int32(batch_ids, 2048, "The ids of every push.");
+DEFINE_int32(width, 16, "The width of the sparse grad.");
+DEFINE_int64(id_range, 1 << 18, "The ids are drawn from [0, id_range).");
+DEFINE_int64(max_rows, 1 << 16, "The max pending rows of the buffer.");
+
+namespace paddle {
+namespace distributed {
+
+static int64_t GetRSSKB() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmRSS:") == 0) {
+      return std::stoll(line.substr(6));
+    }
+  }
+  return 0;
+}
+
+static void FillPush(std::mt19937_64* engine, pten::SelectedRows* slr) {
+  // skewed ids, most pushes hit a small hot set
+  std::exponential_distribution<double> dist(8.0 / FLAGS_id_range);
+  auto* rows = slr->mutable_rows();
+  rows->clear();
+  for (int64_t i = 0; i < FLAGS_batch_ids; ++i) {
+    rows->push_back(static_cast<int64_t>(dist(*engine)) % FLAGS_id_range);
+  }
+  slr->set_height(FLAGS_id_range);
+  int64_t numel = static_cast<int64_t>(FLAGS_batch_ids) * FLAGS_width;
+  float* data = slr->mutable_value()->mutable_data<float>(
+      {FLAGS_batch_ids, FLAGS_width}, platform::CPUPlace());
+  std::fill(data, data + numel, 1.0f);
+}
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Merge on enqueue, the send thread drains slower than the trainers push.
+static void BenchMergeOnEnqueue() {
+  SparseMergeBuffer buffer(FLAGS_max_rows);
+  std::atomic<bool> stop{false};
+  int64_t rss_before = GetRSSKB();
+  int64_t rss_peak = rss_before;
+  std::thread sender([&] {
+    pten::SelectedRows out;
+    while (true) {
+      bool last = stop.load();
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      buffer.SwapAndExport(&out);
+      rss_peak = std::max(rss_peak, GetRSSKB());
+      if (last) break;
+    }
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> trainers;
+  for (int t = 0; t < FLAGS_trainer_num; ++t) {
+    trainers.emplace_back([&buffer, t] {
+      std::mt19937_64 engine(t);
+      pten::SelectedRows push;
+      for (int i = 0; i < FLAGS_push_per_trainer; ++i) {
+        FillPush(&engine, &push);
+        buffer.Add(push);
+      }
+    });
+  }
+  for (auto& t : trainers) t.join();
+  double seconds = Seconds(start);
+  stop = true;
+  sender.join();
+  LOG(INFO) << "merge on enqueue: "
+            << FLAGS_trainer_num * FLAGS_push_per_trainer / seconds
+            << " pushes/sec, rss growth " << rss_peak - rss_before << " KB";
+}
+
+// Queued copies merged afterwards, as AsyncCommunicator does by default.
+static void BenchQueueThenMerge() {
+  int64_t rss_before = GetRSSKB();
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::vector<pten::SelectedRows>> queues(FLAGS_trainer_num);
+  std::vector<std::thread> trainers;
+  for (int t = 0; t < FLAGS_trainer_num; ++t) {
+    trainers.emplace_back([&queues, t] {
+      std::mt19937_64 engine(t);
+      queues[t].resize(FLAGS_push_per_trainer);
+      for (int i = 0; i < FLAGS_push_per_trainer; ++i) {
+        FillPush(&engine, &queues[t][i]);
+      }
+    });
+  }
+  for (auto& t : trainers) t.join();
+  int64_t rss_peak = GetRSSKB();
+  std::vector<const pten::SelectedRows*> inputs;
+  for (auto& queue : queues) {
+    for (auto& slr : queue) inputs.push_back(&slr);
+  }
+  pten::SelectedRows merged;
+  platform::CPUDeviceContext dev_ctx;
+  operators::math::scatter::MergeAdd<platform::CPUDeviceContext, float>
+      merge_add;
+  merge_add(dev_ctx, inputs, &merged);
+  double seconds = Seconds(start);
+  LOG(INFO) << "queue then merge: "
+            << FLAGS_trainer_num * FLAGS_push_per_trainer / seconds
+            << " pushes/sec, rss growth " << rss_peak - rss_before << " KB";
+}
+
+}  // namespace distributed
+}  // namespace paddle
+
+// Compares SparseMergeBuffer with queueing the sparse grads and merging
+// them afterwards, run command: ./sparse_merge_buffer_benchmark [options...]
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::distributed::BenchMergeOnEnqueue();
+  paddle::distributed::BenchQueueThenMerge();
+  return 0;
+}
@@ -0,0 +1,126 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <random>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/communicator/sparse_merge_buffer.h"
+
+namespace paddle {
+namespace distributed {
+
+static const int64_t kWidth = 16;
+static const int64_t kIdRange = 1 << 18;
+static const int64_t kBatchIds = 2048;
+
+static void FillPush(std::mt19937_64* engine, pten::SelectedRows* slr) {
+  // skewed ids, most pushes hit a small hot set
+  std::exponential_distribution<double> dist(8.0 / kIdRange);
+  auto* rows = slr->mutable_rows();
+  rows->clear();
+  for (int64_t i = 0; i < kBatchIds; ++i) {
+    rows->push_back(static_cast<int64_t>(dist(*engine)) % kIdRange);
+  }
+  slr->set_height(kIdRange);
+  float* data = slr->mutable_value()->mutable_data<float>(
+      {kBatchIds, kWidth}, platform::CPUPlace());
+  std::fill(data, data + kBatchIds * kWidth, 1.0f);
+}
+
+TEST(SparseMergeBuffer, MergeOnEnqueue) {
+  SparseMergeBuffer buffer(0, 4);
+  pten::SelectedRows push;
+  push.mutable_rows()->push_back(3);
+  push.mutable_rows()->push_back(7);
+  push.mutable_rows()->push_back(3);
+  float* data = push.mutable_value()->mutable_data<float>(
+      {3, 2}, platform::CPUPlace());
+  for (int i = 0; i < 6; ++i) data[i] = i;
+  buffer.Add(push);
+  buffer.Add(push);
+  ASSERT_EQ(buffer.PendingPushes(), 2);
+  ASSERT_EQ(buffer.PendingRows(), 2UL);
+
+  pten::SelectedRows out;
+  ASSERT_EQ(buffer.SwapAndExport(&out), 2);
+  ASSERT_EQ(out.rows().size(), 2UL);
+  std::unordered_map<int64_t, std::vector<float>> merged;
+  for (size_t i = 0; i < out.rows().size(); ++i) {
+    const float* row = out.value().data<float>() + i * 2;
+    merged[out.rows()[i]] = {row[0], row[1]};
+  }
+  ASSERT_FLOAT_EQ(merged[3][0], 2 * (0 + 4));
+  ASSERT_FLOAT_EQ(merged[3][1], 2 * (1 + 5));
+  ASSERT_FLOAT_EQ(merged[7][0], 2 * 2);
+  ASSERT_FLOAT_EQ(merged[7][1], 2 * 3);
+  ASSERT_EQ(buffer.PendingPushes(), 0);
+  ASSERT_EQ(buffer.PendingRows(), 0UL);
+}
+
+TEST(SparseMergeBuffer, ConcurrentPushes) {
+  const int trainer_num = 4;
+  const int push_per_trainer = 50;
+  const size_t max_rows = 1 << 12;
+
+  // the send thread drains while the trainers push, and the trainers block
+  // when max_rows distinct rows are pending
+  SparseMergeBuffer buffer(max_rows);
+  std::atomic<bool> stop{false};
+  int64_t merged_pushes = 0;
+  double merged_sum = 0;
+  std::thread sender([&] {
+    pten::SelectedRows out;
+    while (true) {
+      bool last = stop.load();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      merged_pushes += buffer.SwapAndExport(&out);
+      EXPECT_LE(out.rows().size(), max_rows);
+      if (out.rows().size() > 0) {
+        const float* data = out.value().data<float>();
+        for (int64_t i = 0; i < out.value().numel(); ++i) {
+          merged_sum += data[i];
+        }
+      }
+      if (last) break;
+    }
+  });
+
+  std::vector<std::thread> trainers;
+  for (int t = 0; t < trainer_num; ++t) {
+    trainers.emplace_back([&, t] {
+      std::mt19937_64 engine(t);
+      pten::SelectedRows push;
+      for (int i = 0; i < push_per_trainer; ++i) {
+        FillPush(&engine, &push);
+        buffer.Add(push);
+      }
+    });
+  }
+  for (auto& t : trainers) t.join();
+  stop = true;
+  sender.join();
+
+  int64_t total_pushes = trainer_num * push_per_trainer;
+  ASSERT_EQ(merged_pushes, total_pushes);
+  ASSERT_DOUBLE_EQ(merged_sum,
+                   static_cast<double>(total_pushes * kBatchIds * kWidth));
+}
+
+}  // namespace distributed
+}  // namespace paddle
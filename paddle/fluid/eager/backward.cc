@@ -13,18 +13,31 @@
 // limitations under the License.
 
 #include "paddle/fluid/eager/backward.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <exception>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
 #include <queue>
+#include <tuple>
 
+#include "paddle/fluid/eager/api/utils/global_utils.h"
 #include "paddle/fluid/eager/autograd_meta.h"
 #include "paddle/fluid/eager/grad_node_info.h"
 #include "paddle/fluid/eager/grad_tensor_holder.h"
 #include "paddle/fluid/eager/utils.h"
 
+#include "paddle/fluid/framework/threadpool.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/errors.h"
 
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 
+DECLARE_int32(eager_backward_num_threads);
+
 namespace egr {
 
 std::unordered_map<GradNodeBase*, int> getInDegreeMap(
@@ -71,6 +84,272 @@ std::unordered_map<GradNodeBase*, int> getInDegreeMap(
   return node_in_degree_map;
 }
 
+// The order in which the serial loop of RunBackward visits the nodes, when
+// every edge carries a grad. It is a Kahn's traversal of the graph which
+// does not run any node.
+static std::unordered_map<GradNodeBase*, int64_t> getSerialOrderMap(
+    const std::queue<GradNodeBase*>& init_queue,
+    std::unordered_map<GradNodeBase*, int> node_in_degree_map) {
+  std::unordered_map<GradNodeBase*, int64_t> order;
+  std::queue<GradNodeBase*> queue = init_queue;
+  while (!queue.empty()) {
+    GradNodeBase* node = queue.front();
+    queue.pop();
+    order.emplace(node, static_cast<int64_t>(order.size()));
+    for (const auto& edge_list : node->GetEdges()) {
+      for (const Edge& edge : edge_list) {
+        GradNodeBase* next_node = edge.GetMutableGradNode().get();
+        if (!next_node) continue;
+        if (--node_in_degree_map[next_node] == 0) queue.push(next_node);
+      }
+    }
+  }
+  return order;
+}
+
+/*
+ * ParallelBackwardExecutor runs the independent branches of the backward
+ * graph at the same time on CPU. Every worker owns a deque of ready nodes.
+ * It pushes the nodes it makes ready to the back of its own deque and pops
+ * from there, and steals from the front of the others when it runs out.
+ *
+ * The state of a node for this run, i.e. its remaining in-degree and the
+ * grads it received, lives in a map built before the run and never changed
+ * during it, so the workers read it without a lock. The grads of a node are
+ * summed when it becomes ready, in the order the serial loop would add them,
+ * which keeps the results the same as the serial loop to the last bit.
+ */
+class ParallelBackwardExecutor {
+ public:
+  ParallelBackwardExecutor(
+      int num_workers, const std::queue<GradNodeBase*>& init_queue,
+      std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+          node_input_buffers_dict,
+      const std::unordered_map<GradNodeBase*, int>& node_in_degree_map)
+      : queues_(num_workers) {
+    auto order = getSerialOrderMap(init_queue, node_in_degree_map);
+    for (auto& item : order) {
+      auto state = std::make_unique<NodeState>();
+      state->order = item.second;
+      auto in_degree = node_in_degree_map.find(item.first);
+      if (in_degree != node_in_degree_map.end()) {
+        state->in_degree = in_degree->second;
+      }
+      auto buffer = node_input_buffers_dict->find(item.first);
+      if (buffer != node_input_buffers_dict->end()) {
+        state->buffer = std::move(buffer->second);
+      }
+      states_.emplace(item.first, std::move(state));
+    }
+    std::queue<GradNodeBase*> queue = init_queue;
+    while (!queue.empty()) {
+      queues_[0].nodes.push_back(queue.front());
+      queue.pop();
+      ++outstanding_;
+    }
+  }
+
+  void Run() {
+    if (outstanding_ == 0) return;
+    // The workers run the nodes with the grad mode and amp level of the
+    // calling thread, which are thread local.
+    bool has_grad = Controller::Instance().HasGrad();
+    auto amp_level = Controller::Instance().GetAMPLevel();
+    std::vector<std::future<void>> helpers;
+    // held until the helpers finish, even if another run resizes the pool
+    std::shared_ptr<paddle::framework::ThreadPool> pool;
+    if (queues_.size() > 1) pool = Pool(queues_.size() - 1);
+    for (size_t i = 1; i < queues_.size(); ++i) {
+      helpers.emplace_back(pool->Run([=]() {
+        Controller::Instance().SetHasGrad(has_grad);
+        Controller::Instance().SetAMPLevel(amp_level);
+        Work(i);
+      }));
+    }
+    Work(0);
+    for (auto& helper : helpers) helper.wait();
+    if (exception_) std::rethrow_exception(exception_);
+  }
+
+ private:
+  struct NodeState {
+    int64_t order{0};
+    std::atomic<int> in_degree{0};
+    std::mutex mutex;
+    std::unique_ptr<GradTensorHolder> buffer;
+    // (order of the producer, slot of the producer output, rank in the slot,
+    //  slot of this node, rank in the slot, grad)
+    std::vector<std::tuple<int64_t, size_t, size_t, size_t, size_t,
+                           paddle::experimental::Tensor>>
+        grads;
+  };
+
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<GradNodeBase*> nodes;
+  };
+
+  // A new pool replaces the shared one when the number of threads changes.
+  // The runs still holding the old one keep it alive until they finish.
+  static std::shared_ptr<paddle::framework::ThreadPool> Pool(
+      size_t num_threads) {
+    static std::mutex mutex;
+    static std::shared_ptr<paddle::framework::ThreadPool> pool;
+    static size_t pool_size = 0;
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!pool || pool_size != num_threads) {
+      pool = std::make_shared<paddle::framework::ThreadPool>(num_threads);
+      pool_size = num_threads;
+    }
+    return pool;
+  }
+
+  void Push(size_t worker, GradNodeBase* node) {
+    {
+      std::lock_guard<std::mutex> guard(queues_[worker].mutex);
+      queues_[worker].nodes.push_back(node);
+    }
+    ++outstanding_;
+    ++queued_;
+    { std::lock_guard<std::mutex> guard(wait_mutex_); }
+    ready_.notify_one();
+  }
+
+  GradNodeBase* Pop(size_t worker) {
+    {
+      auto& own = queues_[worker];
+      std::lock_guard<std::mutex> guard(own.mutex);
+      if (!own.nodes.empty()) {
+        GradNodeBase* node = own.nodes.back();
+        own.nodes.pop_back();
+        --queued_;
+        return node;
+      }
+    }
+    for (size_t i = 1; i < queues_.size(); ++i) {
+      auto& other = queues_[(worker + i) % queues_.size()];
+      std::lock_guard<std::mutex> guard(other.mutex);
+      if (!other.nodes.empty()) {
+        GradNodeBase* node = other.nodes.front();
+        other.nodes.pop_front();
+        --queued_;
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  void Work(size_t worker) {
+    while (true) {
+      GradNodeBase* node = Pop(worker);
+      if (node == nullptr) {
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        ready_.wait(lock, [this]() {
+          return queued_ > 0 || outstanding_ == 0 || aborted_;
+        });
+        if (outstanding_ == 0 || aborted_) return;
+        continue;
+      }
+      try {
+        RunNode(worker, node);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(wait_mutex_);
+        if (!exception_) exception_ = std::current_exception();
+        aborted_ = true;
+        ready_.notify_all();
+        return;
+      }
+      if (--outstanding_ == 0) {
+        std::lock_guard<std::mutex> guard(wait_mutex_);
+        ready_.notify_all();
+      }
+    }
+  }
+
+  void RunNode(size_t worker, GradNodeBase* node) {
+    auto& state = *states_.at(node);
+    std::unique_ptr<GradTensorHolder> node_input_buffer;
+    {
+      std::lock_guard<std::mutex> guard(state.mutex);
+      node_input_buffer = std::move(state.buffer);
+      if (!state.grads.empty()) {
+        if (!node_input_buffer) {
+          node_input_buffer =
+              std::make_unique<GradTensorHolder>(node->InputMeta());
+        }
+        std::sort(state.grads.begin(), state.grads.end(),
+                  [](const decltype(state.grads)::value_type& a,
+                     const decltype(state.grads)::value_type& b) {
+                    return std::tie(std::get<0>(a), std::get<1>(a),
+                                    std::get<2>(a)) <
+                           std::tie(std::get<0>(b), std::get<1>(b),
+                                    std::get<2>(b));
+                  });
+        for (auto& grad : state.grads) {
+          node_input_buffer->add(std::get<3>(grad), std::get<4>(grad),
+                                 std::get<5>(grad));
+        }
+        state.grads.clear();
+      }
+    }
+    PADDLE_ENFORCE(
+        node_input_buffer != nullptr,
+        paddle::platform::errors::Fatal(
+            "Unable to find next node in the InputBuufer"
+            "Trying to run Node without configuring its GradTensorHolder"));
+
+    std::vector<std::vector<paddle::experimental::Tensor>> grad_output_tensors =
+        (*node)(node_input_buffer->Buffers());
+    node_input_buffer.reset();
+
+    const std::vector<std::vector<Edge>>& edges = node->GetEdges();
+    PADDLE_ENFORCE(edges.size() == grad_output_tensors.size() || edges.empty(),
+                   paddle::platform::errors::Fatal(
+                       "Number of edges should be either empty ( for leaf node "
+                       ") or the same as number of output grad tensors, but we "
+                       "got edges size is: %d, grad_output size is: %d",
+                       edges.size(), grad_output_tensors.size()));
+    for (size_t i = 0; i < edges.size(); i++) {
+      for (size_t j = 0; j < edges[i].size(); j++) {
+        const Edge& edge = edges[i][j];
+        GradNodeBase* next_node = edge.GetMutableGradNode().get();
+        if (!next_node || grad_output_tensors[i].empty()) continue;
+        PADDLE_ENFORCE_LT(
+            j, grad_output_tensors[i].size(),
+            paddle::platform::errors::Fatal(
+                "Rank of grad_output_tensors should be less than "
+                "grad_output_tensors[i].size(), which is: %d. This error may "
+                "indicate autoprune or autograd api error. ",
+                grad_output_tensors.size()));
+        auto edge_rank = edge.GetEdgeRankInfo();
+        auto& next_state = *states_.at(next_node);
+        {
+          std::lock_guard<std::mutex> guard(next_state.mutex);
+          next_state.grads.emplace_back(state.order, i, j, edge_rank.first,
+                                        edge_rank.second,
+                                        grad_output_tensors[i][j]);
+        }
+        int in_degree = --next_state.in_degree;
+        PADDLE_ENFORCE(in_degree >= 0,
+                       paddle::platform::errors::Fatal(
+                           "Detected in-degree value smaller than zero."
+                           "Node's in-degree cannot be negative"));
+        if (in_degree == 0) Push(worker, next_node);
+      }
+    }
+  }
+
+  std::unordered_map<GradNodeBase*, std::unique_ptr<NodeState>> states_;
+  std::vector<WorkQueue> queues_;
+  // Nodes pushed but not finished yet, and nodes waiting in the queues.
+  std::atomic<int64_t> outstanding_{0};
+  std::atomic<int64_t> queued_{0};
+  std::mutex wait_mutex_;
+  std::condition_variable ready_;
+  bool aborted_{false};
+  std::exception_ptr exception_;
+};
+
 void RunBackward(const std::vector<paddle::experimental::Tensor>& tensors,
                  const std::vector<paddle::experimental::Tensor>& grad_tensors,
                  bool retain_graph) {
@@ -146,6 +425,18 @@ void RunBackward(const std::vector<paddle::experimental::Tensor>& tensors,
   std::unordered_map<GradNodeBase*, int> node_in_degree_map =
       getInDegreeMap(queue);
 
+  if (FLAGS_eager_backward_num_threads > 1 &&
+      paddle::platform::is_cpu_place(
+          Controller::Instance().GetExpectedPlace())) {
+    VLOG(6) << "Run Backward with " << FLAGS_eager_backward_num_threads
+            << " threads";
+    ParallelBackwardExecutor executor(FLAGS_eager_backward_num_threads, queue,
+                                      &node_input_buffers_dict,
+                                      node_in_degree_map);
+    executor.Run();
+    return;
+  }
+
   /* --- Topological Visit --- */
   // 1. Pop queue
   // 2. Run node
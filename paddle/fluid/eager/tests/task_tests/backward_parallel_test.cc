@@ -0,0 +1,116 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+#include "paddle/fluid/eager/accumulation/accumulation_node.h"
+#include "paddle/fluid/eager/api/generated/eager_generated/backwards/scale_node.h"
+#include "paddle/fluid/eager/api/utils/tensor_utils.h"
+#include "paddle/fluid/eager/autograd_meta.h"
+#include "paddle/fluid/eager/backward.h"
+#include "paddle/fluid/eager/grad_node_info.h"
+#include "paddle/fluid/eager/tests/test_utils.h"
+
+#include "paddle/fluid/eager/api/all.h"
+
+#include "paddle/pten/core/dense_tensor.h"
+
+DECLARE_int32(eager_backward_num_threads);
+
+namespace egr {
+
+/*
+   AccumulationNode
+   |      |      |
+ Node    Node   Node
+   |      |      |
+  ...    ...    ...
+   |      |      |
+ Node    Node   Node
+   |      |      |
+ inp0   inp1   inp2
+*/
+// Builds `num_towers` independent chains of `depth` scale nodes which all
+// end in the accumulation node of `leaf_tensor`.
+static std::vector<paddle::experimental::Tensor> BuildTowers(
+    int num_towers, int depth, const paddle::framework::DDim& ddim,
+    paddle::experimental::Tensor* leaf_tensor) {
+  auto acc_node_ptr = std::make_shared<egr::GradNodeAccumulation>();
+  AutogradMeta* leaf_meta = EagerUtils::autograd_meta(leaf_tensor);
+  leaf_meta->SetGradNode(std::dynamic_pointer_cast<GradNodeBase>(acc_node_ptr));
+  leaf_meta->SetSingleOutRankWithSlot(0, 0);
+  egr_utils_api::RetainGradForTensor(*leaf_tensor);
+
+  std::vector<paddle::experimental::Tensor> target_tensors;
+  for (int t = 0; t < num_towers; ++t) {
+    target_tensors.emplace_back(egr_utils_api::CreateTensorWithValue(
+        ddim, paddle::platform::CPUPlace(), pten::DataType::FLOAT32,
+        pten::DataLayout::NCHW, 1.0 /*value*/, false /*is_leaf*/));
+    std::shared_ptr<GradNodeBase> next_node = acc_node_ptr;
+    for (int d = 0; d < depth; ++d) {
+      auto node_ptr = std::make_shared<GradNodeScale>(1, 1);
+      // Scales which do not sum up exactly in float
+      node_ptr->SetAttributes_scale(1.0f + 0.1f * t + 0.01f * d);
+      node_ptr->SetDefaultGradInOutMeta();
+      auto meta = egr::AutogradMeta();
+      meta.SetStopGradient(false);
+      meta.SetSingleOutRankWithSlot(0, 0);
+      meta.SetGradNode(next_node);
+      std::vector<egr::AutogradMeta*> res = {&meta};
+      node_ptr->AddEdges(&res, 0);
+      next_node = node_ptr;
+    }
+    AutogradMeta* target_meta = EagerUtils::autograd_meta(&target_tensors[t]);
+    target_meta->SetGradNode(next_node);
+    target_meta->SetSingleOutRankWithSlot(0, 0);
+    target_meta->SetStopGradient(false);
+  }
+  return target_tensors;
+}
+
+static std::vector<float> RunTowers(int num_threads, int num_towers,
+                                    int depth,
+                                    const paddle::framework::DDim& ddim) {
+  paddle::experimental::Tensor leaf_tensor;
+  auto target_tensors = BuildTowers(num_towers, depth, ddim, &leaf_tensor);
+  FLAGS_eager_backward_num_threads = num_threads;
+  RunBackward(target_tensors, {});
+  FLAGS_eager_backward_num_threads = 1;
+
+  auto grad = std::dynamic_pointer_cast<pten::DenseTensor>(
+      EagerUtils::unsafe_autograd_meta(leaf_tensor)->Grad().impl());
+  return std::vector<float>(grad->data<float>(),
+                            grad->data<float>() + grad->numel());
+}
+
+TEST(Backward, ParallelSameAsSerial) {
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  paddle::framework::DDim ddim = paddle::framework::make_ddim({4, 16, 32});
+  for (int num_towers : {1, 3, 8}) {
+    auto expect = RunTowers(1, num_towers, 5, ddim);
+    for (int num_threads : {2, 4}) {
+      auto grad = RunTowers(num_threads, num_towers, 5, ddim);
+      ASSERT_EQ(grad.size(), expect.size());
+      for (size_t i = 0; i < grad.size(); ++i) {
+        // Bitwise equal, the grads are summed in the same order
+        ASSERT_EQ(grad[i], expect[i]);
+      }
+    }
+  }
+}
+
+}  // namespace egr
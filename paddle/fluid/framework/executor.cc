@@ -29,6 +29,7 @@ limitations under the License. */
 
 DECLARE_bool(benchmark);
 DECLARE_bool(use_mkldnn);
+DECLARE_bool(async_cpu_garbage_collector);
 
 namespace paddle {
 namespace framework {
@@ -452,7 +453,11 @@ void Executor::RunPartialPreparedContext(ExecutorPrepareContext* ctx,
           platform::errors::Unimplemented("No GPU gc found in CPU/XPU paddle"));
 #endif
     } else if (platform::is_cpu_place(place_)) {
-      gc.reset(new CPUGarbageCollector(place_, max_memory_size));
+      if (FLAGS_async_cpu_garbage_collector) {
+        gc.reset(new AsyncCPUGarbageCollector(place_, max_memory_size));
+      } else {
+        gc.reset(new CPUGarbageCollector(place_, max_memory_size));
+      }
     } else if (platform::is_xpu_place(place_)) {
 #ifdef PADDLE_WITH_XPU
       gc.reset(new XPUGarbageCollector(place_, max_memory_size));
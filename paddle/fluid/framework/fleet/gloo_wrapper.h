@@ -194,13 +194,23 @@ class GlooWrapper {
   template <typename T>
   std::vector<T> AllReduce(std::vector<T>& sendbuf,            // NOLINT
                            const std::string& mode = "sum") {  // NOLINT
-    CHECK_EQ(is_initialized_, true);
     std::vector<T> recvbuf(sendbuf.size(), T());
-    CHECK_EQ(sendbuf.size() == recvbuf.size(), true);
+    AllReduce<T>(sendbuf.data(), recvbuf.data(), sendbuf.size(), mode);
+    return recvbuf;
+  }
+
+  // allreduce num elements of sendbuf into recvbuf, which is done in place
+  // when sendbuf is recvbuf
+  template <typename T>
+  void AllReduce(T* sendbuf, T* recvbuf, size_t num,
+                 const std::string& mode = "sum") {
+    CHECK_EQ(is_initialized_, true);
 #ifdef PADDLE_WITH_GLOO
     gloo::AllreduceOptions opts(context_);
-    opts.setInput(sendbuf.data(), sendbuf.size());
-    opts.setOutput(recvbuf.data(), recvbuf.size());
+    if (sendbuf != recvbuf) {
+      opts.setInput(sendbuf, num);
+    }
+    opts.setOutput(recvbuf, num);
     if (mode == "sum") {
       opts.setReduceFunction(
           static_cast<void (*)(void*, const void*, const void*, size_t)>(
@@ -221,7 +231,6 @@ class GlooWrapper {
 #else
     LOG(WARNING) << "AllReduce does nothing when WITH_GLOO=OFF";
 #endif
-    return recvbuf;
   }
 
   template <typename T>
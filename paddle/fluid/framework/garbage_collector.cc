@@ -12,7 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
 #include <functional>
+#include <thread>  // NOLINT
+#include <vector>
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 #include "paddle/fluid/platform/cuda_device_guard.h"
 #endif
@@ -23,6 +28,7 @@
 DECLARE_double(eager_delete_tensor_gb);
 DECLARE_double(memory_fraction_of_eager_deletion);
 DECLARE_bool(fast_eager_deletion_mode);
+DECLARE_int64(async_cpu_gc_max_pending_mb);
 
 namespace paddle {
 namespace framework {
@@ -45,6 +51,183 @@ void CPUGarbageCollector::ClearCallback(const std::function<void()> &callback) {
   callback();
 }
 
+namespace {
+
+struct GlobalAsyncGarbageCollectorStats {
+  std::mutex mutex;
+  AsyncGarbageCollectorStats stats;
+};
+
+// The stats of all the AsyncGarbageFreers, which outlive any of them
+GlobalAsyncGarbageCollectorStats &GlobalStats() {
+  static auto *stats = new GlobalAsyncGarbageCollectorStats();
+  return *stats;
+}
+
+}  // namespace
+
+// The background thread of an AsyncCPUGarbageCollector
+class AsyncGarbageFreer {
+ public:
+  using GarbageQueue = GarbageCollector::GarbageQueue;
+
+  AsyncGarbageFreer() : thread_([this] { Loop(); }) {}
+
+  // Free the garbages still pending, then join the thread
+  ~AsyncGarbageFreer() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+  }
+
+  void Push(std::unique_ptr<GarbageQueue> garbages,
+            std::function<void()> callback) {
+    size_t memory_size = 0;
+    if (garbages) {
+      for (auto &garbage : *garbages) {
+        if (garbage) memory_size += garbage->size();
+      }
+    }
+    size_t max_pending_size =
+        static_cast<size_t>((std::max)(FLAGS_async_cpu_gc_max_pending_mb,
+                                       static_cast<int64_t>(0)))
+        << 20;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (pending_memory_size_ + memory_size > max_pending_size &&
+        pending_memory_size_ > 0) {
+      auto start = std::chrono::steady_clock::now();
+      cv_.wait(lock, [&] {
+        return pending_memory_size_ + memory_size <= max_pending_size ||
+               pending_memory_size_ == 0;
+      });
+      std::chrono::duration<double, std::milli> cost =
+          std::chrono::steady_clock::now() - start;
+      auto &global = GlobalStats();
+      std::lock_guard<std::mutex> guard(global.mutex);
+      global.stats.wait_time_ms += cost.count();
+    }
+    pending_memory_size_ += memory_size;
+    tasks_.emplace_back(std::move(garbages), std::move(callback), memory_size);
+    cv_.notify_all();
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return tasks_.empty() && !busy_; });
+  }
+
+ private:
+  struct Task {
+    Task(std::unique_ptr<GarbageQueue> garbages, std::function<void()> callback,
+         size_t memory_size)
+        : garbages(std::move(garbages)),
+          callback(std::move(callback)),
+          memory_size(memory_size) {}
+
+    std::unique_ptr<GarbageQueue> garbages;
+    std::function<void()> callback;
+    size_t memory_size;
+  };
+
+  void Loop() {
+    while (true) {
+      std::vector<Task> tasks;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return !tasks_.empty() || stop_; });
+        if (tasks_.empty()) return;
+        tasks.swap(tasks_);
+        busy_ = true;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::shared_ptr<memory::Allocation>> garbages;
+      size_t memory_size = 0;
+      for (auto &task : tasks) {
+        memory_size += task.memory_size;
+        if (!task.garbages) continue;
+        for (auto &garbage : *task.garbages) {
+          if (garbage) garbages.emplace_back(std::move(garbage));
+        }
+      }
+      std::sort(garbages.begin(), garbages.end(),
+                [](const std::shared_ptr<memory::Allocation> &x,
+                   const std::shared_ptr<memory::Allocation> &y) {
+                  return std::less<const void *>()(x->ptr(), y->ptr());
+                });
+      for (auto &garbage : garbages) {
+        garbage.reset();
+      }
+      for (auto &task : tasks) {
+        if (task.callback) task.callback();
+      }
+      tasks.clear();
+      std::chrono::duration<double, std::milli> cost =
+          std::chrono::steady_clock::now() - start;
+
+      {
+        auto &global = GlobalStats();
+        std::lock_guard<std::mutex> guard(global.mutex);
+        global.stats.freed_memory_size += memory_size;
+        global.stats.batch_num += 1;
+        global.stats.free_time_ms += cost.count();
+      }
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        pending_memory_size_ -= memory_size;
+        busy_ = false;
+      }
+      cv_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<Task> tasks_;
+  size_t pending_memory_size_{0};
+  bool busy_{false};
+  bool stop_{false};
+  std::thread thread_;
+};
+
+AsyncCPUGarbageCollector::AsyncCPUGarbageCollector(
+    const platform::CPUPlace &place, size_t max_memory_size)
+    // Always collect the garbages into GarbageQueue, so that their sizes are
+    // known. A batch holds any non-empty garbage when max_memory_size is 0.
+    : GarbageCollector(place,
+                       (std::max)(max_memory_size, static_cast<size_t>(2))),
+      freer_(new AsyncGarbageFreer()) {}
+
+AsyncCPUGarbageCollector::~AsyncCPUGarbageCollector() {
+  freer_.reset();
+  auto stats = Stats();
+  VLOG(1) << "AsyncCPUGarbageCollector has freed "
+          << stats.freed_memory_size << " bytes in " << stats.batch_num
+          << " batches, taking " << stats.free_time_ms
+          << " ms off the critical path of the ops, which waited "
+          << stats.wait_time_ms << " ms for it.";
+}
+
+void AsyncCPUGarbageCollector::Wait() const { freer_->Wait(); }
+
+AsyncGarbageCollectorStats AsyncCPUGarbageCollector::Stats() {
+  auto &global = GlobalStats();
+  std::lock_guard<std::mutex> guard(global.mutex);
+  return global.stats;
+}
+
+void AsyncCPUGarbageCollector::ClearCallback(
+    const std::function<void()> &callback) {
+  freer_->Push(nullptr, callback);
+}
+
+void AsyncCPUGarbageCollector::ClearGarbageQueue(GarbageQueue *garbage_queue) {
+  freer_->Push(std::unique_ptr<GarbageQueue>(garbage_queue), nullptr);
+}
+
 #ifdef PADDLE_WITH_XPU
 XPUGarbageCollector::XPUGarbageCollector(const platform::XPUPlace &place,
                                          size_t max_memory_size)
@@ -42,6 +42,8 @@ class GarbageCollector {
   template <typename Container>
   void Add(Container &&objs);
 
+  // The callback is only called by the Add that makes the garbages pending
+  // exceed max_memory_size, right before they are handed over to be freed.
   template <typename Container, typename Callback>
   void Add(Container &&objs, Callback &&callback);
 
@@ -52,6 +54,11 @@ class GarbageCollector {
  protected:
   virtual void ClearCallback(const std::function<void()> &callback) = 0;
 
+  // Free a batch of garbages, which exceeds max_memory_size_
+  virtual void ClearGarbageQueue(GarbageQueue *garbage_queue) {
+    ClearCallback([garbage_queue]() { delete garbage_queue; });
+  }
+
   platform::DeviceContext *dev_ctx_;
   std::unique_ptr<GarbageQueue> garbages_;
   mutable std::unique_ptr<std::mutex> mutex_;
@@ -67,6 +74,46 @@ class CPUGarbageCollector : public GarbageCollector {
   void ClearCallback(const std::function<void()> &callback) override;
 };
 
+struct AsyncGarbageCollectorStats {
+  size_t freed_memory_size{0};
+  size_t batch_num{0};
+  // the time of freeing in the background thread, which is taken off the
+  // critical path of the ops
+  double free_time_ms{0};
+  // the time the ops waited for the background thread, when the garbages
+  // pending exceed FLAGS_async_cpu_gc_max_pending_mb
+  double wait_time_ms{0};
+};
+
+class AsyncGarbageFreer;
+
+// AsyncCPUGarbageCollector hands the garbages over to a background thread
+// of its own. The thread frees all the garbages pending at once, in the
+// ascending order of their addresses, so that the adjacent free blocks of
+// the allocator are merged one after another. The destructor frees the
+// garbages still pending and joins the thread.
+class AsyncCPUGarbageCollector : public GarbageCollector {
+ public:
+  AsyncCPUGarbageCollector(const platform::CPUPlace &place,
+                           size_t max_memory_size);
+
+  ~AsyncCPUGarbageCollector();
+
+  // Wait until all the garbages handed over are freed
+  void Wait() const override;
+
+  // The stats of all the instances in the process
+  static AsyncGarbageCollectorStats Stats();
+
+ protected:
+  void ClearCallback(const std::function<void()> &callback) override;
+
+  void ClearGarbageQueue(GarbageQueue *garbage_queue) override;
+
+ private:
+  std::unique_ptr<AsyncGarbageFreer> freer_;
+};
+
 #ifdef PADDLE_WITH_XPU
 class XPUGarbageCollector : public GarbageCollector {
  public:
@@ -274,7 +321,7 @@ void GarbageCollector::Add(Container &&objs, Callback &&callback) {
 
   if (garbage_queue) {
     callback();
-    ClearCallback([garbage_queue]() { delete garbage_queue; });
+    ClearGarbageQueue(garbage_queue);
   }
 }
 
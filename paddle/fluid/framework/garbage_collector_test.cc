@@ -0,0 +1,118 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/garbage_collector.h"
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/malloc.h"
+
+DECLARE_int64(async_cpu_gc_max_pending_mb);
+
+namespace paddle {
+namespace framework {
+
+static std::shared_ptr<memory::Allocation> AllocGarbage(size_t size) {
+  return memory::AllocShared(platform::CPUPlace(), size);
+}
+
+TEST(AsyncCPUGarbageCollector, free_after_wait) {
+  AsyncCPUGarbageCollector gc(platform::CPUPlace(), 0);
+  auto before = AsyncCPUGarbageCollector::Stats();
+
+  std::vector<std::weak_ptr<memory::Allocation>> observers;
+  size_t memory_size = 0;
+  for (size_t i = 1; i <= 16; ++i) {
+    auto garbage = AllocGarbage(i * 1024);
+    observers.emplace_back(garbage);
+    memory_size += garbage->size();
+    gc.Add(std::vector<std::shared_ptr<memory::Allocation>>{garbage});
+  }
+  gc.Wait();
+
+  for (auto& observer : observers) {
+    EXPECT_TRUE(observer.expired());
+  }
+  auto after = AsyncCPUGarbageCollector::Stats();
+  EXPECT_EQ(after.freed_memory_size - before.freed_memory_size, memory_size);
+  EXPECT_GT(after.batch_num, before.batch_num);
+}
+
+TEST(AsyncCPUGarbageCollector, callback) {
+  AsyncCPUGarbageCollector gc(platform::CPUPlace(), 1 << 20);
+  auto garbage = AllocGarbage(4096);
+  std::weak_ptr<memory::Allocation> observer = garbage;
+  bool small_called = false;
+  gc.Add(std::vector<std::shared_ptr<memory::Allocation>>{garbage},
+         [&small_called] { small_called = true; });
+  garbage.reset();
+  // the garbage is kept in the collector until max_memory_size is exceeded,
+  // and the callback of an Add which does not exceed it is not called
+  gc.Wait();
+  EXPECT_FALSE(observer.expired());
+  EXPECT_FALSE(small_called);
+
+  bool large_called = false;
+  gc.Add(std::vector<std::shared_ptr<memory::Allocation>>{AllocGarbage(
+             2 << 20)},
+         [&large_called] { large_called = true; });
+  // the callback is called before the batch is handed over
+  EXPECT_TRUE(large_called);
+  gc.Wait();
+  EXPECT_TRUE(observer.expired());
+  EXPECT_FALSE(small_called);
+}
+
+TEST(AsyncCPUGarbageCollector, free_on_destruction) {
+  std::weak_ptr<memory::Allocation> handed_over;
+  std::weak_ptr<memory::Allocation> kept;
+  {
+    AsyncCPUGarbageCollector gc(platform::CPUPlace(), 1 << 20);
+    auto garbage = AllocGarbage(2 << 20);
+    handed_over = garbage;
+    gc.Add(std::vector<std::shared_ptr<memory::Allocation>>{
+        std::move(garbage)});
+    garbage = AllocGarbage(4096);
+    kept = garbage;
+    gc.Add(std::vector<std::shared_ptr<memory::Allocation>>{
+        std::move(garbage)});
+  }
+  EXPECT_TRUE(handed_over.expired());
+  EXPECT_TRUE(kept.expired());
+}
+
+TEST(AsyncCPUGarbageCollector, max_pending_memory) {
+  auto max_pending_mb = FLAGS_async_cpu_gc_max_pending_mb;
+  FLAGS_async_cpu_gc_max_pending_mb = 1;
+  {
+    AsyncCPUGarbageCollector gc(platform::CPUPlace(), 0);
+    std::vector<std::weak_ptr<memory::Allocation>> observers;
+    for (int i = 0; i < 32; ++i) {
+      auto garbage = AllocGarbage(512 << 10);
+      observers.emplace_back(garbage);
+      gc.Add(std::vector<std::shared_ptr<memory::Allocation>>{
+          std::move(garbage)});
+    }
+    gc.Wait();
+    for (auto& observer : observers) {
+      EXPECT_TRUE(observer.expired());
+    }
+  }
+  FLAGS_async_cpu_gc_max_pending_mb = max_pending_mb;
+}
+
+}  // namespace framework
+}  // namespace paddle
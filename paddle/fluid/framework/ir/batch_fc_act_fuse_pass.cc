@@ -0,0 +1,112 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/batch_fc_act_fuse_pass.h"
+
+#include "paddle/fluid/framework/op_version_registry.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+BatchFCActFusePass::BatchFCActFusePass() {
+  AddOpCompat(OpCompat("batch_fc"))
+      .AddInput("Input")
+      .IsTensor()
+      .End()
+      .AddInput("W")
+      .IsTensor()
+      .End()
+      .AddInput("Bias")
+      .IsTensor()
+      .End()
+      .AddOutput("Out")
+      .IsTensor()
+      .End()
+      .AddAttr("activation_type")
+      .IsOptional()
+      .IsStringIn({"relu", ""})
+      .End();
+
+  AddOpCompat(OpCompat("relu"))
+      .AddInput("X")
+      .IsTensor()
+      .End()
+      .AddOutput("Out")
+      .IsTensor()
+      .End();
+}
+
+void BatchFCActFusePass::ApplyImpl(ir::Graph* graph) const {
+  PADDLE_ENFORCE_NOT_NULL(
+      graph, platform::errors::InvalidArgument("Graph cannot be nullptr."));
+  FusePassBase::Init(name_scope_, graph);
+
+  GraphPatternDetector gpd;
+  auto* pattern = gpd.mutable_pattern();
+  auto no_activation = [](Node* x) -> bool {
+    return x->Op()->GetAttrIfExists<std::string>("activation_type").empty();
+  };
+  PDNode* batch_fc_op = pattern->NewNode("batch_fc_op")
+                            ->assert_is_op("batch_fc")
+                            ->assert_more(no_activation);
+  PDNode* batch_fc_out = pattern->NewNode("batch_fc_out")
+                             ->assert_is_op_output("batch_fc", "Out")
+                             ->assert_is_only_input_of_op("relu")
+                             ->AsIntermediate();
+  PDNode* relu_op = pattern->NewNode("relu_op")->assert_is_op("relu");
+  PDNode* relu_out = pattern->NewNode("relu_out")
+                         ->assert_is_op_output("relu", "Out")
+                         ->AsOutput();
+  batch_fc_op->LinksTo({batch_fc_out});
+  relu_op->LinksFrom({batch_fc_out}).LinksTo({relu_out});
+
+  int found_count = 0;
+  auto handler = [&](const GraphPatternDetector::subgraph_t& subgraph,
+                     Graph* g) {
+    if (!IsCompat(subgraph, g)) {
+      LOG(WARNING) << "Pass in op compat failed.";
+      return;
+    }
+    VLOG(4) << "handle batch_fc act fuse";
+    Node* batch_fc = subgraph.at(batch_fc_op);
+    Node* batch_fc_out_var = subgraph.at(batch_fc_out);
+    Node* relu = subgraph.at(relu_op);
+    Node* relu_out_var = subgraph.at(relu_out);
+
+    OpDesc* desc = batch_fc->Op();
+    desc->SetAttr("activation_type", std::string("relu"));
+    desc->SetOutput("Out", {relu_out_var->Name()});
+    desc->Flush();
+
+    GraphSafeRemoveNodes(g, {batch_fc_out_var, relu});
+    IR_NODE_LINK_TO(batch_fc, relu_out_var);
+    found_count++;
+  };
+  gpd(graph, handler);
+  AddStatis(found_count);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(batch_fc_act_fuse_pass,
+              paddle::framework::ir::BatchFCActFusePass);
+REGISTER_PASS_CAPABILITY(batch_fc_act_fuse_pass)
+    .AddCombination(
+        paddle::framework::compatible::OpVersionComparatorCombination()
+            .LE("batch_fc", 1)
+            .EQ("relu", 0));
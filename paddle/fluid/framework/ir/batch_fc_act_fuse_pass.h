@@ -0,0 +1,58 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+
+#include "paddle/fluid/framework/ir/fuse_pass_base.h"
+#include "paddle/fluid/framework/ir/graph.h"
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+/*
+ * Fuse the relu after a batch_fc into the batch_fc, by its attribute
+ * activation_type, so that the relu runs on the output of the GEMMs while
+ * it is in the cache and the intermediate output is not kept.
+ *
+ * Before fuse:
+ *      |
+ *   batch_fc
+ *      |
+ *     relu
+ *      |
+ * After fuse:
+ *      |
+ *   batch_fc(activation_type = "relu")
+ *      |
+ */
+class Graph;
+
+class BatchFCActFusePass : public FusePassBase {
+ public:
+  BatchFCActFusePass();
+  virtual ~BatchFCActFusePass() {}
+
+ protected:
+  void ApplyImpl(ir::Graph* graph) const override;
+
+  const std::string name_scope_{"batch_fc_act_fuse"};
+};
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,86 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/batch_fc_act_fuse_pass.h"
+
+#include <gtest/gtest.h>
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+TEST(BatchFCActFusePass, basic) {
+  // inputs                     operator            output
+  // --------------------------------------------------------
+  // (a, w_0, bias_0)           batch_fc         -> batch_fc_out_0
+  // batch_fc_out_0             relu             -> relu_out_0
+  // (relu_out_0, w_1, bias_1)  batch_fc         -> batch_fc_out_1
+  // batch_fc_out_1             relu             -> relu_out_1
+  // batch_fc_out_1             scale            -> scale_out
+  Layers layers;
+  auto* a = layers.data("a", {4, 16, 8});
+  auto* w_0 = layers.data("w_0", {4, 8, 8}, true);
+  auto* bias_0 = layers.data("bias_0", {4, 8}, true);
+  auto* batch_fc_out_0 = layers.batch_fc(a, w_0, bias_0);
+  auto* relu_out_0 = layers.relu(batch_fc_out_0);
+  auto* w_1 = layers.data("w_1", {4, 8, 6}, true);
+  auto* bias_1 = layers.data("bias_1", {4, 6}, true);
+  auto* batch_fc_out_1 = layers.batch_fc(relu_out_0, w_1, bias_1);
+  auto* relu_out_1 = layers.relu(batch_fc_out_1);
+  // The output of the second batch_fc has another consumer, so its relu
+  // should not be fused.
+  auto* scale_out = layers.scale(batch_fc_out_1, 2.0f, 0.0f, true);
+  VLOG(4) << relu_out_1 << scale_out;
+
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(layers.main_program()));
+  auto pass = PassRegistry::Instance().Get("batch_fc_act_fuse_pass");
+  int num_nodes_before = graph->Nodes().size();
+  VLOG(3) << DebugString(graph);
+
+  graph.reset(pass->Apply(graph.release()));
+  int num_nodes_after = graph->Nodes().size();
+  int num_relu_nodes_after = GetNumOpNodes(graph, "relu");
+  VLOG(3) << DebugString(graph);
+
+  PADDLE_ENFORCE_EQ(num_nodes_before, num_nodes_after + 2,
+                    platform::errors::InvalidArgument(
+                        "num_nodes_before=%d, num_nodes_after=%d.",
+                        num_nodes_before, num_nodes_after));
+  PADDLE_ENFORCE_EQ(num_relu_nodes_after, 1,
+                    platform::errors::InvalidArgument(
+                        "num_relu_nodes_after=%d.", num_relu_nodes_after));
+  int num_fused = 0;
+  for (auto* node : graph->Nodes()) {
+    if (node->IsOp() && node->Op()->Type() == "batch_fc") {
+      auto activation_type =
+          BOOST_GET_CONST(std::string, node->Op()->GetAttr("activation_type"));
+      if (activation_type == "relu") {
+        ++num_fused;
+        PADDLE_ENFORCE_EQ(node->Op()->Output("Out")[0], relu_out_0->Name(),
+                          platform::errors::InvalidArgument(
+                              "The fused batch_fc should output %s.",
+                              relu_out_0->Name()));
+      }
+    }
+  }
+  PADDLE_ENFORCE_EQ(num_fused, 1, platform::errors::InvalidArgument(
+                                      "num_fused=%d.", num_fused));
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(batch_fc_act_fuse_pass);
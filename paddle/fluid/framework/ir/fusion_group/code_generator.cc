@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/ir/fusion_group/code_generator.h"
 #include "paddle/fluid/framework/ir/fusion_group/code_generator_helper.h"
+#include "paddle/fluid/framework/ir/fusion_group/cpu_resources.h"
 #include "paddle/fluid/framework/ir/fusion_group/cuda_resources.h"
 
 namespace paddle {
@@ -42,11 +43,12 @@ std::string ExtractDataType(const std::vector<Node*>& nodes) {
   return dtype_str;
 }
 
-CodeGenerator::CodeGenerator() {
+CodeGenerator::CodeGenerator(bool is_cpu) : is_cpu_(is_cpu) {
   // Only support elementwise operations now.
   code_templates_.resize(1);
 
-  CodeTemplate elementwise_t(cuda_kernel_template_1d);
+  CodeTemplate elementwise_t(is_cpu_ ? cpu_kernel_template_1d
+                                     : cuda_kernel_template_1d);
   code_templates_[0] = elementwise_t;
 }
 
@@ -183,6 +185,13 @@ std::string CodeGenerator::Generate(
   for (const auto& type : dtypes) {
     all_dtype.insert(type.second);
   }
+  if (is_cpu_) {
+    PADDLE_ENFORCE_EQ(
+        all_dtype.find("__half"), all_dtype.end(),
+        platform::errors::Unimplemented(
+            "Float16 is not supported by the CPU code of fusion_group."));
+    return predefined_cpu_functions + code_templates_[0].Format(template_var);
+  }
   std::string predefined_cuda_functions = "";
   if (all_dtype.find("float") != all_dtype.end() &&
       all_dtype.find("__half") == all_dtype.end()) {
@@ -271,6 +280,26 @@ std::string CodeGenerator::EmitParameters(
     const std::set<int>& intermediate_ids,
     const std::unordered_map<int, std::string>& dtypes) const {
   std::stringstream ret;
+  if (is_cpu_) {
+    // The data pointers are passed in an array, in the same order as the
+    // parameters of the CUDA kernel.
+    int index = 0;
+    for (auto id : input_ids) {
+      if (output_ids.find(id) == output_ids.end()) {
+        ret << "const " << dtypes.at(id) << "* __restrict__ " << ArgName(id)
+            << " = static_cast<const " << dtypes.at(id) << "*>(args["
+            << index++ << "]);";
+      }
+    }
+    for (auto id : output_ids) {
+      if (intermediate_ids.find(id) == intermediate_ids.end()) {
+        ret << dtypes.at(id) << "* __restrict__ " << ArgName(id)
+            << " = static_cast<" << dtypes.at(id) << "*>(args[" << index++
+            << "]);";
+      }
+    }
+    return ret.str();
+  }
   ret << "int N, ";
 
   // If a id is in the input and output list at the same time, then remove it
@@ -317,9 +346,13 @@ std::string CodeGenerator::EmitComputeBody(
   for (auto id : input_ids) {
     if (output_ids.find(id) == output_ids.end() &&
         used.find(id) != used.end()) {
-      load << dtypes.at(id) << " " << TmpName(id) << " = "
-           << "__ldg(&" << VarName(id) << ")"
-           << ";";
+      load << dtypes.at(id) << " " << TmpName(id) << " = ";
+      if (is_cpu_) {
+        load << VarName(id) << ";";
+      } else {
+        load << "__ldg(&" << VarName(id) << ")"
+             << ";";
+      }
     }
   }
   // Store temporal variables to memory.
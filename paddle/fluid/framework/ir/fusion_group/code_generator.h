@@ -32,7 +32,9 @@ class SubGraph;
 
 class CodeGenerator {
  public:
-  CodeGenerator();
+  // Generates CUDA kernels by default, or C++ functions for CPUDeviceCode
+  // when is_cpu is true.
+  explicit CodeGenerator(bool is_cpu = false);
 
   std::string Generate(std::string func_name,
                        const std::vector<OperationExpression>& expressions);
@@ -67,6 +69,7 @@ class CodeGenerator {
   std::unordered_map<Node*, int> EncodeVarNodes(SubGraph* subgraph);
 
  private:
+  bool is_cpu_{false};
   std::vector<CodeTemplate> code_templates_;
 };
 
@@ -0,0 +1,138 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/ir/fusion_group/code_generator.h"
+#include "paddle/fluid/framework/ir/fusion_group/operation.h"
+#include "paddle/fluid/platform/device_code.h"
+
+DEFINE_int32(numel, 1 << 20, "The number of floats of every tensor.");
+DEFINE_int32(repeat, 20, "The times of running every function.");
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+static void Launch(const platform::CPUDeviceCode& code,
+                   std::vector<float*> ptrs, size_t n) {
+  std::vector<void*> args = {&n};
+  for (auto& ptr : ptrs) {
+    args.push_back(&ptr);
+  }
+  code.Launch(n, &args);
+}
+
+template <typename Callback>
+static double TimeMs(Callback callback) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    callback();
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / FLAGS_repeat;
+}
+
+// Times t8 = sigmoid(relu(t0 * t1 + t3 - t5)) as one generated function and
+// as one generated function per operation.
+static void BenchElementwiseChain() {
+  OperationMap::Init();
+  std::string dtype = "float";
+  std::vector<OperationExpression> expressions = {
+      OperationExpression("elementwise_mul", {0, 1}, {2}, dtype, dtype, {2}),
+      OperationExpression("elementwise_add", {2, 3}, {4}, dtype, dtype, {4}),
+      OperationExpression("elementwise_sub", {4, 5}, {6}, dtype, dtype, {6}),
+      OperationExpression("relu", {6}, {7}, dtype, dtype, {7}),
+      OperationExpression("sigmoid", {7}, {8}, dtype, dtype)};
+
+  const size_t n = FLAGS_numel;
+  std::vector<std::vector<float>> vars(9, std::vector<float>(n));
+  std::mt19937 rng(100);
+  std::uniform_real_distribution<float> uniform_dist(-1, 1);
+  for (int id : {0, 1, 3, 5}) {
+    for (auto& value : vars[id]) {
+      value = uniform_dist(rng);
+    }
+  }
+
+  CodeGenerator code_generator(true);
+  platform::CPUDeviceCode fused(
+      platform::CPUPlace(), "fused_elementwise_cpu_bench",
+      code_generator.Generate("fused_elementwise_cpu_bench", expressions));
+  PADDLE_ENFORCE_EQ(fused.Compile(), true,
+                    platform::errors::Unavailable(
+                        "Failed to compile the fused function."));
+  std::vector<float> fused_out(n);
+  double fused_ms = TimeMs([&]() {
+    Launch(fused, {vars[0].data(), vars[1].data(), vars[3].data(),
+                   vars[5].data(), fused_out.data()},
+           n);
+  });
+
+  std::vector<std::unique_ptr<platform::CPUDeviceCode>> unfused;
+  for (size_t i = 0; i < expressions.size(); ++i) {
+    auto& expr = expressions[i];
+    OperationExpression single(expr.GetOpType(), expr.GetInputIds(),
+                               expr.GetOutputIds(), dtype, dtype);
+    std::string name = "unfused_elementwise_cpu_bench_" + std::to_string(i);
+    unfused.emplace_back(new platform::CPUDeviceCode(
+        platform::CPUPlace(), name, code_generator.Generate(name, {single})));
+    PADDLE_ENFORCE_EQ(unfused.back()->Compile(), true,
+                      platform::errors::Unavailable(
+                          "Failed to compile the function of %s.",
+                          expr.GetOpType()));
+  }
+  double unfused_ms = TimeMs([&]() {
+    for (size_t i = 0; i < expressions.size(); ++i) {
+      std::vector<float*> ptrs;
+      for (int id : expressions[i].GetInputIds()) {
+        ptrs.push_back(vars[id].data());
+      }
+      ptrs.push_back(vars[expressions[i].GetOutputIds()[0]].data());
+      Launch(*unfused[i], ptrs, n);
+    }
+  });
+
+  LOG(INFO) << "elementwise chain of " << expressions.size()
+            << " operations on " << n << " floats: fused " << fused_ms
+            << " ms, unfused " << unfused_ms << " ms, speedup "
+            << unfused_ms / fused_ms;
+}
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+// Compares a fused elementwise chain with the unfused one on CPU,
+// run command: ./code_generator_cpu_benchmark [options...]
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::platform::CPUDeviceCode::CheckAvailableStatus();
+  if (!paddle::platform::CPUDeviceCode::IsAvailable()) {
+    LOG(WARNING) << "The C++ compiler is not available.";
+    return 0;
+  }
+  paddle::framework::ir::fusion_group::BenchElementwiseChain();
+  return 0;
+}
@@ -0,0 +1,120 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <string>
+
+#include "paddle/fluid/framework/ir/fusion_group/code_generator.h"
+#include "paddle/fluid/framework/ir/fusion_group/operation.h"
+#include "paddle/fluid/platform/device_code.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+static void Launch(const platform::CPUDeviceCode& code,
+                   std::vector<float*> ptrs, size_t n) {
+  std::vector<void*> args = {&n};
+  for (auto& ptr : ptrs) {
+    args.push_back(&ptr);
+  }
+  code.Launch(n, &args);
+}
+
+TEST(code_generator, cpu_elementwise) {
+  platform::CPUDeviceCode::CheckAvailableStatus();
+  if (!platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+  OperationMap::Init();
+
+  // t2 = t0 * t1
+  // t4 = t2 + t3
+  // t6 = t4 - t5
+  // t7 = relu(t6)
+  // t8 = sigmoid(t7)
+  // Only t8 is stored by the fused function.
+  std::string dtype = "float";
+  std::vector<OperationExpression> expressions = {
+      OperationExpression("elementwise_mul", {0, 1}, {2}, dtype, dtype, {2}),
+      OperationExpression("elementwise_add", {2, 3}, {4}, dtype, dtype, {4}),
+      OperationExpression("elementwise_sub", {4, 5}, {6}, dtype, dtype, {6}),
+      OperationExpression("relu", {6}, {7}, dtype, dtype, {7}),
+      OperationExpression("sigmoid", {7}, {8}, dtype, dtype)};
+
+  const size_t n = 1 << 20;
+  std::vector<std::vector<float>> vars(9, std::vector<float>(n));
+  std::mt19937 rng(100);
+  std::uniform_real_distribution<float> uniform_dist(-1, 1);
+  for (int id : {0, 1, 3, 5}) {
+    for (auto& value : vars[id]) {
+      value = uniform_dist(rng);
+    }
+  }
+
+  CodeGenerator code_generator(true);
+  std::string code_str =
+      code_generator.Generate("fused_elementwise_cpu_test", expressions);
+  VLOG(3) << code_str;
+  platform::CPUDeviceCode fused(platform::CPUPlace(),
+                                "fused_elementwise_cpu_test", code_str);
+  ASSERT_TRUE(fused.Compile());
+  std::vector<float> fused_out(n);
+  auto run_fused = [&]() {
+    Launch(fused, {vars[0].data(), vars[1].data(), vars[3].data(),
+                   vars[5].data(), fused_out.data()},
+           n);
+  };
+  run_fused();
+
+  // One function per operation, the way the operators run without fusion,
+  // each one reading and writing the whole intermediate tensors.
+  std::vector<std::unique_ptr<platform::CPUDeviceCode>> unfused;
+  for (size_t i = 0; i < expressions.size(); ++i) {
+    auto& expr = expressions[i];
+    OperationExpression single(expr.GetOpType(), expr.GetInputIds(),
+                               expr.GetOutputIds(), dtype, dtype);
+    std::string name = "unfused_elementwise_cpu_test_" + std::to_string(i);
+    unfused.emplace_back(new platform::CPUDeviceCode(
+        platform::CPUPlace(), name, code_generator.Generate(name, {single})));
+    ASSERT_TRUE(unfused.back()->Compile());
+  }
+  auto run_unfused = [&]() {
+    for (size_t i = 0; i < expressions.size(); ++i) {
+      std::vector<float*> ptrs;
+      for (int id : expressions[i].GetInputIds()) {
+        ptrs.push_back(vars[id].data());
+      }
+      ptrs.push_back(vars[expressions[i].GetOutputIds()[0]].data());
+      Launch(*unfused[i], ptrs, n);
+    }
+  };
+  run_unfused();
+
+  for (size_t i = 0; i < n; ++i) {
+    float t6 = vars[0][i] * vars[1][i] + vars[3][i] - vars[5][i];
+    float t7 = t6 > 0 ? t6 : 0;
+    float expect = 1.0 / (1.0 + std::exp(-t7));
+    ASSERT_NEAR(fused_out[i], expect, 1e-5);
+    ASSERT_NEAR(vars[8][i], expect, 1e-5);
+  }
+}
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
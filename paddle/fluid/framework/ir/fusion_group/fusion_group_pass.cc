@@ -41,18 +41,40 @@ void FusionGroupPass::ApplyImpl(ir::Graph* graph) const {
     //       avaiable.";
     //   return 0;
     // }
+  } else {
+    platform::CPUPlace place;
+    platform::DeviceCodePool::Init({place});
+    if (!platform::CPUDeviceCode::IsAvailable()) {
+      LOG(WARNING) << "Disable fusion_group because the C++ compiler is not "
+                      "available.";
+      return;
+    }
+  }
+
+  fusion_group::OperationMap::Init();
+  int num_elementwise_groups = DetectFusionGroup(graph, 0);
+  AddStatis(num_elementwise_groups);
+  LOG(INFO) << "Detect " << num_elementwise_groups
+            << " elementwise fusion groups.";
+}
 
-    fusion_group::OperationMap::Init();
-    int num_elementwise_groups = DetectFusionGroup(graph, 0);
-    AddStatis(num_elementwise_groups);
-    LOG(INFO) << "Detect " << num_elementwise_groups
-              << " elementwise fusion groups.";
+static bool HasFloat16Var(const fusion_group::SubGraph& subgraph) {
+  for (auto* n : subgraph.Nodes()) {
+    if (n && n->IsVar() && n->Var() &&
+        n->Var()->GetDataType() == proto::VarType::FP16) {
+      return true;
+    }
   }
+  return false;
 }
 
 int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
+  bool use_gpu = Get<bool>("use_gpu");
   // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
+  platform::Place place = platform::CPUPlace();
+  if (use_gpu) {
+    place = platform::CUDAPlace(0);
+  }
   int index = platform::DeviceCodePool::Init({place}).size(place);
 
   std::vector<std::vector<Node*>> subgraphs =
@@ -68,8 +90,13 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
     VLOG(3) << "subgraph: {\n" << DebugString(subgraph.SortedNodes()) << "}\n";
 
     if (subgraph.IsValid(min_subgraph_size)) {
+      if (!use_gpu && HasFloat16Var(subgraph)) {
+        continue;
+      }
       subgraph.SetFuncName("fused_elementwise_" + std::to_string(index++));
-      if (GenerateCode(&subgraph)) {
+      bool is_generated = use_gpu ? GenerateCode(&subgraph)
+                                  : GenerateCPUCode(&subgraph);
+      if (is_generated) {
         InsertFusionGroupOp(graph, &subgraph);
         num_subgraphs++;
       }
@@ -79,6 +106,7 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
 }
 
 bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph) const {
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   fusion_group::CodeGenerator code_generator;
   std::string code_str = code_generator.Generate(subgraph);
   VLOG(4) << code_str;
@@ -93,6 +121,39 @@ bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph) const {
     pool.Set(std::move(device_code));
   }
   return is_compiled;
+#else
+  return false;
+#endif
+}
+
+bool FusionGroupPass::GenerateCPUCode(fusion_group::SubGraph* subgraph) const {
+  // Subgraphs computing the same expressions get the same code, which is
+  // named after its hash, so that the predictors of a process share one
+  // compiled function per expression and skip compiling the ones found in
+  // the disk cache.
+  fusion_group::CodeGenerator code_generator(true);
+  std::vector<fusion_group::OperationExpression> expressions =
+      code_generator.ConvertToExpressions(subgraph);
+  std::string func_name = "fused_elementwise_cpu";
+  size_t hash =
+      std::hash<std::string>()(code_generator.Generate(func_name, expressions));
+  func_name += "_" + std::to_string(hash);
+  std::string code_str = code_generator.Generate(func_name, expressions);
+  subgraph->SetFuncName(func_name);
+  VLOG(4) << code_str;
+
+  platform::CPUPlace place;
+  platform::DeviceCodePool& pool = platform::DeviceCodePool::Init({place});
+  if (pool.Has(place, func_name)) {
+    return true;
+  }
+  std::unique_ptr<platform::CPUDeviceCode> device_code(
+      new platform::CPUDeviceCode(place, func_name, code_str));
+  bool is_compiled = device_code->Compile();
+  if (is_compiled) {
+    pool.Set(std::move(device_code));
+  }
+  return is_compiled;
 }
 
 static int ExtractOpRole(fusion_group::SubGraph* subgraph) {
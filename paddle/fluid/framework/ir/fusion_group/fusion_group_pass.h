@@ -37,6 +37,7 @@ class FusionGroupPass : public FusePassBase {
  private:
   int DetectFusionGroup(Graph* graph, int type = 0) const;
   bool GenerateCode(fusion_group::SubGraph* subgraph) const;
+  bool GenerateCPUCode(fusion_group::SubGraph* subgraph) const;
   void InsertFusionGroupOp(Graph* graph,
                            fusion_group::SubGraph* subgraph) const;
 
@@ -21,6 +21,7 @@ limitations under the License. */
 #include <unordered_set>
 #include <vector>
 
+#include "paddle/fluid/framework/ir/graph_node_index.h"
 #include "paddle/fluid/framework/ir/node.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/platform/enforce.h"
@@ -293,6 +294,7 @@ class Graph {
     }
     nodes_.clear();
     node_set_.clear();
+    if (node_index_) node_index_->Clear();
     return ret;
   }
 
@@ -309,6 +311,7 @@ class Graph {
     ret.reset(nodes_.at(node).release());
     nodes_.erase(node);
     node_set_.erase(node);
+    if (node_index_) node_index_->Remove(node);
     return ret;
   }
 
@@ -352,9 +355,30 @@ class Graph {
                           "The node to be added already exists."));
     nodes_[node].reset(node);
     node_set_.insert(node);
+    if (node_index_) node_index_->Add(node);
     return node;
   }
 
+  // The index of the nodes, which is built at the first call and then
+  // updated with the nodes added or removed. The ops retyped in place are
+  // re-indexed by every call.
+  GraphNodeIndex *NodeIndex() const {
+    if (FLAGS_convert_all_blocks) {
+      if (IsMainGraph()) {
+        return GetSubGraph(0)->NodeIndex();
+      }
+    }
+    if (!node_index_) {
+      node_index_.reset(new GraphNodeIndex());
+      for (auto *node : node_set_) {
+        node_index_->Add(node);
+      }
+    } else {
+      node_index_->Refresh();
+    }
+    return node_index_.get();
+  }
+
   void ResolveHazard(
       const std::map<std::string, std::vector<ir::Node *>> &var_nodes);
 
@@ -431,6 +455,8 @@ class Graph {
   std::map<std::string, std::function<void(void)>> attr_dels_;
   std::map<ir::Node *, std::unique_ptr<ir::Node>> nodes_;
   std::unordered_set<ir::Node *> node_set_;
+  // built lazily by NodeIndex()
+  mutable std::unique_ptr<GraphNodeIndex> node_index_;
   size_t num_node_created_{0};  // help to generate a unique node id.
   // NOTE(Aurelius84): Whether is constructed with partial ProgramDesc.
   // In case of @to_static, whole trainning program is splited into two
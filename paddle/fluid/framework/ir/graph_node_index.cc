@@ -0,0 +1,85 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/ir/graph_node_index.h"
+
+#include "paddle/fluid/framework/op_desc.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+std::string GraphNodeIndex::OpType(const Node *node) {
+  return node->Op() ? node->Op()->Type() : std::string();
+}
+
+void GraphNodeIndex::AddToBucket(Node *node, const std::string &op_type,
+                                 Entry *entry) {
+  auto &bucket = buckets_[op_type];
+  entry->op_type = op_type;
+  entry->pos = bucket.size();
+  bucket.push_back(node);
+}
+
+void GraphNodeIndex::RemoveFromBucket(const Entry &entry) {
+  auto &bucket = buckets_[entry.op_type];
+  // Move the last op of the bucket to the removed position.
+  Node *last = bucket.back();
+  bucket[entry.pos] = last;
+  ops_[last].pos = entry.pos;
+  bucket.pop_back();
+}
+
+void GraphNodeIndex::Add(Node *node) {
+  if (!node->IsOp() || ops_.count(node)) return;
+  AddToBucket(node, OpType(node), &ops_[node]);
+}
+
+void GraphNodeIndex::Remove(Node *node) {
+  auto it = ops_.find(node);
+  if (it == ops_.end()) return;
+  RemoveFromBucket(it->second);
+  ops_.erase(node);
+}
+
+void GraphNodeIndex::Clear() {
+  buckets_.clear();
+  ops_.clear();
+}
+
+void GraphNodeIndex::Refresh() {
+  std::vector<Node *> retyped;
+  for (auto &item : ops_) {
+    if (item.first->Op() && item.first->Op()->Type() != item.second.op_type) {
+      retyped.push_back(item.first);
+    }
+  }
+  for (auto *node : retyped) {
+    VLOG(4) << "Op " << node->id() << " is retyped from "
+            << ops_[node].op_type << " to " << OpType(node);
+    RemoveFromBucket(ops_[node]);
+    AddToBucket(node, OpType(node), &ops_[node]);
+  }
+}
+
+const std::vector<Node *> &GraphNodeIndex::Ops(
+    const std::string &op_type) const {
+  static const std::vector<Node *> kEmpty;
+  auto it = buckets_.find(op_type);
+  return it == buckets_.end() ? kEmpty : it->second;
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,68 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/framework/ir/node.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+/*
+ * GraphNodeIndex buckets the op nodes of a graph by their op types, so that
+ * the GraphPatternDetector only tells the nodes which may match a PDNode,
+ * instead of all the nodes of the graph.
+ *
+ * It is built by Graph::NodeIndex at the first use, and then kept up to date
+ * by Graph::AddNode and Graph::RemoveNode, so the passes don't rebuild it
+ * after each rewrite. Some passes change the type of an OpDesc in place,
+ * Refresh moves those ops to their new buckets.
+ */
+class GraphNodeIndex {
+ public:
+  void Add(Node *node);
+  void Remove(Node *node);
+  void Clear();
+
+  // Move the ops whose types are changed since they are indexed.
+  void Refresh();
+
+  // The op nodes of `op_type`, in no particular order.
+  const std::vector<Node *> &Ops(const std::string &op_type) const;
+
+  size_t OpNum() const { return ops_.size(); }
+
+ private:
+  struct Entry {
+    std::string op_type;
+    // the position in the bucket of op_type
+    size_t pos;
+  };
+
+  static std::string OpType(const Node *node);
+  void AddToBucket(Node *node, const std::string &op_type, Entry *entry);
+  void RemoveFromBucket(const Entry &entry);
+
+  std::unordered_map<std::string, std::vector<Node *>> buckets_;
+  std::unordered_map<Node *, Entry> ops_;
+};
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
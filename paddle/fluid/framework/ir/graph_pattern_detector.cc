@@ -75,6 +75,32 @@ void PDPattern::AddEdge(PDNode *a, PDNode *b) {
   edges_.emplace_back(a, b);
 }
 
+bool PDNode::CollectCandidates(const GraphNodeIndex &index,
+                               std::vector<Node *> *candidates) const {
+  // The assertions are skipped by Tell if there is a teller.
+  if (teller_ || index_hint_ == IndexHint::kNone) return false;
+  if (index_hint_ == IndexHint::kOpType) {
+    for (auto &op_type : hint_op_types_) {
+      auto &ops = index.Ops(op_type);
+      candidates->insert(candidates->end(), ops.begin(), ops.end());
+    }
+    return true;
+  }
+  std::unordered_set<Node *> visited;
+  for (auto &op_type : hint_op_types_) {
+    for (auto *op : index.Ops(op_type)) {
+      auto &vars =
+          index_hint_ == IndexHint::kOpInput ? op->inputs : op->outputs;
+      for (auto *var : vars) {
+        if (visited.insert(var).second) {
+          candidates->push_back(var);
+        }
+      }
+    }
+  }
+  return true;
+}
+
 void GraphPatternDetector::operator()(Graph *graph,
                                       GraphPatternDetector::handle_t handler) {
   if (!MarkPDNodesInGraph(*graph)) {
@@ -100,11 +126,32 @@ bool GraphPatternDetector::MarkPDNodesInGraph(const ir::Graph &graph) {
   VLOG(3) << "mark pdnodes in graph";
   if (graph.Nodes().empty()) return false;
 
-  for (auto &node : GraphTraits::DFS(graph)) {
-    for (const auto &pdnode : pattern_.nodes()) {
-      if (pdnode->Tell(&node)) {
-        VLOG(4) << "Node " << node.Name() << " marked as " << pdnode->name();
-        pdnodes2nodes_[pdnode.get()].insert(&node);
+  // The PDNodes with op types are told on the candidates from the index of
+  // the graph, and the others on all the nodes.
+  const auto &index = *graph.NodeIndex();
+  std::vector<PDNode *> unindexed_pdnodes;
+  std::vector<Node *> candidates;
+  for (const auto &pdnode : pattern_.nodes()) {
+    candidates.clear();
+    if (!pdnode->CollectCandidates(index, &candidates)) {
+      unindexed_pdnodes.push_back(pdnode.get());
+      continue;
+    }
+    for (auto *node : candidates) {
+      if (pdnode->Tell(node)) {
+        VLOG(4) << "Node " << node->Name() << " marked as " << pdnode->name();
+        pdnodes2nodes_[pdnode.get()].insert(node);
+      }
+    }
+  }
+  if (!unindexed_pdnodes.empty()) {
+    for (auto *node : graph.Nodes()) {
+      for (auto *pdnode : unindexed_pdnodes) {
+        if (pdnode->Tell(node)) {
+          VLOG(4) << "Node " << node->Name() << " marked as "
+                  << pdnode->name();
+          pdnodes2nodes_[pdnode].insert(node);
+        }
       }
     }
   }
@@ -174,10 +221,28 @@ struct HitGroup {
     nodes_.insert(node);
   }
 
+  Node *RoleOf(PDNode *pat) const {
+    auto it = roles.find(pat);
+    return it == roles.end() ? nullptr : it->second;
+  }
+
  private:
   std::set<Node *> nodes_;
 };
 
+// The nodes without duplicates, an op takes a var twice if it is used by two
+// arguments.
+static std::vector<Node *> UniqueNodes(const std::vector<Node *> &nodes) {
+  std::vector<Node *> result;
+  result.reserve(nodes.size());
+  for (auto *node : nodes) {
+    if (std::find(result.begin(), result.end(), node) == result.end()) {
+      result.push_back(node);
+    }
+  }
+  return result;
+}
+
 // Tell whether Node a links to b.
 bool IsNodesLink(Node *a, Node *b) {
   for (auto *node : a->outputs) {
@@ -217,22 +282,40 @@ GraphPatternDetector::DetectPatterns() {
     auto &cur_groups = bi_records[1 - (step++ % 2)];
     cur_groups.clear();
     if (pre_groups.empty()) break;
+    const auto &sources = pdnodes2nodes_[edge.first];
+    const auto &targets = pdnodes2nodes_[edge.second];
+    auto extend = [&](const HitGroup &group, Node *source, Node *target) {
+      VLOG(8) << "check " << source->id() << " -- " << target->id();
+      HitGroup new_group = group;
+      bool flag = new_group.Match(source, edge.first) &&
+                  new_group.Match(target, edge.second);
+      if (flag) {
+        new_group.Register(source, edge.first);
+        new_group.Register(target, edge.second);
+        cur_groups.push_back(new_group);
+        // TODO(Superjomn) need to unique
+      }
+    };
     // source -> target
-    for (Node *source : pdnodes2nodes_[edge.first]) {
-      for (Node *target : pdnodes2nodes_[edge.second]) {
-        VLOG(8) << "check " << source->id() << " -- " << target->id();
-        // TODO(Superjomn) add some prune strategies.
-        for (const auto &group : pre_groups) {
-          if (IsNodesLink(source, target)) {
-            HitGroup new_group = group;
-            bool flag = new_group.Match(source, edge.first) &&
-                        new_group.Match(target, edge.second);
-            if (flag) {
-              new_group.Register(source, edge.first);
-              new_group.Register(target, edge.second);
-              cur_groups.push_back(new_group);
-              // TODO(Superjomn) need to unique
-            }
+    for (const auto &group : pre_groups) {
+      // When one end of the edge is matched in the group, only its
+      // neighbours can match the other end.
+      Node *source = group.RoleOf(edge.first);
+      Node *target = group.RoleOf(edge.second);
+      if (source) {
+        if (!sources.count(source)) continue;
+        for (Node *x : UniqueNodes(source->outputs)) {
+          if (targets.count(x)) extend(group, source, x);
+        }
+      } else if (target) {
+        if (!targets.count(target)) continue;
+        for (Node *x : UniqueNodes(target->inputs)) {
+          if (sources.count(x)) extend(group, x, target);
+        }
+      } else {
+        for (Node *x : sources) {
+          for (Node *y : targets) {
+            if (IsNodesLink(x, y)) extend(group, x, y);
           }
         }
       }
@@ -402,6 +485,7 @@ PDNode *PDNode::assert_is_op() {
 }
 
 PDNode *PDNode::assert_is_op(const std::string &op_type) {
+  SetIndexHint(IndexHint::kOpType, std::vector<std::string>{op_type});
   asserts_.emplace_back([op_type](Node *x) {
     return x && x->IsOp() && x->Op()->Type() == op_type;
   });
@@ -454,6 +538,7 @@ PDNode *PDNode::assert_is_op_nth_input(const std::string &op_type,
 
 PDNode *PDNode::assert_is_op_nth_output(const std::string &op_type,
                                         const std::string &argument, int nth) {
+  SetIndexHint(IndexHint::kOpOutput, std::vector<std::string>{op_type});
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -467,6 +552,7 @@ PDNode *PDNode::assert_is_op_nth_output(const std::string &op_type,
 }
 
 PDNode *PDNode::assert_is_only_input_of_op(const std::string &op_type) {
+  SetIndexHint(IndexHint::kOpInput, std::vector<std::string>{op_type});
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
@@ -481,6 +567,7 @@ PDNode *PDNode::assert_is_only_input_of_op(const std::string &op_type) {
 }
 
 PDNode *PDNode::assert_is_only_output_of_op(const std::string &op_type) {
+  SetIndexHint(IndexHint::kOpOutput, std::vector<std::string>{op_type});
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -495,6 +582,7 @@ PDNode *PDNode::assert_is_only_output_of_op(const std::string &op_type) {
 }
 
 PDNode *PDNode::assert_is_op_output(const std::string &op_type) {
+  SetIndexHint(IndexHint::kOpOutput, std::vector<std::string>{op_type});
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -515,6 +603,7 @@ PDNode *PDNode::assert_is_op_output(const std::string &op_type,
 }
 
 PDNode *PDNode::assert_is_op_input(const std::string &op_type) {
+  SetIndexHint(IndexHint::kOpInput, std::vector<std::string>{op_type});
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
@@ -572,6 +661,7 @@ PDNode *PDNode::assert_more(PDNode::teller_t &&teller) {
 }
 
 PDNode *PDNode::assert_is_ops(const std::unordered_set<std::string> &op_types) {
+  SetIndexHint(IndexHint::kOpType, op_types);
   asserts_.emplace_back([op_types](Node *x) {
     return x && x->IsOp() && op_types.count(x->Op()->Type());
   });
@@ -597,6 +687,7 @@ PDNode *PDNode::assert_is_ops_nth_input(
 PDNode *PDNode::assert_is_ops_nth_output(
     const std::unordered_set<std::string> &op_types,
     const std::string &argument, int nth) {
+  SetIndexHint(IndexHint::kOpOutput, op_types);
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -610,6 +701,7 @@ PDNode *PDNode::assert_is_ops_nth_output(
 }
 PDNode *PDNode::assert_is_ops_output(
     const std::unordered_set<std::string> &op_types) {
+  SetIndexHint(IndexHint::kOpOutput, op_types);
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -632,6 +724,7 @@ PDNode *PDNode::assert_is_ops_output(
 
 PDNode *PDNode::assert_is_ops_input(
     const std::unordered_set<std::string> &op_types) {
+  SetIndexHint(IndexHint::kOpInput, op_types);
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
@@ -654,6 +747,7 @@ PDNode *PDNode::assert_is_ops_input(
 
 PDNode *PDNode::assert_is_only_input_of_ops(
     const std::unordered_set<std::string> &op_types) {
+  SetIndexHint(IndexHint::kOpInput, op_types);
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
@@ -669,6 +763,7 @@ PDNode *PDNode::assert_is_only_input_of_ops(
 
 PDNode *PDNode::assert_is_only_output_of_ops(
     const std::unordered_set<std::string> &op_types) {
+  SetIndexHint(IndexHint::kOpOutput, op_types);
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -80,6 +80,12 @@ struct PDNode {
   bool IsOp() const { return type_ == Type::kOp; }
   bool IsVar() const { return type_ == Type::kVar; }
 
+  // Collect the nodes which may match this PDNode from the index of the
+  // graph. Returns false if the assertions give no op type to look up, and
+  // all the nodes of the graph have to be told.
+  bool CollectCandidates(const GraphNodeIndex& index,
+                         std::vector<Node*>* candidates) const;
+
   const std::string& name() const { return name_; }
 
   PDNode& operator=(const PDNode&) = delete;
@@ -163,6 +169,22 @@ struct PDNode {
   }
 
  private:
+  // What the op types of the first assertion on them tell.
+  enum class IndexHint {
+    kNone,
+    kOpType,   // the node is an op of one of the types
+    kOpInput,  // the node is an input of an op of one of the types
+    kOpOutput  // the node is an output of an op of one of the types
+  };
+
+  // Keep the hint of the first assertion, any of them filters the nodes.
+  template <typename Container>
+  void SetIndexHint(IndexHint hint, const Container& op_types) {
+    if (index_hint_ != IndexHint::kNone) return;
+    index_hint_ = hint;
+    hint_op_types_.assign(op_types.begin(), op_types.end());
+  }
+
   PDNode(PDPattern* pattern, const std::string& name = "",
          Type type = Type::kVar)
       : pattern_(pattern), name_(name), type_(type) {}
@@ -188,6 +210,8 @@ struct PDNode {
   std::string name_;
   Type type_;
   Role role_{Role::kUnknown};
+  IndexHint index_hint_{IndexHint::kNone};
+  std::vector<std::string> hint_op_types_;
 };
 
 /*
@@ -14,6 +14,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <string>
+
 #include "paddle/fluid/framework/ir/graph_pattern_detector.h"
 
 namespace paddle {
@@ -203,6 +206,88 @@ TEST(GraphPatternDetector, IntermediateCheck) {
   ASSERT_EQ(count, 1);
 }
 
+// relu -> relu_out -> scale, for each of `num` chains.
+static ProgramDesc BuildReluScaleProgram(int num) {
+  ProgramDesc prog;
+  auto* block = prog.MutableBlock(0);
+  for (int i = 0; i < num; ++i) {
+    auto suffix = std::to_string(i);
+    auto* relu = block->AppendOp();
+    relu->SetType("relu");
+    relu->SetInput("X", {"x" + suffix});
+    relu->SetOutput("Out", {"relu_out" + suffix});
+    auto* scale = block->AppendOp();
+    scale->SetType("scale");
+    scale->SetInput("X", {"relu_out" + suffix});
+    scale->SetOutput("Out", {"out" + suffix});
+  }
+  for (auto* op : block->AllOps()) {
+    for (auto& name : op->InputArgumentNames()) block->Var(name);
+    for (auto& name : op->OutputArgumentNames()) block->Var(name);
+  }
+  return prog;
+}
+
+static int CountReluScale(Graph* graph) {
+  GraphPatternDetector detector;
+  auto* pattern = detector.mutable_pattern();
+  auto* relu = pattern->NewNode("relu")->assert_is_op("relu");
+  auto* relu_out = pattern->NewNode("relu_out")
+                       ->assert_is_op_output("relu", "Out")
+                       ->assert_is_op_input("scale", "X");
+  auto* scale = pattern->NewNode("scale")->assert_is_op("scale");
+  relu->LinksTo({relu_out});
+  scale->LinksFrom({relu_out});
+
+  int count = 0;
+  detector(graph, [&](const GraphPatternDetector::subgraph_t& subgraph,
+                      Graph* g) { ++count; });
+  return count;
+}
+
+TEST(GraphPatternDetector, NodeIndex) {
+  ProgramDesc prog = BuildReluScaleProgram(3);
+  Graph graph(prog);
+  ASSERT_EQ(CountReluScale(&graph), 3);
+
+  auto* index = graph.NodeIndex();
+  ASSERT_EQ(index->OpNum(), 6UL);
+  ASSERT_EQ(index->Ops("relu").size(), 3UL);
+  ASSERT_EQ(index->Ops("scale").size(), 3UL);
+  ASSERT_TRUE(index->Ops("sigmoid").empty());
+
+  // The index is updated with the removed nodes.
+  Node* removed = index->Ops("scale").front();
+  for (auto* in : removed->inputs) {
+    in->outputs.erase(
+        std::remove(in->outputs.begin(), in->outputs.end(), removed),
+        in->outputs.end());
+  }
+  for (auto* out : removed->outputs) {
+    out->inputs.erase(
+        std::remove(out->inputs.begin(), out->inputs.end(), removed),
+        out->inputs.end());
+  }
+  graph.RemoveNode(removed);
+  ASSERT_EQ(index->Ops("scale").size(), 2UL);
+  ASSERT_EQ(CountReluScale(&graph), 2);
+
+  // And with the ops retyped in place.
+  Node* retyped = index->Ops("relu").front();
+  retyped->Op()->SetType("sigmoid");
+  ASSERT_EQ(graph.NodeIndex()->Ops("sigmoid").size(), 1UL);
+  ASSERT_EQ(graph.NodeIndex()->Ops("relu").size(), 2UL);
+
+  // And with the added nodes.
+  OpDesc desc;
+  desc.SetType("relu");
+  Node* added = graph.CreateOpNode(&desc);
+  ASSERT_EQ(graph.NodeIndex()->Ops("relu").size(), 3UL);
+  ASSERT_EQ(graph.NodeIndex()->OpNum(), 6UL);
+  graph.RemoveNode(added);
+  ASSERT_EQ(graph.NodeIndex()->OpNum(), 5UL);
+}
+
 }  // namespace ir
 }  // namespace framework
 }  // namespace paddle
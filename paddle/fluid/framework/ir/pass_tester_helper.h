@@ -158,6 +158,21 @@ struct Layers {
     return out;
   }
 
+  VarDesc* batch_fc(VarDesc* input, VarDesc* w, VarDesc* bias,
+                    std::string activation_type = "") {
+    VarDesc* out = lod_tensor(unique_name());
+    OpDesc* op = program_.MutableBlock(0)->AppendOp();
+    op->SetType("batch_fc");
+    op->SetInput("Input", {input->Name()});
+    op->SetInput("W", {w->Name()});
+    op->SetInput("Bias", {bias->Name()});
+    op->SetOutput("Out", {out->Name()});
+    op->SetAttr("activation_type", activation_type);
+    op->SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(),
+                static_cast<int>(OpRole::kForward));
+    return out;
+  }
+
   void lstm(VarDesc* input, VarDesc* w, VarDesc* bias, VarDesc* cell,
             VarDesc* batch_gate, VarDesc* hidden, VarDesc* batch_cell_pre_act,
             VarDesc* h0 = nullptr, VarDesc* c0 = nullptr,
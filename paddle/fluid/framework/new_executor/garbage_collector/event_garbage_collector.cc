@@ -21,6 +21,10 @@
 #include <windows.h>
 #endif  // !_WIN32
 
+#include <array>
+
+DECLARE_bool(async_cpu_garbage_collector);
+
 namespace paddle {
 namespace framework {
 
@@ -29,6 +33,10 @@ InterpreterCoreEventGarbageCollector::InterpreterCoreEventGarbageCollector() {
                            /*allow_spinning*/ true,
                            /*track_task*/ false);
   queue_ = CreateSingleThreadedWorkQueue(options);
+  if (FLAGS_async_cpu_garbage_collector && max_memory_size_ >= 0) {
+    cpu_gc_.reset(new AsyncCPUGarbageCollector(
+        platform::CPUPlace(), static_cast<size_t>(max_memory_size_)));
+  }
 }
 
 InterpreterCoreEventGarbageCollector::~InterpreterCoreEventGarbageCollector() {
@@ -42,6 +50,13 @@ void InterpreterCoreEventGarbageCollector::Add(
     return;
   }
 
+  if (cpu_gc_ && platform::is_cpu_place(ctx->GetPlace())) {
+    // the events on CPU are always finished, so the garbage can be freed by
+    // the asynchronous collector directly
+    cpu_gc_->Add(std::array<Garbage, 1>{{std::move(garbage)}});
+    return;
+  }
+
   if (max_memory_size_ <= 1) {
     Free(garbage, event, ctx);
   } else {
@@ -57,6 +72,9 @@ void InterpreterCoreEventGarbageCollector::Add(
         garbages_ = std::make_unique<GarbageQueue>();
       }
     }
+    if (pending_delete_garbages) {
+      Free(pending_delete_garbages.release(), event, ctx);
+    }
   }
 }
 
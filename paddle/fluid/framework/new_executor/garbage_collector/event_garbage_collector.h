@@ -14,6 +14,7 @@
 #pragma once
 
 #include <queue>
+#include "paddle/fluid/framework/garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/garbage_collector/garbage_collector.h"
 #include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
 
@@ -41,6 +42,8 @@ class InterpreterCoreEventGarbageCollector
 
   std::unique_ptr<WorkQueue> queue_;
   paddle::memory::SpinLock spinlock_;
+  // frees the CPU garbages in batches when FLAGS_async_cpu_garbage_collector
+  std::unique_ptr<GarbageCollector> cpu_gc_;
 };
 }  // namespace framework
 }  // namespace paddle
@@ -28,6 +28,9 @@ PADDLE_DEFINE_EXPORTED_bool(new_executor_use_inplace, true,
 PADDLE_DEFINE_EXPORTED_bool(new_executor_use_local_scope, true,
                             "Use local_scope in new executor(especially used "
                             "in UT), can turn off for better performance");
+PADDLE_DEFINE_EXPORTED_bool(new_executor_cache_infer_shape, true,
+                            "Skip the InferShape of the ops whose inputs "
+                            "keep the same shapes as the last run");
 
 DECLARE_bool(check_nan_inf);
 DECLARE_bool(benchmark);
@@ -390,9 +393,19 @@ void InterpreterCore::RunInstruction(const Instruction& instr_node) {
   {
     platform::RecordEvent infershape_event("InferShape");
     // If it is OperatorBase, InferShape do nothing.
-    if (op_with_kernel != nullptr)
-      op_with_kernel->Info().infer_shape_(
-          instr_node.InnerInferShapeContext().get());
+    if (op_with_kernel != nullptr) {
+      auto& runtime_ctx = *instr_node.InnerRuntimeContext();
+      auto* cache = instr_node.InnerInferShapeCache().get();
+      if (!FLAGS_new_executor_cache_infer_shape || !cache->Hit(runtime_ctx)) {
+        op_with_kernel->Info().infer_shape_(
+            instr_node.InnerInferShapeContext().get());
+        if (FLAGS_new_executor_cache_infer_shape) {
+          cache->Update(runtime_ctx);
+        }
+      } else {
+        VLOG(4) << "Skip InferShape of " << op->Type();
+      }
+    }
   }
 
   if (op_with_kernel != nullptr &&
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -663,6 +664,75 @@ void VariableScopeListener::onCreateScope(Scope* Scope) {}
 void VariableScopeListener::onDeleteScope(Scope* Scope) {}
 void VariableScopeListener::onClear() {}
 
+// The tensors with no more elements may be the shapes of the outputs.
+static constexpr int64_t kShapeTensorMaxNumel = 16;
+
+bool InferShapeCache::AppendMetas(const VariableValueMap& vars,
+                                  bool with_data,
+                                  std::vector<int64_t>* metas) {
+  for (auto& item : vars) {
+    metas->push_back(static_cast<int64_t>(item.second.size()));
+    for (auto* var : item.second) {
+      if (var == nullptr) {
+        metas->push_back(-1);
+        continue;
+      }
+      if (!var->IsType<LoDTensor>()) {
+        return false;
+      }
+      auto& tensor = var->Get<LoDTensor>();
+      auto& dims = tensor.dims();
+      metas->push_back(dims.size());
+      for (int i = 0; i < dims.size(); ++i) {
+        metas->push_back(dims[i]);
+      }
+      auto& lod = tensor.lod();
+      metas->push_back(static_cast<int64_t>(lod.size()));
+      for (auto& level : lod) {
+        metas->push_back(static_cast<int64_t>(level.size()));
+        metas->insert(metas->end(), level.begin(), level.end());
+      }
+      if (!with_data) {
+        continue;
+      }
+      if (!tensor.initialized()) {
+        metas->push_back(-1);
+        continue;
+      }
+      metas->push_back(static_cast<int64_t>(tensor.dtype()));
+      metas->push_back(static_cast<int64_t>(tensor.layout()));
+      auto numel = tensor.numel();
+      if (numel > kShapeTensorMaxNumel) {
+        continue;
+      }
+      if (!platform::is_cpu_place(tensor.place())) {
+        return false;
+      }
+      size_t size = numel * paddle::experimental::SizeOf(tensor.dtype());
+      size_t offset = metas->size();
+      metas->resize(offset + (size + sizeof(int64_t) - 1) / sizeof(int64_t));
+      std::memcpy(metas->data() + offset, tensor.data(), size);
+    }
+  }
+  return true;
+}
+
+bool InferShapeCache::Hit(const RuntimeContext& ctx) {
+  pending_inputs_.clear();
+  cacheable_ = AppendMetas(ctx.inputs, true, &pending_inputs_);
+  if (!valid_ || !cacheable_ || pending_inputs_ != inputs_) {
+    return false;
+  }
+  buffer_.clear();
+  return AppendMetas(ctx.outputs, false, &buffer_) && buffer_ == outputs_;
+}
+
+void InferShapeCache::Update(const RuntimeContext& ctx) {
+  inputs_.swap(pending_inputs_);
+  outputs_.clear();
+  valid_ = cacheable_ && AppendMetas(ctx.outputs, false, &outputs_);
+}
+
 Instruction::Instruction(size_t id, OpFuncNode&& op_func_node,
                          const platform::DeviceContext& dev_ctx)
     : id_(id), op_func_node_(op_func_node), dev_ctx_(dev_ctx) {
@@ -723,6 +793,7 @@ void Instruction::ResetContext(const VariableValueMap& in_vars,
   static framework::Scope scope_;
   execution_ctx_.reset(
       new ExecutionContext(*OpBase(), scope_, dev_ctx_, *runtime_ctx_.get()));
+  infershape_cache_.reset(new InferShapeCache());
 }
 
 std::shared_ptr<RuntimeContext> Instruction::InnerRuntimeContext() const {
@@ -734,6 +805,10 @@ Instruction::InnerInferShapeContext() const {
   return infershape_ctx_;
 }
 
+std::shared_ptr<InferShapeCache> Instruction::InnerInferShapeCache() const {
+  return infershape_cache_;
+}
+
 std::shared_ptr<ExecutionContext> Instruction::InnerExecutionContext() const {
   return execution_ctx_;
 }
@@ -306,6 +306,42 @@ struct OpFuncNode {
   OpFuncType type_;
 };
 
+/*
+ * InferShapeCache records the metas of the inputs of an instruction at its
+ * last InferShape, and the metas of the outputs after it. If they are the
+ * same at the next run, InferShape would give the same outputs, and it is
+ * skipped. So only the ops whose inputs change shape, e.g. with the
+ * sequence length of the feeds, infer their shapes again.
+ *
+ * The data of the small CPU tensors are recorded too, since they may be
+ * the shape of the outputs. The ops with other inputs or outputs, e.g. the
+ * small tensors on devices or the LoDTensorArrays, are never skipped.
+ */
+class InferShapeCache {
+ public:
+  // Whether the metas are the same as the recorded ones.
+  bool Hit(const RuntimeContext& ctx);
+
+  // Record the metas after InferShape, must follow a Hit which returns
+  // false.
+  void Update(const RuntimeContext& ctx);
+
+  void Clear() { valid_ = false; }
+
+ private:
+  // Returns false if the vars can't be recorded.
+  static bool AppendMetas(const VariableValueMap& vars, bool with_data,
+                          std::vector<int64_t>* metas);
+
+  bool valid_{false};
+  bool cacheable_{false};
+  std::vector<int64_t> inputs_;
+  std::vector<int64_t> outputs_;
+  // the metas of the inputs taken by the last Hit
+  std::vector<int64_t> pending_inputs_;
+  std::vector<int64_t> buffer_;
+};
+
 class Instruction {
  public:
   Instruction(size_t id, OpFuncNode&& op_func_node,
@@ -345,6 +381,8 @@ class Instruction {
 
   std::shared_ptr<ExecutionContext> InnerExecutionContext() const;
 
+  std::shared_ptr<InferShapeCache> InnerInferShapeCache() const;
+
   const platform::DeviceContext& DeviceContext() const;
 
   const std::vector<std::pair<Variable*, Variable*>>& InplaceInfo() const;
@@ -371,6 +409,7 @@ class Instruction {
   std::shared_ptr<RuntimeContext> runtime_ctx_;
   std::shared_ptr<InterpretercoreInferShapeContext> infershape_ctx_;
   std::shared_ptr<ExecutionContext> execution_ctx_;
+  std::shared_ptr<InferShapeCache> infershape_cache_;
 
   std::vector<size_t> gc_check_var_list_;
   NextInstruction next_instruction_;
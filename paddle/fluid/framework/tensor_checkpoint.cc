@@ -0,0 +1,602 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/tensor_checkpoint.h"
+
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <sstream>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/convert_utils.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/tensor_util.h"
+
+DEFINE_int32(tensor_checkpoint_thread_num, 8,
+             "number of threads used to snapshot, write and read the data "
+             "blocks of a chunked tensor checkpoint, default 8");
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'D', 'T', 'C', 'K', 'P', 'T', '\0'};
+constexpr uint32_t kVersion = 0;
+
+constexpr uint64_t kFNVOffset = 14695981039346656037ULL;
+constexpr uint64_t kFNVPrime = 1099511628211ULL;
+
+// FNV-1a over 8 byte words, cheap enough to keep up with the disk.
+uint64_t ChunkChecksum(const char* data, size_t size) {
+  uint64_t hash = kFNVOffset;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * kFNVPrime;
+  }
+  for (; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(data[i])) * kFNVPrime;
+  }
+  return hash;
+}
+
+uint64_t CombineChecksum(const std::vector<uint64_t>& chunk_sums) {
+  uint64_t hash = kFNVOffset;
+  for (auto sum : chunk_sums) {
+    hash = (hash ^ sum) * kFNVPrime;
+  }
+  return hash;
+}
+
+uint64_t AlignUp(uint64_t size) {
+  return (size + kTensorCheckpointAlign - 1) / kTensorCheckpointAlign *
+         kTensorCheckpointAlign;
+}
+
+int ThreadNum(int thread_num) {
+  if (thread_num <= 0) thread_num = FLAGS_tensor_checkpoint_thread_num;
+  return std::max(thread_num, 1);
+}
+
+// Runs fn(0) ... fn(task_num - 1) on up to thread_num threads and rethrows
+// the first error.
+void ParallelRun(size_t task_num, int thread_num,
+                 const std::function<void(size_t)>& fn) {
+  size_t worker_num = std::min(task_num, static_cast<size_t>(thread_num));
+  if (worker_num <= 1) {
+    for (size_t i = 0; i < task_num; ++i) fn(i);
+    return;
+  }
+  std::atomic<size_t> next{0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < worker_num; ++t) {
+    workers.emplace_back([&] {
+      try {
+        for (size_t i = next++; i < task_num; i = next++) fn(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(error_mutex);
+        if (!error) error = std::current_exception();
+        next = task_num;
+      }
+    });
+  }
+  for (auto& worker : workers) worker.join();
+  if (error) std::rethrow_exception(error);
+}
+
+template <typename T>
+void WritePOD(std::ostream& os, const T& value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+void ReadPOD(std::istream& is, T* value) {
+  is.read(reinterpret_cast<char*>(value), sizeof(*value));
+}
+
+std::string SerializeHeader(const std::vector<TensorCheckpointEntry>& entries,
+                            uint64_t chunk_size) {
+  std::ostringstream os;
+  os.write(kMagic, sizeof(kMagic));
+  WritePOD(os, kVersion);
+  WritePOD(os, static_cast<uint32_t>(0));
+  WritePOD(os, chunk_size);
+  WritePOD(os, static_cast<uint64_t>(entries.size()));
+  for (auto& entry : entries) {
+    WritePOD(os, static_cast<uint32_t>(entry.name.size()));
+    os.write(entry.name.data(), entry.name.size());
+
+    proto::VarType::TensorDesc desc;
+    desc.set_data_type(entry.dtype);
+    for (auto dim : entry.dims) desc.add_dims(dim);
+    auto desc_str = desc.SerializeAsString();
+    WritePOD(os, static_cast<int32_t>(desc_str.size()));
+    os.write(desc_str.data(), desc_str.size());
+
+    WritePOD(os, static_cast<uint64_t>(entry.lod.size()));
+    for (auto& level : entry.lod) {
+      uint64_t size = level.size() * sizeof(LoD::value_type::value_type);
+      WritePOD(os, size);
+      os.write(reinterpret_cast<const char*>(level.data()), size);
+    }
+
+    WritePOD(os, entry.offset);
+    WritePOD(os, entry.size);
+    WritePOD(os, entry.checksum);
+  }
+  return os.str();
+}
+
+size_t ChunkNum(uint64_t size, uint64_t chunk_size) {
+  return (size + chunk_size - 1) / chunk_size;
+}
+
+struct ChunkTask {
+  size_t entry;
+  size_t chunk;
+};
+
+std::vector<ChunkTask> SplitChunks(
+    const std::vector<TensorCheckpointEntry>& entries,
+    const std::vector<size_t>& indices, uint64_t chunk_size,
+    std::vector<std::vector<uint64_t>>* chunk_sums) {
+  std::vector<ChunkTask> tasks;
+  chunk_sums->resize(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    size_t chunk_num = ChunkNum(entries[indices[i]].size, chunk_size);
+    (*chunk_sums)[i].resize(chunk_num);
+    for (size_t c = 0; c < chunk_num; ++c) tasks.push_back({i, c});
+  }
+  return tasks;
+}
+
+// Forces the data of `path` to the disk. On posix `path` may also be a
+// directory, whose entries, e.g. a rename into it, are synced then.
+void SyncPath(const std::string& path, bool directory) {
+#ifdef _WIN32
+  // windows commits the directory entries with the file
+  if (directory) return;
+  int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+#else
+  int fd = open(path.c_str(), directory ? O_RDONLY : O_WRONLY);
+#endif
+  PADDLE_ENFORCE_GE(fd, 0, platform::errors::Unavailable(
+                               "Cannot open %s to sync it to disk.", path));
+#ifdef _WIN32
+  int ret = _commit(fd);
+  _close(fd);
+#else
+  int ret = fsync(fd);
+  close(fd);
+#endif
+  PADDLE_ENFORCE_EQ(
+      ret, 0, platform::errors::Unavailable("Failed to sync %s to disk.", path));
+}
+
+std::string ParentDir(const std::string& file_name) {
+  auto pos = file_name.find_last_of("/\\");
+  if (pos == std::string::npos) return ".";
+  if (pos == 0) return "/";
+  return file_name.substr(0, pos);
+}
+
+std::mutex& PendingMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::unordered_map<std::string, std::unique_ptr<TensorCheckpointWriter>>&
+PendingWriters() {
+  static std::unordered_map<std::string,
+                            std::unique_ptr<TensorCheckpointWriter>>
+      writers;
+  return writers;
+}
+
+}  // namespace
+
+bool IsTensorCheckpoint(const std::string& file_name) {
+  std::ifstream fin(file_name, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  fin.read(magic, sizeof(magic));
+  return fin && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+TensorCheckpointWriter::TensorCheckpointWriter(const std::string& file_name,
+                                               int thread_num,
+                                               uint64_t chunk_size)
+    : file_name_(file_name),
+      thread_num_(ThreadNum(thread_num)),
+      chunk_size_(chunk_size) {
+  PADDLE_ENFORCE_GT(chunk_size_, 0UL,
+                    platform::errors::InvalidArgument(
+                        "The chunk size of checkpoint %s should be positive.",
+                        file_name_));
+}
+
+TensorCheckpointWriter::~TensorCheckpointWriter() {
+  if (flush_thread_.joinable()) flush_thread_.join();
+  if (flush_error_) {
+    try {
+      std::rethrow_exception(flush_error_);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Failed to save tensor checkpoint " << file_name_ << ": "
+                 << e.what();
+    } catch (...) {
+      LOG(ERROR) << "Failed to save tensor checkpoint " << file_name_ << ".";
+    }
+  }
+}
+
+void TensorCheckpointWriter::Add(const std::string& name,
+                                 const LoDTensor& tensor,
+                                 const platform::DeviceContext& dev_ctx,
+                                 bool share_buffer) {
+  PADDLE_ENFORCE_EQ(Flushing(), false,
+                    platform::errors::PreconditionNotMet(
+                        "Cannot add tensor %s to checkpoint %s while it is "
+                        "being flushed.",
+                        name, file_name_));
+  PADDLE_ENFORCE_EQ(
+      tensor.IsInitialized(), true,
+      platform::errors::InvalidArgument(
+          "The tensor %s to be saved is not initialized.", name));
+  TensorCheckpointEntry entry;
+  entry.name = name;
+  entry.dtype = TransToProtoVarType(tensor.dtype());
+  entry.dims = vectorize(tensor.dims());
+  entry.lod = tensor.lod();
+  entry.size = tensor.numel() * DataTypeSize(tensor.dtype());
+
+  LoDTensor snapshot;
+  if (!platform::is_cpu_place(tensor.place())) {
+    TensorCopy(tensor, platform::CPUPlace(), dev_ctx, &snapshot);
+    dev_ctx.Wait();
+  } else if (share_buffer) {
+    snapshot.ShareDataWith(tensor);
+  } else if (entry.size > 0) {
+    snapshot.Resize(tensor.dims());
+    char* dst = reinterpret_cast<char*>(
+        snapshot.mutable_data(platform::CPUPlace(), tensor.dtype()));
+    const char* src = reinterpret_cast<const char*>(tensor.data());
+    uint64_t size = entry.size;
+    ParallelRun(ChunkNum(size, chunk_size_), thread_num_, [&](size_t c) {
+      uint64_t begin = c * chunk_size_;
+      std::memcpy(dst + begin, src + begin,
+                  std::min(chunk_size_, size - begin));
+    });
+  }
+  entries_.push_back(std::move(entry));
+  snapshots_.push_back(std::move(snapshot));
+}
+
+void TensorCheckpointWriter::FlushAsync() {
+  PADDLE_ENFORCE_EQ(Flushing(), false,
+                    platform::errors::PreconditionNotMet(
+                        "Checkpoint %s is already being flushed.", file_name_));
+  flush_error_ = nullptr;
+  flush_done_ = false;
+  flush_thread_ = std::thread([this] {
+    try {
+      Flush();
+    } catch (...) {
+      flush_error_ = std::current_exception();
+    }
+    flush_done_ = true;
+  });
+}
+
+void TensorCheckpointWriter::Wait() {
+  if (flush_thread_.joinable()) flush_thread_.join();
+  if (flush_error_) {
+    auto error = flush_error_;
+    flush_error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void TensorCheckpointWriter::Flush() {
+  // the header has a fixed size once the names, shapes and LoDs are known
+  uint64_t offset = AlignUp(SerializeHeader(entries_, chunk_size_).size());
+  for (auto& entry : entries_) {
+    entry.offset = offset;
+    offset = AlignUp(offset + entry.size);
+  }
+  uint64_t file_size = entries_.empty()
+                           ? offset
+                           : entries_.back().offset + entries_.back().size;
+
+  std::string tmp_name = file_name_ + ".tmp";
+  {
+    std::ofstream fout(tmp_name, std::ios::binary | std::ios::trunc);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                      platform::errors::Unavailable(
+                          "Cannot open %s to save checkpoint.", tmp_name));
+    if (file_size > 0) {
+      fout.seekp(file_size - 1);
+      fout.put('\0');
+    }
+  }
+
+  std::vector<size_t> indices(entries_.size());
+  for (size_t i = 0; i < indices.size(); ++i) indices[i] = i;
+  std::vector<std::vector<uint64_t>> chunk_sums;
+  auto tasks = SplitChunks(entries_, indices, chunk_size_, &chunk_sums);
+  ParallelRun(tasks.size(), thread_num_, [&](size_t t) {
+    auto& entry = entries_[tasks[t].entry];
+    uint64_t begin = tasks[t].chunk * chunk_size_;
+    uint64_t size = std::min(chunk_size_, entry.size - begin);
+    const char* data =
+        reinterpret_cast<const char*>(snapshots_[tasks[t].entry].data()) +
+        begin;
+    chunk_sums[tasks[t].entry][tasks[t].chunk] = ChunkChecksum(data, size);
+
+    std::fstream fout(tmp_name,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    fout.seekp(entry.offset + begin);
+    fout.write(data, size);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                      platform::errors::Unavailable(
+                          "Failed to write tensor %s to checkpoint %s.",
+                          entry.name, tmp_name));
+  });
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    entries_[i].checksum = CombineChecksum(chunk_sums[i]);
+  }
+
+  {
+    std::fstream fout(tmp_name,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    auto header = SerializeHeader(entries_, chunk_size_);
+    fout.write(header.data(), header.size());
+    fout.flush();
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                      platform::errors::Unavailable(
+                          "Failed to write the header of checkpoint %s.",
+                          tmp_name));
+  }
+  // the data must reach the disk before the rename can expose it
+  SyncPath(tmp_name, false);
+#ifdef _WIN32
+  // rename does not replace an existing file on windows
+  std::remove(file_name_.c_str());
+#endif
+  PADDLE_ENFORCE_EQ(
+      std::rename(tmp_name.c_str(), file_name_.c_str()), 0,
+      platform::errors::Unavailable("Failed to rename checkpoint %s to %s.",
+                                    tmp_name, file_name_));
+  SyncPath(ParentDir(file_name_), true);
+  // release the snapshots as soon as they are on disk
+  snapshots_.clear();
+}
+
+TensorCheckpointReader::TensorCheckpointReader(const std::string& file_name,
+                                               int thread_num)
+    : file_name_(file_name), thread_num_(ThreadNum(thread_num)) {
+  std::ifstream fin(file_name, std::ios::binary);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                    platform::errors::Unavailable(
+                        "Cannot open checkpoint %s to load.", file_name));
+  char magic[sizeof(kMagic)];
+  fin.read(magic, sizeof(magic));
+  PADDLE_ENFORCE_EQ(
+      static_cast<bool>(fin) &&
+          std::memcmp(magic, kMagic, sizeof(kMagic)) == 0,
+      true, platform::errors::InvalidArgument(
+                "%s is not a chunked tensor checkpoint.", file_name));
+  uint32_t version, reserved;
+  ReadPOD(fin, &version);
+  ReadPOD(fin, &reserved);
+  PADDLE_ENFORCE_EQ(version, kVersion,
+                    platform::errors::InvalidArgument(
+                        "Checkpoint version %u is not supported.", version));
+  uint64_t entry_num;
+  ReadPOD(fin, &chunk_size_);
+  ReadPOD(fin, &entry_num);
+  PADDLE_ENFORCE_GT(chunk_size_, 0UL,
+                    platform::errors::InvalidArgument(
+                        "The chunk size of checkpoint %s is 0.", file_name));
+
+  entries_.resize(entry_num);
+  for (uint64_t i = 0; i < entry_num; ++i) {
+    auto& entry = entries_[i];
+    uint32_t name_size;
+    ReadPOD(fin, &name_size);
+    entry.name.resize(name_size);
+    fin.read(&entry.name[0], name_size);
+
+    int32_t desc_size;
+    ReadPOD(fin, &desc_size);
+    std::string desc_str(desc_size, '\0');
+    fin.read(&desc_str[0], desc_size);
+    proto::VarType::TensorDesc desc;
+    PADDLE_ENFORCE_EQ(desc.ParseFromString(desc_str), true,
+                      platform::errors::InvalidArgument(
+                          "Cannot parse the tensor desc of %s in checkpoint "
+                          "%s.",
+                          entry.name, file_name));
+    entry.dtype = desc.data_type();
+    entry.dims.assign(desc.dims().begin(), desc.dims().end());
+
+    uint64_t lod_level;
+    ReadPOD(fin, &lod_level);
+    entry.lod.resize(lod_level);
+    for (uint64_t j = 0; j < lod_level; ++j) {
+      uint64_t size;
+      ReadPOD(fin, &size);
+      std::vector<size_t> level(size / sizeof(size_t));
+      fin.read(reinterpret_cast<char*>(level.data()), size);
+      entry.lod[j] = level;
+    }
+
+    ReadPOD(fin, &entry.offset);
+    ReadPOD(fin, &entry.size);
+    ReadPOD(fin, &entry.checksum);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                      platform::errors::Unavailable(
+                          "The header of checkpoint %s is damaged.",
+                          file_name));
+    name_to_entry_[entry.name] = i;
+  }
+}
+
+size_t TensorCheckpointReader::EntryIndex(const std::string& name) const {
+  auto iter = name_to_entry_.find(name);
+  PADDLE_ENFORCE_EQ(iter != name_to_entry_.end(), true,
+                    platform::errors::NotFound(
+                        "Tensor %s is not found in checkpoint %s.", name,
+                        file_name_));
+  return iter->second;
+}
+
+void TensorCheckpointReader::Load(
+    const std::string& name, LoDTensor* tensor,
+    const platform::DeviceContext& dev_ctx) const {
+  LoadEntries({EntryIndex(name)}, {tensor}, dev_ctx);
+}
+
+void TensorCheckpointReader::LoadEntries(
+    const std::vector<size_t>& indices, const std::vector<LoDTensor*>& tensors,
+    const platform::DeviceContext& dev_ctx) const {
+  PADDLE_ENFORCE_EQ(indices.size(), tensors.size(),
+                    platform::errors::InvalidArgument(
+                        "The number of entries to load (%d) does not match "
+                        "the number of tensors (%d).",
+                        indices.size(), tensors.size()));
+  bool on_cpu = platform::is_cpu_place(dev_ctx.GetPlace());
+  std::vector<LoDTensor> staging(on_cpu ? 0 : tensors.size());
+  std::vector<char*> buffers(tensors.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    PADDLE_ENFORCE_LT(indices[i], entries_.size(),
+                      platform::errors::OutOfRange(
+                          "Entry %d is out of range, checkpoint %s has %d "
+                          "entries.",
+                          indices[i], file_name_, entries_.size()));
+    auto& entry = entries_[indices[i]];
+    LoDTensor* dst = on_cpu ? tensors[i] : &staging[i];
+    dst->Resize(make_ddim(entry.dims));
+    buffers[i] = reinterpret_cast<char*>(dst->mutable_data(
+        platform::CPUPlace(), TransToPtenDataType(entry.dtype)));
+    PADDLE_ENFORCE_EQ(
+        dst->numel() * DataTypeSize(dst->dtype()), entry.size,
+        platform::errors::InvalidArgument(
+            "The data size of tensor %s in checkpoint %s does not match its "
+            "shape.",
+            entry.name, file_name_));
+  }
+
+  std::vector<std::vector<uint64_t>> chunk_sums;
+  auto tasks = SplitChunks(entries_, indices, chunk_size_, &chunk_sums);
+  ParallelRun(tasks.size(), thread_num_, [&](size_t t) {
+    auto& entry = entries_[indices[tasks[t].entry]];
+    uint64_t begin = tasks[t].chunk * chunk_size_;
+    uint64_t size = std::min(chunk_size_, entry.size - begin);
+    char* data = buffers[tasks[t].entry] + begin;
+
+    std::ifstream fin(file_name_, std::ios::binary);
+    fin.seekg(entry.offset + begin);
+    fin.read(data, size);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                      platform::errors::Unavailable(
+                          "Failed to read tensor %s from checkpoint %s.",
+                          entry.name, file_name_));
+    chunk_sums[tasks[t].entry][tasks[t].chunk] = ChunkChecksum(data, size);
+  });
+
+  for (size_t i = 0; i < indices.size(); ++i) {
+    auto& entry = entries_[indices[i]];
+    PADDLE_ENFORCE_EQ(
+        CombineChecksum(chunk_sums[i]), entry.checksum,
+        platform::errors::Unavailable(
+            "Checksum mismatch of tensor %s, checkpoint %s is damaged.",
+            entry.name, file_name_));
+    if (!on_cpu) {
+      TensorCopy(staging[i], dev_ctx.GetPlace(), dev_ctx, tensors[i]);
+    }
+    tensors[i]->set_lod(entry.lod);
+  }
+  if (!on_cpu) dev_ctx.Wait();
+}
+
+// Takes the pending writers whose flush has finished, and rethrows the
+// first of their errors.
+static void CollectFinishedCheckpoints() {
+  std::vector<std::unique_ptr<TensorCheckpointWriter>> finished;
+  {
+    std::lock_guard<std::mutex> guard(PendingMutex());
+    auto& writers = PendingWriters();
+    for (auto iter = writers.begin(); iter != writers.end();) {
+      if (iter->second->FlushDone()) {
+        finished.push_back(std::move(iter->second));
+        iter = writers.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+  std::exception_ptr error;
+  for (auto& writer : finished) {
+    try {
+      writer->Wait();
+    } catch (...) {
+      if (!error) error = std::current_exception();
+    }
+  }
+  if (error) std::rethrow_exception(error);
+}
+
+void SaveTensorCheckpointAsync(std::unique_ptr<TensorCheckpointWriter> writer,
+                               const std::string& file_name) {
+  WaitTensorCheckpoint(file_name);
+  if (!writer->Flushing()) writer->FlushAsync();
+  {
+    std::lock_guard<std::mutex> guard(PendingMutex());
+    PendingWriters()[file_name] = std::move(writer);
+  }
+  CollectFinishedCheckpoints();
+}
+
+void WaitTensorCheckpoint(const std::string& file_name) {
+  std::unique_ptr<TensorCheckpointWriter> writer;
+  {
+    std::lock_guard<std::mutex> guard(PendingMutex());
+    auto iter = PendingWriters().find(file_name);
+    if (iter != PendingWriters().end()) {
+      writer = std::move(iter->second);
+      PendingWriters().erase(iter);
+    }
+  }
+  if (writer) writer->Wait();
+  CollectFinishedCheckpoints();
+}
+
+}  // namespace framework
+}  // namespace paddle
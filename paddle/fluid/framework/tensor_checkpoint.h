@@ -0,0 +1,157 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * The chunked tensor checkpoint stores a list of LoDTensors in one file:
+ *
+ *   char[8]  magic "PDTCKPT\0"
+ *   uint32_t version
+ *   uint32_t reserved
+ *   uint64_t chunk size in byte
+ *   uint64_t entry num
+ *   entries: name, TensorDesc, LoD, data offset, data size, checksum
+ *   padding to kTensorCheckpointAlign
+ *   data blocks, each one starts at a multiple of kTensorCheckpointAlign
+ *
+ * Since the header indexes every data block, the blocks are written and read
+ * by several threads at once, and a reader can load any single tensor
+ * without touching the others. The checksum of a tensor is computed over its
+ * chunks of `chunk size` bytes, so it can be verified chunk by chunk in
+ * parallel as well.
+ */
+constexpr uint64_t kTensorCheckpointAlign = 4096;
+constexpr uint64_t kTensorCheckpointChunkSize = 64UL << 20;  // 64MB
+
+struct TensorCheckpointEntry {
+  std::string name;
+  proto::VarType::Type dtype;
+  std::vector<int64_t> dims;
+  LoD lod;
+  uint64_t offset{0};
+  uint64_t size{0};
+  uint64_t checksum{0};
+};
+
+// Returns true if `file_name` is a chunked tensor checkpoint.
+bool IsTensorCheckpoint(const std::string& file_name);
+
+class TensorCheckpointWriter {
+ public:
+  // thread_num of 0 means FLAGS_tensor_checkpoint_thread_num.
+  explicit TensorCheckpointWriter(
+      const std::string& file_name, int thread_num = 0,
+      uint64_t chunk_size = kTensorCheckpointChunkSize);
+  ~TensorCheckpointWriter();
+
+  // Snapshots `tensor` into host memory, so the caller may modify or release
+  // it as soon as Add returns. The copy of large CPU tensors is split across
+  // threads. When `share_buffer` is true the tensor memory is referenced
+  // instead of copied, and the caller must not write it until Wait returns.
+  void Add(const std::string& name, const LoDTensor& tensor,
+           const platform::DeviceContext& dev_ctx, bool share_buffer = false);
+
+  // Starts writing the snapshots on background threads. The file is written
+  // under a temporary name, synced to disk and then renamed, and the rename
+  // is synced as well, so a crash never leaves a truncated checkpoint
+  // behind.
+  void FlushAsync();
+
+  // Blocks until the background flush finishes and rethrows its error. An
+  // error that is never taken by Wait is logged by the destructor.
+  void Wait();
+
+  bool Flushing() const { return flush_thread_.joinable(); }
+
+  // Whether the background flush has finished, so that Wait won't block.
+  bool FlushDone() const { return flush_done_; }
+
+ private:
+  void Flush();
+
+  std::string file_name_;
+  int thread_num_;
+  uint64_t chunk_size_;
+  std::vector<TensorCheckpointEntry> entries_;
+  std::vector<LoDTensor> snapshots_;
+  std::thread flush_thread_;
+  std::exception_ptr flush_error_;
+  std::atomic<bool> flush_done_{false};
+};
+
+class TensorCheckpointReader {
+ public:
+  // thread_num of 0 means FLAGS_tensor_checkpoint_thread_num.
+  explicit TensorCheckpointReader(const std::string& file_name,
+                                  int thread_num = 0);
+
+  const std::vector<TensorCheckpointEntry>& entries() const {
+    return entries_;
+  }
+
+  bool Has(const std::string& name) const {
+    return name_to_entry_.count(name) > 0;
+  }
+
+  // Returns the index of the tensor saved as `name` in entries().
+  size_t EntryIndex(const std::string& name) const;
+
+  // Loads the tensor saved as `name` by random access.
+  void Load(const std::string& name, LoDTensor* tensor,
+            const platform::DeviceContext& dev_ctx) const;
+
+  // Loads entries()[indices[i]] into tensors[i], reading and verifying all
+  // data blocks in parallel.
+  void LoadEntries(const std::vector<size_t>& indices,
+                   const std::vector<LoDTensor*>& tensors,
+                   const platform::DeviceContext& dev_ctx) const;
+
+ private:
+  std::string file_name_;
+  int thread_num_;
+  uint64_t chunk_size_{0};
+  std::vector<TensorCheckpointEntry> entries_;
+  std::unordered_map<std::string, size_t> name_to_entry_;
+};
+
+// Keeps `writer` alive until its background flush finishes. A later save or
+// load of the same file should call WaitTensorCheckpoint first.
+void SaveTensorCheckpointAsync(std::unique_ptr<TensorCheckpointWriter> writer,
+                               const std::string& file_name);
+
+// Waits for the pending async save of `file_name`, if any.
+//
+// Both functions also collect the async saves of the other files that have
+// finished, and rethrow the first error among them, so that a failed save is
+// reported by the next save or wait even if its file is never waited on.
+void WaitTensorCheckpoint(const std::string& file_name);
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,157 @@
+//   Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/tensor_checkpoint.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+static void FillTensor(LoDTensor* tensor, const DDim& dims, float base) {
+  tensor->Resize(dims);
+  float* data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = base + i;
+  }
+}
+
+TEST(TensorCheckpoint, SaveAndRandomAccess) {
+  platform::CPUDeviceContext ctx;
+  std::string path = "./tensor_checkpoint_test.ckpt";
+
+  LoDTensor x, y, z;
+  FillTensor(&x, make_ddim({10, 10}), 0);
+  x.set_lod({{0, 2, 10}});
+  FillTensor(&y, make_ddim({3, 7}), 100);
+  z.Resize(make_ddim({5}));
+  int64_t* z_data = z.mutable_data<int64_t>(platform::CPUPlace());
+  for (int i = 0; i < 5; ++i) z_data[i] = i * 11;
+
+  TensorCheckpointWriter writer(path, 4);
+  writer.Add("x", x, ctx);
+  writer.Add("y", y, ctx);
+  writer.Add("z", z, ctx);
+  writer.FlushAsync();
+  // the snapshot is taken already, changing the source must not leak in
+  x.data<float>()[0] = -1;
+  writer.Wait();
+  ASSERT_TRUE(IsTensorCheckpoint(path));
+
+  TensorCheckpointReader reader(path, 4);
+  ASSERT_EQ(reader.entries().size(), 3UL);
+  for (auto& entry : reader.entries()) {
+    ASSERT_EQ(entry.offset % kTensorCheckpointAlign, 0UL);
+  }
+
+  LoDTensor z_out;
+  reader.Load("z", &z_out, ctx);
+  ASSERT_EQ(z_out.dims(), make_ddim({5}));
+  for (int i = 0; i < 5; ++i) ASSERT_EQ(z_out.data<int64_t>()[i], i * 11);
+
+  LoDTensor x_out;
+  reader.Load("x", &x_out, ctx);
+  ASSERT_EQ(x_out.dims(), make_ddim({10, 10}));
+  ASSERT_EQ(x_out.lod().size(), 1UL);
+  ASSERT_EQ(x_out.lod()[0][1], 2UL);
+  ASSERT_EQ(x_out.data<float>()[0], 0);
+  ASSERT_EQ(x_out.data<float>()[99], 99);
+  ASSERT_FALSE(reader.Has("w"));
+
+  // corrupt one byte of y and expect the checksum to catch it
+  {
+    std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(reader.entries()[reader.EntryIndex("y")].offset + 4);
+    f.put(0x7f);
+  }
+  TensorCheckpointReader damaged(path, 4);
+  LoDTensor y_out;
+  ASSERT_THROW(damaged.Load("y", &y_out, ctx), platform::EnforceNotMet);
+  remove(path.c_str());
+}
+
+TEST(TensorCheckpoint, AsyncSaveErrorReportedByNextWait) {
+  platform::CPUDeviceContext ctx;
+  LoDTensor x;
+  FillTensor(&x, make_ddim({16}), 0);
+  std::unique_ptr<TensorCheckpointWriter> writer(
+      new TensorCheckpointWriter("./no_such_dir/tensor_checkpoint.ckpt", 2));
+  writer->Add("x", x, ctx);
+  SaveTensorCheckpointAsync(std::move(writer),
+                            "./no_such_dir/tensor_checkpoint.ckpt");
+  // The failed save is reported by a wait of another file once its flush
+  // has finished.
+  bool reported = false;
+  for (int i = 0; i < 500 && !reported; ++i) {
+    try {
+      WaitTensorCheckpoint("./another_tensor_checkpoint.ckpt");
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    } catch (const platform::EnforceNotMet&) {
+      reported = true;
+    }
+  }
+  ASSERT_TRUE(reported);
+  // and only once
+  WaitTensorCheckpoint("./another_tensor_checkpoint.ckpt");
+}
+
+TEST(TensorCheckpoint, ManyChunks) {
+  platform::CPUDeviceContext ctx;
+  const int tensor_num = 4;
+  const int64_t numel = 1024 * 1024 + 3;  // about 4MB per tensor
+  // small chunks, so each tensor is written and verified in many of them
+  const uint64_t chunk_size = 256 * 1024;
+  std::vector<LoDTensor> tensors(tensor_num);
+  for (int i = 0; i < tensor_num; ++i) {
+    FillTensor(&tensors[i], make_ddim({numel}), i);
+  }
+
+  std::string path = "./tensor_checkpoint_many_chunks.ckpt";
+  TensorCheckpointWriter writer(path, 4, chunk_size);
+  for (int i = 0; i < tensor_num; ++i) {
+    writer.Add("t" + std::to_string(i), tensors[i], ctx);
+  }
+  writer.FlushAsync();
+  writer.Wait();
+
+  TensorCheckpointReader reader(path, 4);
+  std::vector<LoDTensor> loaded(tensor_num);
+  std::vector<size_t> indices;
+  std::vector<LoDTensor*> outputs;
+  for (int i = 0; i < tensor_num; ++i) {
+    indices.push_back(reader.EntryIndex("t" + std::to_string(i)));
+    outputs.push_back(&loaded[i]);
+  }
+  reader.LoadEntries(indices, outputs, ctx);
+  for (int i = 0; i < tensor_num; ++i) {
+    ASSERT_EQ(loaded[i].numel(), numel);
+    const float* expected = tensors[i].data<float>();
+    const float* actual = loaded[i].data<float>();
+    for (int64_t k = 0; k < numel; ++k) {
+      ASSERT_EQ(actual[k], expected[k]);
+    }
+  }
+  remove(path.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include <algorithm>
+#include <atomic>
 #include <limits>
 #include <memory>
 #include <string>
@@ -1137,6 +1138,12 @@ struct DeserializedDataFunctor {
   platform::Place place_;
 };
 
+static std::atomic<uint64_t> tensor_load_generation{0};
+
+uint64_t TensorLoadGeneration() { return tensor_load_generation.load(); }
+
+void BumpTensorLoadGeneration() { ++tensor_load_generation; }
+
 void TensorFromStream(std::istream& is, Tensor* tensor,
                       const platform::DeviceContext& dev_ctx,
                       const size_t& seek, const std::vector<int64_t>& shape) {
@@ -1210,6 +1217,7 @@ void TensorFromStream(std::istream& is, Tensor* tensor,
       is.read(static_cast<char*>(buf), size);
     }
   }
+  BumpTensorLoadGeneration();
 }
 
 void TensorFromStream(std::istream& is, Tensor* tensor,
@@ -1285,6 +1293,7 @@ void TensorFromStream(std::istream& is, Tensor* tensor,
       is.read(static_cast<char*>(buf), size);
     }
   }
+  BumpTensorLoadGeneration();
 }
 
 // get tensor data point by DLDataType
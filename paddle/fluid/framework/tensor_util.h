@@ -67,6 +67,12 @@ void TensorFromStream(std::istream& is, Tensor* tensor,
                       const platform::DeviceContext& dev_ctx,
                       const size_t& seek, const std::vector<int64_t>& shape);
 
+// Bumped whenever the contents of a tensor are loaded from a stream or set
+// from python, so the values computed from loaded parameters, such as the
+// fingerprints of filters, know when to be recomputed.
+uint64_t TensorLoadGeneration();
+void BumpTensorLoadGeneration();
+
 // NOTE(zcd): Because TensorCopy is an async operation, when the src_place
 // and dst_place are two different GPU, to ensure that the operation can
 // be carried out correctly, there is a src_ctx wait operation in TensorCopy.
@@ -33,10 +33,21 @@
 #include "paddle/pten/kernels/funcs/math_function.h"
 
 DECLARE_bool(sort_sum_gradient);
+DECLARE_bool(lazy_sum_gradient);
 
 namespace paddle {
 namespace imperative {
 
+static GradientAccumulator* CreateGradientAccumulator(VariableWrapper* var) {
+  if (FLAGS_sort_sum_gradient) {
+    return new SortedGradientAccumulator(var);
+  } else if (FLAGS_lazy_sum_gradient) {
+    return new LazyGradientAccumulator(var);
+  } else {
+    return new EagerGradientAccumulator(var);
+  }
+}
+
 void BasicEngine::Init(
     const std::vector<std::shared_ptr<VarBase>>& tensors,
     const std::vector<std::shared_ptr<VarBase>>& grad_tensors,
@@ -116,11 +127,7 @@ void BasicEngine::Init(
         accumulators_with_grad_node_[init_grad_var->GetGradNode()]
                                     [init_grad_var];
     if (!accumulator) {
-      if (FLAGS_sort_sum_gradient) {
-        accumulator.reset(new SortedGradientAccumulator(init_grad_var));
-      } else {
-        accumulator.reset(new EagerGradientAccumulator(init_grad_var));
-      }
+      accumulator.reset(CreateGradientAccumulator(init_grad_var));
     }
     accumulator->IncreaseRefCnt();
     accumulator->IncreaseCurCnt();
@@ -215,11 +222,7 @@ void BasicEngine::PrepareGradAccumulators(
                 accumulators_with_grad_node_[grad_pending_node][var.get()];
 
             if (!accumulator) {
-              if (FLAGS_sort_sum_gradient) {
-                accumulator.reset(new SortedGradientAccumulator(var.get()));
-              } else {
-                accumulator.reset(new EagerGradientAccumulator(var.get()));
-              }
+              accumulator.reset(CreateGradientAccumulator(var.get()));
             }
 
             accumulator->IncreaseRefCnt();
@@ -245,11 +248,7 @@ void BasicEngine::PrepareGradAccumulators(
       if (!grad_pending_nodes.size() || !find_grad_node_of_var) {
         auto& accumulator = accumulators_[var.get()];
         if (!accumulator) {
-          if (FLAGS_sort_sum_gradient) {
-            accumulator.reset(new SortedGradientAccumulator(var.get()));
-          } else {
-            accumulator.reset(new EagerGradientAccumulator(var.get()));
-          }
+          accumulator.reset(CreateGradientAccumulator(var.get()));
         }
 
         accumulator->IncreaseRefCnt();
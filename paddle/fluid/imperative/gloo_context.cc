@@ -65,13 +65,15 @@ void GLOOParallelContext::InitWithRingID(int ring_id) {
       platform::errors::OutOfRange("Still not implement InitWithRingID"));
 }
 
-#define GLOO_CASE(type, T, gw)                                  \
-  case type: {                                                  \
-    std::vector<T> send_vector##T;                              \
-    framework::TensorToVector<T>(src_tensor, &send_vector##T);  \
-    auto recv_vector##T = gw->AllReduce<T>(send_vector##T);     \
-    framework::TensorFromVector<T>(recv_vector##T, dst_tensor); \
-    break;                                                      \
+// allreduce on the memory of the tensors, which is done in place when
+// src_tensor and dst_tensor share the memory, e.g. the fused grads of a group
+#define GLOO_CASE(type, T, gw)                                        \
+  case type: {                                                        \
+    const T *send_ptr = src_tensor.data<T>();                         \
+    T *recv_ptr = dst_tensor->mutable_data<T>(platform::CPUPlace());  \
+    gw->AllReduce<T>(const_cast<T *>(send_ptr), recv_ptr,             \
+                     static_cast<size_t>(src_tensor.numel()));        \
+    break;                                                            \
   }
 
 void GLOOParallelContext::AllReduceByStream(const framework::Variable &src,
@@ -120,7 +122,6 @@ void GLOOParallelContext::AllReduce(const framework::Tensor &src_tensor,
           platform::errors::InvalidArgument("Invalid datatype for allreduce"));
     }
   }
-  gloo_wrapper->Barrier();
 }
 
 #define GLOO_ALL_GATHER_CASE(type, T, gw)                         \
@@ -654,6 +654,28 @@ static platform::Place GetPlaceOfVar(
   return place;
 }
 
+// The grad of a var whose stop_gradient is true is zero, with the shape of
+// the grad var
+static void SetZeroStopGradientGrad(const std::shared_ptr<VariableWrapper>& var,
+                                    VariableWrapper* dst_var,
+                                    const platform::Place& place) {
+  if (!dst_var->Var().IsInitialized() ||
+      !dst_var->Var().Get<framework::LoDTensor>().IsInitialized()) {
+    VLOG(6) << "Set StopGradient Grad: " << dst_var->Name() << " as zero ";
+    auto* dev_ctx = platform::DeviceContextPool::Instance().Get(place);
+    bool var_initialized = dst_var->Var().IsInitialized();
+    auto* tensor = dst_var->MutableVar()->GetMutable<framework::LoDTensor>();
+    if (!var_initialized) {
+      VLOG(6) << "Dims of " << dst_var->Name() << " is set as: "
+              << var->Var().Get<framework::LoDTensor>().dims();
+      tensor->Resize(var->Var().Get<framework::LoDTensor>().dims());
+    }
+    tensor->mutable_data(place,
+                         framework::TransToPtenDataType(var->DataType()));
+    pten::funcs::set_constant(*dev_ctx, tensor, 0.0);
+  }
+}
+
 void GradientAccumulator::AccumulateGrad() {
   /**
    * If the leaf gradient has been calculated done, the inner_var_
@@ -780,27 +802,7 @@ void EagerGradientAccumulator::SumGrad(std::shared_ptr<VariableWrapper> var,
       VariableWrapperAdd(var, dst_var, unchange_input);
     }
   } else {
-    if (!dst_var->Var().IsInitialized() ||
-        !dst_var->Var().Get<framework::LoDTensor>().IsInitialized()) {
-      VLOG(6) << "Set StopGradient Grad: " << dst_var->Name() << " as zero ";
-      auto* dev_ctx = platform::DeviceContextPool::Instance().Get(place);
-      if (!dst_var->Var().IsInitialized()) {
-        auto* tensor =
-            dst_var->MutableVar()->GetMutable<framework::LoDTensor>();
-        VLOG(6) << "Dims of " << dst_var->Name() << " is set as: "
-                << var->Var().Get<framework::LoDTensor>().dims();
-        tensor->Resize(var->Var().Get<framework::LoDTensor>().dims());
-        tensor->mutable_data(place,
-                             framework::TransToPtenDataType(var->DataType()));
-        pten::funcs::set_constant(*dev_ctx, tensor, 0.0);
-      } else {
-        auto* tensor =
-            dst_var->MutableVar()->GetMutable<framework::LoDTensor>();
-        tensor->mutable_data(place,
-                             framework::TransToPtenDataType(var->DataType()));
-        pten::funcs::set_constant(*dev_ctx, tensor, 0.0);
-      }
-    }
+    SetZeroStopGradientGrad(var, dst_var, place);
   }
 
   // Type may be changed after OP run, such as VarTypeInference
@@ -914,27 +916,7 @@ void SortedGradientAccumulator::SumGrad(std::shared_ptr<VariableWrapper> var,
       tmp_grad_vars_.clear();
     }
   } else {
-    if (!dst_var->Var().IsInitialized() ||
-        !dst_var->Var().Get<framework::LoDTensor>().IsInitialized()) {
-      VLOG(6) << "Set StopGradient Grad: " << var->Name() << " as zero";
-      auto* dev_ctx = platform::DeviceContextPool::Instance().Get(place);
-      if (!dst_var->Var().IsInitialized()) {
-        auto* tensor =
-            dst_var->MutableVar()->GetMutable<framework::LoDTensor>();
-        VLOG(6) << "Dims of " << dst_var->Name() << " is set as: "
-                << var->Var().Get<framework::LoDTensor>().dims();
-        tensor->Resize(var->Var().Get<framework::LoDTensor>().dims());
-        tensor->mutable_data(place,
-                             framework::TransToPtenDataType(var->DataType()));
-        pten::funcs::set_constant(*dev_ctx, tensor, 0.0);
-      } else {
-        auto* tensor =
-            dst_var->MutableVar()->GetMutable<framework::LoDTensor>();
-        tensor->mutable_data(place,
-                             framework::TransToPtenDataType(var->DataType()));
-        pten::funcs::set_constant(*dev_ctx, tensor, 0.0);
-      }
-    }
+    SetZeroStopGradientGrad(var, dst_var, place);
     // looks like tmp_grad_vars will not have any member but just in case
     tmp_grad_vars_.clear();
   }
@@ -946,5 +928,197 @@ void SortedGradientAccumulator::SumGrad(std::shared_ptr<VariableWrapper> var,
   }
 }
 
+// Add all the tensors of ins to out block by block, so that each block of
+// out stays in the cache while the inputs are added to it.
+template <typename T>
+static void MultiTensorAddImpl(const std::vector<const framework::Tensor*>& ins,
+                               framework::Tensor* out) {
+  constexpr int64_t kBlockSize = 4096;
+  auto numel = out->numel();
+  std::vector<const T*> in_datas;
+  in_datas.reserve(ins.size());
+  for (auto* in : ins) {
+    PADDLE_ENFORCE_EQ(in->numel(), numel,
+                      platform::errors::InvalidArgument(
+                          "The number of elements of the gradients to sum "
+                          "should be the same, but got %d and %d.",
+                          in->numel(), numel));
+    in_datas.emplace_back(in->data<T>());
+  }
+  auto* out_data = out->mutable_data<T>(out->place());
+  for (int64_t begin = 0; begin < numel; begin += kBlockSize) {
+    auto end = std::min(begin + kBlockSize, numel);
+    for (auto* in_data : in_datas) {
+      for (int64_t i = begin; i < end; ++i) {
+        out_data[i] += in_data[i];
+      }
+    }
+  }
+}
+
+static void MultiTensorAdd(const std::vector<const framework::Tensor*>& ins,
+                           framework::Tensor* out) {
+  auto data_type = framework::TransToProtoVarType(out->dtype());
+#define PADDLE_MULTI_TENSOR_ADD(cpp_type)                            \
+  if (data_type == framework::DataTypeTrait<cpp_type>::DataType()) { \
+    MultiTensorAddImpl<cpp_type>(ins, out);                          \
+    return;                                                          \
+  }
+  PADDLE_MULTI_TENSOR_ADD(float);
+  PADDLE_MULTI_TENSOR_ADD(double);
+  PADDLE_MULTI_TENSOR_ADD(int);
+  PADDLE_MULTI_TENSOR_ADD(int64_t);
+  PADDLE_MULTI_TENSOR_ADD(platform::float16);
+  PADDLE_MULTI_TENSOR_ADD(platform::bfloat16);
+  PADDLE_MULTI_TENSOR_ADD(platform::complex<float>);
+  PADDLE_MULTI_TENSOR_ADD(platform::complex<double>);
+#undef PADDLE_MULTI_TENSOR_ADD
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Gradient accumulation of data type (%s) on place (%s) is not "
+      "supported in imperative mode",
+      framework::DataTypeToString(data_type), out->place()));
+}
+
+static void MultiSelectedRowsMerge(
+    const std::vector<const pten::SelectedRows*>& ins,
+    pten::SelectedRows* out) {
+  auto data_type = framework::TransToProtoVarType(ins[0]->value().dtype());
+  auto* dev_ctx = static_cast<platform::CPUDeviceContext*>(
+      platform::DeviceContextPool::Instance().Get(platform::CPUPlace()));
+#define PADDLE_MULTI_SELECTED_ROWS_MERGE(cpp_type)                        \
+  if (data_type == framework::DataTypeTrait<cpp_type>::DataType()) {      \
+    paddle::operators::math::scatter::MergeAdd<platform::CPUDeviceContext, \
+                                               cpp_type>                  \
+        merge_add;                                                        \
+    merge_add(*dev_ctx, ins, out);                                        \
+    return;                                                               \
+  }
+  PADDLE_MULTI_SELECTED_ROWS_MERGE(float);
+  PADDLE_MULTI_SELECTED_ROWS_MERGE(double);
+  PADDLE_MULTI_SELECTED_ROWS_MERGE(int);
+  PADDLE_MULTI_SELECTED_ROWS_MERGE(int64_t);
+#undef PADDLE_MULTI_SELECTED_ROWS_MERGE
+  PADDLE_THROW(platform::errors::InvalidArgument(
+      "Not supported data type %s for SelectedRowsMerge",
+      framework::DataTypeToString(data_type)));
+}
+
+void LazyGradientAccumulator::SumGrad(std::shared_ptr<VariableWrapper> var,
+                                      size_t trace_id, bool unchange_input) {
+  auto* dst_var = Var();
+  platform::Place place = GetPlaceOfVar(var);
+  if (!dst_var->OverridedStopGradient()) {
+    unchange_input = unchange_input || var->HasGradNode();
+    if (ref_cnt_ == 1) {
+      MoveOrCopyVar(dst_var->MutableVar(), var->MutableVar(), unchange_input);
+    } else {
+      if (pending_grad_vars_.empty()) {
+        pending_grad_vars_.reserve(ref_cnt_);
+      }
+      pending_grad_vars_.emplace_back(std::move(var), unchange_input);
+      if (pending_grad_vars_.size() != ref_cnt_) {
+        return;
+      }
+      SumPendingGrads(place);
+      pending_grad_vars_.clear();
+    }
+  } else {
+    SetZeroStopGradientGrad(var, dst_var, place);
+    pending_grad_vars_.clear();
+  }
+
+  if (dst_var->Var().IsType<framework::LoDTensor>()) {
+    dst_var->SetType(framework::proto::VarType::LOD_TENSOR);
+  } else if (dst_var->Var().IsType<pten::SelectedRows>()) {
+    dst_var->SetType(framework::proto::VarType::SELECTED_ROWS);
+  }
+}
+
+void LazyGradientAccumulator::SumPendingGrads(const platform::Place& place) {
+  auto* dst_var = Var();
+  VLOG(6) << "Sum " << pending_grad_vars_.size()
+          << " gradients for: " << dst_var->Name() << " within this graph.";
+  if (!platform::is_cpu_place(place)) {
+    // only CPU has the multi-input kernels, sum them one by one otherwise
+    for (auto& grad_var : pending_grad_vars_) {
+      if (CurCnt() == 0) {
+        MoveOrCopyVar(dst_var->MutableVar(), grad_var.first->MutableVar(),
+                      grad_var.second);
+      } else {
+        VariableWrapperAdd(grad_var.first, dst_var, grad_var.second);
+      }
+      IncreaseCurCnt();
+    }
+    return;
+  }
+
+  std::vector<size_t> dense_indices;
+  std::vector<size_t> sparse_indices;
+  for (size_t i = 0; i < pending_grad_vars_.size(); ++i) {
+    const auto& grad_var = pending_grad_vars_[i].first->Var();
+    if (grad_var.IsType<framework::LoDTensor>()) {
+      dense_indices.emplace_back(i);
+    } else if (grad_var.IsType<pten::SelectedRows>()) {
+      sparse_indices.emplace_back(i);
+    } else {
+      PADDLE_THROW(platform::errors::PermissionDenied(
+          "The type of Gradient var must be LoDTensor or SelectedRows"));
+    }
+  }
+
+  // 1. merge all the SelectedRows at once
+  framework::Variable merged_var;
+  framework::Variable* sparse_var = nullptr;
+  bool unchange_sparse = false;
+  if (sparse_indices.size() == 1) {
+    sparse_var = pending_grad_vars_[sparse_indices[0]].first->MutableVar();
+    unchange_sparse = pending_grad_vars_[sparse_indices[0]].second;
+  } else if (sparse_indices.size() > 1) {
+    std::vector<const pten::SelectedRows*> sparse_ins;
+    sparse_ins.reserve(sparse_indices.size());
+    for (auto i : sparse_indices) {
+      sparse_ins.emplace_back(
+          &pending_grad_vars_[i].first->Var().Get<pten::SelectedRows>());
+    }
+    auto* merged = merged_var.GetMutable<pten::SelectedRows>();
+    MultiSelectedRowsMerge(sparse_ins, merged);
+    if (merged->value().IsInitialized()) {
+      sparse_var = &merged_var;
+    } else {
+      // MergeAdd leaves the output empty when all the inputs have no rows
+      sparse_var = pending_grad_vars_[sparse_indices[0]].first->MutableVar();
+      unchange_sparse = pending_grad_vars_[sparse_indices[0]].second;
+    }
+  }
+
+  // 2. sum the dense tensors into the first of them, which is copied only
+  // if it can't be changed
+  auto* dst = dst_var->MutableVar();
+  if (dense_indices.empty()) {
+    MoveOrCopyVar(dst, sparse_var, unchange_sparse);
+  } else {
+    auto& first = pending_grad_vars_[dense_indices[0]];
+    MoveOrCopyVar(dst, first.first->MutableVar(), first.second);
+    std::vector<const framework::Tensor*> dense_ins;
+    dense_ins.reserve(dense_indices.size() - 1);
+    for (size_t k = 1; k < dense_indices.size(); ++k) {
+      dense_ins.emplace_back(&pending_grad_vars_[dense_indices[k]]
+                                  .first->Var()
+                                  .Get<framework::LoDTensor>());
+    }
+    if (!dense_ins.empty()) {
+      MultiTensorAdd(dense_ins, dst->GetMutable<framework::LoDTensor>());
+    }
+    // 3. add the merged SelectedRows to the sum
+    if (sparse_var != nullptr) {
+      SelectedRowsAddToTensor(*sparse_var, dst);
+    }
+  }
+
+  while (CurCnt() < RefCnt()) {
+    IncreaseCurCnt();
+  }
+}
+
 }  // namespace imperative
 }  // namespace paddle
@@ -164,6 +164,25 @@ class SortedGradientAccumulator : public GradientAccumulator {
   std::vector<SavedVarInfo> tmp_grad_vars_;
 };
 
+// LazyGradientAccumulator keeps the gradients until all of them arrive, and
+// sums them at once. On CPU, all the SelectedRows are merged by one
+// MergeAdd, the dense tensors are summed by one multi-input kernel into the
+// first of them, and the merged SelectedRows is added to the result at last.
+class LazyGradientAccumulator : public GradientAccumulator {
+ public:
+  using GradientAccumulator::GradientAccumulator;
+
+  void SumGrad(std::shared_ptr<VariableWrapper> var, size_t trace_id,
+               bool unchange_input) override;
+
+ private:
+  void SumPendingGrads(const platform::Place& place);
+
+  // <gradient, whether it can't be changed>
+  std::vector<std::pair<std::shared_ptr<VariableWrapper>, bool>>
+      pending_grad_vars_;
+};
+
 template <typename ReturnVarType, typename VarType>
 std::shared_ptr<ReturnVarType> SelectedRowsMerge(const VarType& src1,
                                                  const VarType& src2);
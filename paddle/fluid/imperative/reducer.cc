@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/imperative/reducer.h"
 
+#include <chrono>  // NOLINT
 #include <iostream>
 
 #include "paddle/fluid/framework/tensor_util.h"
@@ -26,6 +27,10 @@
 #include "paddle/fluid/imperative/parallel_context.h"
 
 #include "paddle/pten/core/dense_tensor.h"
+
+DECLARE_bool(gloo_async_allreduce);
+DECLARE_bool(gloo_auto_group_size);
+
 namespace paddle {
 namespace imperative {
 
@@ -342,9 +347,18 @@ Reducer::Reducer(const std::vector<std::shared_ptr<imperative::VarBase>> &vars,
 #ifdef PADDLE_WITH_XPU_BKCL
   comm_pool_.reset(new ::ThreadPool(1));
   comm_op_count_ = 0;
+#elif defined(PADDLE_WITH_GLOO)
+  if (FLAGS_gloo_async_allreduce) {
+    comm_pool_.reset(new ::ThreadPool(1));
+    comm_op_count_ = 0;
+  }
 #endif
   // initialize groups
   InitializeGroups(group_indices);
+#ifdef PADDLE_WITH_GLOO
+  need_measure_comm_cost_ =
+      FLAGS_gloo_auto_group_size && platform::is_cpu_place(place_);
+#endif
   for (size_t global_var_index = 0; global_var_index < vars_.size();
        ++global_var_index) {
     auto var = vars_[global_var_index];
@@ -848,6 +862,42 @@ void Reducer::MarkGroupReady(size_t group_index) {
     });
 #elif defined(PADDLE_WITH_RCCL) || defined(PADDLE_WITH_NCCL) || \
     defined(PADDLE_WITH_GLOO) || defined(PADDLE_WITH_ASCEND_CL)
+#ifdef PADDLE_WITH_GLOO
+    // Gloo blocks the calling thread, so on CPU the groups are allreduced
+    // by comm_pool_ one by one, while the backward keeps computing. The
+    // grads of a ready group are not written by the backward any more.
+    if (comm_pool_ && platform::is_cpu_place(place_)) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        comm_op_count_ += 1;  // lock
+      }
+      auto next_group = next_group_;
+      comm_pool_->enqueue([this, run_order, next_group, &group] {
+        bool failed = false;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          failed = comm_exception_ != nullptr;
+        }
+        std::exception_ptr exception = nullptr;
+        // NOTE: once a group fails, the following ones are skipped, since
+        // the trainers would not issue the same collectives any more.
+        if (!failed) {
+          try {
+            FusedAllReduceSchedule(run_order, group, next_group);
+          } catch (...) {
+            exception = std::current_exception();
+          }
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (exception && !comm_exception_) comm_exception_ = exception;
+          comm_op_count_ -= 1;  // lock
+          cv_.notify_all();
+        }
+      });
+      continue;
+    }
+#endif
     FusedAllReduceSchedule(run_order, group, next_group_);
 #else
     PADDLE_THROW(platform::errors::PreconditionNotMet(
@@ -887,8 +937,19 @@ void Reducer::FusedAllReduceSchedule(const int run_order, Group &group,
 
     group.DivNRanks(dev_context, nranks_);
     // Start allreduce
-    parallel_ctx_->AllReduceByStream(
-        group.dense_contents_, &(group.dense_contents_), run_order, false);
+    if (need_measure_comm_cost_) {
+      auto start = std::chrono::steady_clock::now();
+      parallel_ctx_->AllReduceByStream(
+          group.dense_contents_, &(group.dense_contents_), run_order, false);
+      std::chrono::duration<double, std::micro> cost =
+          std::chrono::steady_clock::now() - start;
+      comm_costs_.emplace_back(
+          group.all_length_ * framework::SizeOfType(group.dtype_),
+          cost.count());
+    } else {
+      parallel_ctx_->AllReduceByStream(
+          group.dense_contents_, &(group.dense_contents_), run_order, false);
+    }
 
     // Select communication stream to split tensors
     // group.dense_contents_ ---> group.dense_tensors
@@ -908,9 +969,12 @@ std::vector<std::vector<size_t>> Reducer::RebuildGruops() {
           vars_.size(), rebuild_vars_.size()));
   std::reverse(rebuild_vars_.begin(), rebuild_vars_.end());
   std::reverse(rebuild_var_indices_.begin(), rebuild_var_indices_.end());
-  auto rebuild_group_indices =
-      AssignGroupBySize(rebuild_vars_, is_sparse_gradient_, group_size_limits_,
-                        rebuild_var_indices_);
+  // The group size measured in this step, if any, replaces the limits.
+  auto rebuild_group_indices = AssignGroupBySize(
+      rebuild_vars_, is_sparse_gradient_,
+      comm_group_size_ > 0 ? std::vector<size_t>{comm_group_size_}
+                           : group_size_limits_,
+      rebuild_var_indices_);
   has_rebuilt_group_ = true;
   rebuild_vars_.clear();
   rebuild_var_indices_.clear();
@@ -1009,10 +1073,15 @@ bool Reducer::HasGrad(size_t var_index) {
 void Reducer::FinalizeBackward() {
   groups_need_finalize_ = false;
   grad_need_hooks_ = false;
-#ifdef PADDLE_WITH_XPU_BKCL
-  {
+#if defined(PADDLE_WITH_XPU_BKCL) || defined(PADDLE_WITH_GLOO)
+  if (comm_pool_) {
     std::unique_lock<std::mutex> lock(mutex_);
     cv_.wait(lock, [&] { return comm_op_count_ == 0; });
+    if (comm_exception_) {
+      auto exception = comm_exception_;
+      comm_exception_ = nullptr;
+      std::rethrow_exception(exception);
+    }
   }
 #endif
 
@@ -1021,6 +1090,21 @@ void Reducer::FinalizeBackward() {
     parallel_ctx_->WaitComm(i);
   }
 
+  if (need_measure_comm_cost_) {
+    need_measure_comm_cost_ = false;
+    MeasureGroupSizeByCommCost();
+    // A pending rebuild regroups in the order of arrival by the measured
+    // size, otherwise the groups are still in the order of declaration.
+    if (comm_group_size_ > 0 && !NeedRebuildGroup()) {
+      // the same order as the groups from python, see DataParallel
+      auto group_indices =
+          AssignGroupBySize(vars_, is_sparse_gradient_, {comm_group_size_});
+      std::reverse(group_indices.begin(), group_indices.end());
+      group_indices_ = std::move(group_indices);
+      InitializeGroups(group_indices_);
+    }
+  }
+
   if (NeedRebuildGroup()) {
     VLOG(3) << "Start rebuilding the groups";
     auto rebuild_group_indices = RebuildGruops();
@@ -1043,6 +1127,63 @@ void Reducer::FinalizeBackward() {
   VLOG(3) << "In the batch, Reducer is finished.";
 }
 
+void Reducer::MeasureGroupSizeByCommCost() {
+  // Fit cost = latency + bytes / bandwidth by the least squares over the
+  // dense groups of this step.
+  double n = comm_costs_.size();
+  double sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+  for (const auto &cost : comm_costs_) {
+    double x = cost.first, y = cost.second;
+    sum_x += x;
+    sum_y += y;
+    sum_xx += x * x;
+    sum_xy += x * y;
+  }
+  comm_costs_.clear();
+  double det = n * sum_xx - sum_x * sum_x;
+  double latency = 0, us_per_byte = 0;
+  if (n >= 2 && det > 0) {
+    us_per_byte = (n * sum_xy - sum_x * sum_y) / det;
+    latency = (sum_y - us_per_byte * sum_x) / n;
+  }
+
+  // Every trainer must build the same groups, so the fit is averaged over
+  // the trainers. A trainer without a valid fit votes for zero.
+  bool valid = latency > 0 && us_per_byte > 0;
+  std::vector<double> local_fit = {valid ? latency : 0.0,
+                                   valid ? us_per_byte : 0.0,
+                                   valid ? 1.0 : 0.0};
+  const auto *dev_ctx = platform::DeviceContextPool::Instance().Get(place_);
+  framework::Variable fit_var;
+  auto *fit_tensor = fit_var.GetMutable<framework::LoDTensor>();
+  framework::TensorFromVector<double>(local_fit, *dev_ctx, fit_tensor);
+  parallel_ctx_->AllReduceByStream(fit_var, &fit_var, 0, true);
+  std::vector<double> global_fit;
+  framework::TensorToVector<double>(*fit_tensor, *dev_ctx, &global_fit);
+  parallel_ctx_->SynchronizeCompute();
+
+  if (global_fit[2] != static_cast<double>(nranks_)) {
+    VLOG(3) << "Keep the groups, since the cost of allreduce can't be "
+               "fitted on every trainer.";
+    return;
+  }
+  latency = global_fit[0] / nranks_;
+  us_per_byte = global_fit[1] / nranks_;
+
+  // The smallest group whose latency is at most 10% of its cost, so the
+  // groups are as small as possible to overlap with the backward.
+  constexpr size_t kMinGroupSize = 64 * 1024;
+  constexpr size_t kMaxGroupSize = 256 * 1024 * 1024;
+  size_t group_size = static_cast<size_t>(
+      (std::min)(9.0 * latency / us_per_byte,
+                 static_cast<double>(kMaxGroupSize)));
+  group_size = (std::max)(group_size, kMinGroupSize);
+  VLOG(3) << "Allreduce latency: " << latency << " us, bandwidth: "
+          << 1.0 / us_per_byte << " bytes/us, regroup by " << group_size
+          << " bytes.";
+  comm_group_size_ = group_size;
+}
+
 // According to the size of each parameter, it is allocated to different groups.
 // The sparse parameter occupies a group exclusively. The dense parameters of
 // the same data type are assigned to the same group. When dividing groups, the
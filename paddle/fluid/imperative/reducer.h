@@ -15,6 +15,7 @@
 #pragma once
 #include <ThreadPool.h>
 #include <algorithm>
+#include <exception>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -157,6 +158,10 @@ class Reducer {
 
   std::vector<std::vector<size_t>> RebuildGruops();
 
+  // Sets comm_group_size_ to the group size which hides the latency of the
+  // allreduce measured in the first step, see FLAGS_gloo_auto_group_size.
+  void MeasureGroupSizeByCommCost();
+
   inline bool NeedRebuildGroup() {
     return !has_rebuilt_group_ && !find_unused_vars_each_step_;
   }
@@ -197,14 +202,24 @@ class Reducer {
   bool find_unused_vars_each_step_{false};
   bool find_unused_vars_once_{true};
   bool groups_need_finalize_{false};
-#ifdef PADDLE_WITH_XPU_BKCL
-  // comm_pool_ is used for scheduling allreduce in multi Kunlun cards training.
+#if defined(PADDLE_WITH_XPU_BKCL) || defined(PADDLE_WITH_GLOO)
+  // comm_pool_ is used for scheduling allreduce in multi Kunlun cards training,
+  // and in CPU training when FLAGS_gloo_async_allreduce is true.
   std::unique_ptr<::ThreadPool> comm_pool_{nullptr};
-  uint32_t comm_op_count_;
+  uint32_t comm_op_count_{0};
   std::mutex mutex_;
   std::condition_variable cv_;
+  // the first exception thrown in comm_pool_, rethrown in FinalizeBackward
+  std::exception_ptr comm_exception_{nullptr};
 #endif
 
+  // Following variables are to size the groups by the measured cost of
+  // allreduce, <bytes, microseconds> of each dense group in the first step.
+  bool need_measure_comm_cost_{false};
+  std::vector<std::pair<int64_t, double>> comm_costs_;
+  // the measured group size in bytes, 0 until it is measured
+  size_t comm_group_size_{0};
+
   // grad_need_hooks_ is used to mark whether gradient synchronization is
   // required across process. The default value is false. When backward()
   // is called, grad_need_hooks_ will be assigned to true during preparation
@@ -0,0 +1,134 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/framework/variable.h"
+#include "paddle/fluid/imperative/gradient_accumulator.h"
+
+DEFINE_int64(vocab_size, 10000, "The rows of the shared embedding table.");
+DEFINE_int64(emb_dim, 64, "The width of the shared embedding table.");
+DEFINE_int64(lookup_number, 64, "The lookups of the shared embedding.");
+DEFINE_int64(row_number, 256, "The rows of the gradient of every lookup.");
+
+namespace paddle {
+namespace imperative {
+
+static void FillRandom(framework::Tensor* tensor, std::mt19937* engine) {
+  std::uniform_int_distribution<int> dist(-10, 10);
+  auto* data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(*engine);
+  }
+}
+
+static framework::Variable RandomEmbeddingGrad(std::mt19937* engine) {
+  framework::Variable ret;
+  auto* sr = ret.GetMutable<pten::SelectedRows>();
+  sr->set_height(FLAGS_vocab_size);
+  sr->mutable_value()->Resize({FLAGS_row_number, FLAGS_emb_dim});
+  FillRandom(sr->mutable_value(), engine);
+  std::uniform_int_distribution<int64_t> dist(0, FLAGS_vocab_size - 1);
+  for (int64_t i = 0; i < FLAGS_row_number; ++i) {
+    sr->mutable_rows()->push_back(dist(*engine));
+  }
+  return ret;
+}
+
+static void CopyVar(const framework::Variable& src, framework::Variable* dst) {
+  if (src.IsType<framework::LoDTensor>()) {
+    framework::TensorCopySync(src.Get<framework::LoDTensor>(),
+                              platform::CPUPlace(),
+                              dst->GetMutable<framework::LoDTensor>());
+    return;
+  }
+  auto& src_sr = src.Get<pten::SelectedRows>();
+  auto* dst_sr = dst->GetMutable<pten::SelectedRows>();
+  dst_sr->set_rows(src_sr.rows());
+  dst_sr->set_height(src_sr.height());
+  framework::TensorCopySync(src_sr.value(), platform::CPUPlace(),
+                            dst_sr->mutable_value());
+}
+
+// Returns the milliseconds of summing `grads` into one gradient.
+static double SumGradsMs(const std::vector<framework::Variable>& grads,
+                         bool lazy_gradient) {
+  std::vector<std::shared_ptr<VariableWrapper>> grad_vars;
+  for (auto& grad : grads) {
+    grad_vars.emplace_back(std::make_shared<VariableWrapper>("grad"));
+    CopyVar(grad, grad_vars.back()->MutableVar());
+  }
+  auto g_var = std::make_shared<VariableWrapper>("g_var");
+  g_var->SetOverridedStopGradient(false);
+  std::unique_ptr<GradientAccumulator> g_accum;
+  if (lazy_gradient) {
+    g_accum.reset(new LazyGradientAccumulator(g_var.get()));
+  } else {
+    g_accum.reset(new EagerGradientAccumulator(g_var.get()));
+  }
+  for (size_t i = 0; i < grads.size(); ++i) {
+    g_accum->IncreaseRefCnt();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < grad_vars.size(); ++i) {
+    g_accum->SumGrad(std::move(grad_vars[i]), i, false);
+  }
+  g_accum->AccumulateGrad();
+  std::chrono::duration<double, std::milli> cost =
+      std::chrono::steady_clock::now() - start;
+  return cost.count();
+}
+
+static void BenchSharedEmbedding() {
+  std::mt19937 engine(0);
+  std::vector<framework::Variable> grads;
+  for (int64_t i = 0; i < FLAGS_lookup_number; ++i) {
+    grads.emplace_back(RandomEmbeddingGrad(&engine));
+  }
+  // the gradients are all SelectedRows at first, then with a dense gradient
+  for (bool with_dense : {false, true}) {
+    if (with_dense) {
+      grads.emplace_back();
+      auto* dense = grads.back().GetMutable<framework::LoDTensor>();
+      dense->Resize({FLAGS_vocab_size, FLAGS_emb_dim});
+      FillRandom(dense, &engine);
+    }
+    double eager_ms = SumGradsMs(grads, false);
+    double lazy_ms = SumGradsMs(grads, true);
+    LOG(INFO) << FLAGS_lookup_number << " lookups"
+              << (with_dense ? " and a dense gradient" : "")
+              << ", eager accumulator: " << eager_ms
+              << " ms, lazy accumulator: " << lazy_ms << " ms";
+  }
+}
+
+}  // namespace imperative
+}  // namespace paddle
+
+// Sums the gradients of one embedding table shared by many lookups with
+// the eager and the lazy accumulator,
+// run command: ./gradient_accumulator_benchmark [options...]
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::imperative::BenchSharedEmbedding();
+  return 0;
+}
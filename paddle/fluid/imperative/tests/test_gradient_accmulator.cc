@@ -348,10 +348,14 @@ static framework::Variable RandomSelectedRows(framework::DDim dims,
 }
 
 static std::unique_ptr<GradientAccumulator> CreateAccumulator(
-    const std::shared_ptr<VariableWrapper>& var, bool sort_gradient) {
+    const std::shared_ptr<VariableWrapper>& var, bool sort_gradient,
+    bool lazy_gradient = false) {
   if (sort_gradient) {
     return std::unique_ptr<GradientAccumulator>(
         new SortedGradientAccumulator(var.get()));
+  } else if (lazy_gradient) {
+    return std::unique_ptr<GradientAccumulator>(
+        new LazyGradientAccumulator(var.get()));
   } else {
     return std::unique_ptr<GradientAccumulator>(
         new EagerGradientAccumulator(var.get()));
@@ -359,7 +363,8 @@ static std::unique_ptr<GradientAccumulator> CreateAccumulator(
 }
 
 static void TestGradientAccumulatorTestUnchangeInput(
-    const platform::Place& place, bool sort_gradient) {
+    const platform::Place& place, bool sort_gradient,
+    bool lazy_gradient = false) {
   framework::DDim dim{10, 20};
   int64_t maximum_row_number = 100;
 
@@ -389,13 +394,13 @@ static void TestGradientAccumulatorTestUnchangeInput(
       */
       auto g_var1 = std::make_shared<VariableWrapper>("g_var1");
       g_var1->SetOverridedStopGradient(false);
-      auto g_accum1 = CreateAccumulator(g_var1, sort_gradient);
+      auto g_accum1 = CreateAccumulator(g_var1, sort_gradient, lazy_gradient);
       g_accum1->IncreaseRefCnt();
       g_accum1->IncreaseRefCnt();
 
       auto g_var2 = std::make_shared<VariableWrapper>("g_var2");
       g_var2->SetOverridedStopGradient(false);
-      auto g_accum2 = CreateAccumulator(g_var2, sort_gradient);
+      auto g_accum2 = CreateAccumulator(g_var2, sort_gradient, lazy_gradient);
       g_accum2->IncreaseRefCnt();
       g_accum2->IncreaseRefCnt();
 
@@ -448,9 +453,11 @@ static void TestGradientAccumulatorTestUnchangeInput(
       CopyVar(var3, var_wrapper3_3->MutableVar());
       CopyVar(var3, var_wrapper4_3->MutableVar());
 
-      auto g_accum3 = CreateAccumulator(var_wrapper3_3, sort_gradient);
+      auto g_accum3 = CreateAccumulator(var_wrapper3_3, sort_gradient,
+                                        lazy_gradient);
       g_accum3->IncreaseRefCnt();
-      auto g_accum4 = CreateAccumulator(var_wrapper4_3, sort_gradient);
+      auto g_accum4 = CreateAccumulator(var_wrapper4_3, sort_gradient,
+                                        lazy_gradient);
       g_accum4->IncreaseRefCnt();
 
       auto var4 = create_var(use_tensor2);
@@ -483,6 +490,83 @@ TEST(test_gradient_accumulator, test_unchange_input) {
                                              sort_gradient);
 #endif
   }
+  TestGradientAccumulatorTestUnchangeInput(platform::CPUPlace(), false, true);
+}
+
+// Scatter the gradient to a dense tensor, since the rows of SelectedRows
+// may be in different orders
+static framework::Tensor ToDenseTensor(const framework::Variable& var) {
+  if (var.IsType<framework::LoDTensor>()) {
+    return var.Get<framework::LoDTensor>();
+  }
+  const auto& sr = var.Get<pten::SelectedRows>();
+  auto width = sr.value().numel() / static_cast<int64_t>(sr.rows().size());
+  framework::Tensor dense;
+  dense.Resize({sr.height(), width});
+  auto* dense_data = dense.mutable_data<float>(platform::CPUPlace());
+  std::fill(dense_data, dense_data + dense.numel(), 0.0f);
+  auto* value_data = sr.value().data<float>();
+  for (size_t i = 0; i < sr.rows().size(); ++i) {
+    for (int64_t j = 0; j < width; ++j) {
+      dense_data[sr.rows()[i] * width + j] += value_data[i * width + j];
+    }
+  }
+  return dense;
+}
+
+// Sum the gradients of an embedding table shared by many lookups
+static void SumSharedEmbeddingGrads(
+    const std::vector<framework::Variable>& grads, bool lazy_gradient,
+    framework::Variable* result) {
+  std::vector<std::shared_ptr<VariableWrapper>> grad_vars;
+  for (auto& grad : grads) {
+    grad_vars.emplace_back(std::make_shared<VariableWrapper>("grad"));
+    CopyVar(grad, grad_vars.back()->MutableVar());
+  }
+
+  auto g_var = std::make_shared<VariableWrapper>("g_var");
+  g_var->SetOverridedStopGradient(false);
+  auto g_accum = CreateAccumulator(g_var, false, lazy_gradient);
+  for (size_t i = 0; i < grads.size(); ++i) {
+    g_accum->IncreaseRefCnt();
+  }
+
+  for (size_t i = 0; i < grad_vars.size(); ++i) {
+    g_accum->SumGrad(std::move(grad_vars[i]), i, false);
+  }
+  EXPECT_TRUE(g_accum->SumGradCompleted());
+  g_accum->AccumulateGrad();
+  *result = std::move(*(g_var->MutableVar()));
+}
+
+TEST(test_gradient_accumulator, test_lazy_shared_embedding) {
+  framework::DDim dims{10000, 64};
+  int64_t lookup_number = 64;
+  int64_t row_number = 256;
+  platform::CPUPlace place;
+
+  std::vector<framework::Variable> grads;
+  for (int64_t i = 0; i < lookup_number; ++i) {
+    grads.emplace_back(RandomSelectedRows<float>(dims, place, row_number));
+  }
+
+  // the gradients are all SelectedRows at first, then with a dense gradient
+  for (auto with_dense : {false, true}) {
+    if (with_dense) {
+      grads.emplace_back(RandomTensor<float>(dims, place));
+    }
+    framework::Variable eager_result, lazy_result;
+    SumSharedEmbeddingGrads(grads, false, &eager_result);
+    SumSharedEmbeddingGrads(grads, true, &lazy_result);
+    ASSERT_EQ(eager_result.Type(), lazy_result.Type());
+    // the values are integers, so the sums are exact in any order
+    auto eager_dense = ToDenseTensor(eager_result);
+    auto lazy_dense = ToDenseTensor(lazy_result);
+    ASSERT_EQ(eager_dense.numel(), lazy_dense.numel());
+    ASSERT_EQ(std::memcmp(eager_dense.data<float>(), lazy_dense.data<float>(),
+                          eager_dense.numel() * sizeof(float)),
+              0);
+  }
 }
 
 }  // namespace imperative
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "paddle/fluid/inference/analysis/ir_pass_manager.h"
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
@@ -52,7 +53,15 @@ void IRPassManager::CreatePasses(Argument *argument,
                                  const std::vector<std::string> &passes) {
   std::string pre_pass;
   int pass_num = 0;
+  bool use_mkldnn = std::find(passes.begin(), passes.end(),
+                              "mkldnn_placement_pass") != passes.end();
   for (const std::string &pass_name : passes) {
+    // fusion_group_pass would fuse the elementwise ops away from the MKLDNN
+    // kernels, so it never runs in the MKLDNN pipeline.
+    if (pass_name == "fusion_group_pass" && use_mkldnn) {
+      LOG(WARNING) << "fusion_group_pass is skipped since MKLDNN is enabled.";
+      continue;
+    }
     auto pass = framework::ir::PassRegistry::Instance().Get(pass_name);
 
     if (pass_name == "graph_viz_pass") {
@@ -248,6 +257,9 @@ void IRPassManager::CreatePasses(Argument *argument,
       bool use_fc_padding = !fc_mkldnn_pass && argument->use_fc_padding();
       pass->Set("use_fc_padding", new bool(use_fc_padding));
     }
+    if (pass_name == "fusion_group_pass") {
+      pass->Set("use_gpu", new bool(argument->use_gpu()));
+    }
 
     pass->Set("disable_logs", new bool(disable_logs_));
 
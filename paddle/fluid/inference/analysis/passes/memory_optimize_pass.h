@@ -34,6 +34,14 @@ namespace paddle {
 namespace inference {
 namespace analysis {
 
+// Maps every var onto a cluster of vars whose lifetimes do not overlap, a
+// cluster is stored in one tensor of the size of its largest var.
+void MakeSimpleReusePlan(
+    const std::unordered_map<std::string, std::pair<int, int>>& lifecycles,
+    const std::unordered_map<std::string, size_t>& space_table,
+    std::unordered_map<std::string, std::string>* node2cluster,
+    std::unordered_map<std::string, int>* cluster_size);
+
 /* Memory optimization.
 * We will perform the following operation:
 * 1. Collect all var's lifetime.
@@ -54,6 +54,8 @@
 
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/fluid/inference/api/mkldnn_quantizer.h"
+
+DECLARE_int32(mkldnn_shape_bucket_size);
 #endif
 
 #if PADDLE_WITH_TENSORRT
@@ -192,6 +194,8 @@ bool AnalysisPredictor::Init(
   // Get the feed_target_names and fetch_target_names
   PrepareFeedFetch();
 
+  PrepareStaticMemoryPlan();
+
   return true;
 }
 
@@ -390,11 +394,17 @@ void AnalysisPredictor::MkldnnPreSet(
     platform::MKLDNNDeviceContext::tls().set_cur_mkldnn_session_id(
         platform::MKLDNNDeviceContextThreadLocals::
             kMKLDNNSessionID_CacheClearing);
-    // Set current_input_shape for caching dynamic shape.
+    // Set current_input_shape for caching dynamic shape. With shape
+    // bucketing, nearby shapes share the cached objects of one bucket.
+    const int bucket = FLAGS_mkldnn_shape_bucket_size;
     std::stringstream ss;
     for (size_t i = 0; i < inputs_shape.size(); ++i) {
       for (size_t j = 0; j < inputs_shape[i].size(); ++j) {
-        ss << inputs_shape[i][j] << "-";
+        int dim = inputs_shape[i][j];
+        if (bucket > 0 && dim > 0) {
+          dim = (dim + bucket - 1) / bucket * bucket;
+        }
+        ss << dim << "-";
       }
     }
     VLOG(2) << "Set input shape=" << ss.str();
@@ -447,6 +457,15 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
     return false;
   }
 
+  if (static_memory_arena_) {
+    std::map<std::string, std::vector<int64_t>> input_shapes;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      auto &name = config_.specify_input_name_ ? inputs[i].name : idx2feeds_[i];
+      input_shapes[name].assign(inputs[i].shape.begin(), inputs[i].shape.end());
+    }
+    BindStaticMemory(input_shapes);
+  }
+
   // Run the inference program
   // if share variables, we need not create variables
   executor_->Run();
@@ -894,6 +913,53 @@ void AnalysisPredictor::PrepareFeedFetch() {
   }
 }
 
+void AnalysisPredictor::PrepareStaticMemoryPlan() {
+  if (!config_.static_memory_plan_enabled()) return;
+#ifdef PADDLE_WITH_MKLDNN
+  // MKLDNN primitives may cache the memory of the tensors.
+  if (config_.use_mkldnn_) {
+    LOG(WARNING) << "The static memory plan is disabled with MKLDNN.";
+    return;
+  }
+#endif
+  if (!platform::is_cpu_place(place_) && !platform::is_gpu_place(place_)) {
+    LOG(WARNING) << "The static memory plan only supports CPU and GPU.";
+    return;
+  }
+  details::StaticMemoryPlanner planner(*inference_program_, GetInputNames(),
+                                       GetOutputNames());
+  if (!planner.Plannable()) {
+    LOG(WARNING) << "The static memory plan is disabled, since the program "
+                    "has sub blocks.";
+    return;
+  }
+  std::vector<details::StaticMemoryPlan> plans;
+  for (auto &bucket : config_.static_memory_shape_buckets()) {
+    std::map<std::string, std::vector<int64_t>> input_shapes;
+    for (auto &input : bucket) {
+      input_shapes[input.first].assign(input.second.begin(),
+                                       input.second.end());
+    }
+    plans.emplace_back(planner.Plan(input_shapes));
+    auto &plan = plans.back();
+    LOG(INFO) << "Static memory plan of bucket " << plans.size() - 1 << ": "
+              << plan.blocks.size() << " tensors in an arena of "
+              << plan.arena_size << " bytes, " << plan.total_size
+              << " bytes without reuse, lower bound " << plan.lower_bound
+              << " bytes";
+  }
+  static_memory_arena_.reset(
+      new details::StaticMemoryArena(place_, std::move(plans)));
+}
+
+void AnalysisPredictor::BindStaticMemory(
+    const std::map<std::string, std::vector<int64_t>> &input_shapes) {
+  if (!static_memory_arena_->Bind(sub_scope_, input_shapes)) {
+    VLOG(3) << "No static memory bucket covers the input shapes, run with "
+               "the allocator.";
+  }
+}
+
 void AnalysisPredictor::CreateFeedFetchVar(framework::Scope *scope) {
   PADDLE_ENFORCE_NOT_NULL(scope, platform::errors::InvalidArgument(
                                      "The scope should not be nullptr."));
@@ -1024,6 +1090,15 @@ bool AnalysisPredictor::ZeroCopyRun() {
   }
 #endif
 
+  if (static_memory_arena_) {
+    std::map<std::string, std::vector<int64_t>> input_shapes;
+    for (auto &name : GetInputNames()) {
+      auto shape = GetInputTensor(name)->shape();
+      input_shapes[name].assign(shape.begin(), shape.end());
+    }
+    BindStaticMemory(input_shapes);
+  }
+
   executor_->Run();
 
   if (config_.shape_range_info_collected()) {
@@ -23,6 +23,7 @@
 #include "paddle/fluid/inference/analysis/analyzer.h"
 #include "paddle/fluid/inference/api/api_impl.h"
 #include "paddle/fluid/inference/api/details/reset_tensor_array.h"
+#include "paddle/fluid/inference/api/details/static_memory_planner.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/platform/device/gpu/gpu_types.h"
@@ -361,6 +362,21 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   void MkldnnPostReset();
 
+  ///
+  /// \brief Plan the intermediate tensors of every shape bucket of the
+  /// config into an arena.
+  ///
+  void PrepareStaticMemoryPlan();
+
+  ///
+  /// \brief Bind the intermediate tensors to the arena of the bucket that
+  /// covers the input shapes, if any.
+  ///
+  /// \param[in] input_shapes the shapes of the inputs of this run
+  ///
+  void BindStaticMemory(
+      const std::map<std::string, std::vector<int64_t>> &input_shapes);
+
 #if PADDLE_WITH_TENSORRT
   ///
   /// \brief save calibration table
@@ -421,6 +437,7 @@ class AnalysisPredictor : public PaddlePredictor {
   // concurrency problems, wrong results and memory leak, so cache them.
   std::vector<framework::LoDTensor> feed_tensors_;
   details::TensorArrayBatchCleaner tensor_array_batch_cleaner_;
+  std::unique_ptr<details::StaticMemoryArena> static_memory_arena_;
   // A mutex help to make Clone thread safe.
   std::mutex clone_mutex_;
 
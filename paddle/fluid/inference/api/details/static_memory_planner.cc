@@ -0,0 +1,336 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/details/static_memory_planner.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "paddle/fluid/framework/convert_utils.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/memory/malloc.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace details {
+
+namespace {
+
+// The operators whose tensors MemoryOptimizePass does not reuse either.
+const std::unordered_set<std::string>& UnplannableOps() {
+  static const std::unordered_set<std::string> ops = {
+      "while",          "conditional_block",       "tensorrt_engine",
+      "recurrent",      "conditional_block_infer", "merge_lod_tensor_infer",
+      "equal",          "merge_lod_tensor",        "sequence_pool",
+      "lod_reset",      "share_data",              "share_buffer",
+      "feed",           "fetch"};
+  return ops;
+}
+
+// A block of the arena handed out to one tensor. It keeps the arena alive.
+class StaticMemoryView : public memory::allocation::Allocation {
+ public:
+  StaticMemoryView(const std::shared_ptr<pten::Allocation>& arena,
+                   size_t offset, size_t size)
+      : memory::allocation::Allocation(
+            static_cast<uint8_t*>(arena->ptr()) + offset, size,
+            arena->place()),
+        arena_(arena) {}
+
+ private:
+  std::shared_ptr<pten::Allocation> arena_;
+};
+
+}  // namespace
+
+size_t AssignStaticMemoryOffsets(std::vector<StaticMemoryBlock>* blocks) {
+  std::vector<StaticMemoryBlock*> order;
+  order.reserve(blocks->size());
+  for (auto& block : *blocks) order.push_back(&block);
+  // Large and long lived blocks first, they are the hardest to fit.
+  std::stable_sort(order.begin(), order.end(),
+                   [](StaticMemoryBlock* a, StaticMemoryBlock* b) {
+                     if (a->size != b->size) return a->size > b->size;
+                     return a->last_use - a->first_use >
+                            b->last_use - b->first_use;
+                   });
+
+  size_t arena_size = 0;
+  std::vector<StaticMemoryBlock*> placed;
+  std::vector<StaticMemoryBlock*> conflicts;
+  for (auto* block : order) {
+    conflicts.clear();
+    for (auto* other : placed) {
+      if (other->first_use <= block->last_use &&
+          block->first_use <= other->last_use) {
+        conflicts.push_back(other);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(),
+              [](StaticMemoryBlock* a, StaticMemoryBlock* b) {
+                return a->offset < b->offset;
+              });
+    size_t best_offset = 0;
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t prev_end = 0;
+    for (auto* other : conflicts) {
+      if (other->offset > prev_end) {
+        size_t gap = other->offset - prev_end;
+        if (gap >= block->size && gap < best_gap) {
+          best_gap = gap;
+          best_offset = prev_end;
+        }
+      }
+      prev_end = std::max(prev_end, other->offset + other->size);
+    }
+    block->offset =
+        best_gap == std::numeric_limits<size_t>::max() ? prev_end : best_offset;
+    arena_size = std::max(arena_size, block->offset + block->size);
+    placed.push_back(block);
+  }
+  return arena_size;
+}
+
+StaticMemoryPlanner::StaticMemoryPlanner(
+    const framework::ProgramDesc& program,
+    const std::vector<std::string>& input_names,
+    const std::vector<std::string>& output_names)
+    : program_(program) {
+  // The tensors of sub blocks are not visible in the op order of block 0.
+  if (program_.Size() > 1) {
+    plannable_ = false;
+    return;
+  }
+  const auto& block = program_.Block(0);
+  std::unordered_set<std::string> skip_vars(input_names.begin(),
+                                            input_names.end());
+  skip_vars.insert(output_names.begin(), output_names.end());
+
+  auto ops = block.AllOps();
+  for (size_t i = 0; i < ops.size(); ++i) {
+    bool skip_op = UnplannableOps().count(ops[i]->Type()) > 0;
+    for (auto& names : {ops[i]->InputArgumentNames(),
+                        ops[i]->OutputArgumentNames()}) {
+      for (auto& name : names) {
+        if (skip_op) skip_vars.insert(name);
+        auto iter = lifetimes_.find(name);
+        if (iter == lifetimes_.end()) {
+          lifetimes_.emplace(name, std::make_pair(static_cast<int>(i),
+                                                  static_cast<int>(i)));
+        } else {
+          iter->second.second = static_cast<int>(i);
+        }
+      }
+    }
+  }
+
+  for (auto iter = lifetimes_.begin(); iter != lifetimes_.end();) {
+    auto* var = block.FindVar(iter->first);
+    if (skip_vars.count(iter->first) || var == nullptr ||
+        var->GetType() != framework::proto::VarType::LOD_TENSOR ||
+        var->Persistable()) {
+      iter = lifetimes_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+StaticMemoryPlan StaticMemoryPlanner::Plan(
+    const std::map<std::string, std::vector<int64_t>>& input_shapes) const {
+  StaticMemoryPlan plan;
+  plan.input_shapes = input_shapes;
+  if (!plannable_) return plan;
+
+  framework::ProgramDesc program(program_);
+  auto* block = program.MutableBlock(0);
+  for (auto& input : input_shapes) {
+    auto* var = block->FindVar(input.first);
+    PADDLE_ENFORCE_NOT_NULL(
+        var, platform::errors::NotFound(
+                 "The input %s of the shape bucket is not found in the "
+                 "inference program.",
+                 input.first));
+    for (auto dim : input.second) {
+      PADDLE_ENFORCE_GT(dim, 0,
+                        platform::errors::InvalidArgument(
+                            "The shape of input %s in the shape bucket must "
+                            "be positive, but received %s.",
+                            input.first, framework::make_ddim(input.second)));
+    }
+    var->SetShape(input.second);
+  }
+
+  // The outputs of an op that fails to infer its shape at compile time, and
+  // everything computed from them, keep the shapes saved in the model, which
+  // may not match the bucket.
+  std::unordered_set<std::string> unknown;
+  for (auto* op : block->AllOps()) {
+    if (op->Type() == "feed" || op->Type() == "fetch") continue;
+    bool known = true;
+    for (auto& name : op->InputArgumentNames()) {
+      if (unknown.count(name)) {
+        known = false;
+        break;
+      }
+    }
+    if (known) {
+      try {
+        op->InferShape(*block);
+      } catch (std::exception& e) {
+        VLOG(3) << "Static memory planner skips the outputs of "
+                << op->Type() << ": " << e.what();
+        known = false;
+      }
+    }
+    if (!known) {
+      for (auto& name : op->OutputArgumentNames()) unknown.insert(name);
+    }
+  }
+
+  for (auto& lifetime : lifetimes_) {
+    if (unknown.count(lifetime.first)) continue;
+    auto* var = block->FindVar(lifetime.first);
+    auto shape = var->GetShape();
+    if (shape.empty()) continue;
+    int64_t numel = 1;
+    for (auto dim : shape) numel *= dim;
+    if (numel <= 0) continue;
+
+    StaticMemoryBlock mem_block;
+    mem_block.name = lifetime.first;
+    mem_block.dims = shape;
+    mem_block.dtype = var->GetDataType();
+    size_t size = numel * framework::SizeOfType(mem_block.dtype);
+    mem_block.size = (size + kStaticMemoryAlignment - 1) /
+                     kStaticMemoryAlignment * kStaticMemoryAlignment;
+    mem_block.first_use = lifetime.second.first;
+    mem_block.last_use = lifetime.second.second;
+    plan.blocks.push_back(std::move(mem_block));
+  }
+  // Make the plan independent of the hash order.
+  std::sort(plan.blocks.begin(), plan.blocks.end(),
+            [](const StaticMemoryBlock& a, const StaticMemoryBlock& b) {
+              return a.name < b.name;
+            });
+  plan.arena_size = AssignStaticMemoryOffsets(&plan.blocks);
+
+  std::vector<size_t> live(block->OpSize(), 0);
+  for (auto& mem_block : plan.blocks) {
+    plan.total_size += mem_block.size;
+    for (int i = mem_block.first_use; i <= mem_block.last_use; ++i) {
+      live[i] += mem_block.size;
+    }
+  }
+  for (auto size : live) plan.lower_bound = std::max(plan.lower_bound, size);
+  return plan;
+}
+
+StaticMemoryArena::StaticMemoryArena(const platform::Place& place,
+                                     std::vector<StaticMemoryPlan> plans)
+    : place_(place), plans_(std::move(plans)), buckets_(plans_.size()) {}
+
+int StaticMemoryArena::MatchBucket(
+    const std::map<std::string, std::vector<int64_t>>& input_shapes) const {
+  int best = -1;
+  for (size_t i = 0; i < plans_.size(); ++i) {
+    bool covered = true;
+    for (auto& planned : plans_[i].input_shapes) {
+      auto iter = input_shapes.find(planned.first);
+      if (iter == input_shapes.end() ||
+          iter->second.size() != planned.second.size()) {
+        covered = false;
+        break;
+      }
+      for (size_t j = 0; j < planned.second.size(); ++j) {
+        if (iter->second[j] > planned.second[j]) {
+          covered = false;
+          break;
+        }
+      }
+      if (!covered) break;
+    }
+    if (covered &&
+        (best < 0 || plans_[i].arena_size < plans_[best].arena_size)) {
+      best = static_cast<int>(i);
+    }
+  }
+  return best;
+}
+
+void StaticMemoryArena::PrepareBucket(int index, framework::Scope* scope) {
+  auto& bucket = buckets_[index];
+  auto& plan = plans_[index];
+  if (!bucket.arena && plan.arena_size > 0) {
+    bucket.arena = memory::AllocShared(place_, plan.arena_size);
+    ++stats_.arena_allocations;
+    stats_.arena_bytes += plan.arena_size;
+    bucket.views.reserve(plan.blocks.size());
+    for (auto& block : plan.blocks) {
+      bucket.views.emplace_back(
+          std::make_shared<StaticMemoryView>(bucket.arena, block.offset,
+                                             block.size));
+    }
+  }
+  if (bucket.scope == scope) return;
+  bucket.tensors.clear();
+  for (auto& block : plan.blocks) {
+    auto* var = scope->FindVar(block.name);
+    PADDLE_ENFORCE_NOT_NULL(
+        var, platform::errors::NotFound(
+                 "The variable %s of the static memory plan is not found in "
+                 "the scope.",
+                 block.name));
+    bucket.tensors.push_back(var->GetMutable<framework::LoDTensor>());
+  }
+  bucket.scope = scope;
+}
+
+bool StaticMemoryArena::Bind(
+    framework::Scope* scope,
+    const std::map<std::string, std::vector<int64_t>>& input_shapes) {
+  ++stats_.runs;
+  if (bound_ >= 0) stats_.reallocated_tensors += CountReallocated();
+  bound_ = MatchBucket(input_shapes);
+  if (bound_ < 0) return false;
+
+  PrepareBucket(bound_, scope);
+  auto& bucket = buckets_[bound_];
+  auto& plan = plans_[bound_];
+  for (size_t i = 0; i < bucket.tensors.size(); ++i) {
+    auto* tensor = bucket.tensors[i];
+    // Shrink the meta first, the view may be smaller than the last shape.
+    tensor->Resize(framework::make_ddim(plan.blocks[i].dims));
+    tensor->set_offset(0);
+    tensor->ResetHolderWithType(
+        bucket.views[i], framework::TransToPtenDataType(plan.blocks[i].dtype));
+  }
+  ++stats_.bound_runs;
+  stats_.bound_tensors += bucket.tensors.size();
+  return true;
+}
+
+int64_t StaticMemoryArena::CountReallocated() const {
+  if (bound_ < 0) return 0;
+  auto& bucket = buckets_[bound_];
+  int64_t count = 0;
+  for (size_t i = 0; i < bucket.tensors.size(); ++i) {
+    if (bucket.tensors[i]->Holder() != bucket.views[i]) ++count;
+  }
+  return count;
+}
+
+}  // namespace details
+}  // namespace paddle
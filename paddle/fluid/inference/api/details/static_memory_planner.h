@@ -0,0 +1,147 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace details {
+
+// Every block starts at a multiple of kStaticMemoryAlignment in the arena.
+constexpr size_t kStaticMemoryAlignment = 256;
+
+// One intermediate tensor of the plan, alive from op `first_use` to op
+// `last_use` of block 0 and stored at `offset` of the arena.
+struct StaticMemoryBlock {
+  std::string name;
+  std::vector<int64_t> dims;
+  framework::proto::VarType::Type dtype;
+  size_t size{0};
+  int first_use{0};
+  int last_use{0};
+  size_t offset{0};
+};
+
+// Assigns an offset to every block such that two blocks alive at the same op
+// never overlap in the arena, and returns the arena size. Blocks are placed
+// from the largest to the smallest, each one into the smallest gap left by
+// the placed blocks whose lifetime it overlaps, or on top of them.
+size_t AssignStaticMemoryOffsets(std::vector<StaticMemoryBlock>* blocks);
+
+struct StaticMemoryPlan {
+  std::map<std::string, std::vector<int64_t>> input_shapes;
+  std::vector<StaticMemoryBlock> blocks;
+  size_t arena_size{0};
+  // The footprint when every block gets its own allocation.
+  size_t total_size{0};
+  // The largest sum of the blocks alive at one op, no plan can do better.
+  size_t lower_bound{0};
+};
+
+/*
+ * StaticMemoryPlanner plans the intermediate tensors of an inference program
+ * for fixed input shapes. The shapes of all the tensors are inferred at
+ * compile time from the input shapes, and every tensor whose shape is fully
+ * known gets an offset in one arena. Inputs, outputs, parameters and the
+ * tensors touched by control flow or LoD operators are left to the allocator,
+ * as MemoryOptimizePass does.
+ */
+class StaticMemoryPlanner {
+ public:
+  StaticMemoryPlanner(const framework::ProgramDesc& program,
+                      const std::vector<std::string>& input_names,
+                      const std::vector<std::string>& output_names);
+
+  // Returns false if the program can not be planned, e.g. it has sub blocks.
+  bool Plannable() const { return plannable_; }
+
+  StaticMemoryPlan Plan(
+      const std::map<std::string, std::vector<int64_t>>& input_shapes) const;
+
+ private:
+  framework::ProgramDesc program_;
+  bool plannable_{true};
+  // Lifetime of every candidate tensor, in op indices of block 0.
+  std::unordered_map<std::string, std::pair<int, int>> lifetimes_;
+};
+
+struct StaticMemoryStats {
+  int64_t runs{0};
+  // Runs whose input shapes matched a bucket.
+  int64_t bound_runs{0};
+  int64_t bound_tensors{0};
+  // Tensors reallocated by the allocator while running on a bucket, because
+  // a kernel needed more memory than planned.
+  int64_t reallocated_tensors{0};
+  // Allocator calls made by the arena itself, one per bucket.
+  int64_t arena_allocations{0};
+  size_t arena_bytes{0};
+};
+
+/*
+ * StaticMemoryArena binds the planned tensors of a scope to their offsets in
+ * one allocation per bucket before each run. A kernel then finds enough
+ * memory in its output tensor and does not call the allocator. Input shapes
+ * that match no bucket run as before, with whatever memory the tensors hold.
+ */
+class StaticMemoryArena {
+ public:
+  StaticMemoryArena(const platform::Place& place,
+                    std::vector<StaticMemoryPlan> plans);
+
+  // Binds the tensors of the smallest bucket whose shapes cover
+  // `input_shapes`. Returns false if no bucket matches.
+  bool Bind(framework::Scope* scope,
+            const std::map<std::string, std::vector<int64_t>>& input_shapes);
+
+  // Counts the tensors of the last bound bucket that left the arena.
+  int64_t CountReallocated() const;
+
+  const std::vector<StaticMemoryPlan>& plans() const { return plans_; }
+  const StaticMemoryStats& Stats() const { return stats_; }
+
+ private:
+  struct Bucket {
+    std::shared_ptr<pten::Allocation> arena;
+    std::vector<std::shared_ptr<pten::Allocation>> views;
+    std::vector<framework::LoDTensor*> tensors;
+    framework::Scope* scope{nullptr};
+  };
+
+  int MatchBucket(
+      const std::map<std::string, std::vector<int64_t>>& input_shapes) const;
+  void PrepareBucket(int index, framework::Scope* scope);
+
+  platform::Place place_;
+  std::vector<StaticMemoryPlan> plans_;
+  std::vector<Bucket> buckets_;
+  int bound_{-1};
+  StaticMemoryStats stats_;
+};
+
+}  // namespace details
+}  // namespace paddle
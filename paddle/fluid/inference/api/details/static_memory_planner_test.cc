@@ -0,0 +1,216 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/details/static_memory_planner.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/inference/analysis/passes/memory_optimize_pass.h"
+
+USE_OP(relu);
+USE_OP_ITSELF(scale);
+USE_OP_ITSELF(concat);
+USE_OP_ITSELF(elementwise_add);
+
+namespace paddle {
+namespace details {
+
+static void CheckNoOverlap(const std::vector<StaticMemoryBlock>& blocks,
+                           size_t arena_size) {
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    ASSERT_LE(blocks[i].offset + blocks[i].size, arena_size);
+    for (size_t j = i + 1; j < blocks.size(); ++j) {
+      auto& a = blocks[i];
+      auto& b = blocks[j];
+      bool alive_together =
+          a.first_use <= b.last_use && b.first_use <= a.last_use;
+      bool share_memory =
+          a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+      ASSERT_FALSE(alive_together && share_memory) << a.name << " " << b.name;
+    }
+  }
+}
+
+// The footprint of the cluster plan of MemoryOptimizePass.
+static size_t ClusterFootprint(const StaticMemoryPlan& plan) {
+  std::unordered_map<std::string, std::pair<int, int>> lifecycles;
+  std::unordered_map<std::string, size_t> space_table;
+  for (auto& block : plan.blocks) {
+    lifecycles[block.name] = std::make_pair(block.first_use, block.last_use);
+    space_table[block.name] = block.size;
+  }
+  std::unordered_map<std::string, std::string> node2cluster;
+  std::unordered_map<std::string, int> cluster_size;
+  inference::analysis::MakeSimpleReusePlan(lifecycles, space_table,
+                                           &node2cluster, &cluster_size);
+  size_t footprint = 0;
+  for (auto& cluster : cluster_size) footprint += cluster.second;
+  return footprint;
+}
+
+TEST(StaticMemoryPlanner, AssignOffsets) {
+  std::vector<StaticMemoryBlock> blocks;
+  auto add = [&](const std::string& name, size_t size, int first, int last) {
+    StaticMemoryBlock block;
+    block.name = name;
+    block.size = size * kStaticMemoryAlignment;
+    block.first_use = first;
+    block.last_use = last;
+    blocks.push_back(block);
+  };
+  add("a", 4, 0, 1);
+  add("b", 2, 1, 2);
+  add("c", 2, 2, 3);
+  add("d", 4, 3, 4);
+  add("e", 1, 0, 4);
+  add("f", 3, 2, 2);
+  size_t arena_size = AssignStaticMemoryOffsets(&blocks);
+  CheckNoOverlap(blocks, arena_size);
+  // a and d never live together, so they share the same memory
+  ASSERT_EQ(blocks[0].offset, blocks[3].offset);
+  ASSERT_LT(arena_size, 16 * kStaticMemoryAlignment);
+}
+
+// x -> relu -> h0 -> scale -> s0 -> concat(h0, s0) -> c0 -> relu -> h1 ...
+// The width doubles at each layer and the last add is the output.
+static framework::ProgramDesc BuildProgram(int layers) {
+  framework::ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  auto add_var = [&](const std::string& name) {
+    auto* var = block->Var(name);
+    var->SetType(framework::proto::VarType::LOD_TENSOR);
+    var->SetDataType(framework::proto::VarType::FP32);
+    var->SetShape({-1, 1});
+  };
+  auto add_op = [&](const std::string& type, const std::string& x,
+                    const std::string& y, const std::string& out) {
+    auto* op = block->AppendOp();
+    op->SetType(type);
+    op->SetInput("X", {x});
+    if (type == "concat") {
+      op->SetInput("X", {x, y});
+      op->SetAttr("axis", 1);
+    } else if (type == "elementwise_add") {
+      op->SetInput("Y", {y});
+      op->SetAttr("axis", -1);
+    } else if (type == "scale") {
+      op->SetAttr("scale", 0.5f);
+      op->SetAttr("bias", 1.0f);
+      op->SetAttr("bias_after_scale", true);
+    }
+    op->SetOutput("Out", {out});
+    op->CheckAttrs();
+    add_var(out);
+  };
+  add_var("x");
+  std::string h = "x";
+  for (int i = 0; i < layers; ++i) {
+    std::string id = std::to_string(i);
+    add_op("relu", h, "", "h" + id);
+    add_op("scale", "h" + id, "", "s" + id);
+    add_op("concat", "h" + id, "s" + id, "c" + id);
+    h = "c" + id;
+  }
+  add_op("scale", h, "", "t");
+  add_op("elementwise_add", h, "t", "out");
+  return program;
+}
+
+TEST(StaticMemoryPlanner, PlanAndBind) {
+  const int layers = 6;
+  const int64_t batch = 8;
+  const int64_t width = 64;
+  auto program = BuildProgram(layers);
+  StaticMemoryPlanner planner(program, {"x"}, {"out"});
+  ASSERT_TRUE(planner.Plannable());
+  std::vector<StaticMemoryPlan> plans;
+  plans.push_back(planner.Plan({{"x", {batch, width}}}));
+  plans.push_back(planner.Plan({{"x", {batch * 4, width}}}));
+
+  auto& plan = plans[0];
+  // h, s and c of every layer, and t
+  ASSERT_EQ(plan.blocks.size(), static_cast<size_t>(layers * 3 + 1));
+  CheckNoOverlap(plan.blocks, plan.arena_size);
+  for (auto& block : plan.blocks) {
+    ASSERT_EQ(block.offset % kStaticMemoryAlignment, 0UL);
+    if (block.name == "t") {
+      ASSERT_EQ(block.dims, std::vector<int64_t>({batch, width << layers}));
+    }
+  }
+  size_t cluster_footprint = ClusterFootprint(plan);
+  ASSERT_GE(plan.arena_size, plan.lower_bound);
+  ASSERT_LE(plan.arena_size, cluster_footprint);
+  ASSERT_LT(plan.arena_size, plan.total_size);
+  LOG(INFO) << "peak memory: arena " << plan.arena_size << " bytes, cluster "
+            << "reuse " << cluster_footprint << " bytes, no reuse "
+            << plan.total_size << " bytes, lower bound " << plan.lower_bound
+            << " bytes";
+
+  platform::CPUPlace place;
+  auto run = [&](framework::Scope* scope, StaticMemoryArena* arena,
+                 int64_t rows, int64_t* allocations) {
+    framework::NaiveExecutor exe(place);
+    exe.Prepare(scope, program, 0, false);
+    auto* x = exe.FindTensor("x");
+    x->Resize({rows, width});
+    float* x_data = x->mutable_data<float>(place);
+    for (int64_t i = 0; i < x->numel(); ++i) x_data[i] = i % 7 - 3;
+    if (arena) arena->Bind(scope, {{"x", {rows, width}}});
+    // count the tensors the run had to allocate
+    std::vector<const void*> holders;
+    for (auto& block : plans[0].blocks) {
+      holders.push_back(exe.FindTensor(block.name)->Holder().get());
+    }
+    exe.Run();
+    for (size_t i = 0; i < holders.size(); ++i) {
+      auto* tensor = exe.FindTensor(plans[0].blocks[i].name);
+      if (tensor->Holder().get() != holders[i]) ++(*allocations);
+    }
+    std::vector<float> out;
+    auto* out_tensor = exe.FindTensor("out");
+    out.assign(out_tensor->data<float>(),
+               out_tensor->data<float>() + out_tensor->numel());
+    return out;
+  };
+
+  framework::Scope base_scope;
+  framework::Scope arena_scope;
+  StaticMemoryArena arena(place, plans);
+  int64_t base_allocations = 0;
+  int64_t arena_allocations = 0;
+  for (int64_t rows : {batch, batch / 2, batch * 4, batch}) {
+    auto expect = run(&base_scope, nullptr, rows, &base_allocations);
+    auto out = run(&arena_scope, &arena, rows, &arena_allocations);
+    ASSERT_EQ(out.size(), expect.size());
+    for (size_t i = 0; i < out.size(); ++i) ASSERT_FLOAT_EQ(out[i], expect[i]);
+    ASSERT_EQ(arena.CountReallocated(), 0);
+  }
+  // a batch larger than every bucket falls back to the allocator
+  ASSERT_FALSE(arena.Bind(&arena_scope, {{"x", {batch * 8, width}}}));
+
+  auto& stats = arena.Stats();
+  ASSERT_EQ(arena_allocations, 0);
+  ASSERT_EQ(stats.bound_runs, 4);
+  ASSERT_EQ(stats.reallocated_tensors, 0);
+  ASSERT_EQ(stats.arena_allocations, 2);
+  LOG(INFO) << "allocations over 4 runs: " << base_allocations
+            << " tensors without the plan, " << stats.arena_allocations
+            << " arenas of " << stats.arena_bytes << " bytes with the plan";
+}
+
+}  // namespace details
+}  // namespace paddle
@@ -693,6 +693,38 @@ struct PD_INFER_DECL AnalysisConfig {
   ///
   bool enable_memory_optim() const;
 
+  ///
+  /// \brief Plan the intermediate tensors into one arena per shape bucket.
+  /// The shapes of all the tensors are inferred from the input shapes of each
+  /// bucket, and every tensor gets a fixed offset in the arena of its bucket.
+  /// A run whose input shapes are covered by a bucket binds the tensors to
+  /// the arena instead of allocating them one by one; other runs allocate as
+  /// usual.
+  ///
+  /// \param shape_buckets The max input shapes of every bucket.
+  ///
+  void EnableStaticMemoryPlan(
+      const std::vector<std::map<std::string, std::vector<int>>>&
+          shape_buckets);
+  ///
+  /// \brief A boolean state telling whether the static memory plan is
+  /// activated.
+  ///
+  /// \return bool Whether the static memory plan is activated.
+  ///
+  bool static_memory_plan_enabled() const {
+    return !static_memory_shape_buckets_.empty();
+  }
+  ///
+  /// \brief Get the shape buckets of the static memory plan.
+  ///
+  /// \return The max input shapes of every bucket.
+  ///
+  const std::vector<std::map<std::string, std::vector<int>>>&
+  static_memory_shape_buckets() const {
+    return static_memory_shape_buckets_;
+  }
+
   ///
   /// \brief Turn on profiling report.
   /// If not turned on, no profiling report will be generated.
@@ -824,6 +856,8 @@ struct PD_INFER_DECL AnalysisConfig {
 
   // memory reuse related.
   bool enable_memory_optim_{false};
+  std::vector<std::map<std::string, std::vector<int>>>
+      static_memory_shape_buckets_;
 
   bool use_mkldnn_{false};
   std::unordered_set<std::string> mkldnn_enabled_op_types_;
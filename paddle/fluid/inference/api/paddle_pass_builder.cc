@@ -197,6 +197,7 @@ CpuPassStrategy::CpuPassStrategy() : PassStrategy({}) {
                   "seqconv_eltadd_relu_fuse_pass",  //
                   // "seqpool_concat_fuse_pass",    //
                   "seqpool_cvm_concat_fuse_pass",  //
+                  "batch_fc_act_fuse_pass",        //
                   // "embedding_fc_lstm_fuse_pass", //
                   // TODO(wilber): fix correctness problem.
                   // "fc_lstm_fuse_pass",                    //
@@ -220,6 +221,12 @@ CpuPassStrategy::CpuPassStrategy() : PassStrategy({}) {
                   "conv_transpose_bn_fuse_pass",             //
                   "conv_transpose_eltwiseadd_bn_fuse_pass",  //
                   "is_test_pass",                            //
+#if !defined(_WIN32) && !defined(__APPLE__)
+                  // fuses the remaining elementwise chains into C++ functions
+                  // built by the system compiler, disables itself when there
+                  // is none, and is removed when MKLDNN is enabled
+                  "fusion_group_pass",  //
+#endif
                   // following pass should be located in the last, since
                   // it will work on all fused ops.
                   "runtime_context_cache_pass"});
@@ -234,6 +241,7 @@ void CpuPassStrategy::EnableMKLDNN() {
 #ifdef PADDLE_WITH_MKLDNN
   if (!use_mkldnn_) {
     passes_.insert(passes_.begin(), "mkldnn_placement_pass");
+    DeletePass("fusion_group_pass");
 
     for (auto &pass : std::vector<std::string>({
              "depthwise_conv_mkldnn_pass",     //
@@ -14,10 +14,12 @@ limitations under the License. */
 
 #pragma once
 #include <algorithm>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/radix_sort.h"
 #include "paddle/fluid/operators/transpose_op.h"
 
 namespace paddle {
@@ -33,10 +35,36 @@ using EigenVector = framework::EigenVector<T, MajorType, IndexType>;
 
 using Tensor = framework::Tensor;
 
+// The rows of integers are sorted by a radix sort, which is stable, so the
+// equal values keep the order of their indices. A single row is sorted by
+// all the omp threads.
 template <typename T, typename Type>
-static void FullSort(Type input_height, Type input_width, int input_dim,
-                     const framework::Tensor* input, T* t_out, Type* t_indices,
-                     bool descending) {
+static typename std::enable_if<std::is_integral<T>::value>::type FullSort(
+    Type input_height, Type input_width, int input_dim,
+    const framework::Tensor* input, T* t_out, Type* t_indices,
+    bool descending) {
+  using KeyT = typename math::RadixKey<T>::Type;
+  const T* in_data = input->data<T>();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (input_height > 1)
+#endif
+  for (Type i = 0; i < input_height; ++i) {
+    const T* row = in_data + i * input_width;
+    Type* row_indices = t_indices + i * input_width;
+    std::vector<KeyT> keys(input_width);
+    math::RadixSortIndices(row, input_width, descending, row_indices,
+                           keys.data());
+    for (Type j = 0; j < input_width; ++j) {
+      t_out[i * input_width + j] = row[row_indices[j]];
+    }
+  }
+}
+
+template <typename T, typename Type>
+static typename std::enable_if<!std::is_integral<T>::value>::type FullSort(
+    Type input_height, Type input_width, int input_dim,
+    const framework::Tensor* input, T* t_out, Type* t_indices,
+    bool descending) {
 #ifdef PADDLE_WITH_MKLML
 #pragma omp parallel for
 #endif
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/batch_fc_op.h"
 #include <string>
+#include "paddle/fluid/framework/op_version_registry.h"
 
 namespace paddle {
 namespace operators {
@@ -108,9 +109,13 @@ class BatchFCOpMaker : public framework::OpProtoAndCheckerMaker {
     AddInput("W", "(Tensor) Input tensor of batch_fc_op operator.");
     AddInput("Bias", "(Tensor) Input tensor of batch_fc_op operator.");
     AddOutput("Out", "Output tensor of batch_fc_op operator.");
+    AddAttr<std::string>("activation_type",
+                         "(string, default \"\") Activation type fused "
+                         "after the batched fc, \"\" or \"relu\".")
+        .SetDefault("")
+        .InEnum({"", "relu"});
     AddComment(R"DOC(
 BatchFC Operator.
-Notice: It currently supports GPU device.
 This Op exists in contrib, which means that it is not shown to the public.
 )DOC");
   }
@@ -153,3 +158,19 @@ REGISTER_OPERATOR(batch_fc_grad, ops::BatchFCGradOp,
 REGISTER_OP_CPU_KERNEL(
     batch_fc, ops::BatchFCKernel<paddle::platform::CPUDeviceContext, float>,
     ops::BatchFCKernel<paddle::platform::CPUDeviceContext, double>);
+
+REGISTER_OP_CPU_KERNEL(
+    batch_fc_grad,
+    ops::BatchFCGradOpKernel<paddle::platform::CPUDeviceContext, float>,
+    ops::BatchFCGradOpKernel<paddle::platform::CPUDeviceContext, double>);
+
+REGISTER_OP_VERSION(batch_fc)
+    .AddCheckpoint(
+        R"ROC(
+        Upgrade batch_fc, add a new attribute [activation_type].
+      )ROC",
+        paddle::framework::compatible::OpVersionDesc().NewAttr(
+            "activation_type",
+            "(string) The activation fused after the batched fc, "
+            "\"\" or \"relu\".",
+            std::string("")));
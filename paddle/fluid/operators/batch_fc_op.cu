@@ -30,22 +30,25 @@ static inline int GET_BLOCKS(const int N) {
 
 template <typename T>
 __global__ void add_bias_kernel(T* data, int slot_pairs_num, int ins_num,
-                                int out_dim, const T* bias) {
+                                int out_dim, const T* bias, bool with_relu) {
   CUDA_KERNEL_LOOP(idx, slot_pairs_num * ins_num * out_dim) {
     int block_len = ins_num * out_dim;
     int slot_index = idx / block_len;
     int out_dim_index = (idx % block_len) % out_dim;
     T temp = data[idx] + bias[slot_index * out_dim + out_dim_index];
+    if (with_relu && temp < static_cast<T>(0)) {
+      temp = static_cast<T>(0);
+    }
     data[idx] = temp;
   }
 }
 
 template <typename T>
 void add_bias(gpuStream_t stream, T* data, int slot_pairs_num, int ins_num,
-              int out_dim, const T* bias) {
+              int out_dim, const T* bias, bool with_relu) {
   add_bias_kernel<<<GET_BLOCKS(slot_pairs_num * ins_num * out_dim),
-                    CUDA_NUM_THREADS, 0, stream>>>(data, slot_pairs_num,
-                                                   ins_num, out_dim, bias);
+                    CUDA_NUM_THREADS, 0, stream>>>(
+      data, slot_pairs_num, ins_num, out_dim, bias, with_relu);
 }
 
 template <typename T>
@@ -83,6 +86,7 @@ class BatchFCCUDAKernel : public framework::OpKernel<T> {
     auto* w = ctx.Input<Tensor>("W");
     auto* bias = ctx.Input<Tensor>("Bias");
     auto* output = ctx.Output<framework::LoDTensor>("Out");
+    bool with_relu = ctx.Attr<std::string>("activation_type") == "relu";
     auto input_dims = input->dims();
     auto w_dims = w->dims();
     auto slot_pairs_num = input_dims[0];
@@ -116,7 +120,7 @@ class BatchFCCUDAKernel : public framework::OpKernel<T> {
     blas.BatchedGEMM(transA, transB, ins_num, out_dim, in_dim, alpha, in_data,
                      w_data, beta, out_data, slot_pairs_num, strideA, strideB);
     add_bias<T>(ctx.cuda_device_context().stream(), out_data, slot_pairs_num,
-                ins_num, out_dim, bias_data);
+                ins_num, out_dim, bias_data, with_relu);
   }
 };
 
@@ -124,6 +128,15 @@ template <typename DeviceContext, typename T>
 class BatchFCGradOpCUDAKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
+    // batch_fc_grad has no proto maker, so the descs saved before the
+    // attribute was added do not have it.
+    PADDLE_ENFORCE_EQ(
+        !ctx.HasAttr("activation_type") ||
+            ctx.Attr<std::string>("activation_type").empty(),
+        true,
+        platform::errors::Unimplemented(
+            "The grad of BatchFC does not support the fused activation, "
+            "which is only fused for the inference."));
     auto* input = ctx.Input<Tensor>("Input");
     auto* w = ctx.Input<Tensor>("W");
     auto* dout = ctx.Input<Tensor>(framework::GradVarName("Out"));
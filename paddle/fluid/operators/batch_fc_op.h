@@ -13,20 +13,130 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <algorithm>
+#include <string>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/blas.h"
 
 namespace paddle {
 namespace operators {
 
+using framework::Tensor;
+
 template <typename DeviceContext, typename T>
 class BatchFCKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
+    // X.dim = slot_pairs_num * ins_num * in_dim
+    // W.dim = slot_pairs_num * in_dim * out_dim
+    // b.dim = slot_pairs_num * out_dim
+    // output.dim = slot_pairs_num * ins_num * out_dim
+    auto* input = ctx.Input<framework::LoDTensor>("Input");
+    auto* w = ctx.Input<Tensor>("W");
+    auto* bias = ctx.Input<Tensor>("Bias");
+    auto* output = ctx.Output<framework::LoDTensor>("Out");
+    bool with_relu = ctx.Attr<std::string>("activation_type") == "relu";
+    auto input_dims = input->dims();
+    auto w_dims = w->dims();
+    auto slot_pairs_num = input_dims[0];
+    auto ins_num = input_dims[1];
+    auto in_dim = input_dims[2];
+    auto out_dim = w_dims[2];
+
+    const T* in_data = input->data<T>();
+    const T* w_data = w->data<T>();
+    const T* bias_data = bias->data<T>();
+    output->Resize({slot_pairs_num, ins_num, out_dim});
+    T* out_data = output->mutable_data<T>(ctx.GetPlace());
+
+    // The output starts from the bias of its slot, and the GEMMs of all the
+    // slots accumulate to it in one batch, so the bias takes no extra pass.
+    for (int64_t slot = 0; slot < slot_pairs_num; ++slot) {
+      const T* slot_bias = bias_data + slot * out_dim;
+      T* slot_out = out_data + slot * ins_num * out_dim;
+      for (int64_t i = 0; i < ins_num; ++i) {
+        std::copy(slot_bias, slot_bias + out_dim, slot_out + i * out_dim);
+      }
+    }
+    auto blas = math::GetBlas<DeviceContext, T>(ctx);
+    blas.BatchedGEMM(CblasNoTrans, CblasNoTrans, ins_num, out_dim, in_dim,
+                     static_cast<T>(1), in_data, w_data, static_cast<T>(1),
+                     out_data, slot_pairs_num, ins_num * in_dim,
+                     in_dim * out_dim);
+    if (with_relu) {
+      int64_t numel = output->numel();
+      for (int64_t i = 0; i < numel; ++i) {
+        out_data[i] = std::max(out_data[i], static_cast<T>(0));
+      }
+    }
+  }
+};
+
+template <typename DeviceContext, typename T>
+class BatchFCGradOpKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    // batch_fc_grad has no proto maker, so the descs saved before the
+    // attribute was added do not have it.
     PADDLE_ENFORCE_EQ(
-        platform::is_gpu_place(ctx.GetPlace()), true,
-        platform::errors::Unimplemented("BatchFC only supports GPU now."));
+        !ctx.HasAttr("activation_type") ||
+            ctx.Attr<std::string>("activation_type").empty(),
+        true,
+        platform::errors::Unimplemented(
+            "The grad of BatchFC does not support the fused activation, "
+            "which is only fused for the inference."));
+    auto* input = ctx.Input<Tensor>("Input");
+    auto* w = ctx.Input<Tensor>("W");
+    auto* dout = ctx.Input<Tensor>(framework::GradVarName("Out"));
+
+    auto* dx = ctx.Output<Tensor>(framework::GradVarName("Input"));
+    auto* dw = ctx.Output<Tensor>(framework::GradVarName("W"));
+    auto* db = ctx.Output<Tensor>(framework::GradVarName("Bias"));
+
+    auto input_dims = input->dims();
+    auto w_dims = w->dims();
+    auto slot_pairs_num = input_dims[0];
+    auto ins_num = input_dims[1];
+    auto in_dim = input_dims[2];
+    auto out_dim = w_dims[2];
+
+    const T* dout_data = dout->data<T>();
+    auto blas = math::GetBlas<DeviceContext, T>(ctx);
+    T alpha = 1;
+    T beta = 0;
+
+    if (dx) {
+      // dx = dout_data * y^T
+      T* dx_data = dx->mutable_data<T>(ctx.GetPlace());
+      blas.BatchedGEMM(CblasNoTrans, CblasTrans, ins_num, in_dim, out_dim,
+                       alpha, dout_data, w->data<T>(), beta, dx_data,
+                       slot_pairs_num, ins_num * out_dim, out_dim * in_dim);
+    }
+    if (dw) {
+      // dy = x^T * dout_data
+      T* dw_data = dw->mutable_data<T>(ctx.GetPlace());
+      blas.BatchedGEMM(CblasTrans, CblasNoTrans, in_dim, out_dim, ins_num,
+                       alpha, input->data<T>(), dout_data, beta, dw_data,
+                       slot_pairs_num, in_dim * ins_num, ins_num * out_dim);
+    }
+    if (db) {
+      // db = the sum of dout_data over the instances of each slot
+      T* db_data = db->mutable_data<T>(ctx.GetPlace());
+      std::fill(db_data, db_data + slot_pairs_num * out_dim,
+                static_cast<T>(0));
+      for (int64_t slot = 0; slot < slot_pairs_num; ++slot) {
+        T* slot_db = db_data + slot * out_dim;
+        const T* slot_dout = dout_data + slot * ins_num * out_dim;
+        for (int64_t i = 0; i < ins_num; ++i) {
+          for (int64_t j = 0; j < out_dim; ++j) {
+            slot_db[j] += slot_dout[i * out_dim + j];
+          }
+        }
+      }
+    }
   }
 };
+
 }  // namespace operators
 }  // namespace paddle
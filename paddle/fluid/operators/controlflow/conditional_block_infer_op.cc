@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/controlflow/conditional_block_op.h"
+#include "paddle/fluid/operators/controlflow/prepared_block_cache.h"
 
 namespace paddle {
 namespace framework {
@@ -71,14 +72,17 @@ class ConditionalBlockInferOp : public ConditionalOp {
       scopes->front() = &scope.NewScope();
       auto &cur_scope = *scopes->front();
 
-      framework::Executor exec(dev_place);
       auto *block = Attr<framework::BlockDesc *>("sub_block");
       VLOG(3) << "Conditional block.idx = " << block->ID()
               << ", scope = " << &cur_scope;
-      exec.Run(*block->Program(), &cur_scope, block->ID(), false);
+      auto *ctx = block_cache_.Get(dev_place, *block, {});
+      RunPreparedBlock(block_cache_.executor(), ctx, &cur_scope, dev_place,
+                       /* keep_kid_scopes */ false);
       scope.DeleteScope(scopes->front());
     }
   }
+
+  mutable PreparedBlockCache block_cache_;
 };
 
 }  // namespace operators
@@ -15,6 +15,7 @@ limitations under the License. */
 #include "paddle/fluid/operators/controlflow/conditional_block_op.h"
 
 #include "paddle/fluid/operators/assign_op.h"
+#include "paddle/fluid/operators/controlflow/prepared_block_cache.h"
 #include "paddle/pten/kernels/funcs/math_function.h"
 
 namespace paddle {
@@ -65,17 +66,18 @@ class ConditionalBlockOp : public ConditionalOp {
       scopes->resize(1);
       scopes->front() = &scope.NewScope();
       auto &cur_scope = *scopes->front();
-      framework::Executor exec(dev_place);
       auto *block = Attr<framework::BlockDesc *>("sub_block");
       VLOG(3) << "Conditional block.idx = " << block->ID()
               << ", scope = " << &cur_scope;
       auto &skip_vars =
           Attr<std::vector<std::string>>(ConditionalOp::kSkipEagerDeletionVars);
-      exec.Run(*block->Program(), &cur_scope, block->ID(), false, true,
-               skip_vars, /* force_disable_gc */ false,
-               /* keep_kid_scopes */ true);
+      auto *ctx = block_cache_.Get(dev_place, *block, skip_vars);
+      RunPreparedBlock(block_cache_.executor(), ctx, &cur_scope, dev_place,
+                       /* keep_kid_scopes */ true);
     }
   }
+
+  mutable PreparedBlockCache block_cache_;
 };
 
 class ConditionalBlockInferShape : public framework::InferShapeBase {
@@ -133,14 +135,13 @@ class ConditionalBlockGradOp : public ConditionalOp {
               scopes.size()));
       framework::Scope &cur_scope = *scopes[0];
 
-      framework::Executor exec(dev_place);
       auto *block = Attr<framework::BlockDesc *>("sub_block");
 
       VLOG(3) << "Conditional Grad block.idx = " << block->ID()
               << ", scope = " << &cur_scope;
-      exec.Run(*block->Program(), &cur_scope, block->ID(), false, true,
-               inside_grads, /* force_disable_gc */ false,
-               /* keep_kid_scopes */ false);
+      auto *ctx = block_cache_.Get(dev_place, *block, inside_grads);
+      RunPreparedBlock(block_cache_.executor(), ctx, &cur_scope, dev_place,
+                       /* keep_kid_scopes */ false);
 
       AssignLocalGradientToParentScope(dev_place, cur_scope, scope,
                                        inside_grads, outside_grads);
@@ -151,6 +152,8 @@ class ConditionalBlockGradOp : public ConditionalOp {
   }
 
  private:
+  mutable PreparedBlockCache block_cache_;
+
   void AssignLocalGradientToParentScope(
       const platform::Place &place, const framework::Scope &cur_scope,
       const framework::Scope &parent_scope,
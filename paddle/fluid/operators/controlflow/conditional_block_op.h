@@ -22,6 +22,10 @@ limitations under the License. */
 #include "paddle/fluid/framework/executor.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/var_type.h"
+#include "paddle/fluid/platform/profiler.h"
+#ifdef PADDLE_WITH_MKLDNN
+#include "paddle/fluid/platform/mkldnn_helper.h"
+#endif
 
 namespace paddle {
 namespace operators {
@@ -92,6 +96,20 @@ class ConditionalOp : public framework::OperatorBase {
     }
     return res;
   }
+
+  // Run the prepared sub-block in `scope` without creating a local scope,
+  // the same as Executor::Run does.
+  void RunPreparedBlock(framework::Executor *exec,
+                        framework::ExecutorPrepareContext *ctx,
+                        framework::Scope *scope,
+                        const platform::Place &place,
+                        bool keep_kid_scopes) const {
+    platform::RecordBlock record_block(ctx->block_id_);
+#ifdef PADDLE_WITH_MKLDNN
+    platform::AttachPointerHashToMKLDNNKey(exec, place);
+#endif
+    exec->RunPreparedContext(ctx, scope, false, true, keep_kid_scopes);
+  }
 };
 
 class ConditionalBlockOpProtoMaker : public framework::OpProtoAndCheckerMaker {
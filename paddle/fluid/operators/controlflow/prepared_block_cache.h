@@ -0,0 +1,75 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/executor.h"
+#include "paddle/fluid/framework/garbage_collector.h"
+
+DECLARE_bool(cache_control_flow_block);
+DECLARE_bool(use_mkldnn);
+
+namespace paddle {
+namespace operators {
+
+/*
+ * PreparedBlockCache keeps the executor and the prepared context of the
+ * sub-block of a control flow op, so that the ops of the sub-block are
+ * created once per op instead of once per run.
+ *
+ * The context is prepared again when the place, the skipped variables, the
+ * eager deletion threshold or FLAGS_use_mkldnn change. With
+ * FLAGS_cache_control_flow_block off, it is prepared on every call, the
+ * same as before.
+ */
+class PreparedBlockCache {
+ public:
+  framework::ExecutorPrepareContext *Get(
+      const platform::Place &place, const framework::BlockDesc &block,
+      const std::vector<std::string> &skip_vars) {
+    int64_t gc_threshold = framework::GetEagerDeletionThreshold();
+    bool hit = FLAGS_cache_control_flow_block && ctx_ != nullptr &&
+               executor_->GetPlace() == place && skip_vars_ == skip_vars &&
+               gc_threshold_ == gc_threshold &&
+               use_mkldnn_ == FLAGS_use_mkldnn;
+    if (!hit) {
+      VLOG(3) << "Prepare the sub-block " << block.ID() << " on " << place;
+      executor_.reset(new framework::Executor(place));
+      // the same as Executor::Run, the ops are created with use_mkldnn set
+      if (FLAGS_use_mkldnn) executor_->EnableMKLDNN(*block.Program());
+      ctx_ = executor_->Prepare(*block.Program(), block.ID(), skip_vars);
+      skip_vars_ = skip_vars;
+      gc_threshold_ = gc_threshold;
+      use_mkldnn_ = FLAGS_use_mkldnn;
+    }
+    return ctx_.get();
+  }
+
+  // The executor of the last context returned by Get.
+  framework::Executor *executor() const { return executor_.get(); }
+
+ private:
+  std::unique_ptr<framework::Executor> executor_;
+  std::unique_ptr<framework::ExecutorPrepareContext> ctx_;
+  std::vector<std::string> skip_vars_;
+  int64_t gc_threshold_{0};
+  bool use_mkldnn_{false};
+};
+
+}  // namespace operators
+}  // namespace paddle
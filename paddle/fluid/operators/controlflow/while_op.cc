@@ -15,6 +15,7 @@
 #include "paddle/fluid/framework/executor.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/operators/controlflow/prepared_block_cache.h"
 #include "paddle/fluid/operators/controlflow/while_op_helper.h"
 
 namespace paddle {
@@ -66,7 +67,6 @@ class WhileOp : public framework::OperatorBase {
             "the Condition's shape is ",
             cond.dims().to_str(), ".\n"));
 
-    framework::Executor executor(dev_place);
     auto *block = Attr<framework::BlockDesc *>(kStepBlock);
 
     auto *program = block->Program();
@@ -109,7 +109,8 @@ class WhileOp : public framework::OperatorBase {
     auto &skip_vars = Attr<std::vector<std::string>>(kSkipEagerDeletionVars);
     VLOG(2) << GetSkipEagerDeletionVarsDebugString(skip_vars);
 
-    auto ctx = executor.Prepare(*program, block->ID(), skip_vars);
+    auto *ctx = block_cache_.Get(dev_place, *block, skip_vars);
+    auto &executor = *block_cache_.executor();
     if (!is_test) {
       while (cond_data) {
         auto &current_scope = scope.NewScope();
@@ -132,8 +133,7 @@ class WhileOp : public framework::OperatorBase {
             }
           }
         }
-        executor.RunPreparedContext(ctx.get(), &current_scope, false, true,
-                                    true);
+        executor.RunPreparedContext(ctx, &current_scope, false, true, true);
 
         for (auto &var_rename : rename_vars) {
           std::string input_var_name =
@@ -144,8 +144,14 @@ class WhileOp : public framework::OperatorBase {
             GetCondData(scope.FindVar(Input(kCondition))->Get<LoDTensor>());
       }
     } else {
-      auto &current_scope = scope.NewScope();
-      executor.CreateVariables(*program, &current_scope, block->ID());
+      // The step scope is kept by the op and reused by the following runs
+      // under the same scope, with its variables created and allocated.
+      if (!FLAGS_cache_control_flow_block || test_scope_ == nullptr ||
+          test_scope_->parent() != &scope) {
+        test_scope_ = scope.NewTmpScope();
+        executor.CreateVariables(*program, test_scope_.get(), block->ID());
+      }
+      auto &current_scope = *test_scope_;
       while (cond_data) {
         for (auto &name : current_scope.LocalVarNames()) {
           auto *var = current_scope.Var(name);
@@ -160,14 +166,19 @@ class WhileOp : public framework::OperatorBase {
             t->clear();
           }
         }
-        executor.RunPreparedContext(ctx.get(), &current_scope, false, false,
+        executor.RunPreparedContext(ctx, &current_scope, false, false,
                                     false);
         cond_data =
             GetCondData(scope.FindVar(Input(kCondition))->Get<LoDTensor>());
       }
-      scope.DeleteScope(&current_scope);
+      if (!FLAGS_cache_control_flow_block) {
+        test_scope_.reset();
+      }
     }
   }
+
+  mutable PreparedBlockCache block_cache_;
+  mutable std::unique_ptr<framework::Scope> test_scope_;
 };
 
 class WhileOpMaker : public framework::OpProtoAndCheckerMaker {
@@ -222,13 +233,12 @@ class WhileGradOp : public framework::OperatorBase {
     // get device context from pool
     platform::DeviceContextPool &pool = platform::DeviceContextPool::Instance();
     auto &dev_ctx = *pool.Get(dev_place);
-    framework::Executor executor(dev_place);
     auto *block = Attr<framework::BlockDesc *>(kStepBlock);
-    auto *program = block->Program();
 
     auto &skip_vars = Attr<std::vector<std::string>>(kSkipEagerDeletionVars);
     VLOG(2) << GetSkipEagerDeletionVarsDebugString(skip_vars);
-    auto ctx = executor.Prepare(*program, block->ID(), skip_vars);
+    auto *ctx = block_cache_.Get(dev_place, *block, skip_vars);
+    auto &executor = *block_cache_.executor();
 
     auto *step_scopes =
         scope.FindVar(Input(kStepScopes))->GetMutable<StepScopeVar>();
@@ -300,8 +310,7 @@ class WhileGradOp : public framework::OperatorBase {
               "WhileGradOp."));
         }
       }
-      executor.RunPreparedContext(ctx.get(), *cur_scope_iter, false, true,
-                                  true);
+      executor.RunPreparedContext(ctx, *cur_scope_iter, false, true, true);
 
       // The Outputs(kXGRAD) contains the names of the gradient of parameters
       // and inputs.
@@ -408,6 +417,8 @@ class WhileGradOp : public framework::OperatorBase {
     }
     step_scopes->clear();
   }
+
+  mutable PreparedBlockCache block_cache_;
 };
 
 template <typename T>
@@ -17,6 +17,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/lod_segment.h"
 #include "paddle/pten/kernels/funcs/math_function.h"
 
 namespace paddle {
@@ -50,14 +51,9 @@ class CRFDecodingOpKernel : public framework::OpKernel<T> {
       emission_weights_tmp.Resize({in_dims[0] * in_dims[1], in_dims[2]});
 
       decoded_path->Resize({in_dims[0] * in_dims[1], 1});
-      for (size_t i = 0; i < seq_num; ++i) {
-        if (length_data[i] == 0) continue;
-        int64_t start_pos = i * in_dims[1];
-        int64_t end_pos = start_pos + static_cast<int64_t>(length_data[i]);
-        Tensor decoded_path_one_seq = decoded_path->Slice(start_pos, end_pos);
-        Decode(emission_weights_tmp.Slice(start_pos, end_pos),
-               *transition_weights, &decoded_path_one_seq);
-      }
+      Decode(emission_weights_tmp, *transition_weights,
+             math::SequenceRows::FromLengths(length_data, seq_num, in_dims[1]),
+             path);
       decoded_path->Resize({in_dims[0], in_dims[1]});
 
       if (label) {
@@ -87,16 +83,8 @@ class CRFDecodingOpKernel : public framework::OpKernel<T> {
               "Input(Emission) must be a sequence. But received: lod level %u.",
               lod.size()));
       const size_t level = 0;
-      const size_t seq_num = lod[level].size() - 1;
-
-      for (size_t i = 0; i < seq_num; ++i) {
-        if (lod[level][i] == lod[level][i + 1]) continue;
-        int64_t start_pos = static_cast<int64_t>(lod[level][i]);
-        int64_t end_pos = static_cast<int64_t>(lod[level][i + 1]);
-        Tensor decoded_path_one_seq = decoded_path->Slice(start_pos, end_pos);
-        Decode(emission_weights->Slice(start_pos, end_pos), *transition_weights,
-               &decoded_path_one_seq);
-      }
+      Decode(*emission_weights, *transition_weights,
+             math::SequenceRows::FromLoD(lod[level]), path);
       if (label) {
         PADDLE_ENFORCE_EQ(label->NumLevels(), 1UL,
                           platform::errors::InvalidArgument(
@@ -113,26 +101,48 @@ class CRFDecodingOpKernel : public framework::OpKernel<T> {
   }
 
  private:
+  // Decode the sequences of `rows` in parallel. The sequences of a part of
+  // them share the memo tables of the part, allocated once for the batch.
   void Decode(const Tensor& emission_weights, const Tensor& transition_weights,
-              Tensor* decoded_path) const {
-    auto emission_dims = emission_weights.dims();
-    const size_t seq_len = emission_dims[0];
-    const size_t tag_num = emission_dims[1];
+              const math::SequenceRows& rows, int64_t* path) const {
+    const size_t tag_num = emission_weights.dims()[1];
     const T* x = emission_weights.data<T>();
     const T* w = transition_weights.data<T>();
-    int64_t* path = decoded_path->data<int64_t>();
+    const int64_t max_len = rows.MaxLength();
+    if (max_len == 0) return;
+    auto ker =
+        jit::KernelFuncs<jit::CRFDecodingTuple<T>, platform::CPUPlace>::Cache()
+            .At(tag_num);
 
+    int num_parts = math::LoDSegmentNumParts(rows.offsets.data(), rows.size(),
+                                             tag_num * tag_num);
+    const int64_t table_numel = max_len * static_cast<int64_t>(tag_num);
     // alpha is a memo table. An element alpha(k, v) records the score of the
     // best sequence of tags from position 1 to position k with v being the end
     // tag.
     Tensor alpha;
-    T* alpha_value = alpha.mutable_data<T>(emission_dims, platform::CPUPlace());
+    T* alpha_value = alpha.mutable_data<T>(
+        framework::make_ddim({num_parts, table_numel}), platform::CPUPlace());
     Tensor track;
-    int* track_value =
-        track.mutable_data<int>(emission_dims, platform::CPUPlace());
-    auto ker =
-        jit::KernelFuncs<jit::CRFDecodingTuple<T>, platform::CPUPlace>::Cache()
-            .At(tag_num);
+    int* track_value = track.mutable_data<int>(
+        framework::make_ddim({num_parts, table_numel}), platform::CPUPlace());
+    math::ForEachLoDPart(
+        rows.offsets.data(), rows.size(), num_parts,
+        [&](int part, size_t seg_begin, size_t seg_end) {
+          for (size_t i = seg_begin; i < seg_end; ++i) {
+            if (rows.Length(i) == 0) continue;
+            int64_t begin = rows.Begin(i);
+            DecodeOneSequence(ker, x + begin * tag_num, w, rows.Length(i),
+                              tag_num, alpha_value + part * table_numel,
+                              track_value + part * table_numel, path + begin);
+          }
+        });
+  }
+
+  static void DecodeOneSequence(
+      typename jit::CRFDecodingTuple<T>::func_type ker, const T* x,
+      const T* w, size_t seq_len, size_t tag_num, T* alpha_value,
+      int* track_value, int64_t* path) {
     ker(static_cast<int>(seq_len), x, w, alpha_value, track_value, tag_num);
     T max_score = -std::numeric_limits<T>::max();
     int max_i = 0;
@@ -72,7 +72,7 @@ class FusionGroupOp : public framework::OperatorWithKernel {
   framework::OpKernelType GetExpectedKernelType(
       const framework::ExecutionContext& ctx) const override {
     return framework::OpKernelType(framework::proto::VarType::FP32,
-                                   platform::CUDAPlace(0));
+                                   ctx.GetPlace());
   };
 };
 
@@ -97,8 +97,9 @@ class FusionGroupOpMaker : public framework::OpProtoAndCheckerMaker {
     AddComment(R"DOC(
 fusion_group Operator.
 
-It is used to execute a generated CUDA kernel which fuse the computation of
-multiple operators into one. It supports several types:
+It is used to execute a generated CUDA kernel, or a generated C++ function on
+CPU, which fuse the computation of multiple operators into one. It supports
+several types:
 0, fused computation of elementwise operations in which all the dims of inputs
     and outputs should be exactly the same.
 )DOC");
@@ -109,4 +110,8 @@ multiple operators into one. It supports several types:
 }  // namespace paddle
 
 namespace ops = paddle::operators;
+namespace plat = paddle::platform;
 REGISTER_OPERATOR(fusion_group, ops::FusionGroupOp, ops::FusionGroupOpMaker);
+REGISTER_OP_CPU_KERNEL(fusion_group,
+                       ops::FusionGroupKernel<plat::CPUDeviceContext, float>,
+                       ops::FusionGroupKernel<plat::CPUDeviceContext, double>);
@@ -0,0 +1,110 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/executor.h"
+#include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/platform/device_code.h"
+
+namespace paddle {
+namespace operators {
+
+static void SetInputs(framework::Scope* scope,
+                      const std::vector<std::string>& names,
+                      const std::vector<int64_t>& shape) {
+  std::mt19937 rng(100);
+  std::uniform_real_distribution<float> uniform_dist(-1, 1);
+  for (auto& name : names) {
+    auto* tensor = scope->Var(name)->GetMutable<framework::LoDTensor>();
+    float* data = tensor->mutable_data<float>(framework::make_ddim(shape),
+                                              platform::CPUPlace());
+    for (int64_t i = 0; i < tensor->numel(); ++i) {
+      data[i] = uniform_dist(rng);
+    }
+  }
+}
+
+static void RunProgram(const framework::ProgramDesc& program,
+                       framework::Scope* scope) {
+  platform::CPUPlace place;
+  framework::Executor executor(place);
+  executor.Run(program, scope, 0, false, true);
+}
+
+// Runs out = sigmoid(relu(x * y + z)) with and without fusion_group_pass,
+// the fused program computes it with one generated C++ function.
+TEST(FusionGroupOp, cpu_end_to_end) {
+  platform::DeviceCodePool::Init({platform::CPUPlace()});
+  if (!platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+  std::vector<int64_t> shape = {16, 32};
+  framework::ir::Layers layers;
+  auto* x = layers.data("x", shape);
+  auto* y = layers.data("y", shape);
+  auto* z = layers.data("z", shape);
+  auto* tmp_0 = layers.elementwise_mul(x, y);
+  auto* tmp_1 = layers.elementwise_add(tmp_0, z);
+  auto* tmp_2 = layers.relu(tmp_1);
+  auto* out = layers.sigmoid(tmp_2);
+  for (auto* var : {tmp_0, tmp_1, tmp_2, out}) {
+    var->SetShape(shape);
+    var->SetDataType(framework::proto::VarType::FP32);
+  }
+  const framework::ProgramDesc& program = layers.main_program();
+
+  framework::Scope scope;
+  SetInputs(&scope, {"x", "y", "z"}, shape);
+  RunProgram(program, &scope);
+
+  std::unique_ptr<framework::ir::Graph> graph(
+      new framework::ir::Graph(program));
+  auto pass = framework::ir::PassRegistry::Instance().Get("fusion_group_pass");
+  pass->Set("use_gpu", new bool(false));
+  graph.reset(pass->Apply(graph.release()));
+  ASSERT_EQ(framework::ir::GetNumOpNodes(graph, "fusion_group"), 1);
+  ASSERT_EQ(framework::ir::GetNumOpNodes(graph, "relu"), 0);
+  framework::ProgramDesc fused_program;
+  framework::ir::GraphToProgram(*graph, &fused_program);
+
+  framework::Scope fused_scope;
+  SetInputs(&fused_scope, {"x", "y", "z"}, shape);
+  RunProgram(fused_program, &fused_scope);
+
+  auto& expect = scope.FindVar(out->Name())->Get<framework::LoDTensor>();
+  auto* fused_var = fused_scope.FindVar(out->Name());
+  ASSERT_NE(fused_var, nullptr);
+  auto& actual = fused_var->Get<framework::LoDTensor>();
+  ASSERT_EQ(actual.dims(), expect.dims());
+  for (int64_t i = 0; i < expect.numel(); ++i) {
+    EXPECT_NEAR(actual.data<float>()[i], expect.data<float>()[i], 1e-5);
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
+
+USE_PASS(fusion_group_pass);
+USE_OP(fusion_group);
+USE_OP(elementwise_mul);
+USE_OP_ITSELF(elementwise_add);
+USE_OP(relu);
+USE_OP(sigmoid);
@@ -14,13 +14,12 @@ limitations under the License. */
 
 #pragma once
 
-extern "C" {
-#include <xxhash.h>
-}
+#include <numeric>
 #include <vector>
 
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/multi_seed_hash.h"
 
 namespace paddle {
 namespace operators {
@@ -57,10 +56,15 @@ class HashKernel : public framework::OpKernel<T> {
     auto seq_length = in_dims[0];
     auto last_dim = in_dims[in_dims.size() - 1];
     auto* input = in_t->data<T>();
+    // All the hashes of a row are computed together.
+    std::vector<uint64_t> seeds(num_hash);
+    std::iota(seeds.begin(), seeds.end(), 0);
+    std::vector<uint64_t> hashes(num_hash);
     for (int idx = 0; idx < seq_length; ++idx) {
+      math::XXH64MultiSeed(input, sizeof(T) * last_dim, seeds.data(),
+                           num_hash, hashes.data());
       for (int ihash = 0; ihash != num_hash; ++ihash) {
-        output[idx * num_hash + ihash] =
-            XXH64(input, sizeof(T) * last_dim, ihash) % mod_by;
+        output[idx * num_hash + ihash] = hashes[ihash] % mod_by;
       }
       input += last_dim;
     }
@@ -13,13 +13,19 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <algorithm>
+#include <vector>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/lod_segment.h"
 #include "paddle/pten/kernels/funcs/math_function.h"
 
 namespace paddle {
 namespace operators {
 
+// Returns the sum of x, and scales x to sum to 1 if the sum is positive.
+// It does not throw, because the sequences run in the omp threads, the
+// caller checks the sum and reports it with EnforceNormalized.
 template <typename T>
 static inline T NormalizeL1(T* x, size_t len) {
   T sum = 0.;
@@ -27,22 +33,20 @@ static inline T NormalizeL1(T* x, size_t len) {
   // (This comment is from the old LinearChainCRFLayer.)
   // Right now, we just bet that sum won't be zero. If this really happens, we
   // will figure out what should be done then.
-  PADDLE_ENFORCE_GT(
-      sum, 0., platform::errors::InvalidArgument(
-                   "The unnormalized probabilities of all possible unfinished "
-                   "sequences must be greater than 0."));
+  if (!(sum > 0.)) return sum;
   T s = 1. / sum;
   for (size_t i = 0; i < len; ++i) x[i] *= s;
   return sum;
 }
 
-template <typename T>
-struct ScalarMul {
-  explicit ScalarMul(const T& scalar) : scalar(scalar) {}
-  T operator()(const T& val) const { return val * scalar; }
-
-  T scalar;
-};
+static inline void EnforceNormalized(const std::vector<uint8_t>& normalized) {
+  PADDLE_ENFORCE_EQ(
+      std::all_of(normalized.begin(), normalized.end(),
+                  [](uint8_t ok) { return ok != 0; }),
+      true, platform::errors::InvalidArgument(
+                "The unnormalized probabilities of all possible unfinished "
+                "sequences must be greater than 0."));
+}
 
 using framework::LoDTensor;
 using framework::LoD;
@@ -136,47 +140,59 @@ class LinearChainCRFOpKernel : public framework::OpKernel<T> {
     auto w_exps = framework::EigenMatrix<T>::From(*transition_exps);
     w_exps.device(place) = w.exp();
     T* log_likelihood = ll->data<T>();
-    for (int64_t i = 0; i < seq_num; ++i) {
-      int64_t start_pos = 0;
-      int64_t end_pos = 0;
-      if (ctx.HasInput("Length")) {
-        start_pos = i * emission_dims[1];
-        end_pos = start_pos + length_data[i];
-      } else {
-        start_pos = static_cast<int64_t>(in_lod[0][i]);
-        end_pos = static_cast<int64_t>(in_lod[0][i + 1]);
-      }
-      if (end_pos == start_pos) {
-        // If an empty input sequence is given, pad 0 for its cost.
-        log_likelihood[i] = 0.;
-        continue;
-      }
-      const Tensor one_seq = emission_weights_tmp.Slice(start_pos, end_pos);
-      Tensor one_seq_row_max = emission_row_max.Slice(start_pos, end_pos);
-      Tensor one_seq_exps = emission_exps_tmp.Slice(start_pos, end_pos);
-      const Tensor one_seq_label = label_tmp.Slice(start_pos, end_pos);
-      Tensor one_seq_alpha = alpha_tmp.Slice(start_pos, end_pos);
-      log_likelihood[i] = ForwardOneSequence(
-          one_seq, one_seq_row_max, one_seq_exps, *transition_weights,
-          *transition_exps, one_seq_label, &one_seq_alpha);
+    auto rows = ctx.HasInput("Length")
+                    ? math::SequenceRows::FromLengths(length_data, seq_num,
+                                                      emission_dims[1])
+                    : math::SequenceRows::FromLoD(in_lod[0]);
+
+    const int64_t* lbl = label_tmp.data<int64_t>();
+    for (size_t i = 0; i < rows.size(); ++i) {
+      const int64_t* seq_lbl = lbl + rows.Begin(i);
+      if (rows.Length(i) == 0) continue;
+      PADDLE_ENFORCE_LT(
+          static_cast<size_t>(
+              *std::max_element(seq_lbl, seq_lbl + rows.Length(i))),
+          static_cast<size_t>(tag_num),
+          platform::errors::InvalidArgument(
+              "An invalid tag label that execesses the largest tag number."));
     }
+
+    const T* x_data = emission_weights_tmp.data<T>();
+    const T* x_row_max_data = emission_row_max.data<T>();
+    const T* x_exps_data = emission_exps_tmp.data<T>();
+    const T* w_data = transition_weights->data<T>();
+    const T* w_exps_data = transition_exps->data<T>();
+    T* alpha_data = alpha_tmp.data<T>();
+    std::vector<uint8_t> normalized(rows.size(), 1);
+    // The sequences are independent, a step of one costs tag_num^2.
+    int num_parts = math::LoDSegmentNumParts(rows.offsets.data(), rows.size(),
+                                             tag_num * tag_num);
+    math::ForEachLoDPart(
+        rows.offsets.data(), rows.size(), num_parts,
+        [&](int part, size_t seg_begin, size_t seg_end) {
+          for (size_t i = seg_begin; i < seg_end; ++i) {
+            int64_t begin = rows.Begin(i);
+            if (rows.Length(i) == 0) {
+              // If an empty input sequence is given, pad 0 for its cost.
+              log_likelihood[i] = 0.;
+              continue;
+            }
+            log_likelihood[i] = ForwardOneSequence(
+                x_data + begin * tag_num, x_row_max_data + begin,
+                x_exps_data + begin * tag_num, w_data, w_exps_data,
+                lbl + begin, rows.Length(i), tag_num,
+                alpha_data + begin * tag_num, &normalized[i]);
+          }
+        });
+    EnforceNormalized(normalized);
   };
 
  private:
-  T ForwardOneSequence(const Tensor& emission, const Tensor& emission_row_max,
-                       const Tensor& emission_exps, const Tensor& trans_weights,
-                       const Tensor& trans_weight_exps, const Tensor& label,
-                       Tensor* alpha) const {
-    const T* x = emission.data<T>();
-    const T* x_row_max = emission_row_max.data<T>();
-    const T* x_exps = emission_exps.data<T>();
-    const T* w = trans_weights.data<T>();
-    const T* w_exps = trans_weight_exps.data<T>();
-    T* alpha_value = alpha->data<T>();
-
-    auto x_dims = emission.dims();
-    const size_t seq_length = x_dims[0];
-    const size_t tag_num = x_dims[1];
+  static T ForwardOneSequence(const T* x, const T* x_row_max,
+                              const T* x_exps, const T* w, const T* w_exps,
+                              const int64_t* lbl, size_t seq_length,
+                              size_t tag_num, T* alpha_value,
+                              uint8_t* normalized) {
     // The 1st row of w are transition weights for start mask.
     // The 2nd row of w are transition weights for end mask.
     // Transition weights between other tags begin from the 3rd row of w.
@@ -185,20 +201,31 @@ class LinearChainCRFOpKernel : public framework::OpKernel<T> {
     for (size_t i = 0; i < tag_num; ++i) {
       alpha_value[i] = w_exps[i] * x_exps[i];
     }
-    T ll = -x_row_max[0] - std::log(NormalizeL1<T>(alpha_value, tag_num));
+    T norm = NormalizeL1<T>(alpha_value, tag_num);
+    bool ok = norm > 0.;
+    T ll = -x_row_max[0] - std::log(norm);
 
     for (size_t k = 1; k < seq_length; ++k) {
-      for (size_t i = 0; i < tag_num; ++i) {
-        T sum = 0.;
-        for (size_t j = 0; j < tag_num; ++j) {
-          sum += alpha_value[(k - 1) * tag_num + j] *  // (*)
-                 w_exps[(j + state_trans_base_idx) * tag_num + i];
+      const T* prev = alpha_value + (k - 1) * tag_num;
+      T* cur = alpha_value + k * tag_num;
+      std::fill(cur, cur + tag_num, static_cast<T>(0));
+      // Accumulate the rows of the transitions, the inner loop runs over the
+      // contiguous tags and is vectorized.
+      for (size_t j = 0; j < tag_num; ++j) {
+        const T a = prev[j];  // (*)
+        const T* w_row = w_exps + (j + state_trans_base_idx) * tag_num;
+        for (size_t i = 0; i < tag_num; ++i) {
+          cur[i] += a * w_row[i];
         }
-        alpha_value[k * tag_num + i] = x_exps[k * tag_num + i] * sum;
+      }
+      const T* x_row = x_exps + k * tag_num;
+      for (size_t i = 0; i < tag_num; ++i) {
+        cur[i] *= x_row[i];
       }
       // NormalizeL1 is to avoid underflow or overflow at (*).
-      ll -= x_row_max[k] +
-            std::log(NormalizeL1<T>(alpha_value + k * tag_num, tag_num));
+      norm = NormalizeL1<T>(cur, tag_num);
+      ok = ok && norm > 0.;
+      ll -= x_row_max[k] + std::log(norm);
     }
     T sum = 0.;
     for (size_t i = 0; i < tag_num; ++i) {
@@ -207,12 +234,6 @@ class LinearChainCRFOpKernel : public framework::OpKernel<T> {
     ll -= std::log(sum);
     // Now ll is equal to -log(Z).
 
-    const int64_t* lbl = label.data<int64_t>();
-    PADDLE_ENFORCE_LT(
-        static_cast<size_t>(*std::max_element(lbl, lbl + seq_length)), tag_num,
-        platform::errors::InvalidArgument(
-            "An invalid tag label that execesses the largest tag number."));
-
     // Calculate the nominator part, which depends on the label sequence.
     ll += w[lbl[0]] /*start transition*/ + x[lbl[0]] +
           w[tag_num + lbl[seq_length - 1]] /*end transition*/;
@@ -220,6 +241,7 @@ class LinearChainCRFOpKernel : public framework::OpKernel<T> {
       ll += x[k * tag_num + lbl[k]] +
             w[(lbl[k - 1] + state_trans_base_idx) * tag_num + lbl[k]];
     }
+    *normalized = ok;
     return -ll;
   }
 };
@@ -242,7 +264,6 @@ class LinearChainCRFGradOpKernel : public framework::OpKernel<T> {
     Tensor alpha_tmp = *alpha;
     Tensor label_tmp = *label;
     Tensor emission_exps_tmp = *emission_exps;
-    Tensor emission_grad_tmp = *emission_grad;
     // getting seq_num  using padding or not
     int64_t seq_num = 0;
     framework::LoD in_lod;
@@ -253,8 +274,6 @@ class LinearChainCRFGradOpKernel : public framework::OpKernel<T> {
       seq_num = label_length->numel();
       auto emission_dims = emission_grad->dims();
       auto label_dims = label->dims();
-      emission_grad_tmp.Resize(
-          {emission_dims[0] * emission_dims[1], emission_dims[2]});
       label_tmp.Resize({label_dims[0] * label_dims[1], 1});
       alpha_tmp.Resize({emission_dims[0] * emission_dims[1], emission_dims[2]});
       emission_exps_tmp.Resize(
@@ -288,48 +307,64 @@ class LinearChainCRFGradOpKernel : public framework::OpKernel<T> {
       beta.Resize({emission_dims[0] * emission_dims[1], emission_dims[2]});
     }
 
-    for (int64_t i = 0; i < seq_num; ++i) {
-      int64_t start_pos = 0;
-      int64_t end_pos = 0;
-      if (ctx.HasInput("Length")) {
-        start_pos = i * emission_dims[1];
-        end_pos = start_pos + length_data[i];
-      } else {
-        start_pos = static_cast<int64_t>(in_lod[0][i]);
-        end_pos = static_cast<int64_t>(in_lod[0][i + 1]);
-      }
+    auto rows = ctx.HasInput("Length")
+                    ? math::SequenceRows::FromLengths(length_data, seq_num,
+                                                      emission_dims[1])
+                    : math::SequenceRows::FromLoD(in_lod[0]);
+    const size_t tag_num = emission_dims[emission_dims.size() - 1];
+    const size_t trans_numel =
+        transition_grad ? static_cast<size_t>(transition_grad->numel()) : 0;
+
+    const T* x_exps_data = emission_exps_tmp.data<T>();
+    const T* w_exps_data = transition_exps->data<T>();
+    const T* alpha_data = alpha_tmp.data<T>();
+    const int64_t* label_data = label_tmp.data<int64_t>();
+    T* beta_data = beta.data<T>();
+    std::vector<uint8_t> normalized(rows.size(), 1);
+    int num_parts = math::LoDSegmentNumParts(rows.offsets.data(), rows.size(),
+                                             tag_num * tag_num);
+    // Each part has a row of scratch and its own transition gradients, which
+    // are summed in the order of the parts after the loop, allocated once
+    // for all the sequences of the batch.
+    const size_t workspace_numel = tag_num + trans_numel;
+    std::vector<T> workspace(num_parts * workspace_numel, static_cast<T>(0));
+    math::ForEachLoDPart(
+        rows.offsets.data(), rows.size(), num_parts,
+        [&](int part, size_t seg_begin, size_t seg_end) {
+          T* part_workspace = workspace.data() + part * workspace_numel;
+          T* part_trans_grad =
+              transition_grad ? part_workspace + tag_num : nullptr;
+          for (size_t i = seg_begin; i < seg_end; ++i) {
+            int64_t begin = rows.Begin(i);
+            if (rows.Length(i) == 0) continue;
+            BackwardOneSequence(
+                ll_grad[i], x_exps_data + begin * tag_num, w_exps_data,
+                alpha_data + begin * tag_num, label_data + begin,
+                rows.Length(i), tag_num, beta_data + begin * tag_num,
+                emission_grad_data + begin * tag_num, part_trans_grad,
+                part_workspace, &normalized[i]);
+          }
+        });
+    EnforceNormalized(normalized);
 
-      if (end_pos == start_pos) {
-        continue;
+    if (transition_grad) {
+      T* trans_grad = transition_grad->data<T>();
+      for (int part = 0; part < num_parts; ++part) {
+        const T* part_trans_grad =
+            workspace.data() + part * workspace_numel + tag_num;
+        for (size_t i = 0; i < trans_numel; ++i) {
+          trans_grad[i] += part_trans_grad[i];
+        }
       }
-      const Tensor one_seq_emission_exps =
-          emission_exps_tmp.Slice(start_pos, end_pos);
-      const Tensor one_seq_label = label_tmp.Slice(start_pos, end_pos);
-      const Tensor one_seq_alpha = alpha_tmp.Slice(start_pos, end_pos);
-      Tensor one_seq_beta = beta.Slice(start_pos, end_pos);
-      Tensor one_seq_emission_grad =
-          emission_grad_tmp.Slice(start_pos, end_pos);
-      BackwardOneSequence(
-          ctx.template device_context<platform::CPUDeviceContext>(), ll_grad[i],
-          one_seq_emission_exps, *transition_exps, one_seq_alpha, one_seq_label,
-          &one_seq_beta, transition_grad, &one_seq_emission_grad);
     }
   };
 
  private:
-  void BackwardOneSequence(const platform::CPUDeviceContext& ctx,
-                           const T ll_grad, const Tensor& emission_exps,
-                           const Tensor& transition_exps, const Tensor& alpha,
-                           const Tensor& label, Tensor* beta,
-                           Tensor* transition_grad,
-                           Tensor* emission_grad) const {
-    const T* w_exps = transition_exps.data<T>();
-    const T* x_exps = emission_exps.data<T>();
-    const int64_t* label_value = label.data<int64_t>();
-    T* beta_value = beta->data<T>();
-    auto x_dims = emission_exps.dims();
-    const size_t seq_length = x_dims[0];
-    const size_t tag_num = x_dims[1];
+  static void BackwardOneSequence(T ll_grad, const T* x_exps, const T* w_exps,
+                                  const T* alpha, const int64_t* label_value,
+                                  size_t seq_length, size_t tag_num,
+                                  T* beta_value, T* x_grad, T* trans_grad,
+                                  T* scratch, uint8_t* normalized) {
     const size_t state_trans_base_idx = 2;
 
     // Calculate the backward vectors: beta.
@@ -337,74 +372,84 @@ class LinearChainCRFGradOpKernel : public framework::OpKernel<T> {
     for (size_t i = 0; i < tag_num; ++i) {
       beta_value[(seq_length - 1) * tag_num + i] = w_exps[tag_num + i];
     }
-    NormalizeL1<T>(beta_value + (seq_length - 1) * tag_num, tag_num);
+    bool ok =
+        NormalizeL1<T>(beta_value + (seq_length - 1) * tag_num, tag_num) > 0.;
     for (int k = static_cast<int>(seq_length) - 2; k >= 0; --k) {
+      const T* next_x = x_exps + (k + 1) * tag_num;
+      const T* next_beta = beta_value + (k + 1) * tag_num;
+      for (size_t j = 0; j < tag_num; ++j) {
+        scratch[j] = next_x[j] * next_beta[j];
+      }
+      T* cur = beta_value + k * tag_num;
       for (size_t i = 0; i < tag_num; ++i) {
+        const T* w_row = w_exps + (i + state_trans_base_idx) * tag_num;
         T sum = 0.;
         for (size_t j = 0; j < tag_num; ++j) {
-          sum += w_exps[(i + state_trans_base_idx) * tag_num + j] *  // (**)
-                 x_exps[(k + 1) * tag_num + j] *
-                 beta_value[(k + 1) * tag_num + j];
+          sum += w_row[j] * scratch[j];  // (**)
         }
-        beta_value[k * tag_num + i] = sum;
+        cur[i] = sum;
       }
       // NormalizeL1 is to avoid underflow or overflow at (**).
-      NormalizeL1<T>(beta_value + k * tag_num, tag_num);
+      ok = NormalizeL1<T>(cur, tag_num) > 0. && ok;
     }
+    *normalized = ok;
 
-    auto x_grad_mat = framework::EigenMatrix<T>::From(*emission_grad);
-    auto alpha_mat = framework::EigenMatrix<T>::From(alpha);
-    auto beta_mat = framework::EigenMatrix<T>::From(*beta);
-
-    auto* place = ctx.eigen_device();
-    auto prob = alpha_mat * beta_mat;
-    auto row_sum = prob.sum(Eigen::DSizes<int, 1>(1))
-                       .reshape(Eigen::DSizes<int, 2>(seq_length, 1))
-                       .broadcast(Eigen::DSizes<int, 2>(1, tag_num));
-    x_grad_mat.device(*place) =
-        (prob / row_sum).unaryExpr(ScalarMul<T>(ll_grad));
-
+    // The marginal probabilities of the tags, scaled by the output gradient.
     for (size_t k = 0; k < seq_length; ++k) {
-      x_grad_mat(k, label_value[k]) -= static_cast<T>(ll_grad);
+      const T* a = alpha + k * tag_num;
+      const T* b = beta_value + k * tag_num;
+      T* g = x_grad + k * tag_num;
+      T row_sum = 0.;
+      for (size_t i = 0; i < tag_num; ++i) {
+        g[i] = a[i] * b[i];
+        row_sum += g[i];
+      }
+      T scale = ll_grad / row_sum;
+      for (size_t i = 0; i < tag_num; ++i) {
+        g[i] *= scale;
+      }
+      g[label_value[k]] -= ll_grad;
     }
 
-    if (transition_grad) {
-      T* trans_grad = transition_grad->data<T>();
+    if (trans_grad) {
       for (size_t k = 0; k < tag_num; ++k) {
-        // Do not multiply by the output gradient here, because x_grad_mat has
+        // Do not multiply by the output gradient here, because x_grad has
         // alrealy done this.
-        trans_grad[k] += x_grad_mat(/*from start state*/ 0, k);
+        trans_grad[k] += x_grad[/*from start state*/ k];
         trans_grad[tag_num + k] +=
-            x_grad_mat(/*to end state*/ seq_length - 1, k);
+            x_grad[/*to end state*/ (seq_length - 1) * tag_num + k];
       }
 
-      auto x_exps_mat = framework::EigenMatrix<T>::From(emission_exps);
-
-      // TODO(caoying): Fix this to avoid using this local variable if we can
-      // profile the training process.
-      Tensor tmp;
-      tmp.mutable_data<T>(beta->dims(), platform::CPUPlace());
-      auto tmp_mat = framework::EigenMatrix<T>::From(tmp);
-      auto prob = beta_mat * x_exps_mat;
-      auto row_sum = prob.sum(Eigen::DSizes<int, 1>(1))
-                         .reshape(Eigen::DSizes<int, 2>(seq_length, 1))
-                         .broadcast(Eigen::DSizes<int, 2>(1, tag_num));
-      tmp_mat.device(*place) = prob / row_sum;
-
       for (size_t k = 1; k < seq_length; ++k) {
+        // scratch is the normalized beta * x_exps of the position k.
+        const T* b = beta_value + k * tag_num;
+        const T* xe = x_exps + k * tag_num;
+        T row_sum = 0.;
+        for (size_t j = 0; j < tag_num; ++j) {
+          scratch[j] = b[j] * xe[j];
+          row_sum += scratch[j];
+        }
+        T inv_row_sum = 1. / row_sum;
+        for (size_t j = 0; j < tag_num; ++j) {
+          scratch[j] *= inv_row_sum;
+        }
+        const T* a = alpha + (k - 1) * tag_num;
         T sum = 0.;
         for (size_t i = 0; i < tag_num; ++i) {
+          const T* w_row = w_exps + (i + state_trans_base_idx) * tag_num;
+          T dot = 0.;
           for (size_t j = 0; j < tag_num; ++j) {
-            sum += w_exps[(i + state_trans_base_idx) * tag_num + j] *  // (**)
-                   alpha_mat(k - 1, i) * tmp_mat(k, j);
+            dot += w_row[j] * scratch[j];  // (**)
           }
+          sum += a[i] * dot;
         }
-        sum = 1. / sum;
+        T scale = ll_grad / sum;
         for (size_t i = 0; i < tag_num; ++i) {
+          const T* w_row = w_exps + (i + state_trans_base_idx) * tag_num;
+          T* g_row = trans_grad + (i + state_trans_base_idx) * tag_num;
+          T coef = scale * a[i];
           for (size_t j = 0; j < tag_num; ++j) {
-            trans_grad[(i + state_trans_base_idx) * tag_num + j] +=
-                sum * w_exps[(i + state_trans_base_idx) * tag_num + j] *
-                alpha_mat(k - 1, i) * tmp_mat(k, j) * ll_grad;
+            g_row[j] += coef * w_row[j] * scratch[j];
           }
         }
         trans_grad[(label_value[k - 1] + state_trans_base_idx) * tag_num +
@@ -23,6 +23,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/data_type_transform.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/string_array.h"
+#include "paddle/fluid/framework/tensor_checkpoint.h"
 #include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/platform/device_context.h"
 
@@ -44,6 +45,12 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                           "it to be greater than 0.",
                           out_var_names.size()));
     if (!model_from_memory) {
+      framework::WaitTensorCheckpoint(filename);
+      if (framework::IsTensorCheckpoint(filename)) {
+        LoadParamsFromCheckpoint(ctx, place, filename, load_as_fp16,
+                                 out_var_names);
+        return;
+      }
       std::ifstream fin(filename, std::ios::binary);
       PADDLE_ENFORCE_EQ(
           static_cast<bool>(fin), true,
@@ -108,27 +115,7 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
 
         // Get data from fin to tensor
         paddle::framework::DeserializeFromStream(*buffer, tensor, dev_ctx);
-
-        auto in_dtype = framework::TransToProtoVarType(tensor->dtype());
-        auto out_dtype =
-            load_as_fp16 ? framework::proto::VarType::FP16 : in_dtype;
-
-        if (in_dtype != out_dtype) {
-          // convert to float16 tensor
-          auto in_kernel_type = framework::OpKernelType(in_dtype, place);
-          auto out_kernel_type = framework::OpKernelType(out_dtype, place);
-          framework::LoDTensor fp16_tensor;
-          // copy LoD info to the new tensor
-          fp16_tensor.set_lod(tensor->lod());
-          framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
-                                   &fp16_tensor);
-
-          // reset output tensor
-          out_vars[i]->Clear();
-          tensor = out_vars[i]->GetMutable<framework::LoDTensor>();
-          tensor->set_lod(fp16_tensor.lod());
-          tensor->ShareDataWith(fp16_tensor);
-        }
+        if (load_as_fp16) ConvertToFP16(place, out_vars[i]);
       }
     }
     buffer->peek();
@@ -137,6 +124,71 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                           "Not allowed to load partial data via "
                           "load_combine_op, please use load_op instead."));
   }
+
+  // Loads a chunked checkpoint. When it holds more tensors than the outputs
+  // and every output name is found in it, only those tensors are read by
+  // random access. Otherwise the outputs are loaded in the saved order.
+  void LoadParamsFromCheckpoint(
+      const framework::ExecutionContext &context, const platform::Place &place,
+      const std::string &filename, bool load_as_fp16,
+      const std::vector<std::string> &out_var_names) const {
+    platform::DeviceContextPool &pool = platform::DeviceContextPool::Instance();
+    auto &dev_ctx = *pool.Get(place);
+    auto out_vars = context.MultiOutputVar("Out");
+    framework::TensorCheckpointReader reader(filename);
+    auto &entries = reader.entries();
+
+    bool by_name = out_var_names.size() < entries.size();
+    for (auto &name : out_var_names) {
+      by_name = by_name && reader.Has(name);
+    }
+    if (!by_name) {
+      PADDLE_ENFORCE_EQ(
+          out_var_names.size(), entries.size(),
+          platform::errors::Unavailable(
+              "The checkpoint %s holds %d tensors, but %d variables are "
+              "loaded, and not all of them are found in the checkpoint.",
+              filename, entries.size(), out_var_names.size()));
+    }
+
+    std::vector<size_t> indices;
+    std::vector<framework::LoDTensor *> tensors;
+    for (size_t i = 0; i < out_var_names.size(); i++) {
+      PADDLE_ENFORCE_NOT_NULL(
+          out_vars[i], platform::errors::InvalidArgument(
+                           "The variable %s to be loaded cannot be found.",
+                           out_var_names[i]));
+      indices.push_back(by_name ? reader.EntryIndex(out_var_names[i]) : i);
+      tensors.push_back(out_vars[i]->GetMutable<framework::LoDTensor>());
+    }
+    reader.LoadEntries(indices, tensors, dev_ctx);
+    if (load_as_fp16) {
+      for (auto *var : out_vars) ConvertToFP16(place, var);
+    }
+  }
+
+  void ConvertToFP16(const platform::Place &place,
+                     framework::Variable *var) const {
+    auto *tensor = var->GetMutable<framework::LoDTensor>();
+    auto in_dtype = framework::TransToProtoVarType(tensor->dtype());
+    auto out_dtype = framework::proto::VarType::FP16;
+    if (in_dtype == out_dtype) return;
+
+    // convert to float16 tensor
+    auto in_kernel_type = framework::OpKernelType(in_dtype, place);
+    auto out_kernel_type = framework::OpKernelType(out_dtype, place);
+    framework::LoDTensor fp16_tensor;
+    // copy LoD info to the new tensor
+    fp16_tensor.set_lod(tensor->lod());
+    framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
+                             &fp16_tensor);
+
+    // reset output tensor
+    var->Clear();
+    tensor = var->GetMutable<framework::LoDTensor>();
+    tensor->set_lod(fp16_tensor.lod());
+    tensor->ShareDataWith(fp16_tensor);
+  }
 };
 
 }  // namespace operators
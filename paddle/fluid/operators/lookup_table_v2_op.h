@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 
 #include <algorithm>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -24,6 +25,8 @@ limitations under the License. */
 #include "paddle/fluid/framework/selected_rows_utils.h"
 #include "paddle/fluid/operators/math/blas.h"
 
+DECLARE_bool(embedding_merge_sparse_grad);
+
 namespace paddle {
 namespace operators {
 
@@ -49,6 +52,48 @@ static std::vector<OutT> CopyIdsToVector(const Tensor &ids) {
   return ret;
 }
 
+// The rows are copied by the omp threads when there are more elements than it
+constexpr int64_t kEmbeddingParallelNumel = 1 << 16;
+// The row of the id this far ahead is prefetched while copying a row
+constexpr int64_t kEmbeddingPrefetchDistance = 8;
+
+template <typename T>
+inline void PrefetchEmbeddingRow(const T *row, int64_t row_width) {
+#if defined(__GNUC__) || defined(__clang__)
+  const char *ptr = reinterpret_cast<const char *>(row);
+  for (int64_t offset = 0; offset < row_width * static_cast<int64_t>(sizeof(T));
+       offset += 64) {
+    __builtin_prefetch(ptr + offset);
+  }
+#endif
+}
+
+// Copy table[rows[i]] to output[i], or fill output[i] with zeros if rows[i]
+// is negative. The ids are split across the omp threads, and each thread
+// prefetches the rows of its upcoming ids.
+template <typename T>
+void CopyEmbeddingRows(const T *table, const std::vector<int64_t> &rows,
+                       int64_t row_width, T *output) {
+  auto ids_numel = static_cast<int64_t>(rows.size());
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (ids_numel * row_width > kEmbeddingParallelNumel)
+#endif
+  for (int64_t i = 0; i < ids_numel; ++i) {
+    if (i + kEmbeddingPrefetchDistance < ids_numel &&
+        rows[i + kEmbeddingPrefetchDistance] >= 0) {
+      PrefetchEmbeddingRow(
+          table + rows[i + kEmbeddingPrefetchDistance] * row_width,
+          row_width);
+    }
+    if (rows[i] < 0) {
+      memset(output + i * row_width, 0, row_width * sizeof(T));
+    } else {
+      memcpy(output + i * row_width, table + rows[i] * row_width,
+             row_width * sizeof(T));
+    }
+  }
+}
+
 template <typename T>
 struct LookupTableV2CPUFunctor {
   LookupTableV2CPUFunctor(const framework::ExecutionContext &context,
@@ -75,7 +120,7 @@ struct LookupTableV2CPUFunctor {
 
       for (int64_t i = 0; i < ids_numel; ++i) {
         if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-          memset(output + i * row_width, 0, row_width * sizeof(T));
+          ids[i] = -1;
         } else {
           PADDLE_ENFORCE_LT(
               ids[i], row_number,
@@ -91,21 +136,18 @@ struct LookupTableV2CPUFunctor {
                   "expected >= 0 and < %ld, but got %ld. Please check input "
                   "value.",
                   row_number, ids[i]));
-          memcpy(output + i * row_width, table + ids[i] * row_width,
-                 row_width * sizeof(T));
         }
       }
+      CopyEmbeddingRows(table, ids, row_width, output);
     } else if (table_var->template IsType<pten::SelectedRows>()) {
       const auto &table_t = table_var->template Get<pten::SelectedRows>();
       int64_t row_width = table_t.value().dims()[1];
       const auto *table = table_t.value().template data<T>();
       auto *output = output_t->template mutable_data<T>(context_.GetPlace());
-      auto input_data_type =
-          framework::TransToProtoVarType(table_t.value().dtype());
 
       for (int64_t i = 0; i < ids_numel; ++i) {
         if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-          memset(output + i * row_width, 0, row_width * sizeof(T));
+          ids[i] = -1;
         } else {
           PADDLE_ENFORCE_GE(
               ids[i], 0,
@@ -119,17 +161,10 @@ struct LookupTableV2CPUFunctor {
               platform::errors::InvalidArgument(
                   "the input key should be exists. But received %d.",
                   id_index));
-
-          if (input_data_type == framework::proto::VarType::BF16) {
-            memcpy(output + i * row_width, table + id_index * row_width,
-                   row_width * sizeof(T));
-          } else {
-            auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context_);
-            blas.VCOPY(row_width, table + id_index * row_width,
-                       output + i * row_width);
-          }
+          ids[i] = id_index;
         }
       }
+      CopyEmbeddingRows(table, ids, row_width, output);
     }
   }
 
@@ -178,7 +213,9 @@ struct LookupTableV2GradCPUFunctor {
 
     // Since paddings are not trainable and fixed in forward, the gradient of
     // paddings makes no sense and we don't deal with it in backward.
-    if (is_sparse) {
+    if (is_sparse && FLAGS_embedding_merge_sparse_grad) {
+      MergeSparseGrad(ids, table_dim, padding_idx);
+    } else if (is_sparse) {
       auto *d_output = context_.Input<LoDTensor>(framework::GradVarName("Out"));
       auto *d_table =
           context_.Output<pten::SelectedRows>(framework::GradVarName("W"));
@@ -249,6 +286,69 @@ struct LookupTableV2GradCPUFunctor {
   }
 
  private:
+  // Emit the gradient of each id once, the rows are sorted by id and the
+  // gradients of the duplicated ids are summed, so the optimizer updates
+  // every row once.
+  void MergeSparseGrad(const std::vector<int64_t> &ids, const DDim &table_dim,
+                       int64_t padding_idx) {
+    auto *d_output = context_.Input<LoDTensor>(framework::GradVarName("Out"));
+    auto *d_table =
+        context_.Output<pten::SelectedRows>(framework::GradVarName("W"));
+    int64_t row_width = table_dim[1];
+    PADDLE_ENFORCE_EQ(
+        d_output->numel(), static_cast<int64_t>(ids.size()) * row_width,
+        platform::errors::InvalidArgument(
+            "ShapeError: The numel of output@Grad should be %ld, which is the "
+            "number of ids times the width of the table. But received %ld.",
+            static_cast<int64_t>(ids.size()) * row_width, d_output->numel()));
+
+    // the positions of the ids, sorted by id and then by position, so that
+    // the gradients are summed in the same order as the dense gradient
+    std::vector<int64_t> order;
+    order.reserve(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+      if (padding_idx == kNoPadding || ids[i] != padding_idx) {
+        order.push_back(i);
+      }
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&ids](int64_t x, int64_t y) { return ids[x] < ids[y]; });
+    std::vector<int64_t> rows;
+    std::vector<int64_t> offsets;
+    for (size_t i = 0; i < order.size(); ++i) {
+      if (i == 0 || ids[order[i]] != ids[order[i - 1]]) {
+        rows.push_back(ids[order[i]]);
+        offsets.push_back(i);
+      }
+    }
+    offsets.push_back(order.size());
+    auto rows_num = static_cast<int64_t>(rows.size());
+
+    d_table->set_rows(rows);
+    d_table->set_height(table_dim[0]);
+    auto *d_table_value = d_table->mutable_value();
+    d_table_value->Resize({rows_num, row_width});
+    auto *d_table_data =
+        d_table_value->template mutable_data<T>(context_.GetPlace());
+    auto *d_output_data = d_output->template data<T>();
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (static_cast<int64_t>(order.size()) * row_width > \
+                             kEmbeddingParallelNumel)
+#endif
+    for (int64_t i = 0; i < rows_num; ++i) {
+      T *dst = d_table_data + i * row_width;
+      memcpy(dst, d_output_data + order[offsets[i]] * row_width,
+             row_width * sizeof(T));
+      for (int64_t k = offsets[i] + 1; k < offsets[i + 1]; ++k) {
+        const T *src = d_output_data + order[k] * row_width;
+        for (int64_t j = 0; j < row_width; ++j) {
+          dst[j] += src[j];
+        }
+      }
+    }
+  }
+
   const framework::ExecutionContext &context_;
   const Tensor *ids_t_;
 };
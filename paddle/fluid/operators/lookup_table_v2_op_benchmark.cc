@@ -0,0 +1,133 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/scope.h"
+
+DECLARE_bool(embedding_merge_sparse_grad);
+
+DEFINE_int64(vocab_size, 100000, "The rows of the embedding table.");
+DEFINE_int64(width, 128, "The width of the embedding table.");
+DEFINE_int64(batch_size, 64, "The rows of the ids.");
+DEFINE_int64(seq_len, 256, "The columns of the ids.");
+DEFINE_double(zipf_a, 1.2, "The exponent of the Zipf distribution of ids.");
+DEFINE_int32(steps, 5, "The steps timed after a warmup step.");
+
+USE_OP(lookup_table_v2);
+
+namespace paddle {
+namespace operators {
+
+namespace f = paddle::framework;
+
+// Zipf distributed ids in [0, vocab_size), the id k has the probability
+// proportional to (k + 1) ^ -zipf_a
+static std::vector<int64_t> ZipfIds(int64_t num) {
+  std::vector<double> cdf(FLAGS_vocab_size);
+  double sum = 0;
+  for (int64_t k = 0; k < FLAGS_vocab_size; ++k) {
+    sum += std::pow(static_cast<double>(k + 1), -FLAGS_zipf_a);
+    cdf[k] = sum;
+  }
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<double> dist(0, sum);
+  std::vector<int64_t> ids(num);
+  for (auto& id : ids) {
+    id = std::min<int64_t>(
+        std::lower_bound(cdf.begin(), cdf.end(), dist(engine)) - cdf.begin(),
+        FLAGS_vocab_size - 1);
+  }
+  return ids;
+}
+
+static void FillRandom(f::LoDTensor* tensor, const f::DDim& dims,
+                       std::mt19937* engine) {
+  std::uniform_real_distribution<float> dist(-1, 1);
+  tensor->Resize(dims);
+  float* data = tensor->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(*engine);
+  }
+}
+
+static void BenchLookupTable() {
+  f::Scope scope;
+  platform::CPUPlace place;
+  std::mt19937 engine(0);
+  FillRandom(scope.Var("W")->GetMutable<f::LoDTensor>(),
+             {FLAGS_vocab_size, FLAGS_width}, &engine);
+  FillRandom(scope.Var("Out@GRAD")->GetMutable<f::LoDTensor>(),
+             {FLAGS_batch_size, FLAGS_seq_len, FLAGS_width}, &engine);
+  auto ids = ZipfIds(FLAGS_batch_size * FLAGS_seq_len);
+  auto* ids_tensor = scope.Var("Ids")->GetMutable<f::LoDTensor>();
+  ids_tensor->Resize({FLAGS_batch_size, FLAGS_seq_len});
+  std::copy(ids.begin(), ids.end(), ids_tensor->mutable_data<int64_t>(place));
+  scope.Var("Out")->GetMutable<f::LoDTensor>();
+  scope.Var("W@GRAD")->GetMutable<pten::SelectedRows>();
+
+  f::AttributeMap attrs = {{"padding_idx", static_cast<int64_t>(-1)},
+                           {"is_sparse", true}};
+  auto forward = f::OpRegistry::CreateOp(
+      "lookup_table_v2", {{"W", {"W"}}, {"Ids", {"Ids"}}}, {{"Out", {"Out"}}},
+      attrs);
+  auto backward = f::OpRegistry::CreateOp(
+      "lookup_table_v2_grad",
+      {{"W", {"W"}}, {"Ids", {"Ids"}}, {"Out@GRAD", {"Out@GRAD"}}},
+      {{"W@GRAD", {"W@GRAD"}}}, attrs);
+
+  for (bool merge : {false, true}) {
+    FLAGS_embedding_merge_sparse_grad = merge;
+    std::chrono::duration<double, std::milli> forward_cost(0);
+    std::chrono::duration<double, std::milli> backward_cost(0);
+    // the first step is the warmup
+    for (int step = 0; step <= FLAGS_steps; ++step) {
+      auto start = std::chrono::steady_clock::now();
+      forward->Run(scope, place);
+      auto mid = std::chrono::steady_clock::now();
+      backward->Run(scope, place);
+      auto end = std::chrono::steady_clock::now();
+      if (step > 0) {
+        forward_cost += mid - start;
+        backward_cost += end - mid;
+      }
+    }
+    auto& grad = scope.FindVar("W@GRAD")->Get<pten::SelectedRows>();
+    LOG(INFO) << "merge_sparse_grad=" << merge << ": " << grad.rows().size()
+              << " grad rows, forward "
+              << forward_cost.count() / FLAGS_steps << " ms, backward "
+              << backward_cost.count() / FLAGS_steps << " ms per step";
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
+
+// Looks up Zipf distributed ids in an embedding table, and compares the
+// sparse gradient with and without merging the duplicated ids,
+// run command: ./lookup_table_v2_op_benchmark [options...]
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::operators::BenchLookupTable();
+  return 0;
+}
@@ -14,6 +14,12 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/math/beam_search.h"
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "paddle/fluid/operators/math/top_k_heap.h"
+
 namespace pten {
 class DenseTensor;
 }  // namespace pten
@@ -43,25 +49,28 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
                   int end_id, bool is_accumulated) {
     auto abs_lod = framework::ToAbsOffset(scores->lod());
     auto &high_level = abs_lod[level];
-
-    auto items = SelectTopBeamSizeItems(pre_ids, pre_scores, ids, scores, level,
-                                        beam_size, end_id, is_accumulated);
-    auto selected_items = ToMap(items, high_level.back());
+    size_t num_seqs = high_level.size() - 1;
+
+    // The selected items of the i-th source are in
+    // items[i * beam_size, i * beam_size + item_nums[i]).
+    std::vector<Item> items(num_seqs * beam_size);
+    std::vector<size_t> item_nums(num_seqs, 0);
+    SelectTopBeamSizeItems(pre_ids, pre_scores, ids, scores, level, beam_size,
+                           end_id, is_accumulated, items.data(), &item_nums);
     if (FLAGS_v == 3) {
       VLOG(3) << "selected_items:";
-      for (size_t i = 0; i < selected_items.size(); ++i) {
-        VLOG(3) << "offset: " << i;
-        for (auto &item : selected_items[i]) {
-          VLOG(3) << item.ToString();
+      for (size_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
+        for (size_t i = 0; i < item_nums[seq_id]; ++i) {
+          VLOG(3) << items[seq_id * beam_size + i].ToString();
         }
       }
     }
 
-    PruneEndBeams(pre_ids, abs_lod, &selected_items, level, end_id);
+    PruneEndBeams(pre_ids, abs_lod, items.data(), &item_nums, level,
+                  beam_size, end_id);
     // calculate the output tensor's height
-    size_t num_instances = std::accumulate(
-        std::begin(selected_items), std::end(selected_items), 0,
-        [](size_t a, std::vector<Item> &b) { return a + b.size(); });
+    size_t num_instances =
+        std::accumulate(item_nums.begin(), item_nums.end(), size_t(0));
     // the output tensor shape should be [num_instances, 1]
     auto dims = framework::make_ddim(
         std::vector<int64_t>({static_cast<int>(num_instances), 1}));
@@ -75,18 +84,24 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
                   {static_cast<int64_t>(num_instances)}, platform::CPUPlace())
             : nullptr;
 
-    // fill in data
+    // fill in data, the items of a source are grouped by their offsets
     std::vector<size_t> low_level;
+    low_level.reserve(high_level.back() + 1);
     size_t low_offset = 0;
-    for (auto &items : selected_items) {
-      low_level.push_back(low_offset);
-      for (auto &item : items) {
-        if (parent_idx) {
-          parent_idx_data[low_offset] = static_cast<int>(low_level.size() - 1);
+    for (size_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
+      const Item *seq_items = items.data() + seq_id * beam_size;
+      size_t i = 0;
+      for (size_t offset = high_level[seq_id]; offset < high_level[seq_id + 1];
+           ++offset) {
+        low_level.push_back(low_offset);
+        for (; i < item_nums[seq_id] && seq_items[i].offset == offset; ++i) {
+          if (parent_idx) {
+            parent_idx_data[low_offset] = static_cast<int>(offset);
+          }
+          selected_ids_data[low_offset] = seq_items[i].id;
+          selected_scores_data[low_offset] = seq_items[i].score;
+          low_offset++;
         }
-        selected_ids_data[low_offset] = item.id;
-        selected_scores_data[low_offset] = item.score;
-        low_offset++;
       }
     }
     low_level.push_back(low_offset);
@@ -144,92 +159,65 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
   };
 
  protected:
+  /*
+   * The order of the selection: the higher score, then the larger offset as
+   * Item::operator<, then the smaller id. So when a candidate ties with the
+   * worst kept one of a full beam, the one with the smaller id is kept, i.e.
+   * the earlier one if the ids are the column indices. The insertion sort
+   * used before let every later tie replace the last slot of the beam.
+   */
+  struct ItemBetter {
+    bool operator()(const Item &a, const Item &b) const {
+      if (b < a) return true;
+      if (a < b) return false;
+      return a.id < b.id;
+    }
+  };
+
   /*
    * Prune the source sentences all branchs finished, and it is optional.
    * Pruning must one step later than finishing (thus pre_ids is needed here),
    * since the end tokens must be writed out.
    */
   void PruneEndBeams(const framework::LoDTensor *pre_ids,
-                     const framework::LoD &abs_lod,
-                     std::vector<std::vector<Item>> *items, size_t lod_level,
-                     int end_id) {
+                     const framework::LoD &abs_lod, const Item *items,
+                     std::vector<size_t> *item_nums, size_t lod_level,
+                     size_t beam_size, int end_id) {
     auto *pre_ids_data = pre_ids->data<int64_t>();
-    auto &high_level = abs_lod[lod_level];
-    for (size_t src_idx = 0; src_idx < high_level.size() - 1; ++src_idx) {
-      size_t src_prefix_start = high_level[src_idx];
-      size_t src_prefix_end = high_level[src_idx + 1];
+    for (size_t seq_id = 0; seq_id < item_nums->size(); ++seq_id) {
+      const Item *seq_items = items + seq_id * beam_size;
       bool finish_flag = true;
-      for (size_t offset = src_prefix_start; offset < src_prefix_end;
-           offset++) {
-        for (auto &item : items->at(offset)) {
-          if (item.id != static_cast<size_t>(end_id) ||
-              pre_ids_data[offset] != end_id) {
-            finish_flag = false;
-            break;
-          }
+      for (size_t i = 0; i < item_nums->at(seq_id); ++i) {
+        if (seq_items[i].id != static_cast<size_t>(end_id) ||
+            pre_ids_data[seq_items[i].offset] != end_id) {
+          finish_flag = false;
+          break;
         }
-        if (!finish_flag) break;
       }
       if (finish_flag) {  // all branchs of the beam (source sentence) end and
                           // prune this beam
-        for (size_t offset = src_prefix_start; offset < src_prefix_end;
-             offset++)
-          items->at(offset).clear();
-      }
-    }
-  }
-
-  /*
-   * Transform the items into a map whose key is offset, value is the items.
-   * NOTE low performance.
-   */
-  std::vector<std::vector<Item>> ToMap(
-      const std::vector<std::vector<Item>> &items, size_t element_num) {
-    std::vector<std::vector<Item>> result;
-    result.resize(element_num);
-    for (auto &entries : items) {
-      for (const auto &item : entries) {
-        result[item.offset].push_back(item);
-      }
-    }
-    return result;
-  }
-
-  void Insert(std::vector<Item> *top_beam_ptr, const Item &item,
-              size_t beam_size) {
-    std::vector<Item> &top_beam = *top_beam_ptr;
-
-    size_t num_beams = top_beam.size();
-    if (num_beams < beam_size) {
-      top_beam.resize(num_beams + 1);
-      num_beams++;
-    } else {
-      if (item < top_beam[beam_size - 1]) {
-        return;
-      }
-    }
-
-    for (int k = static_cast<int>(num_beams) - 2; k >= 0; --k) {
-      if (top_beam[k] < item) {
-        top_beam[k + 1] = top_beam[k];
-      } else {
-        top_beam[k + 1] = item;
-        return;
+        item_nums->at(seq_id) = 0;
       }
     }
-    top_beam[0] = item;
   }
 
   /*
-   * For each source, select top beam_size records.
+   * For each source, select top beam_size records into `items`, grouped by
+   * their offsets, and each group is sorted by ItemBetter.
+   *
+   * All the prefixes of a source share one heap of beam_size items. Once
+   * the heap is full, the candidates of a prefix are checked in blocks
+   * against the worst kept score first, so that std::log is only computed
+   * for the candidates that may be selected.
    */
-  std::vector<std::vector<Item>> SelectTopBeamSizeItems(
-      const framework::LoDTensor *pre_ids,
-      const framework::LoDTensor *pre_scores, const framework::LoDTensor *ids,
-      const framework::LoDTensor *scores, size_t lod_level, size_t beam_size,
-      int end_id, bool is_accumulated) {
-    std::vector<std::vector<Item>> result;
-
+  void SelectTopBeamSizeItems(const framework::LoDTensor *pre_ids,
+                              const framework::LoDTensor *pre_scores,
+                              const framework::LoDTensor *ids,
+                              const framework::LoDTensor *scores,
+                              size_t lod_level, size_t beam_size, int end_id,
+                              bool is_accumulated, Item *items,
+                              std::vector<size_t> *item_nums) {
+    constexpr size_t kBlockSize = 16;
     // find the current candidates
     auto abs_lod = framework::ToAbsOffset(scores->lod());
 
@@ -239,19 +227,21 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
     auto *ids_data = ids ? ids->data<int64_t>() : nullptr;
     auto *scores_data = scores->data<float>();
 
-    size_t num_seqs = scores->NumElements(lod_level);
+    int64_t num_seqs = scores->NumElements(lod_level);
     size_t seq_width = 1;
     for (int i = 1; i < scores->dims().size(); i++) {
       seq_width *= scores->dims()[i];
     }
 
-    for (size_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (num_seqs > 1 && scores->numel() > (1 << 16))
+#endif
+    for (int64_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
       size_t seq_offset_start = abs_lod[lod_level][seq_id];
       size_t seq_offset_end = abs_lod[lod_level][seq_id + 1];
 
-      std::vector<Item> top_beam;
-      top_beam.reserve(beam_size);
-
+      FixedSizeHeap<Item, ItemBetter> top_beam(items + seq_id * beam_size,
+                                               beam_size);
       for (size_t offset = seq_offset_start; offset < seq_offset_end;
            ++offset) {
         auto pre_id = pre_ids_data[offset];
@@ -259,35 +249,56 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
         if (pre_id == end_id) {
           // Allocate all probability mass to end_id for finished branchs and
           // the other candidate ids can be ignored.
-          Item item(offset, end_id, pre_score);
-          Insert(&top_beam, item, beam_size);
-        } else {
-          size_t index = offset * seq_width;
-          for (size_t d = 0; d < seq_width; d++, index++) {
-            int64_t id = ids_data ? ids_data[index] : static_cast<int64_t>(d);
-            float score = is_accumulated
-                              ? scores_data[index]
-                              : pre_score + std::log(scores_data[index]);
-            Item item(offset, id, score);
-            Insert(&top_beam, item, beam_size);
+          top_beam.Push(Item(offset, end_id, pre_score));
+          continue;
+        }
+        size_t index = offset * seq_width;
+        auto push = [&](size_t d) {
+          int64_t id = ids_data ? ids_data[index + d] : static_cast<int64_t>(d);
+          float score = is_accumulated
+                            ? scores_data[index + d]
+                            : pre_score + std::log(scores_data[index + d]);
+          top_beam.Push(Item(offset, id, score));
+        };
+
+        size_t d = 0;
+        for (; d < seq_width && !top_beam.full(); ++d) {
+          push(d);
+        }
+        for (; d + kBlockSize <= seq_width; d += kBlockSize) {
+          // A candidate can't be selected if its score is less than the
+          // worst kept one. The threshold of the probability is lowered a
+          // little to leave room for the rounding of std::log.
+          float threshold = top_beam.worst().score;
+          if (!is_accumulated) {
+            threshold = static_cast<float>(
+                std::exp(static_cast<double>(threshold) - pre_score) *
+                (1.0 - 1e-5));
+          }
+          const float *block = scores_data + index + d;
+          int hit = 0;
+          for (size_t b = 0; b < kBlockSize; ++b) {
+            hit |= !(block[b] < threshold);
+          }
+          if (hit) {
+            for (size_t b = 0; b < kBlockSize; ++b) {
+              push(d + b);
+            }
           }
         }
-      }
-
-      result.emplace_back(top_beam);
-    }
-
-    if (FLAGS_v == 3) {
-      VLOG(3) << "SelectTopBeamSizeItems result size " << result.size();
-      for (auto &items : result) {
-        VLOG(3) << "item set:";
-        for (auto &item : items) {
-          VLOG(3) << item.ToString();
+        for (; d < seq_width; ++d) {
+          push(d);
         }
       }
-    }
 
-    return result;
+      Item *seq_items = items + seq_id * beam_size;
+      size_t num = top_beam.Sort();
+      std::stable_sort(seq_items, seq_items + num,
+                       [](const Item &a, const Item &b) {
+                         return a.offset < b.offset;
+                       });
+      (*item_nums)[seq_id] = num;
+    }
   }
 };
 
@@ -0,0 +1,133 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/operators/math/beam_search.h"
+#include "paddle/fluid/operators/math/top_k_heap.h"
+
+DEFINE_int64(vocab_size, 50000, "The width of the rows.");
+DEFINE_int64(rows, 32, "The rows of top k, and the sources of beam search.");
+DEFINE_int64(beam_size, 4, "The beam size, i.e. the prefixes of a source.");
+DEFINE_int32(repeat, 10, "The times of running each case.");
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+static std::vector<float> RandomProbs(int64_t num) {
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<float> dist(0.001f, 1.0f);
+  std::vector<float> probs(num);
+  for (auto& prob : probs) prob = dist(engine);
+  return probs;
+}
+
+template <typename Func>
+static double AverageMs(Func&& func) {
+  func();  // warmup
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    func();
+  }
+  std::chrono::duration<double, std::milli> cost =
+      std::chrono::steady_clock::now() - start;
+  return cost.count() / FLAGS_repeat;
+}
+
+// TopKRow against partial_sort of the pairs, as top_k_v2 did before
+static void BenchTopKRow() {
+  auto data = RandomProbs(FLAGS_rows * FLAGS_vocab_size);
+  using Item = std::pair<float, int64_t>;
+  std::vector<Item> buffer(FLAGS_vocab_size);
+  for (int64_t k : {1, 10, 50, 100}) {
+    double heap_ms = AverageMs([&] {
+      for (int64_t r = 0; r < FLAGS_rows; ++r) {
+        TopKRow<float, int64_t, true>(data.data() + r * FLAGS_vocab_size,
+                                      FLAGS_vocab_size, k, buffer.data());
+      }
+    });
+    double sort_ms = AverageMs([&] {
+      for (int64_t r = 0; r < FLAGS_rows; ++r) {
+        const float* row = data.data() + r * FLAGS_vocab_size;
+        for (int64_t j = 0; j < FLAGS_vocab_size; ++j) {
+          buffer[j] = Item(row[j], j);
+        }
+        std::partial_sort(buffer.begin(), buffer.begin() + k, buffer.end(),
+                          TopKBetter<float, int64_t, true>());
+      }
+    });
+    LOG(INFO) << "top k of [" << FLAGS_rows << ", " << FLAGS_vocab_size
+              << "], k=" << k << ": heap " << heap_ms << " ms, partial_sort "
+              << sort_ms << " ms";
+  }
+}
+
+static void BenchBeamSearch() {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext context(place);
+  int64_t prefix_num = FLAGS_rows * FLAGS_beam_size;
+  framework::LoD lod(2);
+  for (int64_t i = 0; i <= FLAGS_rows; ++i) {
+    lod[0].push_back(i * FLAGS_beam_size);
+  }
+  for (int64_t i = 0; i <= prefix_num; ++i) {
+    lod[1].push_back(i);
+  }
+
+  framework::LoDTensor scores, pre_ids, pre_scores;
+  scores.set_lod(lod);
+  scores.Resize({prefix_num, FLAGS_vocab_size});
+  auto probs = RandomProbs(prefix_num * FLAGS_vocab_size);
+  std::copy(probs.begin(), probs.end(), scores.mutable_data<float>(place));
+  pre_ids.Resize({prefix_num, 1});
+  pre_scores.Resize({prefix_num, 1});
+  for (int64_t i = 0; i < prefix_num; ++i) {
+    pre_ids.mutable_data<int64_t>(place)[i] = 1;
+    pre_scores.mutable_data<float>(place)[i] = -0.1f * (i % FLAGS_beam_size);
+  }
+
+  BeamSearchFunctor<platform::CPUDeviceContext, float> beam_search;
+  framework::LoDTensor selected_ids, selected_scores;
+  framework::Tensor parent_idx;
+  double cost = AverageMs([&] {
+    beam_search(context, &pre_ids, &pre_scores, nullptr, &scores,
+                &selected_ids, &selected_scores, &parent_idx, 0,
+                FLAGS_beam_size, 0, false);
+  });
+  LOG(INFO) << "beam search of " << FLAGS_rows << " sources, beam size "
+            << FLAGS_beam_size << ", vocab size " << FLAGS_vocab_size
+            << ": " << cost << " ms";
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
+
+// Times the top k of long rows by the fixed size heap, and the CPU beam
+// search over a large vocabulary,
+// run command: ./beam_search_benchmark [options...]
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::operators::math::BenchTopKRow();
+  paddle::operators::math::BenchBeamSearch();
+  return 0;
+}
@@ -15,6 +15,10 @@ limitations under the License. */
 #include "paddle/fluid/operators/math/beam_search.h"
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/place.h"
 
@@ -213,6 +217,215 @@ TEST(BeamSearch, CPU) {
                  paddle::platform::CPUPlace>();
 }
 
+struct BeamSearchCandidate {
+  size_t offset;
+  int64_t id;
+  float score;
+};
+
+// The order of the selection of the CPU beam search: the higher score, then
+// the larger offset, then the smaller id.
+static bool BetterCandidate(const BeamSearchCandidate& a,
+                            const BeamSearchCandidate& b) {
+  if (a.score != b.score) return a.score > b.score;
+  if (a.offset != b.offset) return a.offset > b.offset;
+  return a.id < b.id;
+}
+
+struct BeamSearchResult {
+  std::vector<size_t> low_level;
+  std::vector<int64_t> ids;
+  std::vector<float> scores;
+  std::vector<int> parents;
+};
+
+// The prefix i of scores is the row i of [prefix_num, width], and the
+// source s has the prefixes [seq_offsets[s], seq_offsets[s + 1]). The ids
+// are the column indices if cand_ids is empty.
+struct BeamSearchInput {
+  std::vector<size_t> seq_offsets;
+  size_t width;
+  std::vector<float> scores;
+  std::vector<int64_t> cand_ids;
+  std::vector<float> pre_scores;
+};
+
+static BeamSearchResult RunCPUBeamSearch(const BeamSearchInput& input,
+                                         size_t beam_size,
+                                         bool is_accumulated) {
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceContext context(place);
+  size_t prefix_num = input.seq_offsets.back();
+  std::vector<size_t> prefix_offsets(prefix_num + 1);
+  for (size_t i = 0; i <= prefix_num; ++i) prefix_offsets[i] = i;
+  paddle::framework::LoD lod;
+  lod.push_back(input.seq_offsets);
+  lod.push_back(prefix_offsets);
+
+  paddle::framework::LoDTensor ids, scores, pre_ids, pre_scores;
+  auto dims = paddle::framework::make_ddim(
+      {static_cast<int64_t>(prefix_num), static_cast<int64_t>(input.width)});
+  scores.set_lod(lod);
+  scores.Resize(dims);
+  std::copy(input.scores.begin(), input.scores.end(),
+            scores.mutable_data<float>(place));
+  if (!input.cand_ids.empty()) {
+    ids.set_lod(lod);
+    ids.Resize(dims);
+    std::copy(input.cand_ids.begin(), input.cand_ids.end(),
+              ids.mutable_data<int64_t>(place));
+  }
+  pre_ids.Resize(paddle::framework::make_ddim(
+      {static_cast<int64_t>(prefix_num), 1}));
+  pre_scores.Resize(pre_ids.dims());
+  for (size_t i = 0; i < prefix_num; ++i) {
+    // no prefix is finished, the end id is 0
+    pre_ids.mutable_data<int64_t>(place)[i] = i + 1;
+    pre_scores.mutable_data<float>(place)[i] = input.pre_scores[i];
+  }
+
+  paddle::framework::LoDTensor selected_ids, selected_scores;
+  paddle::framework::Tensor parent_idx;
+  paddle::operators::math::BeamSearchFunctor<
+      paddle::platform::CPUDeviceContext, float>
+      beamsearch;
+  beamsearch(context, &pre_ids, &pre_scores,
+             input.cand_ids.empty() ? nullptr : &ids, &scores, &selected_ids,
+             &selected_scores, &parent_idx, 0, beam_size, 0, is_accumulated);
+
+  EXPECT_EQ(selected_ids.lod(), selected_scores.lod());
+  auto& out_lod = selected_ids.lod();
+  EXPECT_EQ(input.seq_offsets,
+            std::vector<size_t>(out_lod[0].begin(), out_lod[0].end()));
+  BeamSearchResult result;
+  result.low_level.assign(out_lod[1].begin(), out_lod[1].end());
+  size_t num = selected_ids.numel();
+  const int64_t* ids_data = selected_ids.data<int64_t>();
+  const float* scores_data = selected_scores.data<float>();
+  const int* parents_data = parent_idx.data<int>();
+  result.ids.assign(ids_data, ids_data + num);
+  result.scores.assign(scores_data, scores_data + num);
+  result.parents.assign(parents_data, parents_data + num);
+  return result;
+}
+
+// Select the candidates of every source by sorting all of them.
+static BeamSearchResult NaiveBeamSearch(const BeamSearchInput& input,
+                                        size_t beam_size,
+                                        bool is_accumulated) {
+  BeamSearchResult result;
+  for (size_t s = 0; s + 1 < input.seq_offsets.size(); ++s) {
+    std::vector<BeamSearchCandidate> cands;
+    for (size_t offset = input.seq_offsets[s];
+         offset < input.seq_offsets[s + 1]; ++offset) {
+      for (size_t d = 0; d < input.width; ++d) {
+        size_t index = offset * input.width + d;
+        float pre_score = input.pre_scores[offset];
+        float score = is_accumulated
+                          ? input.scores[index]
+                          : pre_score + std::log(input.scores[index]);
+        int64_t id = input.cand_ids.empty() ? static_cast<int64_t>(d)
+                                            : input.cand_ids[index];
+        cands.push_back({offset, id, score});
+      }
+    }
+    size_t num = std::min(beam_size, cands.size());
+    std::partial_sort(cands.begin(), cands.begin() + num, cands.end(),
+                      BetterCandidate);
+    cands.resize(num);
+    std::stable_sort(
+        cands.begin(), cands.end(),
+        [](const BeamSearchCandidate& a, const BeamSearchCandidate& b) {
+          return a.offset < b.offset;
+        });
+    size_t i = 0;
+    for (size_t offset = input.seq_offsets[s];
+         offset < input.seq_offsets[s + 1]; ++offset) {
+      result.low_level.push_back(result.ids.size());
+      for (; i < num && cands[i].offset == offset; ++i) {
+        result.ids.push_back(cands[i].id);
+        result.scores.push_back(cands[i].score);
+        result.parents.push_back(static_cast<int>(offset));
+      }
+    }
+  }
+  result.low_level.push_back(result.ids.size());
+  return result;
+}
+
+static void ExpectSameResult(const BeamSearchResult& expected,
+                             const BeamSearchResult& actual) {
+  EXPECT_EQ(expected.low_level, actual.low_level);
+  EXPECT_EQ(expected.ids, actual.ids);
+  EXPECT_EQ(expected.scores, actual.scores);
+  EXPECT_EQ(expected.parents, actual.parents);
+}
+
+static BeamSearchInput RandomBeamSearchInput(
+    const std::vector<size_t>& seq_offsets, size_t width, bool with_ids,
+    std::mt19937* engine) {
+  BeamSearchInput input;
+  input.seq_offsets = seq_offsets;
+  input.width = width;
+  size_t prefix_num = seq_offsets.back();
+  std::uniform_real_distribution<float> prob(0.001f, 1.0f);
+  std::uniform_int_distribution<int64_t> id(1, 100000);
+  for (size_t i = 0; i < prefix_num * width; ++i) {
+    input.scores.push_back(prob(*engine));
+    if (with_ids) input.cand_ids.push_back(id(*engine));
+  }
+  for (size_t i = 0; i < prefix_num; ++i) {
+    input.pre_scores.push_back(std::log(prob(*engine)));
+  }
+  return input;
+}
+
+// The rows are longer than beam_size + 16, so that the candidates are
+// filtered in blocks of 16 once the beam is full.
+TEST(BeamSearch, CPUBlockFilter) {
+  std::mt19937 engine(0);
+  size_t beam_size = 4;
+  for (bool with_ids : {false, true}) {
+    for (bool is_accumulated : {false, true}) {
+      auto input =
+          RandomBeamSearchInput({0, 3, 5, 6}, 100, with_ids, &engine);
+      ExpectSameResult(NaiveBeamSearch(input, beam_size, is_accumulated),
+                       RunCPUBeamSearch(input, beam_size, is_accumulated));
+    }
+  }
+}
+
+// The scores have more than 1 << 16 elements, so that the sources are
+// selected in parallel.
+TEST(BeamSearch, CPUParallelSources) {
+  std::mt19937 engine(0);
+  size_t beam_size = 8;
+  auto input = RandomBeamSearchInput({0, 2, 4, 6, 8, 10, 12, 14, 16}, 5000,
+                                     true, &engine);
+  ExpectSameResult(NaiveBeamSearch(input, beam_size, false),
+                   RunCPUBeamSearch(input, beam_size, false));
+}
+
+// The candidates tying with the worst kept one of a full beam, the smaller
+// id is kept.
+TEST(BeamSearch, CPUTiesAtFullBeam) {
+  BeamSearchInput input;
+  input.seq_offsets = {0, 2};
+  input.width = 40;
+  input.scores.assign(2 * input.width, 0.5f);
+  std::fill(input.scores.begin() + input.width, input.scores.end(), 0.4f);
+  input.scores[3] = 0.9f;
+  input.scores[input.width + 7] = 0.8f;
+  input.pre_scores = {0.0f, 0.0f};
+
+  auto result = RunCPUBeamSearch(input, 4, true);
+  EXPECT_EQ(std::vector<size_t>({0, 3, 4}), result.low_level);
+  EXPECT_EQ(std::vector<int64_t>({3, 0, 1, 7}), result.ids);
+  EXPECT_EQ(std::vector<float>({0.9f, 0.5f, 0.5f, 0.8f}), result.scores);
+  EXPECT_EQ(std::vector<int>({0, 0, 0, 1}), result.parents);
+  ExpectSameResult(NaiveBeamSearch(input, 4, true), result);
+}
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 TEST(BeamSearch, GPU) {
   TestBeamSearch<paddle::platform::CUDADeviceContext,
@@ -0,0 +1,151 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+/*
+ * A bounded cache of the values computed from hashed features, e.g. the
+ * embedding rows of the n-grams of pyramid_hash, shared by the threads.
+ *
+ * The entries are found by the fingerprint of their keys, and the keys are
+ * compared too, so a collision of the fingerprints is only a miss. The
+ * cache is split into shards with their own locks. A full shard evicts by
+ * CLOCK: the entries sit in a ring of slots with a referenced bit set by
+ * Get, and the hand clears the bits until it finds an entry that was not
+ * used since its last pass.
+ */
+template <typename Value>
+class HashedFeatureCache {
+ public:
+  explicit HashedFeatureCache(size_t capacity)
+      : shard_capacity_((capacity + kNumShards - 1) / kNumShards) {}
+
+  size_t capacity() const { return shard_capacity_ * kNumShards; }
+
+  bool Get(uint64_t fingerprint, const uint32_t* key, size_t key_len,
+           Value* value) {
+    auto& shard = shards_[ShardOf(fingerprint)];
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto it = shard.index.find(fingerprint);
+    if (it == shard.index.end()) return false;
+    auto& slot = shard.slots[it->second];
+    if (!SameKey(slot.key, key, key_len)) return false;
+    slot.referenced = true;
+    *value = slot.value;
+    return true;
+  }
+
+  void Put(uint64_t fingerprint, const uint32_t* key, size_t key_len,
+           const Value& value) {
+    if (shard_capacity_ == 0) return;
+    auto& shard = shards_[ShardOf(fingerprint)];
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    size_t index;
+    auto it = shard.index.find(fingerprint);
+    if (it != shard.index.end()) {
+      index = it->second;
+    } else if (shard.slots.size() < shard_capacity_) {
+      index = shard.slots.size();
+      shard.slots.emplace_back();
+      shard.index.emplace(fingerprint, index);
+    } else {
+      index = shard.Evict();
+      shard.index.emplace(fingerprint, index);
+    }
+    auto& slot = shard.slots[index];
+    slot.fingerprint = fingerprint;
+    slot.key.assign(key, key + key_len);
+    slot.value = value;
+    slot.referenced = false;
+  }
+
+  size_t Size() {
+    size_t size = 0;
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> guard(shard.mutex);
+      size += shard.slots.size();
+    }
+    return size;
+  }
+
+ private:
+  static constexpr size_t kNumShards = 64;
+
+  struct Slot {
+    uint64_t fingerprint{0};
+    std::vector<uint32_t> key;
+    Value value;
+    bool referenced{false};
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::vector<Slot> slots;
+    // fingerprint -> index in slots
+    std::unordered_map<uint64_t, size_t> index;
+    size_t hand{0};
+
+    // Frees the first slot from the hand which was not referenced, and
+    // returns its index.
+    size_t Evict() {
+      while (slots[hand].referenced) {
+        slots[hand].referenced = false;
+        hand = (hand + 1) % slots.size();
+      }
+      size_t victim = hand;
+      hand = (hand + 1) % slots.size();
+      index.erase(slots[victim].fingerprint);
+      return victim;
+    }
+  };
+
+  // The low bits select the bucket in the map, use the high ones.
+  static size_t ShardOf(uint64_t fingerprint) {
+    return static_cast<size_t>(fingerprint >> 58) % kNumShards;
+  }
+
+  static bool SameKey(const std::vector<uint32_t>& stored,
+                      const uint32_t* key, size_t key_len) {
+    return stored.size() == key_len &&
+           std::equal(stored.begin(), stored.end(), key);
+  }
+
+  size_t shard_capacity_;
+  std::array<Shard, kNumShards> shards_;
+};
+
+// Mix the next word of a key into its fingerprint, so that the fingerprints
+// of the n-grams are extended from the shorter ones.
+inline uint64_t MixFingerprint(uint64_t fingerprint, uint32_t word) {
+  uint64_t k = (fingerprint ^ word) * 0x9E3779B97F4A7C15ULL;
+  k ^= k >> 32;
+  k *= 0xD6E8FEB86659FD93ULL;
+  return k ^ (k >> 32);
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
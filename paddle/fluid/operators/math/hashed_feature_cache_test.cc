@@ -0,0 +1,114 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/hashed_feature_cache.h"
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+static uint64_t Fingerprint(const std::vector<uint32_t>& key) {
+  uint64_t fingerprint = 0;
+  for (auto word : key) {
+    fingerprint = MixFingerprint(fingerprint, word);
+  }
+  return fingerprint;
+}
+
+TEST(HashedFeatureCache, get_put) {
+  HashedFeatureCache<int> cache(1024);
+  std::vector<uint32_t> key = {1, 2, 3};
+  int value = 0;
+  EXPECT_FALSE(cache.Get(Fingerprint(key), key.data(), key.size(), &value));
+  cache.Put(Fingerprint(key), key.data(), key.size(), 42);
+  EXPECT_TRUE(cache.Get(Fingerprint(key), key.data(), key.size(), &value));
+  EXPECT_EQ(value, 42);
+
+  // a different key with the same fingerprint misses
+  std::vector<uint32_t> other = {1, 2, 4};
+  EXPECT_FALSE(cache.Get(Fingerprint(key), other.data(), other.size(), &value));
+}
+
+TEST(HashedFeatureCache, bounded) {
+  HashedFeatureCache<int> cache(128);
+  for (uint32_t i = 0; i < 10000; ++i) {
+    std::vector<uint32_t> key = {i};
+    cache.Put(Fingerprint(key), key.data(), key.size(), i);
+  }
+  EXPECT_LE(cache.Size(), cache.capacity());
+
+  HashedFeatureCache<int> disabled(0);
+  std::vector<uint32_t> key = {1};
+  int value = 0;
+  disabled.Put(Fingerprint(key), key.data(), key.size(), 1);
+  EXPECT_FALSE(disabled.Get(Fingerprint(key), key.data(), key.size(), &value));
+}
+
+TEST(HashedFeatureCache, evict_stale) {
+  HashedFeatureCache<int> cache(1024);
+  // warm up with keys that are never used again
+  for (uint32_t i = 0; i < 4096; ++i) {
+    std::vector<uint32_t> key = {i};
+    cache.Put(Fingerprint(key), key.data(), key.size(), i);
+  }
+  // the new working set replaces them, and stays cached
+  int hits = 0;
+  for (int round = 0; round < 3; ++round) {
+    hits = 0;
+    for (uint32_t i = 100000; i < 100256; ++i) {
+      std::vector<uint32_t> key = {i};
+      int value = 0;
+      if (cache.Get(Fingerprint(key), key.data(), key.size(), &value)) {
+        hits += value == static_cast<int>(i);
+      } else {
+        cache.Put(Fingerprint(key), key.data(), key.size(), i);
+      }
+    }
+  }
+  EXPECT_EQ(hits, 256);
+}
+
+TEST(HashedFeatureCache, threads) {
+  HashedFeatureCache<uint32_t> cache(1 << 12);
+  std::vector<std::thread> threads;
+  std::vector<int> errors(4, 0);
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, &errors, t] {
+      for (uint32_t i = 0; i < 20000; ++i) {
+        std::vector<uint32_t> key = {i % 2048, 7};
+        uint64_t fingerprint = Fingerprint(key);
+        uint32_t value = 0;
+        if (cache.Get(fingerprint, key.data(), key.size(), &value)) {
+          errors[t] += value != key[0] * 3;
+        } else {
+          cache.Put(fingerprint, key.data(), key.size(), key[0] * 3);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < 4; ++t) {
+    EXPECT_EQ(errors[t], 0);
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
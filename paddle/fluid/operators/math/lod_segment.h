@@ -0,0 +1,165 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include "paddle/fluid/framework/mixed_vector.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The segments are split across the omp threads when they have more
+// elements than it.
+constexpr int64_t kLoDSegmentParallelNumel = 1 << 15;
+
+/*
+ * Split the `num_segments` segments of `offsets` into `num_parts` ranges of
+ * consecutive segments. The work of a segment is its number of rows plus
+ * one, and the ranges have about the same work, so that the threads are
+ * balanced when the lengths vary a lot. Returns num_parts + 1 bounds.
+ */
+inline std::vector<size_t> BalanceLoDSegments(const size_t* offsets,
+                                              size_t num_segments,
+                                              size_t num_parts) {
+  std::vector<size_t> bounds(num_parts + 1, num_segments);
+  bounds[0] = 0;
+  size_t total = offsets[num_segments] - offsets[0] + num_segments;
+  size_t seg = 0;
+  for (size_t p = 1; p < num_parts; ++p) {
+    size_t target = total * p / num_parts;
+    while (seg < num_segments && offsets[seg] - offsets[0] + seg < target) {
+      ++seg;
+    }
+    bounds[p] = seg;
+  }
+  return bounds;
+}
+
+// The number of the ranges that the segments of `offsets` are split into,
+// 1 unless they have enough elements to be worth the omp threads.
+inline int LoDSegmentNumParts(const size_t* offsets, size_t num_segments,
+                              int64_t width) {
+  int num_parts = 1;
+#ifdef PADDLE_WITH_MKLML
+  int64_t numel =
+      static_cast<int64_t>(offsets[num_segments] - offsets[0]) * width;
+  if (numel > kLoDSegmentParallelNumel) {
+    num_parts = static_cast<int>(std::min<size_t>(
+        static_cast<size_t>(omp_get_max_threads()), num_segments));
+  }
+#endif
+  return std::max(num_parts, 1);
+}
+
+/*
+ * Call `callback(part, seg_begin, seg_end)` for `num_parts` balanced ranges
+ * [seg_begin, seg_end) of the segments of `offsets`, in parallel. The part
+ * index lets the callback use a workspace of its own, and the callback
+ * must only write the data of its segments and must not throw.
+ */
+template <typename Callback>
+void ForEachLoDPart(const size_t* offsets, size_t num_segments,
+                    int num_parts, Callback callback) {
+  if (num_parts <= 1) {
+    callback(0, static_cast<size_t>(0), num_segments);
+    return;
+  }
+  auto bounds = BalanceLoDSegments(offsets, num_segments, num_parts);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_parts)
+#endif
+  for (int p = 0; p < num_parts; ++p) {
+    callback(p, bounds[p], bounds[p + 1]);
+  }
+}
+
+/*
+ * Call `callback(i, begin, end)` for each segment [begin, end) of the lod
+ * level `offsets`, whose rows have `width` elements. The segments are
+ * processed by the omp threads in balanced ranges when there are enough
+ * elements, so the callback must only write the data of its segment and
+ * must not throw.
+ */
+template <typename Callback>
+void ForEachLoDSegment(const framework::Vector<size_t>& offsets,
+                       int64_t width, Callback callback) {
+  if (offsets.size() < 2) return;
+  size_t num_segments = offsets.size() - 1;
+  // Get the data once, the Vector may sync it on each access.
+  const size_t* data = offsets.data();
+  int num_parts = LoDSegmentNumParts(data, num_segments, width);
+  ForEachLoDPart(data, num_segments, num_parts,
+                 [&](int part, size_t seg_begin, size_t seg_end) {
+                   for (size_t i = seg_begin; i < seg_end; ++i) {
+                     callback(i, data[i], data[i + 1]);
+                   }
+                 });
+}
+
+/*
+ * The rows of the sequences of a batch, given by a lod level, or by the
+ * lengths of a padded batch whose i-th sequence starts at row
+ * i * padded_len. `offsets` are the prefix sums of the lengths, packed as if
+ * there were no padding, to balance the sequences with the functions above.
+ */
+struct SequenceRows {
+  std::vector<size_t> offsets;
+  int64_t padded_len{0};
+
+  static SequenceRows FromLoD(const framework::Vector<size_t>& lod) {
+    SequenceRows rows;
+    rows.offsets.assign(lod.begin(), lod.end());
+    return rows;
+  }
+
+  static SequenceRows FromLengths(const int64_t* lengths, size_t num,
+                                  int64_t padded_len) {
+    SequenceRows rows;
+    rows.padded_len = padded_len;
+    rows.offsets.resize(num + 1);
+    rows.offsets[0] = 0;
+    for (size_t i = 0; i < num; ++i) {
+      rows.offsets[i + 1] = rows.offsets[i] + static_cast<size_t>(lengths[i]);
+    }
+    return rows;
+  }
+
+  size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+  int64_t Begin(size_t i) const {
+    return padded_len > 0 ? static_cast<int64_t>(i) * padded_len
+                          : static_cast<int64_t>(offsets[i]);
+  }
+  int64_t Length(size_t i) const {
+    return static_cast<int64_t>(offsets[i + 1] - offsets[i]);
+  }
+  int64_t MaxLength() const {
+    int64_t max_len = 0;
+    for (size_t i = 0; i < size(); ++i) {
+      max_len = std::max(max_len, Length(i));
+    }
+    return max_len;
+  }
+};
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
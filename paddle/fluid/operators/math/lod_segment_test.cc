@@ -0,0 +1,118 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/lod_segment.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+TEST(LoDSegment, balance) {
+  // one long sequence and many short ones
+  std::vector<size_t> offsets = {0, 1000};
+  for (int i = 0; i < 1000; ++i) {
+    offsets.push_back(offsets.back() + 1);
+  }
+  size_t num_segments = offsets.size() - 1;
+  auto bounds = BalanceLoDSegments(offsets.data(), num_segments, 4);
+  ASSERT_EQ(bounds.size(), 5UL);
+  EXPECT_EQ(bounds.front(), 0UL);
+  EXPECT_EQ(bounds.back(), num_segments);
+  for (size_t p = 1; p < bounds.size(); ++p) {
+    EXPECT_LE(bounds[p - 1], bounds[p]);
+  }
+  // the long sequence is alone in the first range, and no other range has
+  // more than a quarter of the work
+  EXPECT_EQ(bounds[1], 1UL);
+  size_t total = offsets.back() + num_segments;
+  for (size_t p = 2; p < bounds.size(); ++p) {
+    size_t work = offsets[bounds[p]] - offsets[bounds[p - 1]] + bounds[p] -
+                  bounds[p - 1];
+    EXPECT_LE(work, total / 4 + 2);
+  }
+}
+
+TEST(LoDSegment, visit_each_segment) {
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<size_t> len_dist(0, 300);
+  framework::Vector<size_t> lod = {0};
+  for (int i = 0; i < 257; ++i) {
+    lod.push_back(lod.back() + len_dist(rng));
+  }
+  std::vector<int> visited(lod.size() - 1, 0);
+  std::vector<int> rows(lod.back(), 0);
+  ForEachLoDSegment(lod, 64, [&](size_t i, size_t begin, size_t end) {
+    ++visited[i];
+    for (size_t j = begin; j < end; ++j) {
+      ++rows[j];
+    }
+  });
+  for (size_t i = 0; i < visited.size(); ++i) {
+    EXPECT_EQ(visited[i], 1) << "segment " << i;
+  }
+  for (size_t j = 0; j < rows.size(); ++j) {
+    EXPECT_EQ(rows[j], 1) << "row " << j;
+  }
+}
+
+TEST(LoDSegment, padded_sequence_rows) {
+  std::vector<int64_t> lengths = {3, 0, 5, 1};
+  auto rows = SequenceRows::FromLengths(lengths.data(), lengths.size(), 5);
+  ASSERT_EQ(rows.size(), lengths.size());
+  EXPECT_EQ(rows.MaxLength(), 5);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    EXPECT_EQ(rows.Begin(i), static_cast<int64_t>(i) * 5);
+    EXPECT_EQ(rows.Length(i), lengths[i]);
+  }
+
+  framework::Vector<size_t> lod = {0, 2, 2, 7};
+  auto lod_rows = SequenceRows::FromLoD(lod);
+  ASSERT_EQ(lod_rows.size(), 3UL);
+  EXPECT_EQ(lod_rows.Begin(2), 2);
+  EXPECT_EQ(lod_rows.Length(1), 0);
+  EXPECT_EQ(lod_rows.Length(2), 5);
+}
+
+TEST(LoDSegment, visit_each_part) {
+  std::vector<int64_t> lengths(300);
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int64_t> len_dist(0, 40);
+  for (auto& len : lengths) len = len_dist(rng);
+  auto rows = SequenceRows::FromLengths(lengths.data(), lengths.size(), 40);
+  int num_parts = LoDSegmentNumParts(rows.offsets.data(), rows.size(), 256);
+  ASSERT_GE(num_parts, 1);
+  std::vector<int> visited(rows.size(), 0);
+  std::vector<int> part_used(num_parts, 0);
+  ForEachLoDPart(rows.offsets.data(), rows.size(), num_parts,
+                 [&](int part, size_t seg_begin, size_t seg_end) {
+                   ++part_used[part];
+                   for (size_t i = seg_begin; i < seg_end; ++i) {
+                     ++visited[i];
+                   }
+                 });
+  for (int p = 0; p < num_parts; ++p) {
+    EXPECT_EQ(part_used[p], 1) << "part " << p;
+  }
+  for (size_t i = 0; i < visited.size(); ++i) {
+    EXPECT_EQ(visited[i], 1) << "sequence " << i;
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,230 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+/*
+ * XXH32 and XXH64 of one key with many seeds, the same values as
+ * XXH32(data, len, seeds[i]) and XXH64(data, len, seeds[i]) on little
+ * endian machines. The words of the key are read once for a block of seeds,
+ * and the loops over the seeds have no branch, so that they are vectorized.
+ */
+namespace detail {
+
+constexpr uint32_t kXXH32Prime1 = 2654435761U;
+constexpr uint32_t kXXH32Prime2 = 2246822519U;
+constexpr uint32_t kXXH32Prime3 = 3266489917U;
+constexpr uint32_t kXXH32Prime4 = 668265263U;
+constexpr uint32_t kXXH32Prime5 = 374761393U;
+
+constexpr uint64_t kXXH64Prime1 = 11400714785074694791ULL;
+constexpr uint64_t kXXH64Prime2 = 14029467366897019727ULL;
+constexpr uint64_t kXXH64Prime3 = 1609587929392839161ULL;
+constexpr uint64_t kXXH64Prime4 = 9650029242287828579ULL;
+constexpr uint64_t kXXH64Prime5 = 2870177450012600261ULL;
+
+// The number of seeds hashed together.
+constexpr size_t kSeedBlock = 16;
+
+inline uint32_t Rotl32(uint32_t x, int r) { return (x << r) | (x >> (32 - r)); }
+inline uint64_t Rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint32_t Read32(const uint8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t Read64(const uint8_t* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t XXH32Round(uint32_t acc, uint32_t input) {
+  acc += input * kXXH32Prime2;
+  return Rotl32(acc, 13) * kXXH32Prime1;
+}
+
+inline uint64_t XXH64Round(uint64_t acc, uint64_t input) {
+  acc += input * kXXH64Prime2;
+  return Rotl64(acc, 31) * kXXH64Prime1;
+}
+
+inline uint64_t XXH64MergeRound(uint64_t acc, uint64_t val) {
+  acc ^= XXH64Round(0, val);
+  return acc * kXXH64Prime1 + kXXH64Prime4;
+}
+
+inline void XXH32Block(const uint8_t* p, size_t len, const uint32_t* seeds,
+                       size_t num, uint32_t* out) {
+  const uint8_t* end = p + len;
+  uint32_t h[kSeedBlock];
+  if (len >= 16) {
+    uint32_t v1[kSeedBlock], v2[kSeedBlock], v3[kSeedBlock], v4[kSeedBlock];
+    for (size_t s = 0; s < num; ++s) {
+      v1[s] = seeds[s] + kXXH32Prime1 + kXXH32Prime2;
+      v2[s] = seeds[s] + kXXH32Prime2;
+      v3[s] = seeds[s];
+      v4[s] = seeds[s] - kXXH32Prime1;
+    }
+    const uint8_t* limit = end - 16;
+    do {
+      uint32_t w1 = Read32(p), w2 = Read32(p + 4);
+      uint32_t w3 = Read32(p + 8), w4 = Read32(p + 12);
+      for (size_t s = 0; s < num; ++s) {
+        v1[s] = XXH32Round(v1[s], w1);
+        v2[s] = XXH32Round(v2[s], w2);
+        v3[s] = XXH32Round(v3[s], w3);
+        v4[s] = XXH32Round(v4[s], w4);
+      }
+      p += 16;
+    } while (p <= limit);
+    for (size_t s = 0; s < num; ++s) {
+      h[s] = Rotl32(v1[s], 1) + Rotl32(v2[s], 7) + Rotl32(v3[s], 12) +
+             Rotl32(v4[s], 18);
+    }
+  } else {
+    for (size_t s = 0; s < num; ++s) {
+      h[s] = seeds[s] + kXXH32Prime5;
+    }
+  }
+  for (size_t s = 0; s < num; ++s) {
+    h[s] += static_cast<uint32_t>(len);
+  }
+  for (; p + 4 <= end; p += 4) {
+    uint32_t w = Read32(p) * kXXH32Prime3;
+    for (size_t s = 0; s < num; ++s) {
+      h[s] = Rotl32(h[s] + w, 17) * kXXH32Prime4;
+    }
+  }
+  for (; p < end; ++p) {
+    uint32_t w = (*p) * kXXH32Prime5;
+    for (size_t s = 0; s < num; ++s) {
+      h[s] = Rotl32(h[s] + w, 11) * kXXH32Prime1;
+    }
+  }
+  for (size_t s = 0; s < num; ++s) {
+    uint32_t x = h[s];
+    x ^= x >> 15;
+    x *= kXXH32Prime2;
+    x ^= x >> 13;
+    x *= kXXH32Prime3;
+    x ^= x >> 16;
+    out[s] = x;
+  }
+}
+
+inline void XXH64Block(const uint8_t* p, size_t len, const uint64_t* seeds,
+                       size_t num, uint64_t* out) {
+  const uint8_t* end = p + len;
+  uint64_t h[kSeedBlock];
+  if (len >= 32) {
+    uint64_t v1[kSeedBlock], v2[kSeedBlock], v3[kSeedBlock], v4[kSeedBlock];
+    for (size_t s = 0; s < num; ++s) {
+      v1[s] = seeds[s] + kXXH64Prime1 + kXXH64Prime2;
+      v2[s] = seeds[s] + kXXH64Prime2;
+      v3[s] = seeds[s];
+      v4[s] = seeds[s] - kXXH64Prime1;
+    }
+    const uint8_t* limit = end - 32;
+    do {
+      uint64_t w1 = Read64(p), w2 = Read64(p + 8);
+      uint64_t w3 = Read64(p + 16), w4 = Read64(p + 24);
+      for (size_t s = 0; s < num; ++s) {
+        v1[s] = XXH64Round(v1[s], w1);
+        v2[s] = XXH64Round(v2[s], w2);
+        v3[s] = XXH64Round(v3[s], w3);
+        v4[s] = XXH64Round(v4[s], w4);
+      }
+      p += 32;
+    } while (p <= limit);
+    for (size_t s = 0; s < num; ++s) {
+      uint64_t x = Rotl64(v1[s], 1) + Rotl64(v2[s], 7) + Rotl64(v3[s], 12) +
+                   Rotl64(v4[s], 18);
+      x = XXH64MergeRound(x, v1[s]);
+      x = XXH64MergeRound(x, v2[s]);
+      x = XXH64MergeRound(x, v3[s]);
+      h[s] = XXH64MergeRound(x, v4[s]);
+    }
+  } else {
+    for (size_t s = 0; s < num; ++s) {
+      h[s] = seeds[s] + kXXH64Prime5;
+    }
+  }
+  for (size_t s = 0; s < num; ++s) {
+    h[s] += static_cast<uint64_t>(len);
+  }
+  for (; p + 8 <= end; p += 8) {
+    uint64_t k = XXH64Round(0, Read64(p));
+    for (size_t s = 0; s < num; ++s) {
+      h[s] = Rotl64(h[s] ^ k, 27) * kXXH64Prime1 + kXXH64Prime4;
+    }
+  }
+  if (p + 4 <= end) {
+    uint64_t k = static_cast<uint64_t>(Read32(p)) * kXXH64Prime1;
+    for (size_t s = 0; s < num; ++s) {
+      h[s] = Rotl64(h[s] ^ k, 23) * kXXH64Prime2 + kXXH64Prime3;
+    }
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    uint64_t k = (*p) * kXXH64Prime5;
+    for (size_t s = 0; s < num; ++s) {
+      h[s] = Rotl64(h[s] ^ k, 11) * kXXH64Prime1;
+    }
+  }
+  for (size_t s = 0; s < num; ++s) {
+    uint64_t x = h[s];
+    x ^= x >> 33;
+    x *= kXXH64Prime2;
+    x ^= x >> 29;
+    x *= kXXH64Prime3;
+    x ^= x >> 32;
+    out[s] = x;
+  }
+}
+
+}  // namespace detail
+
+inline void XXH32MultiSeed(const void* data, size_t len, const uint32_t* seeds,
+                           size_t num, uint32_t* out) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < num; i += detail::kSeedBlock) {
+    detail::XXH32Block(p, len, seeds + i,
+                       std::min(detail::kSeedBlock, num - i), out + i);
+  }
+}
+
+inline void XXH64MultiSeed(const void* data, size_t len, const uint64_t* seeds,
+                           size_t num, uint64_t* out) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < num; i += detail::kSeedBlock) {
+    detail::XXH64Block(p, len, seeds + i,
+                       std::min(detail::kSeedBlock, num - i), out + i);
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
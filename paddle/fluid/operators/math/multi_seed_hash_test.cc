@@ -0,0 +1,58 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/multi_seed_hash.h"
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <xxhash.h>
+}
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+TEST(MultiSeedHash, same_as_xxhash) {
+  std::mt19937 rng(0);
+  // cover the lengths of all the tails and of the long keys
+  for (size_t len = 0; len < 80; ++len) {
+    std::vector<uint8_t> data(len + 1);
+    for (auto& c : data) {
+      c = static_cast<uint8_t>(rng());
+    }
+    // an unaligned key
+    const uint8_t* key = data.data() + 1;
+    for (size_t num : {1, 7, 16, 37}) {
+      std::vector<uint32_t> seeds32(num), out32(num);
+      std::vector<uint64_t> seeds64(num), out64(num);
+      for (size_t i = 0; i < num; ++i) {
+        seeds32[i] = rng();
+        seeds64[i] = (static_cast<uint64_t>(rng()) << 32) | rng();
+      }
+      XXH32MultiSeed(key, len, seeds32.data(), num, out32.data());
+      XXH64MultiSeed(key, len, seeds64.data(), num, out64.data());
+      for (size_t i = 0; i < num; ++i) {
+        EXPECT_EQ(out32[i], XXH32(key, len, seeds32[i])) << "len " << len;
+        EXPECT_EQ(out64[i], XXH64(key, len, seeds64[i])) << "len " << len;
+      }
+    }
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
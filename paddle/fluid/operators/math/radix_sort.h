@@ -0,0 +1,253 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The keys are split across the omp threads when there are more than it,
+// and the sort is not already run by one of them.
+constexpr size_t kRadixSortParallelNumel = 1 << 16;
+
+/*
+ * The unsigned radix key of an integer, in the same order as the integers:
+ * the sign bit of the signed ones is flipped. The keys are complemented for
+ * the descending order.
+ */
+template <typename T>
+struct RadixKey {
+  static_assert(std::is_integral<T>::value,
+                "The radix sort only supports the integers.");
+  using Type = typename std::make_unsigned<T>::type;
+
+  static Type Encode(T value, bool descending) {
+    Type key = static_cast<Type>(value);
+    if (std::is_signed<T>::value) {
+      key ^= static_cast<Type>(Type(1) << (sizeof(T) * 8 - 1));
+    }
+    return descending ? static_cast<Type>(~key) : key;
+  }
+};
+
+// A range of keys at most this long is sorted by insertion, the counts of
+// the digits cost more than the sort.
+constexpr size_t kRadixSortInsertionNumel = 32;
+
+// A range of keys at most this long is sorted from the least significant
+// digit, its workspaces fit in the cache. The longer ones are first split
+// by their most significant digit.
+constexpr size_t kRadixSortCacheNumel = 1 << 14;
+
+namespace detail {
+
+constexpr int kRadixDigitBits = 8;
+constexpr size_t kRadixNumBuckets = 1 << kRadixDigitBits;
+
+// Scatter the chunks of [src, src + n) to dst by the digit at `shift`,
+// stably. `offsets` has kRadixNumBuckets counts for each of the chunks, and
+// `bucket_begin`, if not null, gets the begin of the buckets in dst.
+template <typename KeyT, typename ValueT>
+void RadixScatter(const KeyT* src_keys, const ValueT* src_values, size_t n,
+                  int shift, int num_parts, KeyT* dst_keys, ValueT* dst_values,
+                  size_t* offsets, size_t* bucket_begin) {
+  const KeyT mask = kRadixNumBuckets - 1;
+  const size_t chunk = (n + num_parts - 1) / num_parts;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_parts) if (num_parts > 1)
+#endif
+  for (int p = 0; p < num_parts; ++p) {
+    size_t* count = offsets + p * kRadixNumBuckets;
+    std::fill(count, count + kRadixNumBuckets, 0);
+    size_t end = std::min(n, (p + 1) * chunk);
+    for (size_t i = p * chunk; i < end; ++i) {
+      ++count[(src_keys[i] >> shift) & mask];
+    }
+  }
+  size_t offset = 0;
+  for (size_t b = 0; b < kRadixNumBuckets; ++b) {
+    if (bucket_begin) bucket_begin[b] = offset;
+    for (int p = 0; p < num_parts; ++p) {
+      size_t count = offsets[p * kRadixNumBuckets + b];
+      offsets[p * kRadixNumBuckets + b] = offset;
+      offset += count;
+    }
+  }
+  if (bucket_begin) bucket_begin[kRadixNumBuckets] = n;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(num_parts) if (num_parts > 1)
+#endif
+  for (int p = 0; p < num_parts; ++p) {
+    size_t* next = offsets + p * kRadixNumBuckets;
+    size_t end = std::min(n, (p + 1) * chunk);
+    for (size_t i = p * chunk; i < end; ++i) {
+      size_t pos = next[(src_keys[i] >> shift) & mask]++;
+      dst_keys[pos] = src_keys[i];
+      dst_values[pos] = src_values[i];
+    }
+  }
+}
+
+template <typename KeyT, typename ValueT>
+void InsertionSortPairs(KeyT* keys, ValueT* values, size_t n) {
+  for (size_t i = 1; i < n; ++i) {
+    KeyT key = keys[i];
+    ValueT value = values[i];
+    size_t j = i;
+    for (; j > 0 && key < keys[j - 1]; --j) {
+      keys[j] = keys[j - 1];
+      values[j] = values[j - 1];
+    }
+    keys[j] = key;
+    values[j] = value;
+  }
+}
+
+// Sort the n pairs in `a` with the workspace `b`, the result is left in b
+// if `to_b`, or else in a.
+template <typename KeyT, typename ValueT>
+void RadixSortRange(KeyT* a_keys, ValueT* a_values, KeyT* b_keys,
+                    ValueT* b_values, size_t n, bool to_b, int num_parts) {
+  if (n <= kRadixSortInsertionNumel) {
+    InsertionSortPairs(a_keys, a_values, n);
+    if (to_b) {
+      std::copy(a_keys, a_keys + n, b_keys);
+      std::copy(a_values, a_values + n, b_values);
+    }
+    return;
+  }
+  // The bits that differ between the keys, only their digits are sorted.
+  KeyT diff = 0;
+  for (size_t i = 1; i < n; ++i) {
+    diff |= a_keys[i] ^ a_keys[0];
+  }
+  int top = -1;
+  for (int shift = 0; shift < static_cast<int>(sizeof(KeyT) * 8);
+       shift += kRadixDigitBits) {
+    if ((diff >> shift) != 0) top = shift;
+  }
+
+  if (top < 0 || n <= kRadixSortCacheNumel) {
+    size_t offsets[kRadixNumBuckets];
+    KeyT* src_keys = a_keys;
+    ValueT* src_values = a_values;
+    KeyT* dst_keys = b_keys;
+    ValueT* dst_values = b_values;
+    for (int shift = 0; shift <= top; shift += kRadixDigitBits) {
+      if (((diff >> shift) & (kRadixNumBuckets - 1)) == 0) continue;
+      RadixScatter(src_keys, src_values, n, shift, 1, dst_keys, dst_values,
+                   offsets, static_cast<size_t*>(nullptr));
+      std::swap(src_keys, dst_keys);
+      std::swap(src_values, dst_values);
+    }
+    KeyT* result_keys = to_b ? b_keys : a_keys;
+    if (src_keys != result_keys) {
+      ValueT* result_values = to_b ? b_values : a_values;
+      std::copy(src_keys, src_keys + n, result_keys);
+      std::copy(src_values, src_values + n, result_values);
+    }
+    return;
+  }
+
+  // Split by the most significant digit into b, then sort each bucket by
+  // the lower digits, in parallel, with its range of a as the workspace.
+  std::vector<size_t> offsets(num_parts * kRadixNumBuckets);
+  size_t bucket_begin[kRadixNumBuckets + 1];
+  RadixScatter(a_keys, a_values, n, top, num_parts, b_keys, b_values,
+               offsets.data(), bucket_begin);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic) num_threads(num_parts) \
+    if (num_parts > 1)
+#endif
+  for (int bucket = 0; bucket < static_cast<int>(kRadixNumBuckets);
+       ++bucket) {
+    size_t begin = bucket_begin[bucket];
+    size_t len = bucket_begin[bucket + 1] - begin;
+    if (len < 2) {
+      if (len == 1 && !to_b) {
+        a_keys[begin] = b_keys[begin];
+        a_values[begin] = b_values[begin];
+      }
+      continue;
+    }
+    RadixSortRange(b_keys + begin, b_values + begin, a_keys + begin,
+                   a_values + begin, len, !to_b, 1);
+  }
+}
+
+}  // namespace detail
+
+/*
+ * Sort `n` unsigned keys together with their values, e.g. the indices of
+ * the keys. The sort is stable, so the values of the equal keys keep their
+ * order. `keys` and `values` hold the result, `key_buf` and `value_buf` are
+ * workspaces of n elements.
+ *
+ * A long input is first split into buckets by its most significant digit
+ * that differs, with the chunks of the omp threads counted and scattered in
+ * parallel. The buckets are then sorted in parallel, and those that fit in
+ * the cache from their least significant digit. A digit that is the same
+ * in all the keys of a range is skipped, so keys in a small range, e.g. of
+ * a low cardinality, take fewer passes.
+ */
+template <typename KeyT, typename ValueT>
+void RadixSortPairs(KeyT* keys, ValueT* values, size_t n, KeyT* key_buf,
+                    ValueT* value_buf) {
+  static_assert(std::is_unsigned<KeyT>::value,
+                "The keys of RadixSortPairs should be unsigned.");
+  if (n < 2) return;
+  int num_parts = 1;
+#ifdef PADDLE_WITH_MKLML
+  if (n > kRadixSortParallelNumel && !omp_in_parallel()) {
+    num_parts = std::max(omp_get_max_threads(), 1);
+  }
+#endif
+  detail::RadixSortRange(keys, values, key_buf, value_buf, n, false,
+                         num_parts);
+}
+
+/*
+ * Sort the indices of the `n` integers of `data` by their values, ascending
+ * or descending, and the equal values keep the order of their indices.
+ * `keys` gets the radix keys of the sorted values, so that the runs of the
+ * equal values are found without reading the data again.
+ */
+template <typename T, typename IndexT>
+void RadixSortIndices(const T* data, size_t n, bool descending,
+                      IndexT* indices, typename RadixKey<T>::Type* keys) {
+  using KeyT = typename RadixKey<T>::Type;
+  for (size_t i = 0; i < n; ++i) {
+    keys[i] = RadixKey<T>::Encode(data[i], descending);
+    indices[i] = static_cast<IndexT>(i);
+  }
+  std::vector<KeyT> key_buf(n);
+  std::vector<IndexT> index_buf(n);
+  RadixSortPairs(keys, indices, n, key_buf.data(), index_buf.data());
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,88 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/radix_sort.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+template <typename T>
+void CheckRadixSortIndices(const std::vector<T>& data, bool descending) {
+  std::vector<int64_t> expected(data.size());
+  std::iota(expected.begin(), expected.end(), 0);
+  std::stable_sort(expected.begin(), expected.end(),
+                   [&](int64_t a, int64_t b) {
+                     return descending ? data[a] > data[b] : data[a] < data[b];
+                   });
+
+  std::vector<int64_t> indices(data.size());
+  std::vector<typename RadixKey<T>::Type> keys(data.size());
+  RadixSortIndices(data.data(), data.size(), descending, indices.data(),
+                   keys.data());
+  ASSERT_EQ(indices, expected);
+  for (size_t i = 0; i < data.size(); ++i) {
+    ASSERT_EQ(keys[i], RadixKey<T>::Encode(data[indices[i]], descending));
+  }
+}
+
+template <typename T>
+void CheckRandom(size_t n, T low, T high) {
+  std::mt19937_64 rng(n);
+  std::uniform_int_distribution<T> dist(low, high);
+  std::vector<T> data(n);
+  for (auto& v : data) v = dist(rng);
+  CheckRadixSortIndices(data, false);
+  CheckRadixSortIndices(data, true);
+}
+
+TEST(RadixSort, small_cardinality) {
+  CheckRandom<int64_t>(1000, 0, 9);
+  CheckRandom<int32_t>(1000, -5, 5);
+  // sorted by insertion
+  CheckRandom<int64_t>(20, -3, 3);
+}
+
+TEST(RadixSort, full_range) {
+  CheckRandom<int64_t>(3000, std::numeric_limits<int64_t>::min(),
+                       std::numeric_limits<int64_t>::max());
+  CheckRandom<int32_t>(3000, std::numeric_limits<int32_t>::min(),
+                       std::numeric_limits<int32_t>::max());
+}
+
+TEST(RadixSort, parallel_chunks) {
+  // more keys than kRadixSortParallelNumel, split across the threads
+  CheckRandom<int64_t>(3 * kRadixSortParallelNumel + 7, -1000000, 1000000);
+}
+
+TEST(RadixSort, corner_cases) {
+  CheckRadixSortIndices(std::vector<int64_t>{}, false);
+  CheckRadixSortIndices(std::vector<int64_t>{42}, true);
+  CheckRadixSortIndices(std::vector<int32_t>(100, 7), false);
+  CheckRadixSortIndices(
+      std::vector<int64_t>{std::numeric_limits<int64_t>::max(), -1, 0,
+                           std::numeric_limits<int64_t>::min(), 1},
+      false);
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/math/sequence_padding.h"
+#include "paddle/fluid/operators/math/lod_segment.h"
 
 namespace pten {
 class DenseTensor;
@@ -39,22 +40,27 @@ void CopyValidData(framework::Tensor* dst_tensor,
   const T* src_data = src_tensor->data<T>();
   T* dst_data = dst_tensor->data<T>();
 
-  int seq_cpy_gap = step_width;
-  int pad_cpy_gap =
+  // Check the lengths first, the sequences are copied by the omp threads.
+  int max_seq_len = MaximumSequenceLength(seq_offsets);
+  PADDLE_ENFORCE_GE(
+      pad_seq_len, max_seq_len,
+      platform::errors::InvalidArgument(
+          "The padded sequence length can not "
+          "be less than its original length. Expected %ld >= %ld, but got "
+          "%ld < %ld. Please check input value.",
+          pad_seq_len, max_seq_len, pad_seq_len, max_seq_len));
+
+  int64_t seq_cpy_gap = step_width;
+  int64_t pad_cpy_gap =
       layout == kBatchLengthWidth ? step_width : seq_num * step_width;
-  for (int seq_idx = 0; seq_idx < seq_num; ++seq_idx) {
-    int valid_seq_len = seq_offsets[seq_idx + 1] - seq_offsets[seq_idx];
-    PADDLE_ENFORCE_GE(
-        pad_seq_len, valid_seq_len,
-        platform::errors::InvalidArgument(
-            "The padded sequence length can not "
-            "be less than its original length. Expected %ld >= %ld, but got "
-            "%ld < %ld. Please check input value.",
-            pad_seq_len, valid_seq_len, pad_seq_len, valid_seq_len));
-    int seq_data_offset = seq_offsets[seq_idx] * step_width;
-    int pad_data_offset = layout == kBatchLengthWidth
-                              ? seq_idx * pad_seq_len * step_width
-                              : seq_idx * step_width;
+  ForEachLoDSegment(seq_offsets, step_width, [&](size_t seq_idx,
+                                                 size_t begin, size_t end) {
+    int valid_seq_len = static_cast<int>(end - begin);
+    int64_t seq_data_offset = begin * step_width;
+    int64_t pad_data_offset =
+        layout == kBatchLengthWidth
+            ? static_cast<int64_t>(seq_idx) * pad_seq_len * step_width
+            : static_cast<int64_t>(seq_idx) * step_width;
     float scale = 1.0f / static_cast<float>(valid_seq_len);
 
     for (int step_idx = 0; step_idx < valid_seq_len; ++step_idx) {
@@ -71,7 +77,7 @@ void CopyValidData(framework::Tensor* dst_tensor,
       seq_data_offset += seq_cpy_gap;
       pad_data_offset += pad_cpy_gap;
     }
-  }
+  });
 }
 
 template <typename T>
@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/lod_segment.h"
 #include "paddle/fluid/operators/math/sequence_pooling.h"
 #include "paddle/pten/kernels/funcs/math_function.h"
 
@@ -74,27 +75,31 @@ class MaxSeqPoolFunctor {
 
     int64_t num_seq = out_dims[0];
     int64_t dim = output->numel() / num_seq;
-    for (int64_t i = 0; i < num_seq; ++i) {
-      if (starts[i] == starts[i + 1]) {
+    ForEachLoDSegment(starts, dim, [&](size_t i, size_t begin, size_t end) {
+      T* out = out_data + i * dim;
+      int* idx = max_index + i * dim;
+      if (begin == end) {
         for (int64_t k = 0; k < dim; ++k) {
-          out_data[i * dim + k] = pad_value;
-          max_index[i * dim + k] = -1;
+          out[k] = pad_value;
+          idx[k] = -1;
         }
-        continue;
+        return;
       }
+      std::memcpy(out, in_data + begin * dim, dim * sizeof(T));
       for (int64_t k = 0; k < dim; ++k) {
-        out_data[i * dim + k] = in_data[starts[i] * dim + k];
-        max_index[i * dim + k] = starts[i];
+        idx[k] = static_cast<int>(begin);
       }
-      for (size_t j = starts[i] + 1; j < starts[i + 1]; ++j) {
+      for (size_t j = begin + 1; j < end; ++j) {
+        const T* in = in_data + j * dim;
+        int step = static_cast<int>(j);
+        // no branch, so that the loop is vectorized
         for (int64_t k = 0; k < dim; ++k) {
-          if (in_data[j * dim + k] > out_data[i * dim + k]) {
-            out_data[i * dim + k] = in_data[j * dim + k];
-            max_index[i * dim + k] = j;
-          }
+          bool greater = in[k] > out[k];
+          out[k] = greater ? in[k] : out[k];
+          idx[k] = greater ? step : idx[k];
         }
       }
-    }
+    });
   }
 };
 // Instantisation of Max Sequence Pooling for test phase eg. no need to fill
@@ -133,23 +138,22 @@ class MaxSeqPoolFunctor<T, true> {
 
     int64_t num_seq = out_dims[0];
     int64_t dim = output->numel() / num_seq;
-    for (int64_t i = 0; i < num_seq; ++i) {
-      if (starts[i] == starts[i + 1]) {
+    ForEachLoDSegment(starts, dim, [&](size_t i, size_t begin, size_t end) {
+      T* out = out_data + i * dim;
+      if (begin == end) {
         for (int64_t k = 0; k < dim; ++k) {
-          out_data[i * dim + k] = pad_value;
+          out[k] = pad_value;
         }
-        continue;
+        return;
       }
-      std::memcpy(&out_data[i * dim], &in_data[starts[i] * dim],
-                  dim * sizeof(T));
-      for (size_t j = starts[i] + 1; j < starts[i + 1]; ++j) {
+      std::memcpy(out, in_data + begin * dim, dim * sizeof(T));
+      for (size_t j = begin + 1; j < end; ++j) {
+        const T* in = in_data + j * dim;
         for (int64_t k = 0; k < dim; ++k) {
-          if (in_data[j * dim + k] > out_data[i * dim + k]) {
-            out_data[i * dim + k] = in_data[j * dim + k];
-          }
+          out[k] = in[k] > out[k] ? in[k] : out[k];
         }
       }
-    }
+    });
   }
 };
 template <typename T>
@@ -218,23 +222,19 @@ class LastSeqPoolFunctor {
     // Calculate the size of each item in sequence
     int64_t item_size = input.numel() / input.dims()[0];
     auto lod_level = input.lod().size();
-    auto lod = input.lod()[lod_level - 1];
-    int seq_num = static_cast<int>(lod.size()) - 1;
-    for (int i = 0; i < seq_num; ++i) {
-      // Calculate the length of each sequence
-      int64_t seq_len = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      if (seq_len == 0) {
+    auto& lod = input.lod()[lod_level - 1];
+    ForEachLoDSegment(lod, 1, [&](size_t i, size_t begin, size_t end) {
+      T* out = out_data + i * item_size;
+      if (begin == end) {
         for (int j = 0; j < item_size; ++j) {
-          out_data[j] = pad_value;
+          out[j] = pad_value;
         }
       } else {
-        // Point to the begin of next sequence
-        in_data += seq_len * item_size;
         // Copy the last item of sequence to output
-        std::memcpy(out_data, (in_data - item_size), item_size * sizeof(T));
+        std::memcpy(out, in_data + (end - 1) * item_size,
+                    item_size * sizeof(T));
       }
-      out_data += item_size;
-    }
+    });
   }
 };
 
@@ -251,23 +251,18 @@ class FirstSeqPoolFunctor {
     // Calculate the size of each item in sequence
     int64_t item_size = input.numel() / input.dims()[0];
     auto lod_level = input.lod().size();
-    auto lod = input.lod()[lod_level - 1];
-    int seq_num = static_cast<int>(lod.size()) - 1;
-    for (int i = 0; i < seq_num; ++i) {
-      // Calculate the length of each sequence
-      int64_t seq_len = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      if (seq_len == 0) {
+    auto& lod = input.lod()[lod_level - 1];
+    ForEachLoDSegment(lod, 1, [&](size_t i, size_t begin, size_t end) {
+      T* out = out_data + i * item_size;
+      if (begin == end) {
         for (int j = 0; j < item_size; ++j) {
-          out_data[j] = pad_value;
+          out[j] = pad_value;
         }
       } else {
         // Copy the first item of sequence to output
-        std::memcpy(out_data, in_data, item_size * sizeof(T));
-        // Point to the next sequence
-        in_data += seq_len * item_size;
+        std::memcpy(out, in_data + begin * item_size, item_size * sizeof(T));
       }
-      out_data += item_size;
-    }
+    });
   }
 };
 
@@ -290,16 +285,12 @@ class SumSeqPoolGradFunctor {
     const T* out_g_data = out_grad.data<T>();
     T* in_g_data = in_grad->mutable_data<T>(context.GetPlace());
     auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
-    for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-      int64_t h = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      if (h == 0) continue;
-      int64_t in_offset = lod[i] * in_w;
+    ForEachLoDSegment(lod, in_w, [&](size_t i, size_t begin, size_t end) {
       const T* out_pos = out_g_data + i * out_w;
-      T* in_pos = in_g_data + in_offset;
-      for (int r = 0; r != h; ++r) {
-        blas.VCOPY(in_w, out_pos, in_pos + r * in_w);
+      for (size_t r = begin; r < end; ++r) {
+        blas.VCOPY(in_w, out_pos, in_g_data + r * in_w);
       }
-    }
+    });
   }
 };
 
@@ -333,62 +324,46 @@ class SequencePoolFunctor<platform::CPUDeviceContext, T> {
       return;
     }
     auto lod_level = input.lod().size();
-    auto lod = input.lod()[lod_level - 1];
+    auto& lod = input.lod()[lod_level - 1];
+    jit::SeqPoolType pool_type;
     if (pooltype == "SUM") {
-      auto place = context.GetPlace();
-      PADDLE_ENFORCE_EQ(
-          platform::is_cpu_place(place), true,
-          platform::errors::InvalidArgument(
-              "Sequence_pool should run on CPU Device when pooltype is SUM"));
-      const T* src = input.data<T>();
-      T* dst = output->mutable_data<T>(place);
-      jit::seq_pool_attr_t attr(
-          static_cast<int>(input.numel() / input.dims()[0]),
-          jit::SeqPoolType::kSum);
-      auto seqpool =
-          jit::KernelFuncs<jit::SeqPoolTuple<T>, platform::CPUPlace>::Cache()
-              .At(attr);
-      for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-        attr.h = static_cast<int>(lod[i + 1] - lod[i]);
-        if (attr.h == 0) {
-          for (int j = 0; j < attr.w; ++j) {
-            dst[j] = pad_value;
-          }
-        } else {
-          seqpool(src, dst, &attr);
-        }
-        dst += attr.w;
-        src += attr.h * attr.w;
-      }
-      return;
+      pool_type = jit::SeqPoolType::kSum;
+    } else if (pooltype == "AVERAGE") {
+      pool_type = jit::SeqPoolType::kAvg;
+    } else if (pooltype == "SQRT") {
+      pool_type = jit::SeqPoolType::kSqrt;
+    } else {
+      PADDLE_THROW(platform::errors::InvalidArgument(
+          "unsupported pooling pooltype: %s. Only support \"AVERAGE\" and "
+          "\"SQRT\"",
+          pooltype));
     }
-    auto& place = *context.eigen_device();
-    for (int i = 0; i < static_cast<int>(lod.size()) - 1; ++i) {
-      Tensor out_t = output->Slice(i, i + 1);
-      int64_t w = input.numel() / input.dims()[0];
-      if (lod[i] == lod[i + 1]) {
-        for (int j = 0; j < w; ++j) {
-          out_t.data<T>()[j] = pad_value;
-        }
-        continue;
-      }
-      Tensor in_t =
-          input.Slice(static_cast<int>(lod[i]), static_cast<int>(lod[i + 1]));
-      int64_t h = static_cast<int64_t>(lod[i + 1] - lod[i]);
-      auto in_e = EigenMatrix<T>::From(in_t, framework::make_ddim({h, w}));
-      auto out_e = EigenVector<T>::Flatten(out_t);
-      if (pooltype == "AVERAGE") {
-        out_e.device(place) = in_e.mean(Eigen::array<int, 1>({{0}}));
-      } else if (pooltype == "SQRT") {
-        out_e.device(place) = in_e.sum(Eigen::array<int, 1>({{0}})) /
-                              std::sqrt(static_cast<T>(h));
-      } else {
-        PADDLE_THROW(platform::errors::InvalidArgument(
-            "unsupported pooling pooltype: %s. Only support \"AVERAGE\" and "
-            "\"SQRT\"",
+    auto place = context.GetPlace();
+    PADDLE_ENFORCE_EQ(
+        platform::is_cpu_place(place), true,
+        platform::errors::InvalidArgument(
+            "Sequence_pool should run on CPU Device when pooltype is %s",
             pooltype));
-      }
-    }
+    const T* src = input.data<T>();
+    T* dst = output->mutable_data<T>(place);
+    jit::seq_pool_attr_t pool_attr(
+        static_cast<int>(input.numel() / input.dims()[0]), pool_type);
+    auto seqpool =
+        jit::KernelFuncs<jit::SeqPoolTuple<T>, platform::CPUPlace>::Cache().At(
+            pool_attr);
+    ForEachLoDSegment(
+        lod, pool_attr.w, [&](size_t i, size_t begin, size_t end) {
+          jit::seq_pool_attr_t attr = pool_attr;
+          attr.h = static_cast<int>(end - begin);
+          T* out = dst + i * attr.w;
+          if (attr.h == 0) {
+            for (int j = 0; j < attr.w; ++j) {
+              out[j] = pad_value;
+            }
+          } else {
+            seqpool(src + begin * attr.w, out, &attr);
+          }
+        });
   }
 };
 
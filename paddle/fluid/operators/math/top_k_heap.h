@@ -0,0 +1,181 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+/*
+ * FixedSizeHeap keeps the `capacity` best items pushed into it, in a buffer
+ * owned by the caller, so that it can be reused without allocation.
+ * `better(a, b)` returns true if `a` should be kept rather than `b`, the
+ * worst kept item is at the root.
+ */
+template <typename T, typename Better>
+class FixedSizeHeap {
+ public:
+  FixedSizeHeap(T* data, size_t capacity, Better better = Better())
+      : data_(data), capacity_(capacity), better_(better) {}
+
+  size_t size() const { return size_; }
+  bool full() const { return size_ == capacity_; }
+  // The worst kept item, only valid if the heap is not empty.
+  const T& worst() const { return data_[0]; }
+
+  // Keep the item if the heap is not full or the item is better than the
+  // worst kept one. Returns whether the item is kept.
+  bool Push(const T& item) {
+    if (size_ < capacity_) {
+      size_t i = size_++;
+      while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!better_(data_[parent], item)) break;
+        data_[i] = data_[parent];
+        i = parent;
+      }
+      data_[i] = item;
+      return true;
+    }
+    if (capacity_ == 0 || !better_(item, data_[0])) {
+      return false;
+    }
+    SiftDown(item, 0, size_);
+    return true;
+  }
+
+  // Sort the kept items in place, the best first. Returns the number of the
+  // items, and the heap is empty after that.
+  size_t Sort() {
+    size_t num = size_;
+    for (size_t end = size_; end > 1; --end) {
+      T last = data_[end - 1];
+      data_[end - 1] = data_[0];
+      SiftDown(last, 0, end - 1);
+    }
+    size_ = 0;
+    return num;
+  }
+
+  void Clear() { size_ = 0; }
+
+ private:
+  // Put `item` at `i` and move it down until no child is worse than it.
+  void SiftDown(const T& item, size_t i, size_t end) {
+    while (true) {
+      size_t child = 2 * i + 1;
+      if (child >= end) break;
+      if (child + 1 < end && better_(data_[child], data_[child + 1])) {
+        ++child;
+      }
+      if (!better_(item, data_[child])) break;
+      data_[i] = data_[child];
+      i = child;
+    }
+    data_[i] = item;
+  }
+
+  T* data_;
+  size_t capacity_;
+  size_t size_{0};
+  Better better_;
+};
+
+template <typename T>
+inline bool IsNan(T value) {
+  return value != value;
+}
+
+// The order of top_k_v2: NaN is larger than any other value, and the
+// smaller index comes first for the equal values.
+template <typename T, typename IndexT, bool kLargest>
+struct TopKBetter {
+  bool operator()(const std::pair<T, IndexT>& a,
+                  const std::pair<T, IndexT>& b) const {
+    bool a_nan = IsNan(a.first);
+    bool b_nan = IsNan(b.first);
+    if (a_nan || b_nan) {
+      if (a_nan && b_nan) return a.second < b.second;
+      return kLargest ? a_nan : b_nan;
+    }
+    if (a.first != b.first) {
+      return kLargest ? a.first > b.first : a.first < b.first;
+    }
+    return a.second < b.second;
+  }
+};
+
+/*
+ * Select the top k of `row` into `buffer`, sorted from the best, with the
+ * order of TopKBetter. Returns the number of the selected items, which is
+ * min(k, width).
+ *
+ * Once the heap is full, the row is scanned in blocks: a block is pushed
+ * only if one of its values may beat the worst kept value. The check has no
+ * branch in the block, so the compiler vectorizes it, and most blocks of a
+ * long row are skipped without touching the heap.
+ */
+template <typename T, typename IndexT, bool kLargest>
+IndexT TopKRow(const T* row, IndexT width, IndexT k,
+               std::pair<T, IndexT>* buffer) {
+  constexpr IndexT kBlockSize = 16;
+  using Item = std::pair<T, IndexT>;
+  if (k <= 0) return 0;
+  FixedSizeHeap<Item, TopKBetter<T, IndexT, kLargest>> heap(
+      buffer, static_cast<size_t>(k));
+
+  IndexT j = 0;
+  for (; j < width && !heap.full(); ++j) {
+    heap.Push(Item(row[j], j));
+  }
+  for (; j + kBlockSize <= width; j += kBlockSize) {
+    T threshold = heap.worst().first;
+    const T* block = row + j;
+    int hit = 0;
+    if (IsNan(threshold)) {
+      // When the worst kept value is NaN, the larger index of the block
+      // can't beat it for largest, and any number beats it for smallest.
+      if (kLargest) {
+        j = width;
+        break;
+      }
+      hit = 1;
+    } else if (kLargest) {
+      for (IndexT b = 0; b < kBlockSize; ++b) {
+        hit |= !(block[b] <= threshold);
+      }
+    } else {
+      for (IndexT b = 0; b < kBlockSize; ++b) {
+        hit |= block[b] < threshold;
+      }
+    }
+    if (hit) {
+      for (IndexT b = 0; b < kBlockSize; ++b) {
+        heap.Push(Item(block[b], j + b));
+      }
+    }
+  }
+  for (; j < width; ++j) {
+    heap.Push(Item(row[j], j));
+  }
+  return static_cast<IndexT>(heap.Sort());
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,86 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/top_k_heap.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+template <bool kLargest>
+void CheckTopKRow(const std::vector<float>& row, int64_t k) {
+  using Item = std::pair<float, int64_t>;
+  std::vector<Item> expected;
+  for (size_t i = 0; i < row.size(); ++i) {
+    expected.emplace_back(row[i], i);
+  }
+  std::sort(expected.begin(), expected.end(),
+            TopKBetter<float, int64_t, kLargest>());
+
+  std::vector<Item> result(k);
+  int64_t num = TopKRow<float, int64_t, kLargest>(
+      row.data(), static_cast<int64_t>(row.size()), k, result.data());
+  ASSERT_EQ(num, std::min<int64_t>(k, row.size()));
+  for (int64_t i = 0; i < num; ++i) {
+    EXPECT_EQ(result[i].second, expected[i].second);
+  }
+}
+
+TEST(FixedSizeHeap, keep_the_best) {
+  std::vector<int> buffer(3);
+  FixedSizeHeap<int, std::greater<int>> heap(buffer.data(), buffer.size());
+  for (int value : {5, 1, 9, 3, 7, 2}) {
+    heap.Push(value);
+  }
+  EXPECT_TRUE(heap.full());
+  EXPECT_EQ(heap.worst(), 5);
+  EXPECT_FALSE(heap.Push(4));
+  ASSERT_EQ(heap.Sort(), 3UL);
+  EXPECT_EQ(buffer, std::vector<int>({9, 7, 5}));
+  EXPECT_EQ(heap.size(), 0UL);
+}
+
+TEST(TopKRow, random_with_nan_and_ties) {
+  std::mt19937 rng(0);
+  for (int i = 0; i < 200; ++i) {
+    std::vector<float> row(rng() % 2000 + 1);
+    for (auto& value : row) {
+      // few distinct values to have ties
+      value = static_cast<float>(rng() % 64) / 8.0f;
+      if (rng() % 97 == 0) value = std::numeric_limits<float>::quiet_NaN();
+    }
+    int64_t k = rng() % 128 + 1;
+    CheckTopKRow<true>(row, k);
+    CheckTopKRow<false>(row, k);
+  }
+}
+
+TEST(TopKRow, all_nan) {
+  std::vector<float> row(100, std::numeric_limits<float>::quiet_NaN());
+  row[50] = 1.0f;
+  CheckTopKRow<true>(row, 5);
+  CheckTopKRow<false>(row, 5);
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -12,17 +12,28 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
-#include <xxhash.h>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
 #include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/hashed_feature_cache.h"
+#include "paddle/fluid/operators/math/multi_seed_hash.h"
 #include "paddle/fluid/operators/search_compute.h"
+#include "paddle/fluid/platform/flags.h"
 
 extern "C" {
 #include "math/bloomfilter.h"
 }
 
+PADDLE_DEFINE_EXPORTED_int64(
+    pyramid_hash_cache_capacity, 0,
+    "The number of the n-grams whose filter results and embedding rows are "
+    "cached by pyramid_hash across batches and threads, 0 to disable it");
+
 namespace paddle {
 namespace operators {
 
@@ -30,6 +41,85 @@ using Tensor = framework::Tensor;
 using LoDTensor = framework::LoDTensor;
 using LoD = framework::LoD;
 
+// Whether an n-gram passes the filters, and the rows of W in its embedding.
+struct PyramidHashTerm {
+  bool use_term{false};
+  std::vector<uint32_t> pos;
+};
+
+using PyramidHashCache = math::HashedFeatureCache<PyramidHashTerm>;
+
+// Shared by all the pyramid_hash ops, the keys include their attributes and
+// filters. The cache is rebuilt empty when the capacity flag changes, and is
+// null while it is disabled.
+static std::shared_ptr<PyramidHashCache> GetPyramidHashCache() {
+  static std::mutex mutex;
+  static std::shared_ptr<PyramidHashCache> cache;
+  static int64_t capacity = 0;
+  std::lock_guard<std::mutex> guard(mutex);
+  if (FLAGS_pyramid_hash_cache_capacity != capacity) {
+    capacity = FLAGS_pyramid_hash_cache_capacity;
+    cache = capacity > 0 ? std::make_shared<PyramidHashCache>(
+                               static_cast<size_t>(capacity))
+                         : nullptr;
+  }
+  return cache;
+}
+
+// The fingerprint of the contents of the bloom filter in `tensor`, 0 for no
+// filter. The contents are hashed once per loaded filter: the fingerprint
+// is reused while the allocation of the tensor is alive, the header of the
+// filter is unchanged and no tensor has been loaded since.
+static uint64_t BloomFilterFingerprint(const Tensor& tensor,
+                                       const math::bloomfilter* filter) {
+  if (filter == nullptr) return 0;
+  struct Memo {
+    std::weak_ptr<void> holder;
+    uint64_t m, k, count, generation, fingerprint;
+  };
+  static std::mutex mutex;
+  static std::unordered_map<const void*, Memo> memos;
+  uint64_t generation = framework::TensorLoadGeneration();
+  std::lock_guard<std::mutex> guard(mutex);
+  auto& memo = memos[filter];
+  auto holder = memo.holder.lock();
+  if (holder != nullptr && holder == tensor.Holder() && memo.m == filter->m &&
+      memo.k == filter->k && memo.count == filter->count &&
+      memo.generation == generation) {
+    return memo.fingerprint;
+  }
+  const auto* words = reinterpret_cast<const uint32_t*>(filter);
+  size_t num_words = tensor.numel() * sizeof(float) / sizeof(uint32_t);
+  uint64_t fingerprint = 0;
+  for (size_t i = 0; i < num_words; ++i) {
+    fingerprint = math::MixFingerprint(fingerprint, words[i]);
+  }
+  memo = Memo{tensor.Holder(), filter->m,  filter->k,
+              filter->count,   generation, fingerprint};
+  return fingerprint;
+}
+
+// The seeds of the rows of an embedding, one per rand_len elements.
+static std::vector<uint32_t> PyramidHashSeeds(int num_emb, int rand_len) {
+  std::vector<uint32_t> seeds;
+  for (int j = 0; j < num_emb; j += rand_len) {
+    seeds.push_back(static_cast<uint32_t>(j));
+  }
+  return seeds;
+}
+
+// The rows of W of the embedding of hash_id, which has len elements of T.
+template <typename T>
+void PyramidHashPositions(const T* hash_id, int len,
+                          const std::vector<uint32_t>& seeds, int space_len,
+                          uint32_t* pos) {
+  math::XXH32MultiSeed(hash_id, len * sizeof(T), seeds.data(), seeds.size(),
+                       pos);
+  for (size_t k = 0; k < seeds.size(); ++k) {
+    pos[k] %= static_cast<uint32_t>(space_len);
+  }
+}
+
 class PyramidHashOpMaker : public framework::OpProtoAndCheckerMaker {
  public:
   void Make() override {
@@ -224,26 +314,31 @@ class CPUPyramidHashOPKernel : public framework::OpKernel<T> {
                                        len * sizeof(float)));
   }
 
-  void hash_embedding_ff(const float* hash_id, int len, T* top_pos,
-                         const T* weights, int _num_emb, int _rand_len,
-                         int _space_len) const {
-    unsigned int pos1 = XXH32(hash_id, len * sizeof(float), 0) % _space_len;
-    unsigned int pos2 =
-        XXH32(hash_id, len * sizeof(float), _rand_len) % _space_len;
-
-    for (int j = 0; j != _num_emb; j += _rand_len) {
+  void hash_embedding_ff(const uint32_t* pos, T* top_pos, const T* weights,
+                         int _num_emb, int _rand_len) const {
+    for (int j = 0, k = 0; j != _num_emb; j += _rand_len, ++k) {
       if (j + _rand_len < _num_emb) {
-        __builtin_prefetch(weights + pos2);
+        __builtin_prefetch(weights + pos[k + 1]);
         __builtin_prefetch(top_pos + j + _rand_len);
       }
+      memcpy(top_pos + j, weights + pos[k], _rand_len * sizeof(T));
+    }
+  }
 
-      unsigned int pos3 =
-          XXH32(hash_id, len * sizeof(float), j + 2 * _rand_len) % _space_len;
-      memcpy(top_pos + j, const_cast<T*>(weights + pos1),
-             _rand_len * sizeof(T));
-      pos1 = pos2;
-      pos2 = pos3;
+  // The key of the cache: the attributes of the op and the fingerprints of
+  // the contents of its filters, then the words of the n-gram.
+  static std::vector<uint32_t> cache_key_prefix(int _num_emb, int _rand_len,
+                                                int _space_len,
+                                                uint64_t filter_fingerprint,
+                                                uint64_t black_fingerprint) {
+    std::vector<uint32_t> key = {static_cast<uint32_t>(_num_emb),
+                                 static_cast<uint32_t>(_rand_len),
+                                 static_cast<uint32_t>(_space_len)};
+    for (uint64_t fingerprint : {filter_fingerprint, black_fingerprint}) {
+      key.push_back(static_cast<uint32_t>(fingerprint));
+      key.push_back(static_cast<uint32_t>(fingerprint >> 32));
     }
+    return key;
   }
 
   void Compute(const framework::ExecutionContext& ctx) const override {
@@ -312,17 +407,80 @@ class CPUPyramidHashOPKernel : public framework::OpKernel<T> {
     int* iter = drop_pos->mutable_data<int>(ctx.GetPlace());
     int* iter_end = iter;
 
+    // The filter results and the embedding rows of the n-grams, from the
+    // cache if it is enabled. The fingerprints of the n-grams are extended
+    // from the shorter ones at the same positions.
+    auto seeds = PyramidHashSeeds(_num_emb, _rand_len);
+    size_t num_pos = seeds.size();
+    std::vector<uint32_t> term_pos;
+    PyramidHashTerm term;
+    term.pos.resize(num_pos);
+    auto cache = GetPyramidHashCache();
+    std::vector<uint32_t> key;
+    size_t key_prefix_len = 0;
+    uint64_t key_prefix_fingerprint = 0;
+    std::vector<uint64_t> fingerprints;
+    if (cache) {
+      key = cache_key_prefix(_num_emb, _rand_len, _space_len,
+                             BloomFilterFingerprint(*_blobs_1, _filter),
+                             BloomFilterFingerprint(*_blobs_2, _black_filter));
+      key_prefix_len = key.size();
+      for (auto word : key) {
+        key_prefix_fingerprint =
+            math::MixFingerprint(key_prefix_fingerprint, word);
+      }
+    }
+    auto word_of = [&](size_t index) {
+      uint32_t word;
+      memcpy(&word, bottom_data + index, sizeof(word));
+      return word;
+    };
+    auto get_term = [&](const float* ngram, int len, uint64_t fingerprint) {
+      if (cache) {
+        key.resize(key_prefix_len);
+        for (int k = 0; k < len; ++k) {
+          uint32_t word;
+          memcpy(&word, ngram + k, sizeof(word));
+          key.push_back(word);
+        }
+        if (cache->Get(fingerprint, key.data(), key.size(), &term)) {
+          return;
+        }
+      }
+      term.use_term = should_use_term(_filter, _black_filter, ngram, len);
+      term.pos.resize(num_pos);
+      if (term.use_term) {
+        PyramidHashPositions(ngram, len, seeds, _space_len, term.pos.data());
+      }
+      if (cache) {
+        cache->Put(fingerprint, key.data(), key.size(), term);
+      }
+    };
+
     for (size_t i = 0; i < top_offset.size() - 1; ++i) {
       int w = offset[i + 1] - offset[i];
       int nsentense_with_pyramid = 0;
       if (w < 2) {
         nsentense_with_pyramid = 0;
       } else {
+        if (cache) {
+          fingerprints.resize(w);
+          for (int l = 0; l < w; ++l) {
+            fingerprints[l] = math::MixFingerprint(key_prefix_fingerprint,
+                                                   word_of(offset[i] + l));
+          }
+        }
         for (int ilayer = 1; ilayer < _pyramid_layer && ilayer < w; ++ilayer) {
           for (int l = 0; l < w - ilayer; ++l) {
-            if (should_use_term(_filter, _black_filter,
-                                (const float*)(bottom_data + offset[i] + l),
-                                ilayer + 1)) {
+            uint64_t fingerprint = 0;
+            if (cache) {
+              fingerprints[l] = math::MixFingerprint(
+                  fingerprints[l], word_of(offset[i] + l + ilayer));
+              fingerprint = fingerprints[l];
+            }
+            get_term((const float*)(bottom_data + offset[i] + l), ilayer + 1,
+                     fingerprint);
+            if (term.use_term) {
               if (_is_training != 0) {
                 unsigned int rand_val = rand_r(&_seed);
                 float rate = static_cast<float>(rand_val) / (RAND_MAX);
@@ -330,6 +488,10 @@ class CPUPyramidHashOPKernel : public framework::OpKernel<T> {
               } else {
                 *(iter_end++) = 1;
               }
+              if (*(iter_end - 1) == 1) {
+                term_pos.insert(term_pos.end(), term.pos.begin(),
+                                term.pos.end());
+              }
             } else {
               *(iter_end++) = 0;
             }
@@ -357,6 +519,7 @@ class CPUPyramidHashOPKernel : public framework::OpKernel<T> {
     drop_pos->set_lod(drop_pos_lod);
 
     iter = drop_pos->mutable_data<int>(ctx.GetPlace());
+    const uint32_t* pos_iter = term_pos.data();
     int top_counter = 0;
     for (size_t i = 0; i < offset.size() - 1; ++i) {
       int w_drop = drop_pos_offset[i + 1] - drop_pos_offset[i];
@@ -381,9 +544,9 @@ class CPUPyramidHashOPKernel : public framework::OpKernel<T> {
               // do nothing
             } else {
               auto* top_pos = top_data + top_counter++ * _num_emb;
-              hash_embedding_ff((const float*)(bottom_data + offset[i] + l),
-                                ilayer + 1, top_pos, weights, _num_emb,
-                                _rand_len, _space_len);
+              hash_embedding_ff(pos_iter, top_pos, weights, _num_emb,
+                                _rand_len);
+              pos_iter += num_pos;
             }
           }
         }
@@ -457,10 +620,11 @@ class CPUPyramidHashOPGradKernel : public framework::OpKernel<T> {
  public:
   void hash_embedding_bp(const T* hash_id, int len, const T* top_pos,
                          T* weights, T mlr, int _num_emb, int _rand_len,
-                         int _space_len) const {
-    for (int j = 0; j != _num_emb; j += _rand_len) {
-      unsigned int pos = XXH32(hash_id, len * sizeof(T), j) % _space_len;
-      axpy(top_pos + j, weights + pos, _rand_len, mlr);
+                         int _space_len, const std::vector<uint32_t>& seeds,
+                         uint32_t* pos) const {
+    PyramidHashPositions(hash_id, len, seeds, _space_len, pos);
+    for (int j = 0, k = 0; j != _num_emb; j += _rand_len, ++k) {
+      axpy(top_pos + j, weights + pos[k], _rand_len, mlr);
     }
   }
 
@@ -494,6 +658,8 @@ class CPUPyramidHashOPGradKernel : public framework::OpKernel<T> {
     T mlr = -1.0 * _lr;
 
     const int* iter = drop_pos->data<int>();
+    auto seeds = PyramidHashSeeds(_num_emb, _rand_len);
+    std::vector<uint32_t> pos(seeds.size());
     int top_counter = 0;
     for (size_t i = 0; i < offset.size() - 1; ++i) {
       int w = offset[i + 1] - offset[i];
@@ -510,7 +676,7 @@ class CPUPyramidHashOPGradKernel : public framework::OpKernel<T> {
               const T* top_pos = top_diff + top_counter++ * _num_emb;
               hash_embedding_bp((const T*)(bottom_data + offset[i] + l),
                                 ilayer + 1, top_pos, weights, mlr, _num_emb,
-                                _rand_len, _space_len);
+                                _rand_len, _space_len, seeds, pos.data());
             }
           }
         }
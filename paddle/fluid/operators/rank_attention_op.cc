@@ -132,7 +132,7 @@ class RankAttentionOpMaker : public framework::OpProtoAndCheckerMaker {
     AddComment(R"DOC(
 RankAttention Operator.
 This Op can calculate rank attention between input and rank_param, 
-and rank_param gives the organization of data. Notice: It currently supports GPU device.
+and rank_param gives the organization of data.
 This Op exists in contrib, which means that it is not shown to the public.
 )DOC");
   }
@@ -180,6 +180,12 @@ REGISTER_OP_CPU_KERNEL(
     ops::RankAttentionKernel<paddle::platform::CPUDeviceContext, float>,
     ops::RankAttentionKernel<paddle::platform::CPUDeviceContext, double>);
 
+REGISTER_OP_CPU_KERNEL(
+    rank_attention_grad,
+    ops::RankAttentionGradOpKernel<paddle::platform::CPUDeviceContext, float>,
+    ops::RankAttentionGradOpKernel<paddle::platform::CPUDeviceContext,
+                                   double>);
+
 REGISTER_OP_VERSION(rank_attention)
     .AddCheckpoint(
         R"ROC(
@@ -13,20 +13,250 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <algorithm>
+#include <vector>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/blas.h"
 
 namespace paddle {
 namespace operators {
 
+using framework::Tensor;
+
+/*
+ * The CPU kernel does not expand the parameter of each instance as the GPU
+ * one does, which needs ins_num * max_rank * x_fea_dim * para_col elements.
+ * The rows of the instances are instead grouped by the block of RankParam
+ * they are multiplied with, so each block is read once, by one GEMM of all
+ * its rows.
+ */
 template <typename DeviceContext, typename T>
 class RankAttentionKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_ENFORCE_EQ(platform::is_gpu_place(ctx.GetPlace()), true,
-                      platform::errors::Unimplemented(
-                          "Rank Attention only supports GPU now."));
+    auto* X = ctx.Input<Tensor>("X");
+    auto* rank_offset = ctx.Input<Tensor>("RankOffset");
+    auto* param = ctx.Input<Tensor>("RankParam");
+    auto* input_help = ctx.Output<Tensor>("InputHelp");
+    auto* ins_rank = ctx.Output<Tensor>("InsRank");
+    int max_rank = ctx.Attr<int>("MaxRank");
+    int64_t max_size = ctx.Attr<int>("MaxSize");
+    auto* Out = ctx.Output<Tensor>("Out");
+
+    // check dims
+    auto x_dims = X->dims();
+    int64_t ins_num = x_dims[0];
+    int64_t x_fea_dim = x_dims[1];
+    auto para_dims = param->dims();
+    int64_t para_row = para_dims[0];
+    int64_t para_col = para_dims[1];
+    auto rank_offset_dims = rank_offset->dims();
+    PADDLE_ENFORCE_EQ(
+        rank_offset_dims[0], ins_num,
+        platform::errors::InvalidArgument("Input(RankOffset) has wrong rows."));
+    PADDLE_ENFORCE_EQ((rank_offset_dims[1] - 1) / 2, max_rank,
+                      platform::errors::InvalidArgument(
+                          "Input(RankOffset) has wrong columns."));
+    PADDLE_ENFORCE_EQ(
+        max_rank * max_rank * x_fea_dim, para_row,
+        platform::errors::InvalidArgument("Input(RankParam) has wrong rows."));
+
+    int64_t block_matrix_row = max_rank * x_fea_dim;
+    int64_t max_ins = std::max(ins_num, max_size);
+    int64_t offset_col = rank_offset_dims[1];
+    int num_blocks = max_rank * max_rank;
+    const int* offset_data = rank_offset->data<int>();
+    const T* x_data = X->data<T>();
+
+    // Count the rows of each block of RankParam: the k-th block of the
+    // instance i is multiplied with the block lower * max_rank + faster.
+    std::vector<int64_t> block_begin(num_blocks + 1, 0);
+    for (int64_t i = 0; i < ins_num; ++i) {
+      const int* offset = offset_data + i * offset_col;
+      int lower = offset[0] - 1;
+      if (lower < 0) continue;
+      PADDLE_ENFORCE_LT(lower, max_rank,
+                        platform::errors::InvalidArgument(
+                            "The rank of the instance %d should be less than "
+                            "or equal to MaxRank %d, but got %d.",
+                            i, max_rank, offset[0]));
+      for (int k = 0; k < max_rank; ++k) {
+        int faster = offset[2 * k + 1] - 1;
+        if (faster < 0) continue;
+        PADDLE_ENFORCE_LT(faster, max_rank,
+                          platform::errors::InvalidArgument(
+                              "The rank %d of the instance %d should be less "
+                              "than or equal to MaxRank %d.",
+                              offset[2 * k + 1], i, max_rank));
+        int index = offset[2 * k + 2];
+        PADDLE_ENFORCE_EQ(index >= 0 && index < ins_num, true,
+                          platform::errors::InvalidArgument(
+                              "The index %d in Input(RankOffset) is out of "
+                              "the range [0, %d).",
+                              index, ins_num));
+        ++block_begin[lower * max_rank + faster + 1];
+      }
+    }
+    for (int b = 0; b < num_blocks; ++b) {
+      block_begin[b + 1] += block_begin[b];
+    }
+    int64_t num_rows = block_begin[num_blocks];
+    std::vector<int64_t> out_rows(num_rows);
+    std::vector<int64_t> x_rows(num_rows);
+    std::vector<int64_t> next(block_begin.begin(), block_begin.end() - 1);
+
+    if (input_help) {
+      input_help->Resize({max_ins, block_matrix_row});
+      T* input_help_data = input_help->mutable_data<T>(ctx.GetPlace());
+      std::fill(input_help_data, input_help_data + max_ins * block_matrix_row,
+                static_cast<T>(0));
+    }
+    if (ins_rank) {
+      ins_rank->Resize({max_ins, 1});
+      T* ins_rank_data = ins_rank->mutable_data<T>(ctx.GetPlace());
+      std::fill(ins_rank_data, ins_rank_data + max_ins, static_cast<T>(-1));
+      for (int64_t i = 0; i < ins_num; ++i) {
+        ins_rank_data[i] = static_cast<T>(offset_data[i * offset_col]);
+      }
+    }
+    for (int64_t i = 0; i < ins_num; ++i) {
+      const int* offset = offset_data + i * offset_col;
+      int lower = offset[0] - 1;
+      if (lower < 0) continue;
+      for (int k = 0; k < max_rank; ++k) {
+        int faster = offset[2 * k + 1] - 1;
+        if (faster < 0) continue;
+        int64_t index = offset[2 * k + 2];
+        int64_t pos = next[lower * max_rank + faster]++;
+        out_rows[pos] = i;
+        x_rows[pos] = index;
+        if (input_help) {
+          const T* src = x_data + index * x_fea_dim;
+          std::copy(src, src + x_fea_dim,
+                    input_help->data<T>() + i * block_matrix_row +
+                        k * x_fea_dim);
+        }
+      }
+    }
+
+    T* out_data = Out->mutable_data<T>(ctx.GetPlace());
+    std::fill(out_data, out_data + ins_num * para_col, static_cast<T>(0));
+    int64_t max_block_rows = 0;
+    for (int b = 0; b < num_blocks; ++b) {
+      max_block_rows =
+          std::max(max_block_rows, block_begin[b + 1] - block_begin[b]);
+    }
+    if (max_block_rows == 0) return;
+
+    auto& dev_ctx = ctx.template device_context<DeviceContext>();
+    Tensor block_in = ctx.AllocateTmpTensor<T, DeviceContext>(
+        {max_block_rows, x_fea_dim}, dev_ctx);
+    Tensor block_out = ctx.AllocateTmpTensor<T, DeviceContext>(
+        {max_block_rows, para_col}, dev_ctx);
+    T* block_in_data = block_in.data<T>();
+    T* block_out_data = block_out.data<T>();
+    const T* param_data = param->data<T>();
+    auto blas = math::GetBlas<DeviceContext, T>(dev_ctx);
+    for (int b = 0; b < num_blocks; ++b) {
+      int64_t begin = block_begin[b];
+      int64_t rows = block_begin[b + 1] - begin;
+      if (rows == 0) continue;
+      for (int64_t r = 0; r < rows; ++r) {
+        const T* src = x_data + x_rows[begin + r] * x_fea_dim;
+        std::copy(src, src + x_fea_dim, block_in_data + r * x_fea_dim);
+      }
+      blas.GEMM(CblasNoTrans, CblasNoTrans, rows, para_col, x_fea_dim,
+                static_cast<T>(1), block_in_data,
+                param_data + b * x_fea_dim * para_col, static_cast<T>(0),
+                block_out_data);
+      for (int64_t r = 0; r < rows; ++r) {
+        T* dst = out_data + out_rows[begin + r] * para_col;
+        const T* src = block_out_data + r * para_col;
+        for (int64_t c = 0; c < para_col; ++c) {
+          dst[c] += src[c];
+        }
+      }
+    }
+  }
+};
+
+/*
+ * As the GPU kernel, the grad of the k-th block of the instances of rank r
+ * is accumulated to the block (r - 1) * max_rank + k of RankParam, from
+ * InputHelp and InsRank, for X and RankOffset have no buffer here. The
+ * instances of a rank are gathered, so its max_rank blocks take one GEMM.
+ */
+template <typename DeviceContext, typename T>
+class RankAttentionGradOpKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto* X = ctx.Input<Tensor>("X");                     // not use data
+    auto* rank_offset = ctx.Input<Tensor>("RankOffset");  // not use data
+    auto* param = ctx.Input<Tensor>("RankParam");         // not use data
+    auto* input_help = ctx.Input<Tensor>("InputHelp");
+    auto* ins_rank = ctx.Input<Tensor>("InsRank");
+    auto* dout = ctx.Input<Tensor>(framework::GradVarName("Out"));
+    auto* drank_para = ctx.Output<Tensor>(framework::GradVarName("RankParam"));
+
+    int64_t ins_num = X->dims()[0];
+    int64_t x_fea_dim = X->dims()[1];
+    int64_t para_col = param->dims()[1];
+    int max_rank = (rank_offset->dims()[1] - 1) / 2;
+    int64_t block_matrix_row = max_rank * x_fea_dim;
+
+    T* drank_para_data = drank_para->mutable_data<T>(ctx.GetPlace());
+    std::fill(drank_para_data, drank_para_data + drank_para->numel(),
+              static_cast<T>(0));
+
+    const T* ins_rank_data = ins_rank->data<T>();
+    std::vector<int64_t> rank_begin(max_rank + 1, 0);
+    for (int64_t i = 0; i < ins_num; ++i) {
+      int lower = static_cast<int>(ins_rank_data[i]) - 1;
+      if (lower >= 0 && lower < max_rank) ++rank_begin[lower + 1];
+    }
+    int64_t max_rank_rows = 0;
+    for (int r = 0; r < max_rank; ++r) {
+      max_rank_rows = std::max(max_rank_rows, rank_begin[r + 1]);
+      rank_begin[r + 1] += rank_begin[r];
+    }
+    if (max_rank_rows == 0) return;
+    std::vector<int64_t> rows_of_rank(rank_begin[max_rank]);
+    std::vector<int64_t> next(rank_begin.begin(), rank_begin.end() - 1);
+    for (int64_t i = 0; i < ins_num; ++i) {
+      int lower = static_cast<int>(ins_rank_data[i]) - 1;
+      if (lower >= 0 && lower < max_rank) rows_of_rank[next[lower]++] = i;
+    }
+
+    auto& dev_ctx = ctx.template device_context<DeviceContext>();
+    Tensor rank_in = ctx.AllocateTmpTensor<T, DeviceContext>(
+        {max_rank_rows, block_matrix_row}, dev_ctx);
+    Tensor rank_dout = ctx.AllocateTmpTensor<T, DeviceContext>(
+        {max_rank_rows, para_col}, dev_ctx);
+    T* rank_in_data = rank_in.data<T>();
+    T* rank_dout_data = rank_dout.data<T>();
+    const T* input_help_data = input_help->data<T>();
+    const T* dout_data = dout->data<T>();
+    auto blas = math::GetBlas<DeviceContext, T>(dev_ctx);
+    for (int r = 0; r < max_rank; ++r) {
+      int64_t begin = rank_begin[r];
+      int64_t rows = rank_begin[r + 1] - begin;
+      if (rows == 0) continue;
+      for (int64_t j = 0; j < rows; ++j) {
+        int64_t i = rows_of_rank[begin + j];
+        std::copy(input_help_data + i * block_matrix_row,
+                  input_help_data + (i + 1) * block_matrix_row,
+                  rank_in_data + j * block_matrix_row);
+        std::copy(dout_data + i * para_col, dout_data + (i + 1) * para_col,
+                  rank_dout_data + j * para_col);
+      }
+      blas.GEMM(CblasTrans, CblasNoTrans, block_matrix_row, para_col, rows,
+                static_cast<T>(1), rank_in_data, rank_dout_data,
+                static_cast<T>(0),
+                drank_para_data + r * block_matrix_row * para_col);
+    }
   }
 };
+
 }  // namespace operators
 }  // namespace paddle
@@ -15,6 +15,7 @@ limitations under the License. */
 #include <string>
 
 #include "paddle/fluid/operators/save_combine_op.h"
+#include "paddle/fluid/framework/op_version_registry.h"
 
 namespace paddle {
 namespace operators {
@@ -79,6 +80,19 @@ to a file on disk.
               "(RAW, default empty)."
               "This output is used when saving variables to binary strings.")
         .AsDispensable();
+    AddAttr<bool>("use_chunked_format",
+                  "(boolean, default false)"
+                  "If true, the variables will be saved in the chunked "
+                  "checkpoint format, which indexes every tensor in a header "
+                  "and writes the data blocks in parallel. It is ignored when "
+                  "save_to_memory is true.")
+        .SetDefault(false);
+    AddAttr<bool>("async_save",
+                  "(boolean, default false)"
+                  "If true and use_chunked_format is true, the operator "
+                  "returns once the variables are snapshotted, and the file "
+                  "is written in the background.")
+        .SetDefault(false);
   }
 };
 
@@ -106,3 +120,14 @@ REGISTER_OP_CPU_KERNEL(
                              paddle::platform::bfloat16>,
     ops::SaveCombineOpKernel<paddle::platform::CPUDeviceContext, int>,
     ops::SaveCombineOpKernel<paddle::platform::CPUDeviceContext, int64_t>);
+
+REGISTER_OP_VERSION(save_combine)
+    .AddCheckpoint(
+        R"ROC(
+              Upgrade save_combine, add the chunked checkpoint format)ROC",
+        paddle::framework::compatible::OpVersionDesc()
+            .NewAttr("use_chunked_format",
+                     "Save the variables in the chunked checkpoint format.",
+                     false)
+            .NewAttr("async_save",
+                     "Write the chunked checkpoint in the background.", false));
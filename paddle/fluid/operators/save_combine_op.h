@@ -27,6 +27,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/string_array.h"
+#include "paddle/fluid/framework/tensor_checkpoint.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/pten/backends/dynload/port.h"
 
@@ -41,8 +42,14 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     auto overwrite = ctx.Attr<bool>("overwrite");
     auto save_as_fp16 = ctx.Attr<bool>("save_as_fp16");
     auto save_to_memory = ctx.Attr<bool>("save_to_memory");
+    auto chunked = ctx.Attr<bool>("use_chunked_format") && !save_to_memory;
+    auto async_save = ctx.Attr<bool>("async_save");
     auto output = ctx.Output<std::string>("Y");
 
+    // a pending async save of the same file must land before the overwrite
+    // check and before it is written again
+    if (chunked) framework::WaitTensorCheckpoint(filename);
+
     bool is_present = FileExists(filename);
     if (is_present && !overwrite) {
       PADDLE_THROW(platform::errors::PreconditionNotMet(
@@ -64,6 +71,11 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     platform::DeviceContextPool &pool = platform::DeviceContextPool::Instance();
     auto &dev_ctx = *pool.Get(place);
 
+    std::unique_ptr<framework::TensorCheckpointWriter> writer;
+    if (chunked) {
+      writer.reset(new framework::TensorCheckpointWriter(filename));
+    }
+
     for (size_t i = 0; i < inp_var_names.size(); i++) {
       PADDLE_ENFORCE_NOT_NULL(
           inp_vars[i],
@@ -98,11 +110,22 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
           out.set_lod(tensor.lod());
           framework::TransDataType(in_kernel_type, out_kernel_type, tensor,
                                    &out);
-          framework::SerializeToStream(ss, out, dev_ctx);
+          if (writer) {
+            writer->Add(inp_var_names[i], out, dev_ctx);
+          } else {
+            framework::SerializeToStream(ss, out, dev_ctx);
+          }
+        } else if (writer) {
+          writer->Add(inp_var_names[i], tensor, dev_ctx);
         } else {
           framework::SerializeToStream(ss, tensor, dev_ctx);
         }
       } else {
+        PADDLE_ENFORCE_EQ(chunked, false,
+                          platform::errors::Unimplemented(
+                              "The chunked checkpoint format does not support "
+                              "saving Vocab variable %s.",
+                              inp_var_names[i]));
         auto &tensor = inp_vars[i]->Get<framework::Vocab>();
         std::unordered_map<std::string, std::int32_t> data;
         for (auto it = tensor.begin(); it != tensor.end(); ++it) {
@@ -113,7 +136,17 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
         framework::StringMapToStream(ss, data);
       }
     }
-    if (save_to_memory) {
+    if (chunked) {
+      MkDirRecursively(DirName(filename).c_str());
+      if (async_save) {
+        // the tensors are snapshotted already, training goes on while the
+        // checkpoint is flushed in the background
+        framework::SaveTensorCheckpointAsync(std::move(writer), filename);
+      } else {
+        writer->FlushAsync();
+        writer->Wait();
+      }
+    } else if (save_to_memory) {
       PADDLE_ENFORCE_NE(output, nullptr,
                         platform::errors::InvalidArgument(
                             "Cannot find variable Y for save_combine_op"));
@@ -352,3 +352,54 @@ TEST(SaveLoadTestWithCombineOp, CPU) {
     }
   }
 }
+
+// Save with the chunked checkpoint format in the background, then load all
+// tensors in order and a single one by name.
+TEST(SaveLoadCombineChunkedOp, CPU) {
+  paddle::framework::Scope scope;
+  paddle::platform::CPUPlace place;
+
+  std::vector<int> lod1 = {0, 1, 2, 3, 10};
+  int numel1 = 100;
+  paddle::framework::LoD expect_lod1;
+  int* expect1 = CreateForSaveCombineOp<int, int>(10, 10, lod1, "test_var1",
+                                                  place, &scope, &expect_lod1);
+
+  std::vector<int> lod2 = {0, 2, 5, 10};
+  int numel2 = 200;
+  paddle::framework::LoD expect_lod2;
+  int* expect2 = CreateForSaveCombineOp<int, int>(10, 20, lod2, "test_var2",
+                                                  place, &scope, &expect_lod2);
+
+  paddle::framework::AttributeMap attrs;
+  attrs.insert({"file_path", std::string("check_tensor_chunked.ls")});
+  attrs.insert({"use_chunked_format", true});
+  attrs.insert({"async_save", true});
+
+  auto save_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "save_combine", {{"X", {"test_var1", "test_var2"}}}, {}, attrs);
+  save_combine_op->Run(scope, place);
+
+  auto target1 = GeneratePlaceholderBeforeLoad("out_var1", &scope);
+  auto target2 = GeneratePlaceholderBeforeLoad("out_var2", &scope);
+  // load_combine waits for the pending save of the same file
+  auto load_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "load_combine", {}, {{"Out", {"out_var1", "out_var2"}}}, attrs);
+  load_combine_op->Run(scope, place);
+
+  paddle::framework::LoD actual_lod1, actual_lod2;
+  int* actual1 = GetValuesAfterLoadCombineOp<int>(target1, scope, &actual_lod1);
+  int* actual2 = GetValuesAfterLoadCombineOp<int>(target2, scope, &actual_lod2);
+  CheckValues<int, int>(expect1, actual1, expect_lod1, actual_lod1, numel1);
+  CheckValues<int, int>(expect2, actual2, expect_lod2, actual_lod2, numel2);
+
+  paddle::framework::Scope load_scope;
+  auto target = GeneratePlaceholderBeforeLoad("test_var2", &load_scope);
+  auto load_one_op = paddle::framework::OpRegistry::CreateOp(
+      "load_combine", {}, {{"Out", {"test_var2"}}}, attrs);
+  load_one_op->Run(load_scope, place);
+  paddle::framework::LoD actual_lod;
+  int* actual =
+      GetValuesAfterLoadCombineOp<int>(target, load_scope, &actual_lod);
+  CheckValues<int, int>(expect2, actual, expect_lod2, actual_lod, numel2);
+}
@@ -13,10 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <cstring>
 #include <numeric>  // std::iota
 
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/memory/memcpy.h"
+#include "paddle/fluid/operators/math/lod_segment.h"
 #include "paddle/pten/kernels/funcs/math_function.h"
 
 namespace paddle {
@@ -52,31 +54,30 @@ struct SequenceExpandFunctor<platform::CPUDeviceContext, T> {
       const framework::Vector<size_t>& x_lod,   /*expand source lod*/
       const framework::Vector<size_t>& ref_lod, /*expand referenced lod*/
       LoDTensor* out) {
-    int out_offset = 0;
-    int x_item_length = x.numel() / x.dims()[0];
+    int64_t x_item_length = x.numel() / x.dims()[0];
     auto out_data = out->data<T>();
     auto x_data = x.data<T>();
-    for (size_t i = 1; i < ref_lod.size(); ++i) {
-      int repeat_num = ref_lod[i] - ref_lod[i - 1];
-      int x_start = x_lod[i - 1];
-      int x_end = x_lod[i];
-      int x_seq_len = x_end - x_start;
-      if (repeat_num > 0) {
-        int out_start = out_offset;
-        if (out->lod().size() == 1) {
-          out_start = out->lod()[0][out_offset];
-        }
-        for (int j = 0; j < repeat_num; j++) {
-          for (int k = 0; k < x_seq_len; k++) {
-            for (int l = 0; l < x_item_length; l++) {
-              out_data[(out_start + j * x_seq_len + k) * x_item_length + l] =
-                  x_data[(x_start + k) * x_item_length + l];
-            }
-          }
-        }
+    const size_t* x_offsets = x_lod.data();
+    const size_t* out_offsets =
+        out->lod().size() == 1 ? out->lod()[0].data() : nullptr;
+    size_t ref_begin = ref_lod[0];
+    // Each sequence of x is copied to the rows of its repeats in out.
+    math::ForEachLoDSegment(ref_lod, x_item_length, [&](size_t i,
+                                                        size_t begin,
+                                                        size_t end) {
+      size_t repeat_num = end - begin;
+      if (repeat_num == 0) return;
+      size_t x_start = x_offsets[i];
+      size_t x_seq_len = x_offsets[i + 1] - x_start;
+      size_t out_offset = begin - ref_begin;
+      size_t out_start = out_offsets ? out_offsets[out_offset] : out_offset;
+      size_t seq_numel = x_seq_len * x_item_length;
+      const T* src = x_data + x_start * x_item_length;
+      T* dst = out_data + out_start * x_item_length;
+      for (size_t j = 0; j < repeat_num; j++) {
+        std::memcpy(dst + j * seq_numel, src, seq_numel * sizeof(T));
       }
-      out_offset += repeat_num;
-    }
+    });
   }
 };
 
@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/lod_segment.h"
 
 namespace paddle {
 namespace operators {
@@ -43,19 +44,29 @@ struct SequenceSoftmaxFunctor<platform::CPUDeviceContext, T> {
   void operator()(const platform::CPUDeviceContext &ctx, const LoDTensor &x,
                   const framework::Vector<size_t> &ref_lod, /*referenced lod*/
                   LoDTensor *out) {
-    size_t height = ref_lod.size() - 1;
     const T *in_data = x.data<T>();
     T *out_data = out->mutable_data<T>(ctx.GetPlace());
-    for (size_t i = 0; i < height; ++i) {
-      size_t span = ref_lod[i + 1] - ref_lod[i];
+    math::ForEachLoDSegment(ref_lod, 1, [&](size_t i, size_t begin,
+                                            size_t end) {
+      if (begin == end) return;
+      const T *in = in_data + begin;
+      T *seq_out = out_data + begin;
+      size_t span = end - begin;
+      // Subtract the max so that exp doesn't overflow.
+      T max_value = in[0];
+      for (size_t j = 1; j < span; ++j) {
+        max_value = in[j] > max_value ? in[j] : max_value;
+      }
       T result = 0;
       for (size_t j = 0; j < span; ++j) {
-        result += exp(in_data[ref_lod[i] + j]);
+        seq_out[j] = exp(in[j] - max_value);
+        result += seq_out[j];
       }
+      T scale = static_cast<T>(1) / result;
       for (size_t j = 0; j < span; ++j) {
-        out_data[ref_lod[i] + j] = exp(in_data[ref_lod[i] + j]) / result;
+        seq_out[j] *= scale;
       }
-    }
+    });
   }
 };
 
@@ -65,24 +76,21 @@ struct SequenceSoftmaxGradFunctor<platform::CPUDeviceContext, T> {
                   const LoDTensor &out,
                   const framework::Vector<size_t> &ref_lod, /*referenced lod*/
                   LoDTensor *dx) {
-    size_t height = ref_lod.size() - 1;
-
     const T *softmax_grad_data = dout.data<T>();
     const T *softmax = out.data<T>();
     T *dx_data = dx->mutable_data<T>(ctx.GetPlace());
 
-    for (size_t i = 0; i < height; ++i) {
-      size_t span = ref_lod[i + 1] - ref_lod[i];
+    math::ForEachLoDSegment(ref_lod, 1, [&](size_t i, size_t begin,
+                                            size_t end) {
       T result = 0;
-      for (size_t j = 0; j < span; ++j) {
-        result += softmax_grad_data[ref_lod[i] + j] * softmax[ref_lod[i] + j];
+      for (size_t j = begin; j < end; ++j) {
+        result += softmax_grad_data[j] * softmax[j];
       }
 
-      for (size_t j = 0; j < span; ++j) {
-        dx_data[ref_lod[i] + j] = (softmax_grad_data[ref_lod[i] + j] - result) *
-                                  softmax[ref_lod[i] + j];
+      for (size_t j = begin; j < end; ++j) {
+        dx_data[j] = (softmax_grad_data[j] - result) * softmax[j];
       }
-    }
+    });
   }
 };
 
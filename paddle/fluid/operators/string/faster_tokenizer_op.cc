@@ -14,8 +14,10 @@ limitations under the License. */
 #include <algorithm>
 #include <chrono>
 #include <codecvt>
+#include <functional>
 #include <fstream>
 #include <iostream>
+#include <mutex>  // NOLINT
 #include <numeric>
 #include <string>
 #include <unordered_map>
@@ -438,6 +440,421 @@ void BertTokenizer::BatchEncode(
   }
 }
 
+void DoubleArrayTrie::Build(vector<std::pair<string, int32_t>> keys) {
+  std::sort(keys.begin(), keys.end());
+
+  // Build a plain trie first, the children of a node are sorted by byte
+  // since the keys are sorted.
+  struct Node {
+    vector<std::pair<uint8_t, int>> children;
+    int32_t value{-1};
+  };
+  vector<Node> nodes(1);
+  for (auto& key : keys) {
+    int cur = 0;
+    for (char ch : key.first) {
+      uint8_t c = static_cast<uint8_t>(ch);
+      auto& children = nodes[cur].children;
+      if (children.empty() || children.back().first != c) {
+        children.emplace_back(c, static_cast<int>(nodes.size()));
+        nodes.emplace_back();
+      }
+      cur = nodes[cur].children.back().second;
+    }
+    nodes[cur].value = key.second;
+  }
+
+  // Place the children of every node at the first base where all of them
+  // find a free unit, in breadth first order.
+  base_.assign(256, 0);
+  check_.assign(256, -1);
+  value_.assign(256, -1);
+  value_[kRoot] = nodes[0].value;
+  size_t first_free = 1;
+  vector<std::pair<int, int>> queue = {{0, kRoot}};
+  for (size_t head = 0; head < queue.size(); ++head) {
+    const auto& children = nodes[queue[head].first].children;
+    int unit = queue[head].second;
+    if (children.empty()) continue;
+
+    while (first_free < check_.size() && check_[first_free] >= 0) {
+      ++first_free;
+    }
+    size_t base = first_free > children[0].first
+                      ? first_free - children[0].first
+                      : 1;
+    while (true) {
+      if (base + 256 > check_.size()) {
+        size_t size = std::max(check_.size() * 2, base + 256);
+        base_.resize(size, 0);
+        check_.resize(size, -1);
+        value_.resize(size, -1);
+      }
+      bool fits = true;
+      for (auto& child : children) {
+        if (check_[base + child.first] >= 0) {
+          fits = false;
+          break;
+        }
+      }
+      if (fits) break;
+      ++base;
+    }
+
+    base_[unit] = static_cast<int32_t>(base);
+    for (auto& child : children) {
+      size_t t = base + child.first;
+      check_[t] = unit;
+      value_[t] = nodes[child.second].value;
+      queue.emplace_back(child.second, static_cast<int>(t));
+    }
+  }
+
+  size_t size = check_.size();
+  while (size > 1 && check_[size - 1] < 0) --size;
+  base_.resize(size);
+  check_.resize(size);
+  value_.resize(size);
+}
+
+int DoubleArrayTrie::Find(int node, const char* begin, const char* end) const {
+  for (const char* p = begin; p != end && node >= 0; ++p) {
+    node = Next(node, static_cast<uint8_t>(*p));
+  }
+  return node;
+}
+
+size_t DoubleArrayTrie::LongestPrefix(int node, const char* begin,
+                                      const char* end, int32_t* value) const {
+  size_t matched = 0;
+  for (const char* p = begin; p != end; ++p) {
+    node = Next(node, static_cast<uint8_t>(*p));
+    if (node < 0) break;
+    if (value_[node] >= 0) {
+      matched = p - begin + 1;
+      *value = value_[node];
+    }
+  }
+  return matched;
+}
+
+TrieBertTokenizer::TrieBertTokenizer(
+    const framework::Vocab& vocab, const wstring& unk_token /* = L"[UNK]" */,
+    const wstring& pad_token /* = L"[PAD]" */,
+    const wstring& cls_token /* = L"[CLS]" */,
+    const wstring& sep_token /* = L"[SEP]" */,
+    const size_t max_input_chars_per_word /* = 100 */)
+    : max_input_chars_per_word_(max_input_chars_per_word) {
+  vector<std::pair<string, int32_t>> keys;
+  keys.reserve(vocab.size());
+  for (auto& item : vocab) {
+    string key;
+    framework::ConvertWstrToStr(item.first, &key);
+    keys.emplace_back(std::move(key), item.second);
+  }
+  trie_.Build(std::move(keys));
+  suffix_root_ = trie_.Find(DoubleArrayTrie::kRoot, "##", "##" + 2);
+
+  auto token_id = [&](const wstring& token) -> int64_t {
+    auto iter = vocab.find(token);
+    PADDLE_ENFORCE_NE(iter, vocab.end(),
+                      platform::errors::NotFound(
+                          "The special token is not found in the vocab."));
+    return iter->second;
+  };
+  unk_token_id_ = token_id(unk_token);
+  pad_token_id_ = token_id(pad_token);
+  cls_token_id_ = token_id(cls_token);
+  sep_token_id_ = token_id(sep_token);
+}
+
+std::shared_ptr<const TrieBertTokenizer> TrieBertTokenizer::Get(
+    const framework::Vocab* vocab) {
+  struct CacheEntry {
+    // the contents the tokenizer was built from
+    framework::Vocab vocab;
+    std::shared_ptr<const TrieBertTokenizer> tokenizer;
+  };
+  static std::mutex mutex;
+  static unordered_map<const framework::Vocab*,
+                       std::shared_ptr<const CacheEntry>>
+      entries;
+  std::shared_ptr<const CacheEntry> entry;
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto iter = entries.find(vocab);
+    if (iter != entries.end()) entry = iter->second;
+  }
+  // The holder may have been reloaded or freed and reused since, so a hit
+  // is only taken if the contents are still the same.
+  if (entry && entry->vocab.size() == vocab->size() &&
+      entry->vocab == *vocab) {
+    return entry->tokenizer;
+  }
+  auto new_entry = std::make_shared<CacheEntry>();
+  new_entry->vocab = *vocab;
+  new_entry->tokenizer = std::make_shared<TrieBertTokenizer>(*vocab);
+  std::lock_guard<std::mutex> guard(mutex);
+  // A few vocabs are used by one process, drop them all if there are more.
+  if (entries.size() >= 16 && entries.count(vocab) == 0) entries.clear();
+  entries[vocab] = new_entry;
+  return new_entry->tokenizer;
+}
+
+void TrieBertTokenizer::WordPiece(const char* word, size_t len,
+                                  size_t num_chars,
+                                  vector<int64_t>* ids) const {
+  if (num_chars > max_input_chars_per_word_) {
+    ids->emplace_back(unk_token_id_);
+    return;
+  }
+  size_t num_ids = ids->size();
+  size_t start = 0;
+  while (start < len) {
+    int node = start == 0 ? DoubleArrayTrie::kRoot : suffix_root_;
+    int32_t value = -1;
+    size_t matched =
+        node < 0 ? 0
+                 : trie_.LongestPrefix(node, word + start, word + len, &value);
+    if (matched == 0) {
+      // The whole word is unknown if any piece of it is.
+      ids->resize(num_ids);
+      ids->emplace_back(unk_token_id_);
+      return;
+    }
+    ids->emplace_back(value);
+    start += matched;
+  }
+}
+
+bool TrieBertTokenizer::Tokenize(const string& text, bool do_lower_case,
+                                 vector<int64_t>* ids) const {
+  // The current word, lower cased and encoded in UTF-8 again.
+  thread_local string word;
+  word.clear();
+  size_t word_chars = 0;
+  auto push_word = [&]() {
+    if (!word.empty()) {
+      WordPiece(word.data(), word.size(), word_chars, ids);
+      word.clear();
+      word_chars = 0;
+    }
+  };
+
+  auto* ptr = reinterpret_cast<const utf8proc_uint8_t*>(text.data());
+  utf8proc_ssize_t remain = text.size();
+  utf8proc_uint8_t buf[4];
+  while (remain > 0) {
+    utf8proc_int32_t codepoint;
+    utf8proc_ssize_t n = utf8proc_iterate(ptr, remain, &codepoint);
+    if (n <= 0) return false;
+    ptr += n;
+    remain -= n;
+
+    wchar_t ch = codepoint;
+    if (ch == 0 || ch == 0xfffd || IsControl(ch)) {
+      continue;
+    }
+    if (do_lower_case) {
+      ch = utf8proc_tolower(ch);
+    }
+    if (IsChineseChar(ch) || IsPunctuation(ch)) {
+      push_word();
+      n = utf8proc_encode_char(ch, buf);
+      WordPiece(reinterpret_cast<const char*>(buf), n, 1, ids);
+    } else if (IsWhiteSpace(ch)) {
+      push_word();
+    } else {
+      n = utf8proc_encode_char(ch, buf);
+      word.append(reinterpret_cast<const char*>(buf), n);
+      ++word_chars;
+    }
+  }
+  push_word();
+  return true;
+}
+
+bool TrieBertTokenizer::LookupChars(const string& text,
+                                    vector<int64_t>* ids) const {
+  const char* ptr = text.data();
+  utf8proc_ssize_t remain = text.size();
+  while (remain > 0) {
+    utf8proc_int32_t codepoint;
+    utf8proc_ssize_t n = utf8proc_iterate(
+        reinterpret_cast<const utf8proc_uint8_t*>(ptr), remain, &codepoint);
+    if (n <= 0) return false;
+    int node = trie_.Find(DoubleArrayTrie::kRoot, ptr, ptr + n);
+    int32_t value = node < 0 ? -1 : trie_.Value(node);
+    ids->emplace_back(value < 0 ? unk_token_id_ : value);
+    ptr += n;
+    remain -= n;
+  }
+  return true;
+}
+
+bool TrieBertTokenizer::EncodeTokens(const string& text,
+                                     const string* text_pair,
+                                     bool do_lower_case,
+                                     bool is_split_into_words,
+                                     size_t max_seq_len, vector<int64_t>* ids,
+                                     vector<int64_t>* pair_ids) const {
+  ids->clear();
+  pair_ids->clear();
+  if (!is_split_into_words) {
+    if (!Tokenize(text, do_lower_case, ids) || ids->empty()) return false;
+    if (text_pair && !text_pair->empty()) {
+      if (!Tokenize(*text_pair, do_lower_case, pair_ids) ||
+          pair_ids->empty()) {
+        return false;
+      }
+    }
+  } else if (!LookupChars(text, ids)) {
+    return false;
+  }
+
+  // Truncate the longer sequence first.
+  size_t total_len = ids->size() + pair_ids->size() +
+                     static_cast<size_t>(pair_ids->empty() ? 2 : 3);
+  if (max_seq_len > 0 && total_len > max_seq_len) {
+    for (size_t i = total_len - max_seq_len; i > 0 && !ids->empty(); --i) {
+      if (pair_ids->empty() || ids->size() > pair_ids->size()) {
+        ids->pop_back();
+      } else {
+        pair_ids->pop_back();
+      }
+    }
+    total_len = ids->size() + pair_ids->size() +
+                static_cast<size_t>(pair_ids->empty() ? 2 : 3);
+    if (total_len > max_seq_len) {
+      VLOG(3) << "There is something wrong with the input sequence length."
+                 " Please check it.";
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t TrieBertTokenizer::SequenceLength(const vector<int64_t>& ids,
+                                         const vector<int64_t>& pair_ids,
+                                         bool encoded, bool has_text_pair,
+                                         size_t max_seq_len,
+                                         bool pad_to_max_seq_len) const {
+  if (!encoded) {
+    return has_text_pair ? 3 : 2;
+  }
+  size_t len = ids.size() + pair_ids.size() + (pair_ids.empty() ? 2 : 3);
+  if (pad_to_max_seq_len && max_seq_len > 0 && len < max_seq_len) {
+    len = max_seq_len;
+  }
+  return len;
+}
+
+void TrieBertTokenizer::WriteSequence(const vector<int64_t>& ids,
+                                      const vector<int64_t>& pair_ids,
+                                      bool encoded, bool has_text_pair,
+                                      size_t width, int64_t* out_ids,
+                                      int64_t* out_seg_ids) const {
+  size_t len = 0;
+  auto put = [&](int64_t id, int64_t seg_id) {
+    out_ids[len] = id;
+    out_seg_ids[len] = seg_id;
+    ++len;
+  };
+  if (!encoded) {
+    put(cls_token_id_, 0);
+    put(sep_token_id_, 0);
+    if (has_text_pair) put(cls_token_id_, 1);
+  } else {
+    put(cls_token_id_, 0);
+    for (auto id : ids) put(id, 0);
+    put(sep_token_id_, 0);
+    if (!pair_ids.empty()) {
+      for (auto id : pair_ids) put(id, 1);
+      put(sep_token_id_, 1);
+    }
+  }
+  std::fill(out_ids + len, out_ids + width, pad_token_id_);
+  std::fill(out_seg_ids + len, out_seg_ids + width, pad_token_id_);
+}
+
+void TrieBertTokenizer::BatchEncode(const framework::Strings& batch_text,
+                                    const framework::Strings* batch_text_pair,
+                                    bool do_lower_case,
+                                    bool is_split_into_words,
+                                    size_t max_seq_len, bool pad_to_max_seq_len,
+                                    framework::Tensor* input_ids,
+                                    framework::Tensor* seg_ids) const {
+  bool has_text_pair = batch_text_pair && !batch_text_pair->empty();
+  int64_t batch_size = batch_text.size();
+  auto resize = [&](size_t width) {
+    auto dims = framework::make_ddim({batch_size, static_cast<int64_t>(width)});
+    input_ids->Resize(dims);
+    seg_ids->Resize(dims);
+    return std::make_pair(
+        input_ids->mutable_data<int64_t>(platform::CPUPlace()),
+        seg_ids->mutable_data<int64_t>(platform::CPUPlace()));
+  };
+  auto encode = [&](int64_t i, vector<int64_t>* ids,
+                    vector<int64_t>* pair_ids) {
+    return EncodeTokens(batch_text[i],
+                        has_text_pair ? &(*batch_text_pair)[i] : nullptr,
+                        do_lower_case, is_split_into_words, max_seq_len, ids,
+                        pair_ids);
+  };
+
+  if (pad_to_max_seq_len && max_seq_len >= 3) {
+    // Every encoded sequence is padded to max_seq_len, so the ids are
+    // written into the outputs right away.
+    auto outs = resize(max_seq_len);
+    bool any_encoded = false;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for reduction(|| : any_encoded)
+#endif
+    for (int64_t i = 0; i < batch_size; ++i) {
+      thread_local vector<int64_t> ids;
+      thread_local vector<int64_t> pair_ids;
+      bool encoded = encode(i, &ids, &pair_ids);
+      any_encoded = any_encoded || encoded;
+      WriteSequence(ids, pair_ids, encoded, has_text_pair, max_seq_len,
+                    outs.first + i * max_seq_len,
+                    outs.second + i * max_seq_len);
+    }
+    if (!any_encoded && batch_size > 0) {
+      // Only the default sequences, which are not padded.
+      size_t width = has_text_pair ? 3 : 2;
+      outs = resize(width);
+      for (int64_t i = 0; i < batch_size; ++i) {
+        WriteSequence({}, {}, false, has_text_pair, width,
+                      outs.first + i * width, outs.second + i * width);
+      }
+    }
+    return;
+  }
+
+  vector<vector<int64_t>> batch_ids(batch_size);
+  vector<vector<int64_t>> batch_pair_ids(batch_size);
+  vector<char> batch_encoded(batch_size);
+  size_t width = 0;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for reduction(max : width)
+#endif
+  for (int64_t i = 0; i < batch_size; ++i) {
+    batch_encoded[i] = encode(i, &batch_ids[i], &batch_pair_ids[i]);
+    width = std::max(width, SequenceLength(batch_ids[i], batch_pair_ids[i],
+                                           batch_encoded[i], has_text_pair,
+                                           max_seq_len, pad_to_max_seq_len));
+  }
+  auto outs = resize(width);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < batch_size; ++i) {
+    WriteSequence(batch_ids[i], batch_pair_ids[i], batch_encoded[i],
+                  has_text_pair, width, outs.first + i * width,
+                  outs.second + i * width);
+  }
+}
+
 class FasterTokenizerOp : public framework::OperatorWithKernel {
  public:
   using framework::OperatorWithKernel::OperatorWithKernel;
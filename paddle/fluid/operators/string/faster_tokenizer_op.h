@@ -13,9 +13,11 @@ limitations under the License. */
 
 #include <utf8proc.h>
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/framework/op_registry.h"
@@ -117,6 +119,100 @@ class BertTokenizer {
   InvVocab inv_vocab_;
 };
 
+// DoubleArrayTrie maps byte strings to non-negative int32 values. The child
+// of node s by byte c is t = base[s] + c, which exists if check[t] == s, so
+// walking the trie costs two array reads per byte.
+class DoubleArrayTrie {
+ public:
+  static constexpr int kRoot = 0;
+
+  void Build(vector<std::pair<string, int32_t>> keys);
+
+  // Returns the child of `node` by byte `c`, or -1.
+  int Next(int node, uint8_t c) const {
+    size_t t = static_cast<size_t>(base_[node]) + c;
+    return t < check_.size() && check_[t] == node ? static_cast<int>(t) : -1;
+  }
+  // Returns the node reached from `node` by the bytes of [begin, end), or -1.
+  int Find(int node, const char* begin, const char* end) const;
+  // Returns the value of the key ending at `node`, or -1.
+  int32_t Value(int node) const { return value_[node]; }
+  // Returns the byte length of the longest non-empty key starting at `node`
+  // which is a prefix of [begin, end), and stores its value in `value`.
+  // Returns 0 if there is no such key.
+  size_t LongestPrefix(int node, const char* begin, const char* end,
+                       int32_t* value) const;
+
+  size_t NumUnits() const { return check_.size(); }
+
+ private:
+  vector<int32_t> base_;
+  vector<int32_t> check_;
+  vector<int32_t> value_;
+};
+
+// TrieBertTokenizer produces the same ids as BertTokenizer, working on the
+// UTF-8 bytes of the text directly. The vocab is compiled into a
+// DoubleArrayTrie once, and the greedy longest-match of WordPiece walks the
+// trie instead of building and hashing every candidate substring as a
+// wstring. BatchEncode tokenizes the examples in parallel and writes the ids
+// into the output tensors.
+class TrieBertTokenizer {
+ public:
+  explicit TrieBertTokenizer(const framework::Vocab& vocab,
+                             const wstring& unk_token = L"[UNK]",
+                             const wstring& pad_token = L"[PAD]",
+                             const wstring& cls_token = L"[CLS]",
+                             const wstring& sep_token = L"[SEP]",
+                             const size_t max_input_chars_per_word = 100);
+
+  // Returns the tokenizer of `vocab`. Tokenizers are cached by the address
+  // of the vocab together with a copy of its contents, which is compared on
+  // every hit, so a vocab that is reloaded or replaced gets its own.
+  static std::shared_ptr<const TrieBertTokenizer> Get(
+      const framework::Vocab* vocab);
+
+  // Appends the ids of `text` to `ids`. Returns false if the text is not
+  // valid UTF-8.
+  bool Tokenize(const string& text, bool do_lower_case,
+                vector<int64_t>* ids) const;
+
+  void BatchEncode(const framework::Strings& batch_text,
+                   const framework::Strings* batch_text_pair,
+                   bool do_lower_case, bool is_split_into_words,
+                   size_t max_seq_len, bool pad_to_max_seq_len,
+                   framework::Tensor* input_ids,
+                   framework::Tensor* seg_ids) const;
+
+  int64_t GetPadTokenID() const { return pad_token_id_; }
+
+ private:
+  void WordPiece(const char* word, size_t len, size_t num_chars,
+                 vector<int64_t>* ids) const;
+  bool LookupChars(const string& text, vector<int64_t>* ids) const;
+  // Tokenizes and truncates one example, returns false if it fails to
+  // encode and the default sequence should be used.
+  bool EncodeTokens(const string& text, const string* text_pair,
+                    bool do_lower_case, bool is_split_into_words,
+                    size_t max_seq_len, vector<int64_t>* ids,
+                    vector<int64_t>* pair_ids) const;
+  size_t SequenceLength(const vector<int64_t>& ids,
+                        const vector<int64_t>& pair_ids, bool encoded,
+                        bool has_text_pair, size_t max_seq_len,
+                        bool pad_to_max_seq_len) const;
+  // Writes the sequence with the special tokens, padded to `width`.
+  void WriteSequence(const vector<int64_t>& ids,
+                     const vector<int64_t>& pair_ids, bool encoded,
+                     bool has_text_pair, size_t width, int64_t* out_ids,
+                     int64_t* out_seg_ids) const;
+
+  DoubleArrayTrie trie_;
+  // The node of "##", where the keys of the word suffixes start.
+  int suffix_root_;
+  size_t max_input_chars_per_word_;
+  int64_t unk_token_id_, pad_token_id_, cls_token_id_, sep_token_id_;
+};
+
 template <typename T>
 class FasterTokenizerKernel : public framework::OpKernel<T> {
  public:
@@ -141,53 +237,10 @@ class FasterTokenizerKernel : public framework::OpKernel<T> {
       return;
     }
 
-    BertTokenizer tokenizer(vocab, do_lower_case);
-    size_t batch_max_seq_len = 0;
-    size_t batch_size = text->size();
-
-    vector<unordered_map<string, vector<int64_t>>> batch_encode_inputs(
-        batch_size);
-    if (text_pair) {
-      tokenizer.BatchEncode(&batch_encode_inputs, *text, *text_pair,
-                            is_split_into_words, max_seq_len,
-                            pad_to_max_seq_len);
-    } else {
-      tokenizer.BatchEncode(&batch_encode_inputs, *text, vector<string>(),
-                            is_split_into_words, max_seq_len,
-                            pad_to_max_seq_len);
-    }
-
-    for (size_t i = 0; i < batch_size; ++i) {
-      size_t seq_len = batch_encode_inputs[i]["input_ids"].size();
-      if (seq_len > batch_max_seq_len) {
-        batch_max_seq_len = seq_len;
-      }
-    }
-
-    input_ids->Resize(
-        framework::make_ddim({static_cast<int64_t>(batch_size),
-                              static_cast<int64_t>(batch_max_seq_len)}));
-    auto* input_ids_data = input_ids->mutable_data<T>(ctx.GetPlace());
-    seg_ids->Resize(
-        framework::make_ddim({static_cast<int64_t>(batch_size),
-                              static_cast<int64_t>(batch_max_seq_len)}));
-    auto* seg_ids_data = seg_ids->mutable_data<T>(ctx.GetPlace());
-
-    auto pad_token_id = tokenizer.GetPadTokenID();
-    for (size_t i = 0; i < batch_size; i++) {
-      auto& encoder_input_ids = batch_encode_inputs[i]["input_ids"];
-      auto& encoder_seg_ids = batch_encode_inputs[i]["token_type_ids"];
-      const size_t& seq_len = encoder_input_ids.size();
-      // Copy the memory
-      std::memcpy(input_ids_data + i * batch_max_seq_len,
-                  encoder_input_ids.data(), seq_len * sizeof(T));
-      std::memcpy(seg_ids_data + i * batch_max_seq_len, encoder_seg_ids.data(),
-                  seq_len * sizeof(T));
-      std::memset(input_ids_data + i * batch_max_seq_len + seq_len,
-                  pad_token_id, (batch_max_seq_len - seq_len) * sizeof(T));
-      std::memset(seg_ids_data + i * batch_max_seq_len + seq_len, pad_token_id,
-                  (batch_max_seq_len - seq_len) * sizeof(T));
-    }
+    auto tokenizer = TrieBertTokenizer::Get(vocab);
+    tokenizer->BatchEncode(*text, text_pair, do_lower_case,
+                           is_split_into_words, max_seq_len,
+                           pad_to_max_seq_len, input_ids, seg_ids);
   }
 };
 
@@ -0,0 +1,91 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>  // NOLINT
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/operators/string/faster_tokenizer_op.h"
+
+DEFINE_int32(batch_size, 256, "The number of texts of a batch.");
+DEFINE_int32(words_per_text, 64, "The number of words of every text.");
+DEFINE_int32(repeat, 10, "The times of encoding the batch.");
+
+namespace paddle {
+namespace operators {
+
+static framework::Vocab MakeVocab() {
+  framework::Vocab vocab;
+  std::vector<std::wstring> tokens = {
+      L"[PAD]", L"[UNK]", L"[CLS]", L"[SEP]", L"[MASK]", L"the",  L"un",
+      L"##aff", L"##able", L"##a",  L"a",     L"b",      L"ab",   L"##b",
+      L"##ab",  L"hello",  L"world", L"##s",  L",",      L".",    L"!",
+      L"中",    L"国",     L"é",    L"##é",   L"x",      L"##x",  L"xx"};
+  for (auto& token : tokens) {
+    int32_t id = static_cast<int32_t>(vocab.size());
+    vocab.emplace(token, id);
+  }
+  return vocab;
+}
+
+static void BenchBatchEncode() {
+  auto vocab = MakeVocab();
+  std::vector<std::string> words = {"the",   "unaffable", "hello", "worlds",
+                                    "abab",  "中国",      "é",     "xxxxx",
+                                    "zz",    "Hello,",    "b!",    "a"};
+  std::mt19937 engine(0);
+  std::uniform_int_distribution<size_t> dist(0, words.size() - 1);
+  framework::Strings text(FLAGS_batch_size);
+  for (auto& line : text) {
+    for (int i = 0; i < FLAGS_words_per_text; ++i) {
+      line += words[dist(engine)] + " ";
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    BertTokenizer tokenizer(&vocab, true);
+    std::vector<std::unordered_map<std::string, std::vector<int64_t>>>
+        encoded(text.size());
+    tokenizer.BatchEncode(&encoded, text, {}, false, 128, true);
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    framework::Tensor input_ids;
+    framework::Tensor seg_ids;
+    TrieBertTokenizer::Get(&vocab)->BatchEncode(
+        text, nullptr, true, false, 128, true, &input_ids, &seg_ids);
+  }
+  auto end = std::chrono::steady_clock::now();
+  using ms = std::chrono::duration<double, std::milli>;
+  LOG(INFO) << "BertTokenizer " << ms(mid - start).count() / FLAGS_repeat
+            << " ms/batch, TrieBertTokenizer "
+            << ms(end - mid).count() / FLAGS_repeat << " ms/batch";
+}
+
+}  // namespace operators
+}  // namespace paddle
+
+// Compares BertTokenizer with TrieBertTokenizer on one batch of texts,
+// run command: ./faster_tokenizer_op_benchmark [options...]
+int main(int argc, char* argv[]) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::operators::BenchBatchEncode();
+  return 0;
+}
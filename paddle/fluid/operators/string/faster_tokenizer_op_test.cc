@@ -0,0 +1,158 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/string/faster_tokenizer_op.h"
+
+namespace paddle {
+namespace operators {
+
+static framework::Vocab MakeVocab() {
+  framework::Vocab vocab;
+  std::vector<std::wstring> tokens = {
+      L"[PAD]", L"[UNK]", L"[CLS]", L"[SEP]", L"[MASK]", L"the",  L"un",
+      L"##aff", L"##able", L"##a",  L"a",     L"b",      L"ab",   L"##b",
+      L"##ab",  L"hello",  L"world", L"##s",  L",",      L".",    L"!",
+      L"中",    L"国",     L"é",    L"##é",   L"x",      L"##x",  L"xx"};
+  for (auto& token : tokens) {
+    int32_t id = static_cast<int32_t>(vocab.size());
+    vocab.emplace(token, id);
+  }
+  return vocab;
+}
+
+// Runs the old BertTokenizer and pads the results as the kernel did.
+static void ReferenceEncode(const framework::Vocab& vocab,
+                            const framework::Strings& text,
+                            const framework::Strings& text_pair,
+                            bool do_lower_case, bool is_split_into_words,
+                            size_t max_seq_len, bool pad_to_max_seq_len,
+                            std::vector<std::vector<int64_t>>* ids,
+                            std::vector<std::vector<int64_t>>* seg_ids) {
+  BertTokenizer tokenizer(&vocab, do_lower_case);
+  std::vector<std::unordered_map<std::string, std::vector<int64_t>>> encoded(
+      text.size());
+  tokenizer.BatchEncode(&encoded, text, text_pair, is_split_into_words,
+                        max_seq_len, pad_to_max_seq_len);
+  size_t width = 0;
+  for (auto& item : encoded) {
+    width = std::max(width, item["input_ids"].size());
+  }
+  ids->clear();
+  seg_ids->clear();
+  for (auto& item : encoded) {
+    ids->push_back(item["input_ids"]);
+    seg_ids->push_back(item["token_type_ids"]);
+    ids->back().resize(width, tokenizer.GetPadTokenID());
+    seg_ids->back().resize(width, tokenizer.GetPadTokenID());
+  }
+}
+
+static void CheckSameAsReference(const framework::Vocab& vocab,
+                                 const framework::Strings& text,
+                                 const framework::Strings& text_pair,
+                                 bool do_lower_case, bool is_split_into_words,
+                                 size_t max_seq_len, bool pad_to_max_seq_len) {
+  std::vector<std::vector<int64_t>> expect_ids;
+  std::vector<std::vector<int64_t>> expect_seg_ids;
+  ReferenceEncode(vocab, text, text_pair, do_lower_case, is_split_into_words,
+                  max_seq_len, pad_to_max_seq_len, &expect_ids,
+                  &expect_seg_ids);
+
+  TrieBertTokenizer tokenizer(vocab);
+  framework::Tensor input_ids;
+  framework::Tensor seg_ids;
+  tokenizer.BatchEncode(text, text_pair.empty() ? nullptr : &text_pair,
+                        do_lower_case, is_split_into_words, max_seq_len,
+                        pad_to_max_seq_len, &input_ids, &seg_ids);
+  ASSERT_EQ(input_ids.dims()[0], static_cast<int64_t>(text.size()));
+  size_t width = text.empty() ? 0 : expect_ids[0].size();
+  ASSERT_EQ(input_ids.dims()[1], static_cast<int64_t>(width));
+  for (size_t i = 0; i < text.size(); ++i) {
+    for (size_t j = 0; j < width; ++j) {
+      ASSERT_EQ(input_ids.data<int64_t>()[i * width + j], expect_ids[i][j])
+          << text[i] << " " << j;
+      ASSERT_EQ(seg_ids.data<int64_t>()[i * width + j], expect_seg_ids[i][j])
+          << text[i] << " " << j;
+    }
+  }
+}
+
+TEST(DoubleArrayTrie, Find) {
+  DoubleArrayTrie trie;
+  trie.Build({{"a", 1}, {"ab", 2}, {"abc", 3}, {"b", 4}, {"\xe4\xb8\xad", 5}});
+  std::string text = "abcd";
+  int node = trie.Find(DoubleArrayTrie::kRoot, text.data(), text.data() + 2);
+  ASSERT_GE(node, 0);
+  ASSERT_EQ(trie.Value(node), 2);
+  ASSERT_LT(trie.Find(DoubleArrayTrie::kRoot, "c", "c" + 1), 0);
+
+  int32_t value = -1;
+  ASSERT_EQ(trie.LongestPrefix(DoubleArrayTrie::kRoot, text.data(),
+                               text.data() + text.size(), &value),
+            3UL);
+  ASSERT_EQ(value, 3);
+  ASSERT_EQ(trie.LongestPrefix(DoubleArrayTrie::kRoot, "cb", "cb" + 2, &value),
+            0UL);
+}
+
+TEST(TrieBertTokenizer, SameAsBertTokenizer) {
+  auto vocab = MakeVocab();
+  framework::Strings text = {
+      "the unaffable hello, world!",
+      "Hello Worlds.  THE ab abab",
+      "中国 中文 unaffablex",
+      "ééé xxxx xx\t\tb",
+      "",
+      "\xff\xfe invalid",
+      std::string(120, 'x'),
+      "zzz"};
+  framework::Strings text_pair = {"a b", "",    "中国", "ab",
+                                  "b",   "abc", "x",    "hello"};
+  for (bool do_lower_case : {false, true}) {
+    for (bool is_split_into_words : {false, true}) {
+      for (size_t max_seq_len : {0, 2, 4, 8, 32}) {
+        for (bool pad : {false, true}) {
+          CheckSameAsReference(vocab, text, {}, do_lower_case,
+                               is_split_into_words, max_seq_len, pad);
+          CheckSameAsReference(vocab, text, text_pair, do_lower_case,
+                               is_split_into_words, max_seq_len, pad);
+        }
+      }
+    }
+  }
+  // All the examples fail, only the default sequences are left.
+  CheckSameAsReference(vocab, {"", "\xff"}, {}, true, false, 16, true);
+  CheckSameAsReference(vocab, {}, {}, true, false, 16, true);
+}
+
+TEST(TrieBertTokenizer, CacheFollowsVocab) {
+  auto vocab = MakeVocab();
+  auto first = TrieBertTokenizer::Get(&vocab);
+  ASSERT_EQ(TrieBertTokenizer::Get(&vocab), first);
+  // the same holder and size, but another id for "hello"
+  vocab[L"hello"] = 100;
+  auto second = TrieBertTokenizer::Get(&vocab);
+  ASSERT_NE(second, first);
+  std::vector<int64_t> ids;
+  ASSERT_TRUE(second->Tokenize("hello", false, &ids));
+  ASSERT_EQ(ids, std::vector<int64_t>({100}));
+}
+
+}  // namespace operators
+}  // namespace paddle
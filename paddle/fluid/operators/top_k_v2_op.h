@@ -27,6 +27,7 @@ limitations under the License. */
 #include <vector>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/top_k_heap.h"
 #include "paddle/fluid/operators/top_k_op.h"
 #include "paddle/fluid/operators/transpose_op.h"
 
@@ -46,12 +47,44 @@ inline void GetDims(const framework::DDim& dim, int axis, int* pre, int* n,
   }
 }
 
+// Select the top k of each row with a heap of k items, which is reused by
+// all the rows of an omp thread. The output is always sorted.
+template <typename T, typename Type>
+static void HeapTopK(Type input_height, Type input_width, const T* input_data,
+                     T* t_out, Type* t_indices, Type k, bool largest) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel
+#endif
+  {
+    std::vector<std::pair<T, Type>> heap(k);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp for
+#endif
+    for (Type i = 0; i < input_height; ++i) {
+      const T* row = input_data + i * input_width;
+      if (largest) {
+        math::TopKRow<T, Type, true>(row, input_width, k, heap.data());
+      } else {
+        math::TopKRow<T, Type, false>(row, input_width, k, heap.data());
+      }
+      for (Type j = 0; j < k; ++j) {
+        t_out[i * k + j] = heap[j].first;
+        t_indices[i * k + j] = heap[j].second;
+      }
+    }
+  }
+}
+
 template <typename T, typename Type>
 static void FullTopK(Type input_height, Type input_width, int input_dim,
                      const framework::Tensor* input, T* t_out, Type* t_indices,
                      const int& k, const bool& largest, const bool& sorted) {
-  // when the k is small, will the partial sort
-  bool partial_sort_flag = (k * 64) < input_width;
+  // when the k is small, will use the heap
+  if ((k * 64) < input_width) {
+    HeapTopK<T, Type>(input_height, input_width, input->data<T>(), t_out,
+                      t_indices, k, largest);
+    return;
+  }
 
 #ifdef PADDLE_WITH_MKLML
 #pragma omp parallel for
@@ -71,58 +104,42 @@ static void FullTopK(Type input_height, Type input_width, int input_dim,
         col_vec.emplace_back(std::pair<T, Type>(e_input(i, j), j));
       }
     }
-    if (partial_sort_flag) {
-      std::partial_sort(
-          col_vec.begin(), col_vec.begin() + k, col_vec.end(),
-          [&largest](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-            if (largest) {
-              return (std::isnan(static_cast<double>(l.first)) &&
-                      !std::isnan(static_cast<double>(r.first))) ||
-                     (l.first > r.first);
-            } else {
-              return (!std::isnan(static_cast<double>(l.first)) &&
-                      std::isnan(static_cast<double>(r.first))) ||
-                     (l.first < r.first);
-            }
+    // use the nth-element to get the K-larger or K-small element
+    if (largest) {
+      std::nth_element(
+          col_vec.begin(), col_vec.begin() + k - 1, col_vec.end(),
+          [](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
+            return (std::isnan(static_cast<double>(l.first)) &&
+                    !std::isnan(static_cast<double>(r.first))) ||
+                   (l.first > r.first);
           });
+      // the nth-element will get the unorder elements, sort the element
+      if (sorted) {
+        std::sort(col_vec.begin(), col_vec.begin() + k - 1,
+                  [&largest](const std::pair<T, Type>& l,
+                             const std::pair<T, Type>& r) {
+                    return (std::isnan(static_cast<double>(l.first)) &&
+                            !std::isnan(static_cast<double>(r.first))) ||
+                           (l.first > r.first);
+                  });
+      }
     } else {
-      // use the nth-element to get the K-larger or K-small element
-      if (largest) {
-        std::nth_element(
-            col_vec.begin(), col_vec.begin() + k - 1, col_vec.end(),
-            [](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-              return (std::isnan(static_cast<double>(l.first)) &&
-                      !std::isnan(static_cast<double>(r.first))) ||
-                     (l.first > r.first);
-            });
-        // the nth-element will get the unorder elements, sort the element
-        if (sorted) {
-          std::sort(col_vec.begin(), col_vec.begin() + k - 1,
-                    [&largest](const std::pair<T, Type>& l,
-                               const std::pair<T, Type>& r) {
-                      return (std::isnan(static_cast<double>(l.first)) &&
-                              !std::isnan(static_cast<double>(r.first))) ||
-                             (l.first > r.first);
-                    });
-        }
-      } else {
-        std::nth_element(
-            col_vec.begin(), col_vec.begin() + k - 1, col_vec.end(),
+      std::nth_element(
+          col_vec.begin(), col_vec.begin() + k - 1, col_vec.end(),
+          [](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
+            return (!std::isnan(static_cast<double>(l.first)) &&
+                    std::isnan(static_cast<double>(r.first))) ||
+                   (l.first < r.first);
+          });
+      // the nth-element will get the unorder elements, sort the element
+      if (sorted) {
+        std::sort(
+            col_vec.begin(), col_vec.begin() + k - 1,
             [](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
               return (!std::isnan(static_cast<double>(l.first)) &&
                       std::isnan(static_cast<double>(r.first))) ||
                      (l.first < r.first);
             });
-        // the nth-element will get the unorder elements, sort the element
-        if (sorted) {
-          std::sort(
-              col_vec.begin(), col_vec.begin() + k - 1,
-              [](const std::pair<T, Type>& l, const std::pair<T, Type>& r) {
-                return (!std::isnan(static_cast<double>(l.first)) &&
-                        std::isnan(static_cast<double>(r.first))) ||
-                       (l.first < r.first);
-              });
-        }
       }
     }
     for (Type j = 0; j < k; ++j) {
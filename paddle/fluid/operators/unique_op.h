@@ -16,18 +16,94 @@ limitations under the License. */
 #include <algorithm>
 #include <cmath>
 #include <numeric>
+#include <limits>
 #include <set>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/operators/math/concat_and_split.h"
+#include "paddle/fluid/operators/math/radix_sort.h"
 #include "paddle/fluid/operators/transpose_op.h"
 #include "paddle/pten/kernels/funcs/math_function.h"
 
 namespace paddle {
 namespace operators {
 
+// The integers are numbered by a hash map while it has at most this many
+// entries, which fit in the cache, and by a radix sort when there are more.
+constexpr size_t kUniqueHashMaxSize = 1 << 16;
+
+// Number the distinct values of `in_data` in the order of their first
+// occurrence: index_data[i] gets the number of in_data[i], and `uniq` the
+// distinct values. Returns false if there are more than `max_size` of them.
+template <typename InT, typename IndexT>
+static bool UniqueInOrderByHash(const InT* in_data, int64_t numel,
+                                IndexT* index_data, std::vector<InT>* uniq,
+                                size_t max_size) {
+  std::unordered_map<InT, int64_t> dict;
+  int64_t j = 0;
+  for (int64_t i = 0; i < numel; i++) {
+    auto it = dict.find(in_data[i]);
+    if (it == dict.end()) {
+      if (dict.size() >= max_size) return false;
+      dict.emplace(std::make_pair(in_data[i], j));
+      uniq->emplace_back(in_data[i]);
+      index_data[i] = static_cast<IndexT>(j);
+      j++;
+    } else {
+      index_data[i] = static_cast<IndexT>(it->second);
+    }
+  }
+  return true;
+}
+
+// The same numbering with a radix sort of the indices by the values: the
+// runs of the equal values are numbered in the sorted order, then renumbered
+// in the order of their first occurrence.
+template <typename InT, typename IndexT>
+static void UniqueInOrderBySort(const InT* in_data, int64_t numel,
+                                IndexT* index_data, std::vector<InT>* uniq) {
+  using KeyT = typename math::RadixKey<InT>::Type;
+  std::vector<int64_t> order(numel);
+  std::vector<KeyT> keys(numel);
+  math::RadixSortIndices(in_data, numel, false, order.data(), keys.data());
+  int64_t run = -1;
+  for (int64_t k = 0; k < numel; ++k) {
+    if (k == 0 || keys[k] != keys[k - 1]) ++run;
+    index_data[order[k]] = static_cast<IndexT>(run);
+  }
+  std::vector<int64_t> renumber(run + 1, -1);
+  uniq->clear();
+  for (int64_t i = 0; i < numel; ++i) {
+    int64_t& id = renumber[static_cast<int64_t>(index_data[i])];
+    if (id < 0) {
+      id = static_cast<int64_t>(uniq->size());
+      uniq->emplace_back(in_data[i]);
+    }
+    index_data[i] = static_cast<IndexT>(id);
+  }
+}
+
+template <typename InT, typename IndexT>
+static typename std::enable_if<std::is_integral<InT>::value>::type
+UniqueInOrder(const InT* in_data, int64_t numel, IndexT* index_data,
+              std::vector<InT>* uniq) {
+  if (!UniqueInOrderByHash(in_data, numel, index_data, uniq,
+                           kUniqueHashMaxSize)) {
+    UniqueInOrderBySort(in_data, numel, index_data, uniq);
+  }
+}
+
+template <typename InT, typename IndexT>
+static typename std::enable_if<!std::is_integral<InT>::value>::type
+UniqueInOrder(const InT* in_data, int64_t numel, IndexT* index_data,
+              std::vector<InT>* uniq) {
+  UniqueInOrderByHash(in_data, numel, index_data, uniq,
+                      std::numeric_limits<size_t>::max());
+}
+
 template <typename InT>
 struct UniqueOpFunctor {
   framework::Tensor* out_;
@@ -45,10 +121,6 @@ struct UniqueOpFunctor {
     auto* in_data = in_->data<InT>();
     auto* index_data = index_->mutable_data<IndexT>(platform::CPUPlace());
 
-    int64_t j = 0;
-
-    // TODO(fangzeyang): Should optimize performance here.
-    std::unordered_map<InT, int64_t> dict;
     std::vector<InT> uniq;
 
     PADDLE_ENFORCE_LT(
@@ -58,17 +130,7 @@ struct UniqueOpFunctor {
             "but received num is %d.",
             in_->numel()));
 
-    for (auto i = 0; i < in_->numel(); i++) {
-      auto it = dict.find(in_data[i]);
-      if (it == dict.end()) {
-        dict.emplace(std::make_pair(in_data[i], j));
-        uniq.emplace_back(in_data[i]);
-        index_data[i] = static_cast<IndexT>(j);
-        j++;
-      } else {
-        index_data[i] = static_cast<IndexT>(it->second);
-      }
-    }
+    UniqueInOrder(in_data, in_->numel(), index_data, &uniq);
 
     if (count_ != nullptr) {
       // Resize the count tensor dims to allocate the memory
@@ -131,11 +193,69 @@ static bool Equal(const framework::Tensor& a, const framework::Tensor& b) {
   return true;
 }
 
+// The integers are sorted by a radix sort of their indices, which is stable,
+// so the first index of a run of equal values is their first occurrence.
+template <typename InT, typename IndexT>
+static typename std::enable_if<std::is_integral<InT>::value>::type
+UniqueFlattendTensor(const framework::ExecutionContext& context,
+                     const framework::Tensor& in, framework::Tensor* out,
+                     bool return_index, bool return_inverse,
+                     bool return_counts) {
+  using KeyT = typename math::RadixKey<InT>::Type;
+  const InT* in_data = in.data<InT>();
+  const int64_t numel = in.numel();
+  std::vector<IndexT> order(numel);
+  std::vector<KeyT> keys(numel);
+  math::RadixSortIndices(in_data, numel, false, order.data(), keys.data());
+  std::vector<int64_t> run_begin;
+  for (int64_t k = 0; k < numel; ++k) {
+    if (k == 0 || keys[k] != keys[k - 1]) run_begin.push_back(k);
+  }
+  const int64_t num_uniq = static_cast<int64_t>(run_begin.size());
+  run_begin.push_back(numel);
+
+  out->Resize(framework::make_ddim({num_uniq}));
+  auto out_data = out->mutable_data<InT>(context.GetPlace());
+  for (int64_t i = 0; i < num_uniq; ++i) {
+    out_data[i] = in_data[order[run_begin[i]]];
+  }
+
+  if (return_index) {
+    auto* indices = context.Output<framework::Tensor>("Indices");
+    indices->Resize(framework::make_ddim({num_uniq}));
+    auto indices_data = indices->mutable_data<IndexT>(context.GetPlace());
+    for (int64_t i = 0; i < num_uniq; ++i) {
+      indices_data[i] = order[run_begin[i]];
+    }
+  }
+
+  if (return_inverse) {
+    auto* inverse = context.Output<framework::Tensor>("Index");
+    inverse->Resize(framework::make_ddim({numel}));
+    auto inverse_data = inverse->mutable_data<IndexT>(context.GetPlace());
+    for (int64_t i = 0; i < num_uniq; ++i) {
+      for (int64_t k = run_begin[i]; k < run_begin[i + 1]; ++k) {
+        inverse_data[order[k]] = static_cast<IndexT>(i);
+      }
+    }
+  }
+
+  if (return_counts) {
+    auto* count = context.Output<framework::Tensor>("Counts");
+    count->Resize(framework::make_ddim({num_uniq}));
+    auto count_data = count->mutable_data<IndexT>(context.GetPlace());
+    for (int64_t i = 0; i < num_uniq; ++i) {
+      count_data[i] = static_cast<IndexT>(run_begin[i + 1] - run_begin[i]);
+    }
+  }
+}
+
 template <typename InT, typename IndexT>
-static void UniqueFlattendTensor(const framework::ExecutionContext& context,
-                                 const framework::Tensor& in,
-                                 framework::Tensor* out, bool return_index,
-                                 bool return_inverse, bool return_counts) {
+static typename std::enable_if<!std::is_integral<InT>::value>::type
+UniqueFlattendTensor(const framework::ExecutionContext& context,
+                     const framework::Tensor& in, framework::Tensor* out,
+                     bool return_index, bool return_inverse,
+                     bool return_counts) {
   const InT* in_data = in.data<InT>();
   std::set<InT> unique(in_data, in_data + in.numel());
   out->Resize(framework::make_ddim({static_cast<int64_t>(unique.size())}));
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
@@ -22,6 +23,12 @@ limitations under the License. */
 #include "paddle/fluid/platform/dynload/warpctc.h"
 #include "paddle/pten/kernels/funcs/math_function.h"
 
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+DECLARE_int32(paddle_num_threads);
+
 namespace paddle {
 namespace operators {
 
@@ -103,7 +110,7 @@ class WarpCTCFunctor {
                   const size_t sequence_width, const size_t num_sequences,
                   const size_t blank, T* cpu_loss) {
     // Init warp-ctc options
-    init(ctx, blank);
+    init(ctx, blank, num_sequences);
 
     // Compute the required workspace size.
     // There is no memory allocated operations within warp-ctc.
@@ -142,11 +149,21 @@ class WarpCTCFunctor {
         ctx.template device_context<DeviceContext>(), &workspace,
         static_cast<T>(0));
 
+#ifdef PADDLE_WITH_MKLML
+    // warp-ctc sets the omp threads of this thread to options_.num_threads,
+    // restore them for the following ops and the next CpuNumThreads.
+    int omp_threads = omp_get_max_threads();
+#endif
     // compute loss and gradient
     status = ComputeCtcLossFunctor<DeviceContext, T>()(
         input, gradient, cpu_labels, cpu_label_lengths, cpu_input_lengths,
         static_cast<int>(sequence_width), static_cast<int>(num_sequences),
         cpu_loss, workspace_data, options_);
+#ifdef PADDLE_WITH_MKLML
+    if (options_.loc == CTC_CPU) {
+      omp_set_num_threads(omp_threads);
+    }
+#endif
 
     PADDLE_ENFORCE_EQ(
         CTC_STATUS_SUCCESS, status,
@@ -156,7 +173,8 @@ class WarpCTCFunctor {
   }
 
  protected:
-  void init(const framework::ExecutionContext& ctx, const size_t blank) {
+  void init(const framework::ExecutionContext& ctx, const size_t blank,
+            const size_t num_sequences) {
     warpctc_version_ = platform::dynload::get_warpctc_version();
 
     if (platform::is_gpu_place(ctx.GetPlace())) {
@@ -171,12 +189,27 @@ class WarpCTCFunctor {
 #endif
     } else {
       options_.loc = CTC_CPU;
-      options_.num_threads = 1;
+      options_.num_threads = CpuNumThreads(num_sequences);
     }
 
     options_.blank_label = blank;
   }
 
+  // The CPU path of warp-ctc computes the sequences in parallel on its omp
+  // threads. Use as many as the framework, without more than the sequences.
+  // warp-ctc sets the omp threads to this number, and they are restored
+  // after every call, so the bound read here does not shrink from run to
+  // run.
+  static int CpuNumThreads(const size_t num_sequences) {
+#ifdef PADDLE_WITH_MKLML
+    int num_threads = omp_get_max_threads();
+#else
+    int num_threads = FLAGS_paddle_num_threads;
+#endif
+    num_threads = std::min<int>(num_threads, static_cast<int>(num_sequences));
+    return std::max(num_threads, 1);
+  }
+
  private:
   int warpctc_version_;
   ctcOptions options_;
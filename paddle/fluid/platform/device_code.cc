@@ -12,15 +12,25 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <dlfcn.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
 #include <set>
+#include <sstream>
 #include <utility>
 
 #include "paddle/fluid/platform/device_code.h"
 #include "paddle/fluid/platform/enforce.h"
 
 DECLARE_string(cuda_dir);
+DECLARE_string(fusion_group_cpu_compiler);
+DECLARE_string(fusion_group_cpu_cache_dir);
 
 namespace paddle {
 namespace platform {
@@ -65,28 +75,212 @@ DeviceCodePool::DeviceCodePool(const std::vector<platform::Place>& places) {
                     errors::InvalidArgument(
                         "Expected the number of places >= 1. But received %d.",
                         places.size()));
+  AddPlaces(places);
+}
+
+void DeviceCodePool::AddPlaces(const std::vector<platform::Place>& places) {
   // Remove the duplicated places
   std::set<Place> set;
   for (auto& p : places) {
     set.insert(p);
   }
+  bool has_new_cpu = false;
+  bool has_new_gpu = false;
   for (auto& p : set) {
+    if (device_codes_.find(p) != device_codes_.end()) {
+      continue;
+    }
     if (is_gpu_place(p)) {
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
       device_codes_.emplace(p, DeviceCodeMap());
+      has_new_gpu = true;
 #else
       PADDLE_THROW(platform::errors::PreconditionNotMet(
           "CUDAPlace or HIPPlace is not supported, please re-compile with "
           "WITH_GPU=ON or WITH_ROCM=ON."));
 #endif
+    } else if (is_cpu_place(p)) {
+      device_codes_.emplace(p, DeviceCodeMap());
+      has_new_cpu = true;
     }
   }
 
+  if (has_new_cpu) {
+    CPUDeviceCode::CheckAvailableStatus();
+  }
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
-  CUDADeviceCode::CheckAvailableStatus();
+  if (has_new_gpu) {
+    CUDADeviceCode::CheckAvailableStatus();
+  }
 #endif
 }
 
+bool CPUDeviceCode::available_ = false;
+void CPUDeviceCode::CheckAvailableStatus() {
+  std::string command =
+      FLAGS_fusion_group_cpu_compiler + " --version > /dev/null 2>&1";
+  available_ = std::system(command.c_str()) == 0;
+  if (!available_) {
+    LOG_FIRST_N(WARNING, 1)
+        << "Cannot find the C++ compiler " << FLAGS_fusion_group_cpu_compiler
+        << " for JIT compiling of CPU code, please specify it by export "
+           "FLAGS_fusion_group_cpu_compiler=xxx.";
+  }
+}
+
+CPUDeviceCode::CPUDeviceCode(const Place& place, const std::string& name,
+                             const std::string& kernel) {
+  if (!is_cpu_place(place)) {
+    PADDLE_THROW(platform::errors::PermissionDenied(
+        "CPUDeviceCode can only launch on CPU place."));
+  }
+
+  place_ = place;
+  name_ = name;
+  kernel_ = kernel;
+}
+
+CPUDeviceCode::~CPUDeviceCode() {
+  if (handle_ != nullptr) {
+    dlclose(handle_);
+  }
+}
+
+static std::string ReadFile(const std::string& path) {
+  std::ifstream fin(path);
+  std::stringstream content;
+  content << fin.rdbuf();
+  return content.str();
+}
+
+// Returns the feature line of /proc/cpuinfo, or an empty string when the
+// features of the host CPU are unknown.
+static std::string HostCPUFeatures() {
+  std::ifstream fin("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(fin, line)) {
+    if (line.compare(0, 5, "flags") == 0 ||
+        line.compare(0, 8, "Features") == 0) {
+      return line;
+    }
+  }
+  return "";
+}
+
+// The cached libraries are loaded into the process, so the cache directory
+// and the libraries must be owned by the current user and must not be
+// writable by anyone else.
+static bool IsPrivateToUser(const std::string& path, bool is_dir) {
+  struct stat st;
+  if (lstat(path.c_str(), &st) != 0) {
+    return false;
+  }
+  bool type_ok = is_dir ? S_ISDIR(st.st_mode) : S_ISREG(st.st_mode);
+  return type_ok && st.st_uid == getuid() &&
+         (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+bool CPUDeviceCode::Compile(bool include_path) {
+  is_compiled_ = false;
+  // -march=native ties the library to the host CPU, so the CPU features are
+  // part of the cache key. They are left out only when unknown, and then the
+  // library is built for the generic target.
+  static const std::string cpu_features = HostCPUFeatures();
+  const std::string options =
+      std::string(cpu_features.empty() ? "-O3" : "-O3 -march=native") +
+      " -std=c++11 -fPIC -shared -fno-math-errno";
+
+  // The library is shared by all the processes of the user using the same
+  // kernel, so it is named after the hash of everything that goes into it.
+  std::string dir = FLAGS_fusion_group_cpu_cache_dir;
+  if (dir.empty()) {
+    dir = "/tmp/paddle_fusion_group_" + std::to_string(getuid());
+  }
+  if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+    LOG_FIRST_N(WARNING, 1) << "Cannot create the cache directory " << dir
+                            << " for JIT compiling of CPU code.";
+    return false;
+  }
+  if (!IsPrivateToUser(dir, /*is_dir=*/true)) {
+    LOG_FIRST_N(WARNING, 1) << "The cache directory " << dir
+                            << " for JIT compiling of CPU code is not a "
+                               "directory owned by and only writable by the "
+                               "current user, so it is not used.";
+    return false;
+  }
+  size_t hash = std::hash<std::string>()(FLAGS_fusion_group_cpu_compiler +
+                                         options + cpu_features + kernel_);
+  std::string lib_path =
+      dir + "/" + name_ + "_" + std::to_string(hash) + ".so";
+
+  struct stat st;
+  if (stat(lib_path.c_str(), &st) != 0) {
+    // Compile to a temporary file and rename it, so that other processes
+    // never load a partially written library.
+    std::string tmp_path = lib_path + "." + std::to_string(getpid());
+    std::string src_path = tmp_path + ".cc";
+    std::string log_path = tmp_path + ".log";
+    {
+      std::ofstream fout(src_path);
+      fout << kernel_;
+    }
+    std::string command = FLAGS_fusion_group_cpu_compiler + " " + options +
+                          " " + src_path + " -o " + tmp_path + " > " +
+                          log_path + " 2>&1";
+    bool compiled = std::system(command.c_str()) == 0 &&
+                    chmod(tmp_path.c_str(), 0700) == 0 &&
+                    std::rename(tmp_path.c_str(), lib_path.c_str()) == 0;
+    if (!compiled) {
+      LOG(WARNING) << "JIT compiling of CPU code failed:"
+                   << "\n  Kernel name: " << name_ << "\n  Kernel body:\n"
+                   << kernel_ << "\n  Compiling log: " << ReadFile(log_path);
+    }
+    std::remove(src_path.c_str());
+    std::remove(log_path.c_str());
+    std::remove(tmp_path.c_str());
+    if (!compiled) {
+      return false;
+    }
+  }
+
+  if (!IsPrivateToUser(lib_path, /*is_dir=*/false)) {
+    LOG_FIRST_N(WARNING, 1) << "The cached library " << lib_path
+                            << " is not owned by and only writable by the "
+                               "current user, so it is not loaded.";
+    return false;
+  }
+  handle_ = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle_ == nullptr) {
+    LOG_FIRST_N(WARNING, 1) << "Call dlopen for < " << name_
+                            << " > failed: " << dlerror();
+    return false;
+  }
+  function_ = reinterpret_cast<KernelFunc>(dlsym(handle_, name_.c_str()));
+  if (function_ == nullptr) {
+    LOG_FIRST_N(WARNING, 1) << "Call dlsym for < " << name_
+                            << " > failed: " << dlerror();
+    return false;
+  }
+
+  is_compiled_ = true;
+  return true;
+}
+
+void CPUDeviceCode::Launch(const size_t n, std::vector<void*>* args) const {
+  PADDLE_ENFORCE_EQ(
+      is_compiled_, true,
+      errors::PreconditionNotMet(
+          "Please compile the code before launching the kernel."));
+
+  // The arguments are laid out as those of CUDADeviceCode, args[0] points to
+  // n and args[i] points to the (i - 1)-th data pointer.
+  std::vector<void*> ptrs(args->size() - 1);
+  for (size_t i = 1; i < args->size(); ++i) {
+    ptrs[i - 1] = *static_cast<void**>((*args)[i]);
+  }
+  function_(static_cast<int64_t>(n), ptrs.data());
+}
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 #ifdef PADDLE_WITH_HIP
 static bool CheckCUDADriverResult(hipError_t result, std::string caller,
@@ -88,6 +88,32 @@ class CUDADeviceCode : public DeviceCode {
 };
 #endif
 
+// CPUDeviceCode compiles the C++ source of a kernel into a shared library with
+// the system compiler, and caches the library on disk by kernel name. The
+// kernel must be declared as
+//   extern "C" void name(int64_t n, void** args);
+// where args holds the data pointers of the inputs and outputs.
+class CPUDeviceCode : public DeviceCode {
+ public:
+  explicit CPUDeviceCode(const Place& place, const std::string& name,
+                         const std::string& kernel);
+  ~CPUDeviceCode();
+  bool Compile(bool include_path = false) override;
+  void Launch(const size_t n, std::vector<void*>* args) const override;
+
+  static void CheckAvailableStatus();
+  static bool IsAvailable() { return available_; }
+
+ private:
+  using KernelFunc = void (*)(int64_t, void**);
+
+  static bool available_;
+
+  bool is_compiled_{false};
+  void* handle_{nullptr};
+  KernelFunc function_{nullptr};
+};
+
 class DeviceCodePool {
  public:
   using DeviceCodeMap =
@@ -106,6 +132,8 @@ class DeviceCodePool {
   static DeviceCodePool& Init(const std::vector<platform::Place>& places) {
     if (pool == nullptr) {
       pool = new DeviceCodePool(places);
+    } else {
+      pool->AddPlaces(places);
     }
     return *pool;
   }
@@ -115,6 +143,12 @@ class DeviceCodePool {
   platform::DeviceCode* Get(const platform::Place& place,
                             const std::string& name);
 
+  bool Has(const platform::Place& place, const std::string& name) const {
+    auto iter = device_codes_.find(place);
+    return iter != device_codes_.end() &&
+           iter->second.find(name) != iter->second.end();
+  }
+
   size_t size(const platform::Place& place) const {
     auto iter = device_codes_.find(place);
     if (iter == device_codes_.end()) {
@@ -124,6 +158,8 @@ class DeviceCodePool {
   }
 
  private:
+  void AddPlaces(const std::vector<platform::Place>& places);
+
   static DeviceCodePool* pool;
   std::map<Place, DeviceCodeMap> device_codes_;
   DISABLE_COPY_AND_ASSIGN(DeviceCodePool);
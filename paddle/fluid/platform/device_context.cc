@@ -10,6 +10,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 #include "paddle/fluid/platform/device_context.h"
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <set>
@@ -33,6 +34,10 @@ limitations under the License. */
 #include "paddle/fluid/platform/device/device_wrapper.h"
 #include "paddle/fluid/platform/profiler.h"
 
+#ifdef PADDLE_WITH_MKLDNN
+DECLARE_int32(mkldnn_primitive_cache_capacity);
+#endif
+
 namespace paddle {
 namespace memory {
 
@@ -649,6 +654,8 @@ MKLDNNDeviceContext::MKLDNNDeviceContext(CPUPlace place)
   p_blobmap_.reset(new BlobMap());
   p_exec_items_.reset(new ExecShape());
   p_mutex_.reset(new std::mutex());
+  p_primitive_cache_.reset(new MKLDNNPrimitiveCache(
+      static_cast<size_t>(std::max(FLAGS_mkldnn_primitive_cache_capacity, 0))));
 }
 
 MKLDNNDeviceContextThreadLocals::Body::Body()
@@ -727,6 +734,7 @@ void MKLDNNDeviceContext::ResetBlobMap(void* ptr) {
     // objects allocated when using given executor
     if (ptr == nullptr) {
       p_blobmap_->clear();
+      p_primitive_cache_->Clear();
     } else {
       // Iterate through all shapes and release
       // for each shape and active executor all entries
@@ -737,6 +745,7 @@ void MKLDNNDeviceContext::ResetBlobMap(void* ptr) {
         }
         s.second->erase(ptr);
       }
+      p_primitive_cache_->Erase(ptr);
     }
   } else {
     VLOG(3) << "Prevented Clearing DNNL cache.";
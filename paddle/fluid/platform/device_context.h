@@ -56,6 +56,7 @@ limitations under the License. */
 #ifdef PADDLE_WITH_MKLDNN
 #include "dnnl.hpp"
 #include "paddle/fluid/framework/data_layout.h"
+#include "paddle/fluid/platform/mkldnn_primitive_cache.h"
 #endif
 
 #include <map>
@@ -804,6 +805,11 @@ class MKLDNNDeviceContext : public CPUDeviceContext {
   // Find a saved blob. Return nullptr if not found
   std::shared_ptr<void> GetBlob(const std::string& name) const;
 
+  // The primitives shared by all the threads, keyed by hash
+  MKLDNNPrimitiveCache& GetPrimitiveCache() const {
+    return *p_primitive_cache_;
+  }
+
   static auto tls() -> decltype(MKLDNNDeviceContextThreadLocals::fetch()) {
     return MKLDNNDeviceContextThreadLocals::fetch();
   }
@@ -814,6 +820,7 @@ class MKLDNNDeviceContext : public CPUDeviceContext {
   // to erase
   std::shared_ptr<ExecShape> p_exec_items_;
   std::shared_ptr<std::mutex> p_mutex_;
+  std::shared_ptr<MKLDNNPrimitiveCache> p_primitive_cache_;
   bool block_next_cache_clearing_ = false;
 };
 #endif
@@ -269,6 +269,50 @@ PADDLE_DEFINE_EXPORTED_int32(communicator_send_queue_size, 20,
                              "queue size to recv gradient before send");
 #endif
 
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_layerwise_sample_thread_num
+ * Since Version: 2.3
+ * Value Range: int32, default=0
+ * Example: FLAGS_layerwise_sample_thread_num=8 would make
+ *          LayerWiseSampler::sample use 8 threads.
+ * Note: 0 means using all the hardware threads. The samples of a seed are
+ *       the same for any number of threads.
+ */
+PADDLE_DEFINE_EXPORTED_int32(
+    layerwise_sample_thread_num, 0,
+    "thread num of LayerWiseSampler::sample, 0 means using all "
+    "hardware threads");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_layerwise_sample_min_batch
+ * Since Version: 2.3
+ * Value Range: int32, default=256
+ * Example: FLAGS_layerwise_sample_min_batch=1024 would make
+ *          LayerWiseSampler::sample use one more thread for every 1024
+ *          targets at most.
+ */
+PADDLE_DEFINE_EXPORTED_int32(
+    layerwise_sample_min_batch, 256,
+    "minimum number of targets sampled by one thread");
+
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_pserver_merge_dense_push
+ * Since Version: 2.3
+ * Value Range: bool, default=false
+ * Example: FLAGS_pserver_merge_dense_push=true would make the async dense
+ *          tables on the pserver merge the pushes into their shards.
+ * Note: The merged gradients are applied by one thread for each shard,
+ *       without blocking the pushes. It only works for the optimizers whose
+ *       update is linear in the gradient, i.e. sgd and sum, the other
+ *       tables apply every push as before.
+ */
+PADDLE_DEFINE_EXPORTED_bool(
+    pserver_merge_dense_push, false,
+    "merge the pushes of the async dense table into its shards, and apply "
+    "them by one thread for each shard without blocking the pushes");
+
 /**
  * Distributed related FLAG
  * Name: FLAGS_dist_threadpool_size
@@ -327,6 +371,39 @@ PADDLE_DEFINE_EXPORTED_bool(
     "Fast eager deletion mode. If enabled, memory would release "
     "immediately without waiting GPU kernel ends.");
 
+/**
+ * Memory related FLAG
+ * Name: FLAGS_async_cpu_garbage_collector
+ * Since Version: 2.3.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_async_cpu_garbage_collector=true would free the CPU memory
+ *          garbage of Executor and InterpreterCore in a background thread.
+ * Note: The garbage pending in the background thread is freed in batches, in
+ *       the ascending order of addresses. Its size is bounded by
+ *       FLAGS_async_cpu_gc_max_pending_mb, beyond which the ops wait for the
+ *       background thread. Only works when garbage collection strategy is
+ *       enabled.
+ */
+PADDLE_DEFINE_EXPORTED_bool(
+    async_cpu_garbage_collector, false,
+    "Whether to free the CPU memory garbage in a background thread.");
+
+/**
+ * Memory related FLAG
+ * Name: FLAGS_async_cpu_gc_max_pending_mb
+ * Since Version: 2.3.0
+ * Value Range: int64, default=256
+ * Example: FLAGS_async_cpu_gc_max_pending_mb=64 would make the ops wait when
+ *          more than 64MB CPU memory garbage is not freed yet.
+ * Note: The bound applies to each collector, which has a background thread
+ *       of its own. Only works when FLAGS_async_cpu_garbage_collector is
+ *       true.
+ */
+PADDLE_DEFINE_EXPORTED_int64(
+    async_cpu_gc_max_pending_mb, 256,
+    "The maximum size (MB) of the CPU memory garbage pending in the "
+    "background thread of the asynchronous garbage collector.");
+
 /**
  * Memory related FLAG
  * Name: FLAGS_memory_fraction_of_eager_deletion
@@ -546,6 +623,38 @@ PADDLE_DEFINE_EXPORTED_double(
  */
 PADDLE_DEFINE_EXPORTED_bool(use_mkldnn, false, "Use MKLDNN to run");
 
+/**
+ * MKLDNN related FLAG
+ * Name: mkldnn_primitive_cache_capacity
+ * Since Version: 2.3.0
+ * Value Range: int32, default=1024
+ * Example: FLAGS_mkldnn_primitive_cache_capacity=0 disables the cache.
+ * Note: The number of oneDNN primitives kept by the hash of the operator key
+ * and shared by all the threads. The least recently used primitive is
+ * evicted when the cache is full.
+ */
+PADDLE_DEFINE_EXPORTED_int32(
+    mkldnn_primitive_cache_capacity, 1024,
+    "The capacity of the oneDNN primitive cache shared by all the threads, "
+    "0 disables it.");
+
+/**
+ * MKLDNN related FLAG
+ * Name: mkldnn_shape_bucket_size
+ * Since Version: 2.3.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_mkldnn_shape_bucket_size=16 puts the sequence lengths 1 to
+ * 16 into one bucket, 17 to 32 into the next one and so on.
+ * Note: In the cache clearing mode of the inference predictor, the input
+ * shapes are rounded up to a multiple of this size before they select the
+ * cached objects, so nearby sequence lengths count as one shape against
+ * the cache capacity. 0 disables the bucketing.
+ */
+PADDLE_DEFINE_EXPORTED_int32(
+    mkldnn_shape_bucket_size, 0,
+    "Round the input shapes up to a multiple of this size when they select "
+    "the oneDNN cache of the inference predictor, 0 disables it.");
+
 PADDLE_DEFINE_EXPORTED_bool(use_curand, false, "Random OP use CURAND");
 
 /**
@@ -592,6 +701,38 @@ PADDLE_DEFINE_EXPORTED_bool(sort_sum_gradient, false,
                             "Sum gradients by the reverse order of "
                             "the forward execution sequence.");
 
+/**
+ * Performance related FLAG
+ * Name: lazy_sum_gradient
+ * Since Version: 2.3.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_lazy_sum_gradient=true would keep the gradients of a var in
+ * dygraph until all of them arrive, and sum them at once.
+ * Note: On CPU, the SelectedRows gradients are merged in one pass and the
+ * dense gradients are summed by one multi-input kernel, which is faster for
+ * the embeddings looked up many times. FLAGS_sort_sum_gradient takes
+ * precedence over it.
+ */
+PADDLE_DEFINE_EXPORTED_bool(lazy_sum_gradient, false,
+                            "Sum all the gradients of a var at once when "
+                            "the last of them arrives.");
+
+/**
+ * Performance related FLAG
+ * Name: eager_backward_num_threads
+ * Since Version: 2.3.0
+ * Value Range: int32, default=1
+ * Example: FLAGS_eager_backward_num_threads=4 runs the independent branches
+ * of the backward graph on 4 threads.
+ * Note: The number of threads running the backward pass of eager mode on
+ * CPU. The grads are the same as with 1 thread, which runs the nodes one by
+ * one on the calling thread.
+ */
+PADDLE_DEFINE_EXPORTED_int32(
+    eager_backward_num_threads, 1,
+    "The number of threads running the backward pass of eager mode on CPU, "
+    "1 runs it on the calling thread only.");
+
 /**
  * Performance related FLAG
  * Name: max_inplace_grad_add
@@ -717,6 +858,37 @@ PADDLE_DEFINE_EXPORTED_bool(allreduce_record_one_event, false,
                             "events. Currently, only fuse allreduce supports "
                             "this. Otherwise, the precision may be wrong.");
 
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_gloo_async_allreduce
+ * Since Version: 2.3.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_gloo_async_allreduce=true makes the dygraph DataParallel
+ *          reducer on CPU allreduce the ready groups with Gloo in a
+ *          communication thread, while the backward keeps computing.
+ * Note: The groups are still communicated one by one in the order of
+ *       the groups, so all the trainers issue the same Gloo collectives.
+ */
+PADDLE_DEFINE_EXPORTED_bool(gloo_async_allreduce, false,
+                            "It controls whether the dygraph reducer on CPU "
+                            "overlaps the Gloo allreduce with the backward.");
+
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_gloo_auto_group_size
+ * Since Version: 2.3.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_gloo_auto_group_size=true makes the dygraph reducer on CPU
+ *          measure the latency and the bandwidth of the Gloo allreduce in
+ *          the first step, and regroup the dense parameters by the size that
+ *          hides the latency, instead of comm_buffer_size.
+ * Note: The measurements are averaged over the trainers, so that all of
+ *       them build the same groups.
+ */
+PADDLE_DEFINE_EXPORTED_bool(gloo_auto_group_size, false,
+                            "It controls whether the dygraph reducer on CPU "
+                            "sizes the groups from the measured bandwidth.");
+
 #ifdef PADDLE_WITH_CINN
 /*
  * CINN related FLAG
@@ -752,6 +924,64 @@ PADDLE_DEFINE_EXPORTED_string(deny_cinn_ops, "",
                               "It controls the cinn op subset to be not used.");
 #endif
 
+/*
+ * Fusion group related FLAG
+ * Name: FLAGS_fusion_group_cpu_compiler
+ * Since Version: 2.3
+ * Value Range: string, default="c++"
+ * Example: FLAGS_fusion_group_cpu_compiler="/usr/bin/g++" would compile the
+ * CPU kernels generated by fusion_group_pass with /usr/bin/g++
+ */
+PADDLE_DEFINE_EXPORTED_string(
+    fusion_group_cpu_compiler, "c++",
+    "The C++ compiler used to compile the CPU kernels of fusion_group.");
+
+/*
+ * Fusion group related FLAG
+ * Name: FLAGS_fusion_group_cpu_cache_dir
+ * Since Version: 2.3
+ * Value Range: string, default=""
+ * Example: FLAGS_fusion_group_cpu_cache_dir="/home/work/kernels" would keep
+ * the compiled CPU kernels of fusion_group in /home/work/kernels
+ * Note: The empty default means /tmp/paddle_fusion_group_<uid>. The directory
+ * must be owned by and only writable by the current user.
+ */
+PADDLE_DEFINE_EXPORTED_string(
+    fusion_group_cpu_cache_dir, "",
+    "The directory where the compiled CPU kernels of fusion_group are cached "
+    "and shared among the processes of the current user. Empty means "
+    "/tmp/paddle_fusion_group_<uid>.");
+
+/*
+ * Operator related FLAG
+ * Name: FLAGS_embedding_merge_sparse_grad
+ * Since Version: 2.3
+ * Value Range: bool, default=false
+ * Example: FLAGS_embedding_merge_sparse_grad=true would make the CPU kernel
+ * of lookup_table_v2 sort the ids of its sparse gradient and sum the
+ * gradients of the duplicated ids, so every row appears once.
+ * Note: The summed gradient is numerically the same as the dense one, and
+ * the optimizer updates every row once.
+ */
+PADDLE_DEFINE_EXPORTED_bool(
+    embedding_merge_sparse_grad, false,
+    "Whether to merge the duplicated rows of the sparse gradient of the "
+    "embedding on CPU.");
+
+/*
+ * Executor related FLAG
+ * Name: FLAGS_cache_control_flow_block
+ * Since Version: 2.3
+ * Value Range: bool, default=true
+ * Example: FLAGS_cache_control_flow_block=false would make while_op and
+ * conditional_block_op prepare their sub-blocks on every run.
+ * Note: When it is true, the prepared sub-block is kept by the op, and the
+ * step scope of while_op in inference is reused by the following runs.
+ */
+PADDLE_DEFINE_EXPORTED_bool(
+    cache_control_flow_block, true,
+    "Whether to keep the prepared sub-blocks of the control flow ops.");
+
 DEFINE_int32(record_pool_max_size, 2000000,
              "SlotRecordDataset slot record pool max size");
 DEFINE_int32(slotpool_thread_num, 1, "SlotRecordDataset slot pool thread num");
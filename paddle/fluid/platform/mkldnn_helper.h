@@ -18,6 +18,7 @@ limitations under the License. */
 #include <memory>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "dnnl.hpp"
@@ -432,15 +433,52 @@ inline MKLDNNMemoryFormat StringToMKLDNNFormat(std::string* format) {
 }
 
 inline std::string ThreadIDasStr(void) {
-  return std::to_string(
+  // Every handler extends its key with it, so it is formatted once per
+  // thread.
+  thread_local const std::string tid = std::to_string(
       std::hash<std::thread::id>()(std::this_thread::get_id()));
+  return tid;
+}
+
+// Keys are built for every operator run, so the integers are formatted in
+// place instead of through a temporary std::string.
+inline void AppendInteger(std::string* key, uint64_t value) {
+  char buf[20];
+  char* end = buf + sizeof(buf);
+  char* p = end;
+  do {
+    *--p = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  key->append(p, end - p);
+}
+
+inline void AppendInteger(std::string* key, int64_t value) {
+  if (value < 0) {
+    key->push_back('-');
+    AppendInteger(key, 0 - static_cast<uint64_t>(value));
+  } else {
+    AppendInteger(key, static_cast<uint64_t>(value));
+  }
 }
 
 template <typename T>
-inline void AppendKey(std::string* key, const T& num) {
+inline void AppendNumber(std::string* key, const T& num, std::true_type) {
+  using Wide = typename std::conditional<std::is_signed<T>::value, int64_t,
+                                         uint64_t>::type;
+  AppendInteger(key, static_cast<Wide>(num));
+}
+
+template <typename T>
+inline void AppendNumber(std::string* key, const T& num, std::false_type) {
   key->append(std::to_string(num));
 }
 
+template <typename T>
+inline void AppendKey(std::string* key, const T& num) {
+  AppendNumber(key, num, std::is_integral<T>());
+}
+
 template <>
 inline void AppendKey(std::string* key,
                       const dnnl::memory::format_tag& format) {
@@ -473,7 +511,7 @@ inline void AppendKey(std::string* key, const char* str) { key->append(str); }
 template <typename T>
 inline void AppendKey(std::string* key, const std::vector<T>& dims) {
   for (size_t i = 0; i < dims.size(); i++) {
-    AppendKey(key, std::to_string(dims[i]));
+    AppendKey(key, dims[i]);
   }
 }
 
@@ -0,0 +1,110 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/mkldnn_primitive_cache.h"
+
+namespace paddle {
+namespace platform {
+
+MKLDNNPrimitiveCache::MKLDNNPrimitiveCache(size_t capacity)
+    : capacity_(capacity),
+      shard_capacity_((capacity + kNumShards - 1) / kNumShards),
+      shards_(static_cast<size_t>(kNumShards)) {}
+
+std::shared_ptr<void> MKLDNNPrimitiveCache::Get(uint64_t hash,
+                                                const std::string& key) {
+  if (capacity_ == 0) return nullptr;
+  auto& shard = GetShard(hash);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto iter = shard.index.find(hash);
+  if (iter == shard.index.end() || iter->second->key != key) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  shard.lru.splice(shard.lru.begin(), shard.lru, iter->second);
+  return iter->second->value;
+}
+
+void MKLDNNPrimitiveCache::Set(uint64_t hash, const std::string& key,
+                               std::shared_ptr<void> value, void* owner) {
+  if (capacity_ == 0) return;
+  auto& shard = GetShard(hash);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto iter = shard.index.find(hash);
+  if (iter != shard.index.end()) {
+    // also taken by another key of the same hash, which is replaced
+    iter->second->key = key;
+    iter->second->value = std::move(value);
+    iter->second->owner = owner;
+    shard.lru.splice(shard.lru.begin(), shard.lru, iter->second);
+    return;
+  }
+  if (shard.lru.size() >= shard_capacity_) {
+    shard.index.erase(shard.lru.back().hash);
+    shard.lru.pop_back();
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+  shard.lru.push_front(Entry{hash, key, owner, std::move(value)});
+  shard.index[hash] = shard.lru.begin();
+}
+
+void MKLDNNPrimitiveCache::Clear() {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    shard.index.clear();
+    shard.lru.clear();
+  }
+}
+
+void MKLDNNPrimitiveCache::Erase(void* owner) {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    for (auto iter = shard.lru.begin(); iter != shard.lru.end();) {
+      if (iter->owner == owner) {
+        shard.index.erase(iter->hash);
+        iter = shard.lru.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+  }
+}
+
+size_t MKLDNNPrimitiveCache::Size() const {
+  size_t size = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    size += shard.lru.size();
+  }
+  return size;
+}
+
+MKLDNNPrimitiveCacheStats MKLDNNPrimitiveCache::Stats() const {
+  MKLDNNPrimitiveCacheStats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.evictions = evictions_.load(std::memory_order_relaxed);
+  stats.size = Size();
+  return stats;
+}
+
+void MKLDNNPrimitiveCache::ResetStats() {
+  hits_ = 0;
+  misses_ = 0;
+  evictions_ = 0;
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,131 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace platform {
+
+inline uint64_t HashCombine(uint64_t seed, uint64_t value) {
+  // The mixing step of boost::hash_combine, widened to 64 bits.
+  return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+// FNV-1a of the bytes of `key`, stable across runs and platforms.
+inline uint64_t HashKey(const std::string& key) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : key) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+struct MKLDNNPrimitiveCacheStats {
+  int64_t hits{0};
+  int64_t misses{0};
+  int64_t evictions{0};
+  size_t size{0};
+
+  double HitRate() const {
+    return hits + misses == 0 ? 0.0
+                              : static_cast<double>(hits) / (hits + misses);
+  }
+};
+
+/*
+ * MKLDNNPrimitiveCache keeps the oneDNN primitives, which are immutable
+ * once created, by the 64-bit hash of the operator key. The key itself is
+ * kept next to the value and compared on every hit, so two keys of the same
+ * hash never get each other's value, they only replace each other in the
+ * cache. Unlike the blob map
+ * of MKLDNNDeviceContext, it is shared by all the threads and evicts the
+ * least recently used primitive one by one when it is full, instead of
+ * dropping every object of an input shape at once.
+ *
+ * The keys must carry everything the blob map key carries, that is the
+ * session, the executor and the thread when it is used in the key, since
+ * the base keys of different programs may be the same.
+ *
+ * The keys are spread over a fixed number of shards, each of them with its
+ * own lock and LRU list, so that the threads running different operators
+ * rarely wait for each other.
+ */
+class MKLDNNPrimitiveCache {
+ public:
+  // The capacity is split evenly over the shards. A capacity of 0 disables
+  // the cache, Get always misses and Set does nothing.
+  explicit MKLDNNPrimitiveCache(size_t capacity);
+
+  // `hash` must be the same for the same `key`, e.g. HashKey(key).
+  std::shared_ptr<void> Get(uint64_t hash, const std::string& key);
+  // `owner` is the executor that created the value, or nullptr.
+  void Set(uint64_t hash, const std::string& key, std::shared_ptr<void> value,
+           void* owner = nullptr);
+  void Clear();
+  // Drops the values created by `owner`, along with its blob map entries.
+  void Erase(void* owner);
+
+  bool Enabled() const { return capacity_ > 0; }
+  size_t Capacity() const { return capacity_; }
+  size_t Size() const;
+
+  MKLDNNPrimitiveCacheStats Stats() const;
+  void ResetStats();
+
+ private:
+  static constexpr size_t kNumShards = 16;
+
+  struct Entry {
+    uint64_t hash;
+    std::string key;
+    void* owner;
+    std::shared_ptr<void> value;
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    // The most recently used entry is at the front.
+    std::list<Entry> lru;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+  };
+
+  Shard& GetShard(uint64_t hash) {
+    // The keys of similar operators differ in a few bits, mix them first.
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return shards_[hash % kNumShards];
+  }
+
+  size_t capacity_;
+  size_t shard_capacity_;
+  std::vector<Shard> shards_;
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> misses_{0};
+  std::atomic<int64_t> evictions_{0};
+};
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,134 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/mkldnn_primitive_cache.h"
+
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace platform {
+
+static std::string Key(int i) { return "conv2d-" + std::to_string(i); }
+
+static std::shared_ptr<void> Get(MKLDNNPrimitiveCache* cache, int i) {
+  return cache->Get(HashKey(Key(i)), Key(i));
+}
+
+static void Set(MKLDNNPrimitiveCache* cache, int i, int value,
+                void* owner = nullptr) {
+  cache->Set(HashKey(Key(i)), Key(i), std::make_shared<int>(value), owner);
+}
+
+TEST(MKLDNNPrimitiveCache, GetAndSet) {
+  MKLDNNPrimitiveCache cache(64);
+  ASSERT_EQ(Get(&cache, 0), nullptr);
+  Set(&cache, 0, 7);
+  auto value = std::static_pointer_cast<int>(Get(&cache, 0));
+  ASSERT_NE(value, nullptr);
+  ASSERT_EQ(*value, 7);
+  // Set replaces the value of an existing key
+  Set(&cache, 0, 8);
+  ASSERT_EQ(*std::static_pointer_cast<int>(Get(&cache, 0)), 8);
+  ASSERT_EQ(cache.Size(), 1UL);
+
+  auto stats = cache.Stats();
+  ASSERT_EQ(stats.hits, 2);
+  ASSERT_EQ(stats.misses, 1);
+  cache.Clear();
+  ASSERT_EQ(Get(&cache, 0), nullptr);
+  uint64_t hash = HashKey(Key(0));
+  ASSERT_NE(HashCombine(hash, 1), HashCombine(hash, 2));
+}
+
+TEST(MKLDNNPrimitiveCache, SameHashOtherKey) {
+  MKLDNNPrimitiveCache cache(64);
+  cache.Set(1, "conv2d@fwd_p", std::make_shared<int>(1));
+  // a colliding key misses instead of getting the other value
+  ASSERT_EQ(cache.Get(1, "pool2d@fwd_p"), nullptr);
+  cache.Set(1, "pool2d@fwd_p", std::make_shared<int>(2));
+  ASSERT_EQ(cache.Get(1, "conv2d@fwd_p"), nullptr);
+  ASSERT_EQ(*std::static_pointer_cast<int>(cache.Get(1, "pool2d@fwd_p")), 2);
+  ASSERT_EQ(cache.Size(), 1UL);
+}
+
+TEST(MKLDNNPrimitiveCache, EvictLeastRecentlyUsed) {
+  const int capacity = 64;
+  MKLDNNPrimitiveCache cache(capacity);
+  for (int i = 0; i < capacity * 4; ++i) {
+    Set(&cache, i, i);
+    // Key 0 stays hot, it must never be evicted
+    ASSERT_NE(Get(&cache, 0), nullptr);
+  }
+  auto stats = cache.Stats();
+  ASSERT_LE(stats.size, static_cast<size_t>(capacity));
+  ASSERT_GT(stats.evictions, 0);
+  // Every entry is evicted on its own, the recent ones are still there
+  ASSERT_NE(Get(&cache, capacity * 4 - 1), nullptr);
+  ASSERT_EQ(Get(&cache, 1), nullptr);
+}
+
+TEST(MKLDNNPrimitiveCache, EraseByExecutor) {
+  MKLDNNPrimitiveCache cache(64);
+  int exec0 = 0, exec1 = 0;
+  for (int i = 0; i < 8; ++i) {
+    Set(&cache, i, i, i % 2 ? &exec1 : &exec0);
+  }
+  cache.Erase(&exec0);
+  ASSERT_EQ(cache.Size(), 4UL);
+  ASSERT_EQ(Get(&cache, 0), nullptr);
+  ASSERT_NE(Get(&cache, 1), nullptr);
+}
+
+TEST(MKLDNNPrimitiveCache, Disabled) {
+  MKLDNNPrimitiveCache cache(0);
+  ASSERT_FALSE(cache.Enabled());
+  Set(&cache, 0, 0);
+  ASSERT_EQ(Get(&cache, 0), nullptr);
+  ASSERT_EQ(cache.Size(), 0UL);
+}
+
+TEST(MKLDNNPrimitiveCache, SharedByThreads) {
+  MKLDNNPrimitiveCache cache(1024);
+  const int num_threads = 8;
+  const int num_keys = 256;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&cache]() {
+      for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < num_keys; ++i) {
+          auto value = Get(&cache, i);
+          if (value == nullptr) {
+            Set(&cache, i, i);
+          } else {
+            ASSERT_EQ(*std::static_pointer_cast<int>(value), i);
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  auto stats = cache.Stats();
+  ASSERT_EQ(stats.size, static_cast<size_t>(num_keys));
+  ASSERT_EQ(stats.hits + stats.misses, num_threads * num_keys * 4);
+  // Only the first lookups of every key may miss
+  ASSERT_LE(stats.misses, num_threads * num_keys);
+  ASSERT_GT(stats.HitRate(), 0.7);
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -257,40 +257,19 @@ class MKLDNNHandlerT {
   }
 
   std::shared_ptr<TForward> AcquireForwardPrimitive() {
-    const std::string key_p = key_ + "@fwd_p";
-    auto forward_p =
-        std::static_pointer_cast<TForward>(dev_ctx_.GetBlob(key_p));
-    if (forward_p == nullptr) {
-      forward_p = std::make_shared<TForward>(*fwd_pd_);
-      dev_ctx_.SetBlob(key_p, forward_p);
-    }
-    return forward_p;
+    return AcquirePrimitive<TForward>(fwd_pd_, "@fwd_p", 1);
   }
 
   std::shared_ptr<TBackward> AcquireBackwardPrimitive() {
-    const std::string key_p = key_ + "@bwd_p";
-    auto backward_p =
-        std::static_pointer_cast<TBackward>(dev_ctx_.GetBlob(key_p));
-    if (backward_p == nullptr) {
-      backward_p = std::make_shared<TBackward>(*bwd_pd_);
-      dev_ctx_.SetBlob(key_p, backward_p);
-    }
-    return backward_p;
+    return AcquirePrimitive<TBackward>(bwd_pd_, "@bwd_p", 2);
   }
 
   std::shared_ptr<TBackward_params> AcquireBackwardWeightsPrimitive() {
-    const std::string key_p = key_ + "@bwd_w_p";
-    auto backward_p =
-        std::static_pointer_cast<TBackward_params>(dev_ctx_.GetBlob(key_p));
-    if (backward_p == nullptr) {
-      PADDLE_ENFORCE_NOT_NULL(bwd_w_pd_, platform::errors::Unavailable(
-                                             "BWD_PD should be set when "
-                                             "getting BWD prim witk key: %s .",
-                                             key_p));
-      backward_p = std::make_shared<TBackward_params>(*bwd_w_pd_);
-      dev_ctx_.SetBlob(key_p, backward_p);
-    }
-    return backward_p;
+    PADDLE_ENFORCE_NOT_NULL(bwd_w_pd_, platform::errors::Unavailable(
+                                           "BWD_PD should be set when "
+                                           "getting BWD prim witk key: %s .",
+                                           key_ + "@bwd_w_p"));
+    return AcquirePrimitive<TBackward_params>(bwd_w_pd_, "@bwd_w_p", 3);
   }
 
   std::shared_ptr<dnnl::memory> AcquireSrcMemory(
@@ -361,6 +340,47 @@ class MKLDNNHandlerT {
   }
 
  protected:
+  // Primitives do not change once created, so they go to the primitive
+  // cache of the device context, which evicts them one by one instead of a
+  // whole input shape at once. They are keyed by the full key, the session
+  // and the executor, like the blob map, and are dropped with the blob map
+  // entries of their executor. The blob map is used when the cache is
+  // disabled.
+  template <typename TPrimitive, typename TPrimitiveDesc>
+  std::shared_ptr<TPrimitive> AcquirePrimitive(
+      const std::shared_ptr<TPrimitiveDesc>& pd, const char* suffix,
+      uint64_t kind) {
+    auto& cache = dev_ctx_.GetPrimitiveCache();
+    if (!cache.Enabled()) {
+      const std::string key_p = key_ + suffix;
+      auto prim_p =
+          std::static_pointer_cast<TPrimitive>(dev_ctx_.GetBlob(key_p));
+      if (prim_p == nullptr) {
+        prim_p = std::make_shared<TPrimitive>(*pd);
+        dev_ctx_.SetBlob(key_p, prim_p);
+      }
+      return prim_p;
+    }
+    auto& tls = platform::MKLDNNDeviceContext::tls();
+    if (scoped_key_.empty()) {
+      scoped_key_ = key_ + "-s" +
+                    std::to_string(tls.get_cur_mkldnn_session_id()) + "-e" +
+                    std::to_string(
+                        reinterpret_cast<uintptr_t>(tls.get_curr_exec()));
+      key_hash_ = platform::HashKey(scoped_key_);
+    }
+    // the suffix tells the type of the primitive, the cache compares it
+    const std::string key_p = scoped_key_ + suffix;
+    const uint64_t hash_p = platform::HashCombine(key_hash_, kind);
+    auto prim_p =
+        std::static_pointer_cast<TPrimitive>(cache.Get(hash_p, key_p));
+    if (prim_p == nullptr) {
+      prim_p = std::make_shared<TPrimitive>(*pd);
+      cache.Set(hash_p, key_p, prim_p, tls.get_curr_exec());
+    }
+    return prim_p;
+  }
+
   bool isCached() {
     const std::string key_pd = key_ + "@fwd_pd";
     fwd_pd_ = std::static_pointer_cast<typename TForward::primitive_desc>(
@@ -600,6 +620,10 @@ class MKLDNNHandlerT {
   platform::Place place_;
   std::string key_common_;
   std::string key_;
+  // The key with the session and the executor, and its hash, computed on
+  // the first cached primitive.
+  std::string scoped_key_;
+  uint64_t key_hash_{0};
   std::shared_ptr<typename TForward::primitive_desc> fwd_pd_;
   std::shared_ptr<typename TBackward::primitive_desc> bwd_pd_;
   std::shared_ptr<typename TBackward_params::primitive_desc> bwd_w_pd_;
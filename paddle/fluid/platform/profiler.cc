@@ -329,6 +329,10 @@ void EnableProfiler(ProfilerState state) {
   g_state = state;
   should_send_profile_state = true;
   GetDeviceTracer()->Enable();
+#ifdef PADDLE_WITH_MKLDNN
+  auto *mkldnn_cache = GetMKLDNNPrimitiveCache();
+  if (mkldnn_cache != nullptr) mkldnn_cache->ResetStats();
+#endif
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   if (g_state == ProfilerState::kCUDA || g_state == ProfilerState::kAll ||
       g_state == ProfilerState::kCPU) {
@@ -387,6 +391,9 @@ void DisableProfiler(EventSortingKey sorted_key,
 
   std::vector<std::vector<MemEvent>> all_mem_events = GetMemEvents();
   ParseMemEvents(all_mem_events);
+#ifdef PADDLE_WITH_MKLDNN
+  PrintMKLDNNCacheProfiler();
+#endif
 
   ResetProfiler();
   g_state = ProfilerState::kDisabled;
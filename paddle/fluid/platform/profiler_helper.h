@@ -187,6 +187,36 @@ void ParseMemEvents(const std::vector<std::vector<MemEvent>> &events) {
   PrintMemProfiler(annotation_report, 55, 18);
 }
 
+#ifdef PADDLE_WITH_MKLDNN
+MKLDNNPrimitiveCache *GetMKLDNNPrimitiveCache() {
+  auto *dev_ctx = dynamic_cast<MKLDNNDeviceContext *>(
+      DeviceContextPool::Instance().Get(CPUPlace()));
+  return dev_ctx == nullptr ? nullptr : &dev_ctx->GetPrimitiveCache();
+}
+
+// Print the oneDNN primitive cache statistics of the profiling period
+void PrintMKLDNNCacheProfiler() {
+  if (g_state == ProfilerState::kDisabled) return;
+  auto *cache = GetMKLDNNPrimitiveCache();
+  if (cache == nullptr || !cache->Enabled()) return;
+  auto stats = cache->Stats();
+  std::cout << "\n------------------------->"
+            << "  oneDNN Primitive Cache Report "
+            << "<-------------------------\n\n";
+  std::cout.setf(std::ios::left);
+  std::cout << std::setw(18) << "Hits" << std::setw(18) << "Misses"
+            << std::setw(18) << "Hit Rate" << std::setw(18) << "Evictions"
+            << std::setw(18) << "Size/Capacity" << std::endl;
+  std::cout << std::setw(18) << stats.hits << std::setw(18) << stats.misses
+            << std::setw(18) << stats.HitRate() << std::setw(18)
+            << stats.evictions << std::setw(18)
+            << string::Sprintf("%d/%d", stats.size, cache->Capacity())
+            << std::endl
+            << std::endl;
+  cache->ResetStats();
+}
+#endif
+
 void DealWithShowName() {
   std::unordered_map<std::string, std::vector<std::string>> profiler_name_info;
   for (auto it = g_all_event_lists.begin(); it != g_all_event_lists.end();
@@ -480,6 +480,7 @@ void SetTensorFromPyArray(framework::Tensor *self, const py::object &obj,
         "float64, int8, int16, int32, int64, uint8 or uint16, "
         "please check your input or input array data type."));
   }
+  framework::BumpTensorLoadGeneration();
 }
 
 template <typename T>
@@ -45,6 +45,19 @@ class TrainerRuntimeConfig(object):
             "FLAGS_communicator_send_wait_times", "5")
         self.runtime_configs['communicator_is_sgd_optimizer'] = os.getenv(
             "FLAGS_communicator_is_sgd_optimizer", "1")
+        self.runtime_configs[
+            'communicator_merge_sparse_on_enqueue'] = os.getenv(
+                "FLAGS_communicator_merge_sparse_on_enqueue", "0")
+        self.runtime_configs['communicator_sparse_merge_max_rows'] = os.getenv(
+            "FLAGS_communicator_sparse_merge_max_rows", "0")
+        self.runtime_configs['communicator_sparse_hot_cache_rows'] = os.getenv(
+            "FLAGS_communicator_sparse_hot_cache_rows", "0")
+        self.runtime_configs[
+            'communicator_sparse_hot_cache_refresh_steps'] = os.getenv(
+                "FLAGS_communicator_sparse_hot_cache_refresh_steps", "100")
+        self.runtime_configs[
+            'communicator_sparse_hot_cache_push_steps'] = os.getenv(
+                "FLAGS_communicator_sparse_hot_cache_push_steps", "10")
 
         # not used 
         self.runtime_configs['rpc_deadline'] = os.getenv("FLAGS_rpc_deadline",
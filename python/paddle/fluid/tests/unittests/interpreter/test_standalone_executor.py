@@ -352,5 +352,54 @@ class TestException(unittest.TestCase):
             self.fetch_vars.name))
 
 
+class TestVariableSeqLen(unittest.TestCase):
+    def setUp(self):
+        self.place = paddle.CUDAPlace(0) if core.is_compiled_with_cuda(
+        ) else paddle.CPUPlace()
+        # the same lengths in a row skip InferShape
+        self.seq_lens = [3, 7, 7, 3, 5, 5, 5, 1]
+
+    def build_program(self):
+        main_program = paddle.static.Program()
+        startup_program = paddle.static.Program()
+        with paddle.static.program_guard(main_program, startup_program):
+            x = paddle.static.data(name="x", shape=[2, -1, 8], dtype='float32')
+            h = paddle.static.nn.fc(x, 8, num_flatten_dims=2)
+            h = paddle.nn.functional.softmax(h, axis=1)
+            # the shape of the output depends on the data of a tensor
+            shape = paddle.shape(h)
+            h = paddle.reshape(h, shape=[shape[0] * shape[1], 8])
+            out = paddle.sum(h, axis=1)
+        return main_program, startup_program, out
+
+    def _run(self, cache_infer_shape):
+        paddle.fluid.set_flags({
+            'FLAGS_new_executor_cache_infer_shape': cache_infer_shape
+        })
+        paddle.seed(2020)
+        main_program, startup_program, out = self.build_program()
+        scope = paddle.static.Scope()
+        exe = paddle.static.Executor(self.place)
+        outs = []
+        os.environ['FLAGS_USE_STANDALONE_EXECUTOR'] = '1'
+        with paddle.static.scope_guard(scope):
+            exe.run(startup_program)
+            for seq_len in self.seq_lens:
+                x = np.random.RandomState(seq_len).random(
+                    [2, seq_len, 8]).astype('float32')
+                outs.append(
+                    exe.run(main_program, feed={'x': x}, fetch_list=[out])[0])
+        del os.environ['FLAGS_USE_STANDALONE_EXECUTOR']
+        paddle.fluid.set_flags({'FLAGS_new_executor_cache_infer_shape': True})
+        return outs
+
+    def test_result(self):
+        res = self._run(True)
+        gt = self._run(False)
+        for seq_len, x, y in zip(self.seq_lens, gt, res):
+            self.assertEqual(y.shape, (2 * seq_len, ))
+            self.assertTrue(np.allclose(x, y))
+
+
 if __name__ == "__main__":
     unittest.main()
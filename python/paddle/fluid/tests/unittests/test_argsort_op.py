@@ -442,5 +442,37 @@ class TestArgsortImperative4(TestArgsortImperative):
         self.axis = 1
 
 
+class TestArgsortInt64Stable(unittest.TestCase):
+    # The integers are sorted stably on CPU, the equal values keep the order
+    # of their indices in both directions.
+    def init(self):
+        self.input_shape = [4, 3000]
+        self.axis = 1
+
+    def setUp(self):
+        self.init()
+        self.input_data = np.random.randint(
+            -50, 50, self.input_shape, dtype='int64')
+        self.place = core.CPUPlace()
+
+    def test_api(self):
+        paddle.disable_static(self.place)
+        var_x = paddle.to_tensor(self.input_data)
+        out = paddle.argsort(var_x, axis=self.axis)
+        expect = np.argsort(self.input_data, axis=self.axis, kind='stable')
+        self.assertTrue((expect == out.numpy()).all())
+
+        out2 = paddle.argsort(var_x, axis=self.axis, descending=True)
+        expect2 = np.argsort(-self.input_data, axis=self.axis, kind='stable')
+        self.assertTrue((expect2 == out2.numpy()).all())
+        paddle.enable_static()
+
+
+class TestArgsortInt64Stable2(TestArgsortInt64Stable):
+    def init(self):
+        self.input_shape = [200000, 2]
+        self.axis = 0
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -89,17 +89,43 @@ class TestBatchFCOp1(OpTest):
         self.outputs = {"Out": np_out}
 
     def test_check_output_cpu(self):
-        try:
-            self.check_output_with_place(place=core.CPUPlace())
-        except:
-            print("do not support cpu test, skip")
+        self.check_output_with_place(place=core.CPUPlace())
 
     def test_check_grad_cpu(self):
-        try:
-            self.check_grad_with_place(core.CPUPlace(), ["Bias", "W", "Input"],
-                                       "Out")
-        except:
-            print("do not support cpu test, skip")
+        self.check_grad_with_place(core.CPUPlace(), ["Bias", "W", "Input"],
+                                   "Out")
+
+
+class TestBatchFCOpRelu(OpTest):
+    def config(self):
+        self.slot_pairs_num = 6
+        self.batch_size = 7
+        self.in_dim = 9
+        self.out_dim = 11
+        self.dtype = "float64"
+
+    def setUp(self):
+        self.config()
+        self.input = np.random.uniform(
+            -1, 1, (self.slot_pairs_num, self.batch_size,
+                    self.in_dim)).astype(self.dtype)
+        self.w = np.random.uniform(-1, 1, (self.slot_pairs_num, self.in_dim,
+                                           self.out_dim)).astype(self.dtype)
+        self.bias = np.random.uniform(
+            -1, 1, (self.slot_pairs_num, self.out_dim)).astype(self.dtype)
+        self.op_type = "batch_fc"
+        np_out = np_cal_batchfc(self.input, self.w, self.bias)
+        np_out = np.maximum(np_out, 0).astype(self.dtype)
+        self.inputs = {"Input": self.input, "W": self.w, "Bias": self.bias}
+        self.attrs = {"activation_type": "relu"}
+        self.outputs = {"Out": np_out}
+
+    def test_check_output_cpu(self):
+        self.check_output_with_place(place=core.CPUPlace())
+
+    def test_check_output_gpu(self):
+        if core.is_compiled_with_cuda():
+            self.check_output_with_place(core.CUDAPlace(0))
 
 
 if __name__ == "__main__":
@@ -176,6 +176,12 @@ class TestCRFDecodingOp4(TestCRFDecodingOp2):
         self.lod = [[0, 2, 3, 0]]
 
 
+class TestCRFDecodingOpManySequences(TestCRFDecodingOp2):
+    # Enough sequences, some of them empty, to be split across the threads.
+    def init_lod(self):
+        self.lod = [[random.randint(0, 20) for _ in range(200)]]
+
+
 def seq_pad(data, length):
     max_len = np.max(length)
     shape = [len(length), max_len] + list(data.shape[1:])
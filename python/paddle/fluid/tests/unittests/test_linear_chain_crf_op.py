@@ -99,13 +99,19 @@ class LinearChainCrfForward(object):
 
 
 class TestLinearChainCrfOp(OpTest):
+    def init_shape(self):
+        self.seq_num = 3
+        self.tag_num = 17
+        self.max_seq_len = 5
+
     def set_test_data(self):
         # TODO(caoying) Fix the unittest by: add the boundary cases when
         # sequence lengths are 1, 2, and 3.
 
-        SEQ_NUM = 3
-        TAG_NUM = 17
-        MAX_SEQ_LEN = 5
+        self.init_shape()
+        SEQ_NUM = self.seq_num
+        TAG_NUM = self.tag_num
+        MAX_SEQ_LEN = self.max_seq_len
 
         # the linear_chain_crf operator only supports sequence (LoD level = 1)
         lod = [[]]
@@ -157,6 +163,21 @@ class TestLinearChainCrfOp(OpTest):
             ["Emission"], "LogLikelihood", no_grad_set=set("Transition"))
 
 
+class TestLinearChainCrfOpManySequences(TestLinearChainCrfOp):
+    # Enough sequences to be split across the threads.
+    def init_shape(self):
+        self.seq_num = 64
+        self.tag_num = 17
+        self.max_seq_len = 10
+
+    def test_check_grad(self):
+        self.check_grad(
+            ["Transition"], "LogLikelihood", no_grad_set=set("Emission"))
+
+    def test_check_grad_ignore_transition(self):
+        pass
+
+
 class TestLinearChainCrfPaddingTensor(OpTest):
     def seq_pad(self, data, length):
         max_len = np.max(length)
@@ -235,6 +235,64 @@ class TestLookupTableIsSparse(unittest.TestCase):
             w_grad1, w_grad2, rtol=tolerance, atol=tolerance)
 
 
+class TestLookupTableMergeSparseGrad(unittest.TestCase):
+    def setUp(self):
+        self.flag = paddle.get_flags('FLAGS_embedding_merge_sparse_grad')[
+            'FLAGS_embedding_merge_sparse_grad']
+
+    def tearDown(self):
+        paddle.set_flags({'FLAGS_embedding_merge_sparse_grad': self.flag})
+
+    def zipf_ids(self, size, vocab_size):
+        ids = np.random.zipf(1.2, size=size) - 1
+        return np.minimum(ids, vocab_size - 1).astype('int64')
+
+    def run_embedding(self, w, ids, out_grad, merge, padding_idx=None):
+        paddle.set_flags({'FLAGS_embedding_merge_sparse_grad': merge})
+        emb = paddle.nn.Embedding(
+            w.shape[0],
+            w.shape[1],
+            padding_idx=padding_idx,
+            sparse=True,
+            weight_attr=paddle.ParamAttr(
+                initializer=paddle.nn.initializer.Assign(w)))
+        out = emb(paddle.to_tensor(ids))
+        out.backward(paddle.to_tensor(out_grad))
+        grad = emb.weight._grad_ivar().value().get_selected_rows()
+        return out.numpy(), grad.rows(), np.array(grad.get_tensor())
+
+    def check_merged_grad(self, ids, padding_idx=None):
+        vocab_size, width = 100, 16
+        w = np.random.random((vocab_size, width)).astype('float32')
+        out_grad = np.random.random(ids.shape + (width, )).astype('float32')
+        out, rows, values = self.run_embedding(
+            w, ids, out_grad, False, padding_idx=padding_idx)
+        merged_out, merged_rows, merged_values = self.run_embedding(
+            w, ids, out_grad, True, padding_idx=padding_idx)
+        self.assertTrue(np.array_equal(out, merged_out))
+
+        expected_rows = np.unique(ids)
+        if padding_idx is not None:
+            expected_rows = expected_rows[expected_rows != padding_idx]
+        self.assertEqual(merged_rows, expected_rows.tolist())
+
+        dense_grad = np.zeros_like(w)
+        for row, value in zip(rows, values):
+            if row != padding_idx:
+                dense_grad[row] += value
+        np.testing.assert_allclose(
+            merged_values, dense_grad[merged_rows], rtol=1e-5, atol=1e-6)
+
+    def test_merge(self):
+        with fluid.dygraph.guard(fluid.CPUPlace()):
+            self.check_merged_grad(self.zipf_ids((8, 64), 100))
+            self.check_merged_grad(np.array([[5, 5, 5, 5]]).astype('int64'))
+
+    def test_merge_with_padding(self):
+        with fluid.dygraph.guard(fluid.CPUPlace()):
+            self.check_merged_grad(self.zipf_ids((8, 64), 100), padding_idx=0)
+
+
 class TestLookupTableApi(unittest.TestCase):
     def test_api(self):
         x = fluid.layers.data(name='x', shape=[20], dtype='int64')
@@ -0,0 +1,65 @@
+# Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import os
+import unittest
+
+from test_dist_base import TestDistBase
+
+flag_name = os.path.splitext(__file__)[0]
+
+SYNC_ENVS = {
+    "FLAGS_gloo_async_allreduce": "0",
+    "FLAGS_gloo_auto_group_size": "0",
+}
+
+ASYNC_ENVS = {
+    "FLAGS_gloo_async_allreduce": "1",
+    "FLAGS_gloo_auto_group_size": "1",
+}
+
+
+class TestParallelDygraphAsyncAllReduce_GLOO(TestDistBase):
+    def _setup_config(self):
+        self._sync_mode = False
+        self._gloo_mode = True
+        self._dygraph = True
+
+    def run_with_envs(self, model_file, envs):
+        self.check_with_place(
+            model_file,
+            delta=1e-5,
+            check_error_log=True,
+            need_envs=envs,
+            log_name=flag_name)
+
+    def compare_with_sync(self, model_file):
+        # both reducers must match the local training
+        self.run_with_envs(model_file, SYNC_ENVS)
+        self.run_with_envs(model_file, ASYNC_ENVS)
+
+    def test_mnist(self):
+        self.compare_with_sync("parallel_dygraph_mnist.py")
+
+    def test_sparse_embedding(self):
+        self.compare_with_sync("parallel_dygraph_sparse_embedding.py")
+
+    def test_unused_variables(self):
+        self.run_with_envs("parallel_dygraph_unused_variables.py", ASYNC_ENVS)
+
+
+if __name__ == "__main__":
+    unittest.main()
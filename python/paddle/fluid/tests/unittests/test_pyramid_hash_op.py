@@ -58,5 +58,140 @@ class TestPyramidHashOpApi(unittest.TestCase):
                       return_numpy=False)
 
 
+class TestPyramidHashCache(unittest.TestCase):
+    def run_program(self, x_data, x_lod, cache_capacity):
+        fluid.set_flags({'FLAGS_pyramid_hash_cache_capacity': cache_capacity})
+        num_voc = 128
+        embed_dim = 64
+        main_program = fluid.Program()
+        startup_program = fluid.Program()
+        with fluid.program_guard(main_program, startup_program):
+            x = fluid.data(
+                name='x', shape=list(x_data.shape), dtype='int32', lod_level=1)
+            hash_embd = fluid.contrib.search_pyramid_hash(
+                input=x,
+                num_emb=embed_dim,
+                space_len=num_voc * embed_dim,
+                pyramid_layer=4,
+                rand_len=16,
+                drop_out_percent=0.0,
+                is_training=False,
+                use_filter=False,
+                white_list_len=6400,
+                black_list_len=2800,
+                seed=3,
+                lr=0.002,
+                param_attr=fluid.ParamAttr(
+                    name="PyramidHash_emb_cache",
+                    initializer=fluid.initializer.Uniform(seed=1)),
+                param_attr_wl=fluid.ParamAttr(name="Filter_cache"),
+                param_attr_bl=None,
+                distribute_update_vars=["PyramidHash_emb_cache"],
+                name=None, )
+
+        place = fluid.CPUPlace()
+        exe = fluid.Executor(place)
+        scope = fluid.core.Scope()
+        outs = []
+        with fluid.scope_guard(scope):
+            exe.run(startup_program)
+            # the n-grams of the second run are all cached
+            for _ in range(2):
+                x_tensor = fluid.create_lod_tensor(x_data, x_lod, place)
+                ret = exe.run(main_program,
+                              feed={'x': x_tensor},
+                              fetch_list=[hash_embd],
+                              return_numpy=False)
+                outs.append(np.array(ret[0]))
+        fluid.set_flags({'FLAGS_pyramid_hash_cache_capacity': 0})
+        return outs
+
+    def test_cache(self):
+        x_lod = [[3, 5, 2, 6]]
+        x_data = np.random.RandomState(0).randint(0, 8, [16, 1]).astype(
+            'int32')
+        expected = self.run_program(x_data, x_lod, 0)
+        result = self.run_program(x_data, x_lod, 1024)
+        for x, y in zip(expected, result):
+            self.assertTrue(np.array_equal(x, y))
+
+
+
+class TestPyramidHashFilterReload(unittest.TestCase):
+    def bloom_filter(self, list_len, bits):
+        # the header is magic_num, m, k and count, then the bit vector
+        buf = np.full([list_len * 4], bits, dtype='uint8')
+        num_bits = (list_len * 4 - 32) * 8
+        buf[:32] = np.array(
+            [17070416, num_bits, 1, 100], dtype='uint64').view('uint8')
+        return buf.view('float32').reshape([list_len, 1])
+
+    def test_filter_reload(self):
+        num_voc = 128
+        embed_dim = 64
+        white_list_len = 6400
+        black_list_len = 2800
+        x_lod = [[3, 5, 2, 6]]
+        x_data = np.random.RandomState(0).randint(0, 8, [16, 1]).astype(
+            'int32')
+        main_program = fluid.Program()
+        startup_program = fluid.Program()
+        with fluid.program_guard(main_program, startup_program):
+            x = fluid.data(
+                name='x', shape=list(x_data.shape), dtype='int32', lod_level=1)
+            hash_embd = fluid.contrib.search_pyramid_hash(
+                input=x,
+                num_emb=embed_dim,
+                space_len=num_voc * embed_dim,
+                pyramid_layer=4,
+                rand_len=16,
+                drop_out_percent=0.0,
+                is_training=False,
+                use_filter=True,
+                white_list_len=white_list_len,
+                black_list_len=black_list_len,
+                seed=3,
+                lr=0.002,
+                param_attr=fluid.ParamAttr(
+                    name="PyramidHash_emb_reload",
+                    initializer=fluid.initializer.Uniform(seed=1)),
+                param_attr_wl=fluid.ParamAttr(name="WhiteFilter_reload"),
+                param_attr_bl=fluid.ParamAttr(name="BlackFilter_reload"),
+                distribute_update_vars=["PyramidHash_emb_reload"],
+                name=None, )
+
+        place = fluid.CPUPlace()
+        exe = fluid.Executor(place)
+        scope = fluid.core.Scope()
+
+        def run(cache_capacity):
+            fluid.set_flags(
+                {'FLAGS_pyramid_hash_cache_capacity': cache_capacity})
+            x_tensor = fluid.create_lod_tensor(x_data, x_lod, place)
+            ret = exe.run(main_program,
+                          feed={'x': x_tensor},
+                          fetch_list=[hash_embd],
+                          return_numpy=False)
+            return np.array(ret[0])
+
+        def load_white_filter(bits):
+            # the same shape and header, so only the bits change
+            scope.find_var("WhiteFilter_reload").get_tensor().set(
+                self.bloom_filter(white_list_len, bits), place)
+
+        with fluid.scope_guard(scope):
+            exe.run(startup_program)
+            scope.find_var("BlackFilter_reload").get_tensor().set(
+                self.bloom_filter(black_list_len, 0x00), place)
+            load_white_filter(0xFF)
+            pass_all = run(1024)
+            load_white_filter(0x00)
+            pass_none = run(1024)
+            expected = run(0)
+        fluid.set_flags({'FLAGS_pyramid_hash_cache_capacity': 0})
+        self.assertFalse(np.array_equal(pass_all, pass_none))
+        self.assertTrue(np.array_equal(pass_none, expected))
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -273,5 +273,33 @@ class TestTopKAPI(unittest.TestCase):
             paddle.topk(x, k=0)
 
 
+class TestTopKLargeVocab(unittest.TestCase):
+    def setUp(self):
+        self.vocab_size = 50000
+        self.input_data = np.random.RandomState(0).rand(
+            32, self.vocab_size).astype('float32')
+
+    def test_largest_and_smallest(self):
+        paddle.disable_static(core.CPUPlace())
+        x = paddle.to_tensor(self.input_data)
+        for k in [1, 5, 100]:
+            for largest in [True, False]:
+                values, indices = paddle.topk(x, k=k, largest=largest)
+                numpy_values, numpy_indices = numpy_topk(
+                    self.input_data, k=k, largest=largest)
+                self.assertTrue(np.array_equal(values.numpy(), numpy_values))
+                self.assertTrue(np.array_equal(indices.numpy(), numpy_indices))
+        paddle.enable_static()
+
+    def test_nan(self):
+        paddle.disable_static(core.CPUPlace())
+        input_data = self.input_data[:2].copy()
+        input_data[0, [7, 300]] = np.nan
+        values, indices = paddle.topk(paddle.to_tensor(input_data), k=3)
+        self.assertEqual(indices.numpy()[0].tolist()[:2], [7, 300])
+        self.assertTrue(np.isnan(values.numpy()[0][:2]).all())
+        paddle.enable_static()
+
+
 if __name__ == "__main__":
     unittest.main()
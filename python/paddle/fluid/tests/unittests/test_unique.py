@@ -70,6 +70,25 @@ class TestRandom(TestUniqueOp):
         self.outputs = {'Out': target_out, 'Index': target_index}
 
 
+class TestRandomManyValues(TestUniqueOp):
+    # More distinct values than the hash map takes, numbered by a sort.
+    def init_config(self):
+        x = np.random.randint(-2**40, 2**40, (100000, ), dtype='int64')
+        x[1::2] = x[::2][::-1]
+        self.inputs = {'X': x}
+        self.attrs = {'dtype': int(core.VarDesc.VarType.INT64)}
+        np_unique, np_index, np_inverse = np.unique(self.inputs['X'], True,
+                                                    True)
+        # number the distinct values in the order of their first occurrence
+        order = np.argsort(np_index, kind='stable')
+        rank = np.empty_like(order)
+        rank[order] = np.arange(len(order))
+        target_out = np_unique[order]
+        target_index = rank[np_inverse]
+
+        self.outputs = {'Out': target_out, 'Index': target_index}
+
+
 class TestUniqueRaiseError(unittest.TestCase):
     def test_errors(self):
         def test_type():
@@ -151,6 +170,33 @@ class TestSortedUniqueOp(TestUniqueOp):
         }
 
 
+class TestSortedUniqueOpLargeRange(TestUniqueOp):
+    def init_config(self):
+        x = np.random.randint(-2**40, 2**40, (20000, ), dtype='int64')
+        x[::2] = x[1::2]
+        self.inputs = {'X': x}
+        unique, indices, inverse, count = np.unique(
+            self.inputs['X'],
+            return_index=True,
+            return_inverse=True,
+            return_counts=True,
+            axis=None)
+        self.attrs = {
+            'dtype': int(core.VarDesc.VarType.INT64),
+            "return_index": True,
+            "return_inverse": True,
+            "return_counts": True,
+            "axis": None,
+            "is_sorted": True
+        }
+        self.outputs = {
+            'Out': unique,
+            'Indices': indices,
+            "Index": inverse,
+            "Counts": count,
+        }
+
+
 class TestUniqueOpAxisNone(TestUniqueOp):
     def init_config(self):
         self.inputs = {'X': np.random.random((4, 7, 10)).astype('float64')}
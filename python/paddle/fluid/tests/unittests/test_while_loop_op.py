@@ -570,5 +570,60 @@ class TestApiWhileLoopSliceInBody(unittest.TestCase):
         self.assertTrue(np.array_equal(res[0], [np.sum(np_x)]))
 
 
+class TestApiWhileLoopCachedBlock(unittest.TestCase):
+    def setUp(self):
+        self.flag = paddle.get_flags('FLAGS_cache_control_flow_block')[
+            'FLAGS_cache_control_flow_block']
+
+    def tearDown(self):
+        paddle.set_flags({'FLAGS_cache_control_flow_block': self.flag})
+
+    def build_decoder(self, steps, is_test):
+        # A decoding-like loop of small ops with a branch in every step.
+        def cond(i, h):
+            return layers.less_than(i, limit)
+
+        def body(i, h):
+            h = layers.tanh(layers.elementwise_add(h * 0.5, x))
+            h = layers.cond(
+                layers.less_than(i, half), lambda: h + 1.0, lambda: h - 1.0)
+            return layers.increment(i), h
+
+        main_program = Program()
+        startup_program = Program()
+        with program_guard(main_program, startup_program):
+            x = fluid.data(name='x', shape=[4, 8], dtype='float32')
+            i = layers.fill_constant(shape=[1], dtype='int64', value=0)
+            limit = layers.fill_constant(
+                shape=[1], dtype='int64', value=steps)
+            half = layers.fill_constant(
+                shape=[1], dtype='int64', value=steps // 2)
+            h = layers.fill_constant(shape=[4, 8], dtype='float32', value=0)
+            _, h = layers.while_loop(cond, body, [i, h], is_test=is_test)
+        return main_program, h
+
+    def run_decoder(self, cache, is_test, steps=16, repeat=2):
+        paddle.set_flags({'FLAGS_cache_control_flow_block': cache})
+        main_program, h = self.build_decoder(steps, is_test)
+        exe = fluid.Executor(fluid.CPUPlace())
+        np_x = np.random.RandomState(0).rand(4, 8).astype('float32')
+        scope = fluid.Scope()
+        with fluid.scope_guard(scope):
+            res = exe.run(main_program, feed={'x': np_x}, fetch_list=[h])
+            # the later runs reuse the cached blocks
+            for _ in range(repeat):
+                res_again = exe.run(main_program,
+                                    feed={'x': np_x},
+                                    fetch_list=[h])
+                self.assertTrue(np.array_equal(res[0], res_again[0]))
+        return res[0]
+
+    def test_cached_block(self):
+        for is_test in [True, False]:
+            expected = self.run_decoder(False, is_test)
+            res = self.run_decoder(True, is_test)
+            self.assertTrue(np.allclose(res, expected))
+
+
 if __name__ == '__main__':
     unittest.main()